@@ -181,10 +181,13 @@ HEADERS += extensionfactory.h \
     obscurancevoxelshader.h \
     vtk4dlinearregressiongradientestimator.h \
     combiningvoxelshader.h \
+    voxelshaderchain.h \
     vtkVolumeRayCastSingleVoxelShaderCompositeFunction.h \
+    minmaxbrickgrid.h \
     obscurance.h \
     viewpointgenerator.h \
     thumbnailcreator.h \
+    thumbnailservice.h \
     nonclosedangletool.h \
     abortrendercommand.h \
     roitool.h \
@@ -264,6 +267,7 @@ HEADERS += extensionfactory.h \
     applyhangingprotocolqviewercommand.h \
     renderqviewercommand.h \
     volumepixeldata.h \
+    volumepixeldatacache.h \
     voxel.h \
     customwindowlevelswriter.h \
     qcustomwindowleveleditwidget.h \
@@ -558,9 +562,11 @@ SOURCES += extensionmediator.cpp \
     vtk4dlinearregressiongradientestimator.cpp \
     combiningvoxelshader.cpp \
     vtkVolumeRayCastSingleVoxelShaderCompositeFunction.cxx \
+    minmaxbrickgrid.cpp \
     obscurance.cpp \
     viewpointgenerator.cpp \
     thumbnailcreator.cpp \
+    thumbnailservice.cpp \
     nonclosedangletool.cpp \
     abortrendercommand.cpp \
     roitool.cpp \
@@ -638,6 +644,7 @@ SOURCES += extensionmediator.cpp \
     applyhangingprotocolqviewercommand.cpp \
     renderqviewercommand.cpp \
     volumepixeldata.cpp \
+    volumepixeldatacache.cpp \
     voxel.cpp \
     customwindowlevelswriter.cpp \
     qcustomwindowleveleditwidget.cpp \
@@ -62,12 +62,21 @@ const QString CoreSettings::FunctionForHighQualityObscurances(HighQualityObscura
 const QString CoreSettings::VariantForHighQualityObscurances(HighQualityObscurancesBase + "variant");
 const QString CoreSettings::GradientRadiusForHighQualityObscurances(HighQualityObscurancesBase + "gradientRadius");
 
+const QString Q3DViewerBase("3DViewer/");
+const QString CoreSettings::EnableQ3DViewerInteractiveLevelOfDetail(Q3DViewerBase + "enable3DViewerInteractiveLevelOfDetail");
+
 const QString CoreSettings::LanguageLocale("Starviewer-Language/languageLocale");
 
 const QString CoreSettings::ForcedImageReaderLibrary("Input/ForcedImageReaderLibrary");
 const QString CoreSettings::ForceITKImageReaderForSpecifiedModalities("Input/ForceITKImageReaderForSpecifiedModalities");
 const QString CoreSettings::ForceVTKImageReaderForSpecifiedModalities("Input/ForceVTKImageReaderForSpecifiedModalities");
 const QString CoreSettings::UseItkGdcmImageReaderByDefault("Input/UseItkGdcmImageReaderByDefault");
+const QString CoreSettings::NumberOfThreadsForVtkDcmtkDecoding("Input/NumberOfThreadsForVtkDcmtkDecoding");
+const QString CoreSettings::NumberOfThreadsForDICOMFileReading("Input/NumberOfThreadsForDICOMFileReading");
+const QString CoreSettings::UseDecodedVolumeCache("Input/UseDecodedVolumeCache");
+const QString CoreSettings::DecodedVolumeCachePath("Input/DecodedVolumeCachePath");
+const QString CoreSettings::DecodedVolumeCacheMaximumSize("Input/DecodedVolumeCacheMaximumSizeInMegaBytes");
+const QString CoreSettings::VolumePixelDataMemoryBudget("Input/VolumePixelDataMemoryBudgetInMegaBytes");
 
 // Release Notes
 const QString CoreSettings::LastReleaseNotesVersionShown("LastReleaseNotesVersionShown");
@@ -84,6 +93,7 @@ const QString CoreSettings::MammographyAutoOrientationExceptions("MammographyAut
 
 const QString CoreSettings::AllowAsynchronousVolumeLoading("AllowAsynchronousVolumeLoading");
 const QString CoreSettings::MaximumNumberOfVolumesLoadingConcurrently("MaximumNumberOfVolumesLoadingConcurrently");
+const QString CoreSettings::AllowProgressiveVolumeLoading("AllowProgressiveVolumeLoading");
 
 const QString CoreSettings::MaximumNumberOfVisibleVoiLutComboItems("MaximumNumberOfVisibleVoiLutComboItems");
 
@@ -98,6 +108,7 @@ const QString CoreSettings::PacsListConfigurationSectionName = "PacsList";
 const QString Q2DViewerBase("2DViewer/");
 const QString CoreSettings::EnableQ2DViewerSliceScrollLoop(Q2DViewerBase + "enable2DViewerSliceScrollLoop");
 const QString CoreSettings::EnableQ2DViewerPhaseScrollLoop(Q2DViewerBase + "enable2DViewerPhaseScrollLoop");
+const QString CoreSettings::EnableQ2DViewerLazyOverlayLoading(Q2DViewerBase + "enable2DViewerLazyOverlayLoading");
 const QString CoreSettings::EnableQ2DViewerReferenceLinesForMR(Q2DViewerBase + "enable2DViewerReferenceLinesForMR");
 const QString CoreSettings::EnableQ2DViewerReferenceLinesForCT(Q2DViewerBase + "enable2DViewerReferenceLinesForCT");
 const QString CoreSettings::ModalitiesWithZoomToolByDefault(Q2DViewerBase + "ModalitiesWithZoomToolByDefault");
@@ -140,9 +151,18 @@ void CoreSettings::init()
     settingsRegistry->addSetting(MammographyAutoOrientationExceptions, (QStringList() << "BAV" << "BAG" << "estereot"));
     settingsRegistry->addSetting(AllowAsynchronousVolumeLoading, true);
     settingsRegistry->addSetting(MaximumNumberOfVolumesLoadingConcurrently, 1);
+    settingsRegistry->addSetting(AllowProgressiveVolumeLoading, false);
+    settingsRegistry->addSetting(NumberOfThreadsForVtkDcmtkDecoding, 0);
+    settingsRegistry->addSetting(NumberOfThreadsForDICOMFileReading, 0);
+    settingsRegistry->addSetting(UseDecodedVolumeCache, false);
+    settingsRegistry->addSetting(DecodedVolumeCachePath, UserDataRootPath + "decodedvolumes/", Settings::Parseable);
+    settingsRegistry->addSetting(DecodedVolumeCacheMaximumSize, 10240);
+    settingsRegistry->addSetting(VolumePixelDataMemoryBudget, 0);
     settingsRegistry->addSetting(MaximumNumberOfVisibleVoiLutComboItems, 50);
+    settingsRegistry->addSetting(EnableQ3DViewerInteractiveLevelOfDetail, true);
     settingsRegistry->addSetting(EnableQ2DViewerSliceScrollLoop, false);
     settingsRegistry->addSetting(EnableQ2DViewerPhaseScrollLoop, false);
+    settingsRegistry->addSetting(EnableQ2DViewerLazyOverlayLoading, true);
     settingsRegistry->addSetting(EnableQ2DViewerReferenceLinesForMR, true);
     settingsRegistry->addSetting(EnableQ2DViewerReferenceLinesForCT, false);
     settingsRegistry->addSetting(ModalitiesWithZoomToolByDefault, "MG;CR;RF;OP;DX;MR");
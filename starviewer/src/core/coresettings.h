@@ -55,6 +55,10 @@ public:
     static const QString VariantForHighQualityObscurances;
     static const QString GradientRadiusForHighQualityObscurances;
 
+    /// If true, the CPU ray casting of the 3D viewer renders from a downsampled volume while the user interacts and then refines the image
+    /// progressively to full quality.
+    static const QString EnableQ3DViewerInteractiveLevelOfDetail;
+
     static const QString LanguageLocale;
 
     /// Els 3 següents settings són "backdoors" que *només* s'haurien de fer servir en casos molt específics i controlats
@@ -71,6 +75,25 @@ public:
     /// If true, the ITK-GDCM image reader will be the default, instead of the new VTK-DCMTK.
     static const QString UseItkGdcmImageReaderByDefault;
 
+    /// Number of threads used by the VTK-DCMTK image reader to decode multi-file series. If 0 or not set, the ideal thread count for the machine is used.
+    /// Set it to 1 to decode slices sequentially.
+    static const QString NumberOfThreadsForVtkDcmtkDecoding;
+
+    /// Number of threads used by PatientFiller to read DICOM files when processing a list of files. If 0 or not set, the ideal thread count for the
+    /// machine is used. Set it to 1 to read the files sequentially.
+    static const QString NumberOfThreadsForDICOMFileReading;
+
+    /// If true, the pixel data of the volumes read from DICOM files is saved decoded to the decoded volume cache and read from there the next times,
+    /// as long as the files have not changed.
+    static const QString UseDecodedVolumeCache;
+    /// Directory where the decoded volume cache is stored.
+    static const QString DecodedVolumeCachePath;
+    /// Maximum size, in megabytes, of the decoded volume cache. When exceeded, the least recently used entries are removed. If 0, there's no limit.
+    static const QString DecodedVolumeCacheMaximumSize;
+    /// Maximum memory, in megabytes, used by the pixel data of the loaded volumes. When exceeded, the pixel data of the least recently used volumes that
+    /// are not displayed is released. If 0, there's no limit.
+    static const QString VolumePixelDataMemoryBudget;
+
     /// La última versió comprobada de les Release Notes
     static const QString LastReleaseNotesVersionShown;
 
@@ -97,6 +120,9 @@ public:
     static const QString AllowAsynchronousVolumeLoading;
     /// Indica quans volums poden estar-se carregant a la vegada com a màxim.
     static const QString MaximumNumberOfVolumesLoadingConcurrently;
+    /// If true, volumes loaded asynchronously are shown as soon as their pixel data is allocated and each slice is displayed as soon as it is decoded,
+    /// decoding first the slices around the current one.
+    static const QString AllowProgressiveVolumeLoading;
 
     /// Defineix el nombre màxim d'ítems visibles al desplegar-se el combo de window/levels per defecte.
     /// Si tenim més presets que els que indiqui aquest setting, apareixerà un scroll vertical.
@@ -116,6 +142,10 @@ public:
     static const QString EnableQ2DViewerSliceScrollLoop;
     static const QString EnableQ2DViewerPhaseScrollLoop;
 
+    /// If true, image overlays are read and built only for the slices around the displayed one, and released when the displayed slice moves away.
+    /// Otherwise, the overlays of all the slices are loaded when the input is set.
+    static const QString EnableQ2DViewerLazyOverlayLoading;
+
     /// Defineix si habilitem per defecte el reference lines per modalitats MR i/o CT
     static const QString EnableQ2DViewerReferenceLinesForMR;
     static const QString EnableQ2DViewerReferenceLinesForCT;
@@ -28,6 +28,7 @@ DICOMFileClassifierFillerStep::DICOMFileClassifierFillerStep()
  : PatientFillerStep()
 {
     m_dicomReader = new DICOMTagReader;
+    m_requiresPixelData = false;
 }
 
 DICOMFileClassifierFillerStep::~DICOMFileClassifierFillerStep()
@@ -29,6 +29,10 @@
 
 namespace {
 
+/// Values longer than this are not read when loading only the header of a file. This leaves out the pixel data and other bulk data, such as overlays,
+/// curves or big private elements.
+const Uint32 HeaderOnlyMaxReadLength = 1024;
+
 /// Returns true if the given tag contains text that is encoded with the Specific Character Set (0008,0005). See http://www.dabsoft.ch/dicom/3/C.12.1.1.2/.
 bool isEncodedText(const DcmTag &tag)
 {
@@ -69,6 +73,12 @@ DICOMTagReader::DICOMTagReader(const QString &filename)
     this->setFile(filename);
 }
 
+DICOMTagReader::DICOMTagReader(const QString &filename, ReadMode readMode)
+{
+    initialize();
+    this->setFile(filename, readMode);
+}
+
 DICOMTagReader::~DICOMTagReader()
 {
     deleteDataLastLoadedFile();
@@ -94,13 +104,22 @@ void DICOMTagReader::deleteDataLastLoadedFile()
     }
 }
 
-bool DICOMTagReader::setFile(const QString &filename)
+bool DICOMTagReader::setFile(const QString &filename, ReadMode readMode)
 {
     DcmFileFormat dicomFile;
 
     m_filename = filename;
 
-    OFCondition status = dicomFile.loadFile(qPrintable(filename));
+    OFCondition status;
+    if (readMode == ReadHeaderOnly)
+    {
+        // Els valors llargs no es llegeixen, dcmtk en guarda la posició dins el fitxer i els llegeix si mai es demanen
+        status = dicomFile.loadFile(qPrintable(filename), EXS_Unknown, EGL_noChange, HeaderOnlyMaxReadLength);
+    }
+    else
+    {
+        status = dicomFile.loadFile(qPrintable(filename));
+    }
     if (status.good())
     {
         m_hasValidFile = true;
@@ -46,9 +46,17 @@ public:
     /// hem de retornar-los sense sel seu valor, estalviant-nos de llegir i carregar-los en memòria
     enum ReturnValueOfTags { AllTags, ExcludeHeavyTags };
 
+    /// Indicates how much of a file is read when it is loaded. With ReadHeaderOnly only the short values are read, and long values such as Pixel Data
+    /// (7FE0,0010) or Overlay Data are skipped and left on disk. They are read from the file on demand if they are ever accessed, so the file must remain
+    /// available while the reader is in use.
+    enum ReadMode { ReadAllData, ReadHeaderOnly };
+
     DICOMTagReader();
     /// Constructor per nom de fitxer.
     DICOMTagReader(const QString &filename);
+
+    /// Constructor per nom de fitxer, llegint el fitxer segons el mode indicat.
+    DICOMTagReader(const QString &filename, ReadMode readMode);
     /// Constructor per nom de fitxer per si es té un DcmDataset ja llegit.
     /// D'aquesta forma no cal tornar-lo a llegir.
     DICOMTagReader(const QString &filename, DcmDataset *dcmDataset);
@@ -56,7 +64,8 @@ public:
     virtual ~DICOMTagReader();
 
     /// Nom de l'arxiu DICOM que es vol llegir. Torna cert si l'arxiu s'ha pogut carregar correctament, fals altrament.
-    bool setFile(const QString &filename);
+    /// With ReadHeaderOnly the pixel data is not read, see ReadMode.
+    bool setFile(const QString &filename, ReadMode readMode = ReadAllData);
 
     /// Ens diu si l'arxiu assignat és vàlid com a arxiu DICOM. Si no tenim arxiu assignat retornarà fals.
     bool canReadFile() const;
@@ -183,6 +183,9 @@ void Drawer::erasePrimitive(DrawerPrimitive *primitive)
         return;
     }
 
+    // Si estava deshabilitada deixem de tenir-ne constància, ja que l'adreça podria ser reutilitzada per una altra primitiva
+    m_disabledPrimitives.remove(primitive);
+
     // Mirem si està en algun grup
     QMutableMapIterator<QString, DrawerPrimitive*> groupsIterator(m_primitiveGroups);
     while (groupsIterator.hasNext())
@@ -35,6 +35,7 @@ Image::Image(QObject *parent)
     m_estimatedRadiographicMagnificationFactor = 1.0;
     
     m_numberOfOverlays = 0;
+    m_overlaysReferenceCount = 0;
     memset(m_imagePositionPatient, 0, 3 * sizeof(double));
 
     m_haveToBuildDisplayShutterForDisplay = false;
@@ -504,6 +505,25 @@ QList<ImageOverlay> Image::getOverlaysSplit()
     return m_overlaysSplit;
 }
 
+void Image::increaseOverlaysReferenceCount()
+{
+    ++m_overlaysReferenceCount;
+}
+
+void Image::decreaseOverlaysReferenceCount()
+{
+    if (m_overlaysReferenceCount > 0)
+    {
+        --m_overlaysReferenceCount;
+    }
+
+    if (m_overlaysReferenceCount == 0)
+    {
+        m_overlaysList.clear();
+        m_overlaysSplit.clear();
+    }
+}
+
 bool Image::hasDisplayShutters() const
 {
     return !m_shuttersList.isEmpty();
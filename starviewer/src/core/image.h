@@ -217,6 +217,12 @@ public:
     /// i després es fa la partició òptima de les diferents parts que el composen
     QList<ImageOverlay> getOverlaysSplit();
 
+    /// Indica que un visor fa servir els overlays llegits de la imatge. Mentre algun visor els faci servir no s'alliberaran.
+    void increaseOverlaysReferenceCount();
+    /// Indica que un visor ja no fa servir els overlays llegits de la imatge. Quan cap visor no els fa servir s'alliberen
+    /// i es tornaran a llegir la propera vegada que es demanin.
+    void decreaseOverlaysReferenceCount();
+
     /// Ens diu si té shutters o no
     bool hasDisplayShutters() const;
     
@@ -415,6 +421,9 @@ private:
     /// Llista que conté la partició en regions òptimes de la fusió de tots els overlays
     QList<ImageOverlay> m_overlaysSplit;
 
+    /// Nombre de visors que fan servir els overlays llegits
+    int m_overlaysReferenceCount;
+
     /// Llista de display shutters
     QList<DisplayShutter> m_shuttersList;
     
@@ -24,6 +24,7 @@
 #include "dicomsequenceitem.h"
 #include "dicomvalueattribute.h"
 #include "thumbnailcreator.h"
+#include "thumbnailservice.h"
 #include "patientorientation.h"
 #include "displayshutter.h"
 #include "mathtools.h"
@@ -39,6 +40,8 @@ ImageFillerStep::ImageFillerStep()
  : PatientFillerStep()
 {
     m_requiredLabelsList << "DICOMFileClassifierFillerStep";
+    // Els thumbnails que genera llegeixen les dades de píxel del fitxer quan cal, no necessita que es llegeixin amb la capçalera
+    m_requiresPixelData = false;
 }
 
 ImageFillerStep::~ImageFillerStep()
@@ -125,7 +128,9 @@ QList<Image*> ImageFillerStep::processDICOMFile(DICOMTagReader *dicomReader)
                                 {
                                     QString path = QString("%1/thumbnail%2.png").arg(QFileInfo(lastProcessedImage->getPath()).absolutePath()).arg(
                                                            lastProcessedImage->getVolumeNumberInSeries());
-                                    ThumbnailCreator().getThumbnail(lastProcessedImage).save(path, "PNG");
+                                    ThumbnailService::instance()->requestThumbnail(m_input->getCurrentSeries()->getInstanceUID(),
+                                                                                   lastProcessedImage->getVolumeNumberInSeries(),
+                                                                                   lastProcessedImage->getPath(), QStringList() << path);
                                 }
                                 saveThumbnail(dicomReader);
                             }
@@ -163,14 +168,27 @@ void ImageFillerStep::saveThumbnail(DICOMTagReader *dicomReader)
     int volumeNumber = m_input->getCurrentVolumeNumber();
     QString thumbnailPath = QFileInfo(dicomReader->getFileName()).absolutePath();
 
-    ThumbnailCreator thumbnailCreator;
-    QImage thumbnail = thumbnailCreator.getThumbnail(dicomReader);
-    thumbnail.save(QString("%1/thumbnail%2.png").arg(thumbnailPath).arg(volumeNumber), "PNG");
+    QStringList thumbnailFilePaths;
+    thumbnailFilePaths << QString("%1/thumbnail%2.png").arg(thumbnailPath).arg(volumeNumber);
 
     // Si és el primer thumbnail, també creem el thumbnail ordinari que s'havia fet sempre
     if (volumeNumber == 1)
     {
-        thumbnail.save(QString("%1/thumbnail.png").arg(thumbnailPath), "PNG");
+        thumbnailFilePaths << QString("%1/thumbnail.png").arg(thumbnailPath);
+    }
+
+    if (dicomReader->getValueAttributeAsQString(DICOMNumberOfFrames).toInt() > 1)
+    {
+        // Els fitxers multiframe ja els tenim a memòria i tornar-ne a llegir la capçalera de disc costaria més que descodificar-ne ara el primer frame.
+        // Només es desa en PNG en segon pla
+        ThumbnailService::instance()->requestThumbnail(m_input->getCurrentSeries()->getInstanceUID(), volumeNumber,
+                                                       ThumbnailCreator().getThumbnail(dicomReader), thumbnailFilePaths);
+    }
+    else
+    {
+        // El thumbnail es crea en segon pla perquè la descàrrega i la importació no n'hagin d'esperar la descodificació i la codificació en PNG
+        ThumbnailService::instance()->requestThumbnail(m_input->getCurrentSeries()->getInstanceUID(), volumeNumber, dicomReader->getFileName(),
+                                                       thumbnailFilePaths);
     }
 }
 
@@ -61,7 +61,7 @@ private:
     /// Donat un dicomReader guardem a la cache el corresponent thumbnail.
     /// La intenció d'aquest mètode és estalviar temps en la càrrega de thumbnails per arxius
     /// multiframe i enhanced ja que actualment és molt costós perquè hem de carregar tot el volum
-    /// a memòria i aquí podem aprofitar que el dataset està a memòria evitant la càrrega posterior
+    /// a memòria. El thumbnail es crea en segon pla amb el ThumbnailService.
     /// Tot i així es pot fer servir en altres casos que es cregui necessari avançar la creació del thumbnail
     void saveThumbnail(DICOMTagReader *dicomReader);
 
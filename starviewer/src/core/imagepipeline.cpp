@@ -30,6 +30,8 @@ ImagePipeline::ImagePipeline()
     // Filtre de thick slab + grayscale
     m_thickSlabProjectionFilter = new ThickSlabFilter();
     m_thickSlabProjectionFilter->setSlabThickness(1);
+    // Scrolling through the volume moves the slab one slice at a time, so it's cheaper to update the average projection than to compute it again
+    m_thickSlabProjectionFilter->setIncrementalProjection(true);
 
     m_windowLevelLUTFilter = new WindowLevelFilter();
 
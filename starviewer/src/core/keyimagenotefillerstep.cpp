@@ -26,6 +26,7 @@ KeyImageNoteFillerStep::KeyImageNoteFillerStep()
  : PatientFillerStep()
 {
     m_requiredLabelsList << "DICOMFileClassifierFillerStep";
+    m_requiresPixelData = false;
 }
 
 KeyImageNoteFillerStep::~KeyImageNoteFillerStep()
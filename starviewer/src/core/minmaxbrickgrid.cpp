@@ -0,0 +1,226 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "minmaxbrickgrid.h"
+
+#include "transferfunction.h"
+
+#include <cmath>
+#include <limits>
+
+namespace udg {
+
+MinMaxBrickGrid::MinMaxBrickGrid()
+ : m_maximumValue(0)
+{
+    clear();
+}
+
+MinMaxBrickGrid::~MinMaxBrickGrid()
+{
+}
+
+void MinMaxBrickGrid::setData(const unsigned short *data, const int dimensions[3])
+{
+    clear();
+
+    if (!data || dimensions[0] < 1 || dimensions[1] < 1 || dimensions[2] < 1)
+    {
+        return;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        m_dimensions[i] = dimensions[i];
+        m_numberOfBricks[i] = (dimensions[i] - 1) / BrickSize + 1;
+    }
+
+    int numberOfBricks = m_numberOfBricks[0] * m_numberOfBricks[1] * m_numberOfBricks[2];
+    m_minimums.fill(std::numeric_limits<unsigned short>::max(), numberOfBricks);
+    m_maximums.fill(0, numberOfBricks);
+    m_transparent.fill(false, numberOfBricks);
+
+    for (int bz = 0; bz < m_numberOfBricks[2]; bz++)
+    {
+        // Rang de vòxels del brick amb un vòxel de marge a cada costat
+        int zBegin = qMax(bz * BrickSize - 1, 0), zEnd = qMin((bz + 1) * BrickSize + 1, m_dimensions[2] - 1);
+
+        for (int by = 0; by < m_numberOfBricks[1]; by++)
+        {
+            int yBegin = qMax(by * BrickSize - 1, 0), yEnd = qMin((by + 1) * BrickSize + 1, m_dimensions[1] - 1);
+
+            for (int bx = 0; bx < m_numberOfBricks[0]; bx++)
+            {
+                int xBegin = qMax(bx * BrickSize - 1, 0), xEnd = qMin((bx + 1) * BrickSize + 1, m_dimensions[0] - 1);
+                unsigned short minimum = std::numeric_limits<unsigned short>::max(), maximum = 0;
+
+                for (int z = zBegin; z <= zEnd; z++)
+                {
+                    for (int y = yBegin; y <= yEnd; y++)
+                    {
+                        const unsigned short *row = data + m_dimensions[0] * (y + m_dimensions[1] * z);
+
+                        for (int x = xBegin; x <= xEnd; x++)
+                        {
+                            unsigned short value = row[x];
+                            if (value < minimum)
+                            {
+                                minimum = value;
+                            }
+                            if (value > maximum)
+                            {
+                                maximum = value;
+                            }
+                        }
+                    }
+                }
+
+                int index = getBrickIndex(bx, by, bz);
+                m_minimums[index] = minimum;
+                m_maximums[index] = maximum;
+
+                if (maximum > m_maximumValue)
+                {
+                    m_maximumValue = maximum;
+                }
+            }
+        }
+    }
+}
+
+void MinMaxBrickGrid::clear()
+{
+    for (int i = 0; i < 3; i++)
+    {
+        m_dimensions[i] = 0;
+        m_numberOfBricks[i] = 0;
+    }
+
+    m_maximumValue = 0;
+    m_minimums.clear();
+    m_maximums.clear();
+    m_transparent.clear();
+}
+
+bool MinMaxBrickGrid::hasData() const
+{
+    return !m_minimums.isEmpty();
+}
+
+void MinMaxBrickGrid::setTransferFunction(const TransferFunction &transferFunction)
+{
+    if (!hasData())
+    {
+        return;
+    }
+
+    // opaqueValues[v] és el nombre de valors opacs menors que v, així un brick és transparent si no n'hi ha cap entre el seu mínim i el seu màxim
+    QVector<int> opaqueValues(m_maximumValue + 2);
+    opaqueValues[0] = 0;
+    for (int value = 0; value <= m_maximumValue; value++)
+    {
+        opaqueValues[value + 1] = opaqueValues[value] + (transferFunction.getScalarOpacity(value) > 0.0 ? 1 : 0);
+    }
+
+    for (int i = 0; i < m_transparent.size(); i++)
+    {
+        m_transparent[i] = opaqueValues[m_maximums[i] + 1] == opaqueValues[m_minimums[i]];
+    }
+}
+
+const int* MinMaxBrickGrid::getNumberOfBricks() const
+{
+    return m_numberOfBricks;
+}
+
+unsigned short MinMaxBrickGrid::getMinimum(int x, int y, int z) const
+{
+    return m_minimums.at(getBrickIndex(x, y, z));
+}
+
+unsigned short MinMaxBrickGrid::getMaximum(int x, int y, int z) const
+{
+    return m_maximums.at(getBrickIndex(x, y, z));
+}
+
+bool MinMaxBrickGrid::isTransparent(int x, int y, int z) const
+{
+    return m_transparent.at(getBrickIndex(x, y, z));
+}
+
+int MinMaxBrickGrid::getNumberOfTransparentSteps(const Vector3 &position, const Vector3 &increment, int maximumSteps) const
+{
+    if (!hasData())
+    {
+        return 0;
+    }
+
+    const double rayIncrement[3] = { increment.x, increment.y, increment.z };
+    int steps = 0;
+
+    while (steps < maximumSteps)
+    {
+        Vector3 samplePosition = position + steps * increment;
+        const double currentPosition[3] = { samplePosition.x, samplePosition.y, samplePosition.z };
+        int brick[3];
+
+        for (int i = 0; i < 3; i++)
+        {
+            double voxel = std::floor(currentPosition[i]);
+            if (voxel < 0.0 || voxel >= m_dimensions[i])
+            {
+                return steps;
+            }
+            brick[i] = static_cast<int>(voxel) / BrickSize;
+        }
+
+        if (!m_transparent.at(getBrickIndex(brick[0], brick[1], brick[2])))
+        {
+            return steps;
+        }
+
+        // Nombre de passos fins a la primera cara del brick per on surt el raig
+        double stepsInBrick = std::numeric_limits<double>::max();
+        for (int i = 0; i < 3; i++)
+        {
+            double stepsToFace;
+            if (rayIncrement[i] > 0.0)
+            {
+                stepsToFace = ((brick[i] + 1) * BrickSize - currentPosition[i]) / rayIncrement[i];
+            }
+            else if (rayIncrement[i] < 0.0)
+            {
+                stepsToFace = (brick[i] * BrickSize - currentPosition[i]) / rayIncrement[i];
+            }
+            else
+            {
+                continue;
+            }
+
+            stepsInBrick = qMin(stepsInBrick, stepsToFace);
+        }
+
+        if (stepsInBrick >= maximumSteps - steps)
+        {
+            return maximumSteps;
+        }
+
+        // La mostra que cau just a la cara encara té floor(posició) dins del marge del brick, per això també se salta
+        steps += static_cast<int>(stepsInBrick) + 1;
+    }
+
+    return maximumSteps;
+}
+
+}
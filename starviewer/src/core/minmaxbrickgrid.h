@@ -0,0 +1,94 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGMINMAXBRICKGRID_H
+#define UDGMINMAXBRICKGRID_H
+
+#include <QVector>
+
+#include "vector3.h"
+
+namespace udg {
+
+class TransferFunction;
+
+/**
+    Graella de bricks (blocs de BrickSize³ vòxels) que guarda el valor mínim i màxim de cada brick d'un volum d'unsigned shorts, per poder saltar l'espai
+    buit durant el ray casting.
+
+    Els mínims i màxims es calculen un sol cop amb setData(). Cada cop que canvia la funció de transferència, setTransferFunction() marca com a transparents
+    els bricks on l'opacitat és 0 per a tots els valors entre el mínim i el màxim, cosa que només costa recórrer els valors possibles un cop i els bricks un cop.
+
+    El mínim i el màxim de cada brick inclouen un vòxel de marge a cada costat, de manera que totes les mostres amb floor(posició) dins del brick, tant amb
+    interpolació trilineal com amb el vòxel més proper, només llegeixen valors d'aquest rang encara que la posició tingui errors d'arrodoniment.
+  */
+class MinMaxBrickGrid {
+
+public:
+    /// Nombre de vòxels de cada costat d'un brick.
+    static const int BrickSize = 8;
+
+    MinMaxBrickGrid();
+    ~MinMaxBrickGrid();
+
+    /// Calcula el mínim i el màxim de cada brick del volum data, amb les dimensions donades i l'índex x variant més ràpid.
+    void setData(const unsigned short *data, const int dimensions[3]);
+    /// Esborra la graella. Sense dades no es salta cap mostra.
+    void clear();
+    /// Retorna cert si la graella té dades.
+    bool hasData() const;
+
+    /// Marca els bricks transparents segons l'opacitat escalar de la funció de transferència.
+    void setTransferFunction(const TransferFunction &transferFunction);
+
+    /// Retorna el nombre de bricks en cada dimensió.
+    const int* getNumberOfBricks() const;
+    /// Retorna el valor mínim del brick (x,y,z).
+    unsigned short getMinimum(int x, int y, int z) const;
+    /// Retorna el valor màxim del brick (x,y,z).
+    unsigned short getMaximum(int x, int y, int z) const;
+    /// Retorna cert si el brick (x,y,z) és transparent.
+    bool isTransparent(int x, int y, int z) const;
+
+    /// Retorna quantes mostres consecutives del raig, començant a position i avançant increment cada cop, cauen dins de bricks transparents, fins a un
+    /// màxim de maximumSteps. Les posicions són en coordenades de vòxel.
+    int getNumberOfTransparentSteps(const Vector3 &position, const Vector3 &increment, int maximumSteps) const;
+
+private:
+    /// Retorna l'índex del brick (x,y,z).
+    int getBrickIndex(int x, int y, int z) const;
+
+private:
+    /// Dimensions del volum.
+    int m_dimensions[3];
+    /// Nombre de bricks en cada dimensió.
+    int m_numberOfBricks[3];
+    /// Valor màxim del volum.
+    unsigned short m_maximumValue;
+
+    /// Mínim, màxim i transparència de cada brick.
+    QVector<unsigned short> m_minimums;
+    QVector<unsigned short> m_maximums;
+    QVector<bool> m_transparent;
+
+};
+
+inline int MinMaxBrickGrid::getBrickIndex(int x, int y, int z) const
+{
+    return x + m_numberOfBricks[0] * (y + m_numberOfBricks[1] * z);
+}
+
+}
+
+#endif
@@ -28,11 +28,11 @@ Obscurance::Obscurance(unsigned int size, bool color, bool doublePrecision)
 {
     if (!m_color && !m_doublePrecision)
     {
-        m_floatObscurance = new float[m_size];
+        m_floatObscurance = new float[m_size]();
     }
     if (!m_color && m_doublePrecision)
     {
-        m_doubleObscurance = new double[m_size];
+        m_doubleObscurance = new double[m_size]();
     }
     if (m_color && !m_doublePrecision)
     {
@@ -113,6 +113,31 @@ void Obscurance::normalize()
     }
 }
 
+void Obscurance::add(const Obscurance &obscurance)
+{
+    Q_ASSERT(obscurance.m_size == m_size && obscurance.m_color == m_color && obscurance.m_doublePrecision == m_doublePrecision);
+
+    for (unsigned int i = 0; i < m_size; i++)
+    {
+        if (m_floatObscurance)
+        {
+            m_floatObscurance[i] += obscurance.m_floatObscurance[i];
+        }
+        if (m_doubleObscurance)
+        {
+            m_doubleObscurance[i] += obscurance.m_doubleObscurance[i];
+        }
+        if (m_floatColorBleeding)
+        {
+            m_floatColorBleeding[i] += obscurance.m_floatColorBleeding[i];
+        }
+        if (m_doubleColorBleeding)
+        {
+            m_doubleColorBleeding[i] += obscurance.m_doubleColorBleeding[i];
+        }
+    }
+}
+
 bool Obscurance::load(const QString &fileName)
 {
     QFile file(fileName);
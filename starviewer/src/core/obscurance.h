@@ -37,6 +37,8 @@ public:
 
     /// Normalitza les obscurances.
     void normalize();
+    /// Suma a aquestes obscurances les de \a obscurance, que han de tenir la mateixa mida, color i precisió.
+    void add(const Obscurance &obscurance);
 
     /// Retorna l'array d'obscurança amb floats (0 si no existeix).
     float* floatObscurance() const;
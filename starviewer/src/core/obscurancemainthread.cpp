@@ -27,6 +27,8 @@
 #include "vector3.h"
 #include "viewpointgenerator.h"
 
+#include <new>
+
 namespace udg {
 
 bool ObscuranceMainThread::hasColor(Variant variant)
@@ -40,7 +42,8 @@ ObscuranceMainThread::ObscuranceMainThread(int numberOfDirections, double maximu
    m_numberOfDirections(numberOfDirections), m_maximumDistance(maximumDistance), m_function(function), m_variant(variant),
    m_doublePrecision(doublePrecision),
    m_volume(0),
-   m_obscurance(0)
+   m_obscurance(0),
+   m_stopped(false), m_allTasksEnqueued(false), m_numberOfDirectionsInProgress(0), m_numberOfFinishedDirections(0)
 {
 }
 
@@ -83,7 +86,10 @@ Obscurance* ObscuranceMainThread::getObscurance() const
 
 void ObscuranceMainThread::stop()
 {
+    QMutexLocker locker(&m_tasksMutex);
     m_stopped = true;
+    m_taskAvailableCondition.wakeAll();
+    m_directionFinishedCondition.wakeAll();
 }
 
 void ObscuranceMainThread::run()
@@ -97,11 +103,6 @@ void ObscuranceMainThread::run()
     /// \TODO fent això aquí crec que va més ràpid, però s'hauria de comprovar i provar també amb l'Update()
     gradientEstimator->GetEncodedNormals();
 
-    // Creem els threads
-    /// \todo QThread::idealThreadCount() amb Qt >= 4.3
-    int numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
-    QVector<ObscuranceThread*> threads(numberOfThreads);
-
     // Variables necessàries
     vtkImageData *image = mapper->GetInput();
     unsigned short *data = reinterpret_cast<unsigned short*>(image->GetPointData()->GetScalars()->GetVoidPointer(0));
@@ -118,132 +119,119 @@ void ObscuranceMainThread::run()
 
     m_obscurance = new Obscurance(dataSize, hasColor(), m_doublePrecision);
 
+    // Buffers d'obscurances de cada thread: el primer acumula directament al resultat i la resta se sumen al final.
+    // Si no hi ha memòria per a tots els buffers fem servir menys threads.
+    /// \todo QThread::idealThreadCount() amb Qt >= 4.3
+    int numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    QVector<Obscurance*> buffers;
+    buffers << m_obscurance;
+    for (int i = 1; i < numberOfThreads; i++)
+    {
+        try
+        {
+            buffers << new Obscurance(dataSize, hasColor(), m_doublePrecision);
+        }
+        catch (std::bad_alloc &e)
+        {
+            WARN_LOG(QString("No hi ha prou memòria per als buffers d'obscurances de %1 threads, se'n faran servir %2: %3").arg(numberOfThreads)
+                     .arg(buffers.size()).arg(e.what()));
+            break;
+        }
+    }
+    numberOfThreads = buffers.size();
+
+    m_tasks.clear();
+    m_allTasksEnqueued = false;
+    m_numberOfDirectionsInProgress = 0;
+    m_numberOfFinishedDirections = 0;
+
+    // Creem i iniciem els threads, que esperaran les tasques
+    QVector<ObscuranceThread*> threads(numberOfThreads);
     for (int i = 0; i < numberOfThreads; i++)
     {
-        ObscuranceThread * thread = new ObscuranceThread(i, numberOfThreads, m_transferFunction);
+        ObscuranceThread * thread = new ObscuranceThread(i, this, m_transferFunction);
         thread->setGradientEstimator(gradientEstimator);
         thread->setData(data, dataSize, dimensions, increments);
-        thread->setObscuranceParameters(m_maximumDistance, m_function, m_variant, m_obscurance);
+        thread->setObscuranceParameters(m_maximumDistance, m_function, m_variant, buffers[i]);
         thread->setSaliency(m_saliency, m_fxSaliencyA, m_fxSaliencyB, m_fxSaliencyLow, m_fxSaliencyHigh);
         threads[i] = thread;
+        thread->start();
     }
 
-    // Estructures de dades reaprofitables
-    QVector<Vector3> lineStarts;
-
     const QVector<Vector3> directions = getDirections();
     int nDirections = directions.size();
+    QList<DirectionParameters*> directionParameters;
+    int lastProgress = 0;
+
+    // Preparem les direccions mentre els threads processen les anteriors. Limitem les direccions en procés perquè els començaments de línia de cada
+    // direcció ocupen memòria, però sempre n'hi ha més d'una perquè els threads que acaben no hagin d'esperar els altres.
+    const int MaximumNumberOfDirectionsInProgress = 2;
 
-    // Iterem per les direccions
     for (int i = 0; i < nDirections && !m_stopped; i++)
     {
         const Vector3 &direction = directions.at(i);
 
         DEBUG_LOG(QString("Direcció %1: %2").arg(i).arg(direction.toString()));
 
-        // Direcció dominant (0 = x, 1 = y, 2 = z)
-        int dominant;
-        Vector3 absDirection(qAbs(direction.x), qAbs(direction.y), qAbs(direction.z));
-        if (absDirection.x >= absDirection.y)
-        {
-            if (absDirection.x >= absDirection.z)
-            {
-                dominant = 0;
-            }
-            else
-            {
-                dominant = 2;
-            }
-        }
-        else
-        {
-            if (absDirection.y >= absDirection.z)
-            {
-                dominant = 1;
-            }
-            else
-            {
-                dominant = 2;
-            }
-        }
+        DirectionParameters *parameters = getDirectionParameters(direction, dimensions, increments);
+        directionParameters << parameters;
 
-        // Vector per avançar
-        Vector3 forward;
-        switch (dominant)
-        {
-            case 0:
-                forward = Vector3(direction.x, direction.y, direction.z);
-                break;
-            case 1:
-                forward = Vector3(direction.y, direction.z, direction.x);
-                break;
-            case 2: 
-                forward = Vector3(direction.z, direction.x, direction.y);
-                break;
-        }
-        // La direcció x passa a ser 1 o -1
-        forward /= qAbs(forward.x);
-        DEBUG_LOG(QString("forward = ") + forward.toString());
-
-        // Dimensions i increments segons la direcció dominant
-        int x = dominant, y = (dominant + 1) % 3, z = (dominant + 2) % 3;
-        int dimX = dimensions[x], dimY = dimensions[y], dimZ = dimensions[z];
-        int incX = increments[x], incY = increments[y], incZ = increments[z];
-        int sX = 1, sY = 1, sZ = 1;
-        qptrdiff startDelta = 0;
-        if (forward.x < 0.0)
-        {
-            startDelta += incX * (dimX - 1);
-//             incX = -incX;
-            forward.x = -forward.x;
-            sX = -1;
-        }
-        if (forward.y < 0.0)
+        int finishedDirections;
+        m_tasksMutex.lock();
+        while (m_numberOfDirectionsInProgress >= MaximumNumberOfDirectionsInProgress && !m_stopped)
         {
-            startDelta += incY * (dimY - 1);
-//             incY = -incY;
-            forward.y = -forward.y;
-            sY = -1;
+            m_directionFinishedCondition.wait(&m_tasksMutex);
         }
-        if (forward.z < 0.0)
-        {
-            startDelta += incZ * (dimZ - 1);
-//             incZ = -incZ;
-            forward.z = -forward.z;
-            sZ = -1;
-        }
-        DEBUG_LOG(QString("forward = ") + forward.toString());
-        // Ara els 3 components són positius
-
-        // Llista dels vòxels que són començament de línia
-        getLineStarts(lineStarts, dimX, dimY, dimZ, forward);
-
-//         int incXYZ[3] = { incX, incY, incZ };
-        int xyz[3] = { x, y, z };
-        int sXYZ[3] = { sX, sY, sZ };
+        enqueueTasks(parameters, numberOfThreads);
+        finishedDirections = m_numberOfFinishedDirections;
+        m_tasksMutex.unlock();
 
-        // Iniciem els threads
-        for (int j = 0; j < numberOfThreads; j++)
+        if (100 * finishedDirections / nDirections != lastProgress)
         {
-            ObscuranceThread * thread = threads[j];
-            thread->setPerDirectionParameters(direction, forward, xyz, sXYZ, lineStarts, startDelta);
-            thread->start();
+            lastProgress = 100 * finishedDirections / nDirections;
+            emit progress(lastProgress);
         }
+    }
+
+    // Esperem que s'acabin totes les direccions
+    m_tasksMutex.lock();
+    m_allTasksEnqueued = true;
+    m_taskAvailableCondition.wakeAll();
+    while (m_numberOfDirectionsInProgress > 0 && !m_stopped)
+    {
+        m_directionFinishedCondition.wait(&m_tasksMutex);
+        int finishedDirections = m_numberOfFinishedDirections;
+        m_tasksMutex.unlock();
 
-        // Esperem que acabin els threads
-        for (int j = 0; j < numberOfThreads; j++)
+        if (100 * finishedDirections / nDirections != lastProgress)
         {
-            threads[j]->wait();
+            lastProgress = 100 * finishedDirections / nDirections;
+            emit progress(lastProgress);
         }
 
-        emit progress(100 * (i + 1) / nDirections);
+        m_tasksMutex.lock();
     }
+    m_tasks.clear();
+    m_tasksMutex.unlock();
 
-    // Destruïm els threads
+    // Esperem que acabin i destruïm els threads
     for (int j = 0; j < numberOfThreads; j++)
     {
+        threads[j]->wait();
         delete threads[j];
     }
+    qDeleteAll(directionParameters);
+
+    // Sumem els buffers dels threads al resultat
+    for (int j = 1; j < numberOfThreads; j++)
+    {
+        if (!m_stopped)
+        {
+            m_obscurance->add(*buffers[j]);
+        }
+        delete buffers[j];
+    }
+
     // Si han cancel·lat el procés ja podem plegar
     if (m_stopped)
     {
@@ -257,6 +245,156 @@ void ObscuranceMainThread::run()
     emit computed();
 }
 
+bool ObscuranceMainThread::takeTask(Task &task)
+{
+    QMutexLocker locker(&m_tasksMutex);
+
+    while (m_tasks.isEmpty() && !m_allTasksEnqueued && !m_stopped)
+    {
+        m_taskAvailableCondition.wait(&m_tasksMutex);
+    }
+
+    if (m_tasks.isEmpty() || m_stopped)
+    {
+        return false;
+    }
+
+    task = m_tasks.dequeue();
+    return true;
+}
+
+void ObscuranceMainThread::finishTask(const Task &task)
+{
+    QMutexLocker locker(&m_tasksMutex);
+
+    task.direction->numberOfPendingTasks--;
+    if (task.direction->numberOfPendingTasks == 0)
+    {
+        // Ja no calen els començaments de línia de la direcció
+        task.direction->lineStarts = QVector<Vector3>();
+        m_numberOfDirectionsInProgress--;
+        m_numberOfFinishedDirections++;
+        m_directionFinishedCondition.wakeAll();
+    }
+}
+
+ObscuranceMainThread::DirectionParameters* ObscuranceMainThread::getDirectionParameters(const Vector3 &direction, const int dimensions[3],
+                                                                                         const int increments[3])
+{
+    DirectionParameters *parameters = new DirectionParameters();
+    parameters->direction = direction;
+    parameters->numberOfPendingTasks = 0;
+
+    // Direcció dominant (0 = x, 1 = y, 2 = z)
+    int dominant;
+    Vector3 absDirection(qAbs(direction.x), qAbs(direction.y), qAbs(direction.z));
+    if (absDirection.x >= absDirection.y)
+    {
+        if (absDirection.x >= absDirection.z)
+        {
+            dominant = 0;
+        }
+        else
+        {
+            dominant = 2;
+        }
+    }
+    else
+    {
+        if (absDirection.y >= absDirection.z)
+        {
+            dominant = 1;
+        }
+        else
+        {
+            dominant = 2;
+        }
+    }
+
+    // Vector per avançar
+    Vector3 forward;
+    switch (dominant)
+    {
+        case 0:
+            forward = Vector3(direction.x, direction.y, direction.z);
+            break;
+        case 1:
+            forward = Vector3(direction.y, direction.z, direction.x);
+            break;
+        case 2:
+            forward = Vector3(direction.z, direction.x, direction.y);
+            break;
+    }
+    // La direcció x passa a ser 1 o -1
+    forward /= qAbs(forward.x);
+    DEBUG_LOG(QString("forward = ") + forward.toString());
+
+    // Dimensions i increments segons la direcció dominant
+    int x = dominant, y = (dominant + 1) % 3, z = (dominant + 2) % 3;
+    int dimX = dimensions[x], dimY = dimensions[y], dimZ = dimensions[z];
+    int incX = increments[x], incY = increments[y], incZ = increments[z];
+    int sX = 1, sY = 1, sZ = 1;
+    qptrdiff startDelta = 0;
+    if (forward.x < 0.0)
+    {
+        startDelta += incX * (dimX - 1);
+        forward.x = -forward.x;
+        sX = -1;
+    }
+    if (forward.y < 0.0)
+    {
+        startDelta += incY * (dimY - 1);
+        forward.y = -forward.y;
+        sY = -1;
+    }
+    if (forward.z < 0.0)
+    {
+        startDelta += incZ * (dimZ - 1);
+        forward.z = -forward.z;
+        sZ = -1;
+    }
+    DEBUG_LOG(QString("forward = ") + forward.toString());
+    // Ara els 3 components són positius
+
+    // Llista dels vòxels que són començament de línia
+    getLineStarts(parameters->lineStarts, dimX, dimY, dimZ, forward);
+
+    parameters->forward = forward;
+    parameters->xyz[0] = x; parameters->xyz[1] = y; parameters->xyz[2] = z;
+    parameters->sXYZ[0] = sX; parameters->sXYZ[1] = sY; parameters->sXYZ[2] = sZ;
+    parameters->startDelta = startDelta;
+
+    return parameters;
+}
+
+void ObscuranceMainThread::enqueueTasks(DirectionParameters *parameters, int numberOfThreads)
+{
+    // Trossos prou petits perquè els threads que acaben abans en puguin agafar d'altres, però prou grans perquè la cua no sigui un coll d'ampolla
+    const int ChunksPerThread = 16;
+    int nLineStarts = parameters->lineStarts.size();
+    int chunkSize = qMax(1, nLineStarts / (numberOfThreads * ChunksPerThread));
+
+    for (int first = 0; first < nLineStarts; first += chunkSize)
+    {
+        Task task;
+        task.direction = parameters;
+        task.firstLineStart = first;
+        task.endLineStart = qMin(first + chunkSize, nLineStarts);
+        m_tasks.enqueue(task);
+        parameters->numberOfPendingTasks++;
+    }
+
+    if (parameters->numberOfPendingTasks > 0)
+    {
+        m_numberOfDirectionsInProgress++;
+        m_taskAvailableCondition.wakeAll();
+    }
+    else
+    {
+        m_numberOfFinishedDirections++;
+    }
+}
+
 void ObscuranceMainThread::getLineStarts(QVector<Vector3> &lineStarts, int dimX, int dimY, int dimZ, const Vector3 &forward)
 {
     lineStarts.resize(0);
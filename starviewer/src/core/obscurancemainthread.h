@@ -17,7 +17,10 @@
 
 #include <QThread>
 
+#include <QMutex>
+#include <QQueue>
 #include <QVector>
+#include <QWaitCondition>
 
 #include "obscurance.h"
 #include "transferfunction.h"
@@ -28,6 +31,11 @@ namespace udg {
 
 /**
     Thread principal per al càlcul d'obscurances. Controla els altres threads.
+
+    Els threads treballadors són persistents durant tot el càlcul. El thread principal prepara les direccions una a una i les divideix en tasques (rangs
+    de línies) que posa en una cua compartida, d'on els treballadors les agafen a mesura que acaben les anteriors. Així no cal esperar que acabi una
+    direcció per començar la següent i les línies llargues no desequilibren la càrrega. Com que línies de direccions diferents poden passar pels mateixos
+    vòxels, cada treballador acumula les obscurances en un buffer propi i al final se sumen tots.
   */
 class ObscuranceMainThread : public QThread {
 Q_OBJECT
@@ -40,6 +48,23 @@ public:
     /// Variants de les obscurances.
     enum Variant { Density, DensitySmooth, Opacity, OpacitySmooth, OpacitySaliency, OpacitySmoothSaliency, OpacityColorBleeding, OpacitySmoothColorBleeding };
 
+    /// Paràmetres d'una direcció, compartits per totes les seves tasques.
+    struct DirectionParameters
+    {
+        Vector3 direction, forward;
+        int xyz[3], sXYZ[3];
+        QVector<Vector3> lineStarts;
+        qptrdiff startDelta;
+        /// Nombre de tasques de la direcció que encara no s'han acabat.
+        int numberOfPendingTasks;
+    };
+    /// Tasca d'un thread treballador: el rang [firstLineStart, endLineStart) de començaments de línia d'una direcció.
+    struct Task
+    {
+        DirectionParameters *direction;
+        int firstLineStart, endLineStart;
+    };
+
     static bool hasColor(Variant variant);
 
     ObscuranceMainThread(int numberOfDirections, double maximumDistance, Function function, Variant variant, bool doublePrecision = true, QObject *parent = 0);
@@ -52,6 +77,12 @@ public:
 
     Obscurance* getObscurance() const;
 
+    /// Agafa la següent tasca de la cua, esperant si encara no n'hi ha cap. Retorna fals quan ja no hi haurà més tasques o s'ha aturat el càlcul.
+    /// El fan servir els threads treballadors.
+    bool takeTask(Task &task);
+    /// Indica que s'ha acabat la tasca donada. El fan servir els threads treballadors.
+    void finishTask(const Task &task);
+
 public slots:
     void stop();
 
@@ -65,6 +96,10 @@ protected:
 private:
     static void getLineStarts(QVector<Vector3> &lineStarts, int dimX, int dimY, int dimZ, const Vector3 &forward);
     QVector<Vector3> getDirections() const;
+    /// Calcula els paràmetres de la direcció donada per a un volum amb les dimensions i increments donats.
+    static DirectionParameters* getDirectionParameters(const Vector3 &direction, const int dimensions[3], const int increments[3]);
+    /// Posa a la cua les tasques de la direcció donada, repartint les línies en trossos perquè els threads s'equilibrin.
+    void enqueueTasks(DirectionParameters *parameters, int numberOfThreads);
 
 private:
     int m_numberOfDirections;
@@ -81,6 +116,21 @@ private:
 
     bool m_stopped;
 
+    /// Cua de tasques pendents.
+    QQueue<Task> m_tasks;
+    /// Cert quan ja s'han posat a la cua les tasques de totes les direccions.
+    bool m_allTasksEnqueued;
+    /// Nombre de direccions amb tasques a la cua o en procés.
+    int m_numberOfDirectionsInProgress;
+    /// Nombre de direccions acabades.
+    int m_numberOfFinishedDirections;
+    /// Protegeix la cua de tasques i els comptadors de direccions.
+    QMutex m_tasksMutex;
+    /// Es desperta quan s'afegeixen tasques a la cua o quan ja no n'hi haurà més.
+    QWaitCondition m_taskAvailableCondition;
+    /// Es desperta quan s'acaba una direcció.
+    QWaitCondition m_directionFinishedCondition;
+
 };
 
 }
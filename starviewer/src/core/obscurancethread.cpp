@@ -28,8 +28,8 @@
 
 namespace udg {
 
-ObscuranceThread::ObscuranceThread(int id, int numberOfThreads, const TransferFunction &transferFunction, QObject *parent)
- : QThread(parent), m_id(id), m_numberOfThreads(numberOfThreads), m_transferFunction(transferFunction), m_obscurance(0), m_saliency(0)
+ObscuranceThread::ObscuranceThread(int id, ObscuranceMainThread *mainThread, const TransferFunction &transferFunction, QObject *parent)
+ : QThread(parent), m_id(id), m_mainThread(mainThread), m_transferFunction(transferFunction), m_obscurance(0), m_saliency(0)
 {
 }
 
@@ -68,21 +68,40 @@ void ObscuranceThread::setSaliency(const double * saliency, double fxSaliencyA,
     m_fxSaliencyHigh = fxSaliencyHigh;
 }
 
-void ObscuranceThread::setPerDirectionParameters(const Vector3 &direction, const Vector3 &forward, const int xyz[3], const int sXYZ[3],
-                                                 const QVector<Vector3> &lineStarts, qptrdiff startDelta)
+void ObscuranceThread::run()
 {
-    m_direction = direction;
-    m_forward = forward;
-    m_xyz = xyz;
-    m_sXYZ = sXYZ;
-    m_lineStarts = lineStarts;
-    m_startDelta = startDelta;
+    DEBUG_LOG(QString("%1: run()").arg(m_id));
+
+    ObscuranceMainThread::Task task;
+    int numberOfTasks = 0;
+
+    // Processem tasques fins que no n'hi hagi més o s'aturi el càlcul
+    while (m_mainThread->takeTask(task))
+    {
+        setTask(task);
+        runTask();
+        m_mainThread->finishTask(task);
+        numberOfTasks++;
+    }
+
+    DEBUG_LOG(QString("%1: %2 tasques processades").arg(m_id).arg(numberOfTasks));
 }
 
-void ObscuranceThread::run()
+void ObscuranceThread::setTask(const ObscuranceMainThread::Task &task)
 {
-    DEBUG_LOG(QString("%1: run()").arg(m_id));
+    const ObscuranceMainThread::DirectionParameters *parameters = task.direction;
+    m_direction = parameters->direction;
+    m_forward = parameters->forward;
+    m_xyz = parameters->xyz;
+    m_sXYZ = parameters->sXYZ;
+    m_lineStarts = parameters->lineStarts;
+    m_startDelta = parameters->startDelta;
+    m_firstLineStart = task.firstLineStart;
+    m_endLineStart = task.endLineStart;
+}
 
+void ObscuranceThread::runTask()
+{
     switch (m_obscuranceVariant)
     {
         case ObscuranceMainThread::Density:
@@ -125,10 +144,9 @@ void ObscuranceThread::runDensity()
     unresolvedVoxels.reserve(dimX);
 
     const ushort *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLineStart; j < m_endLineStart; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -197,10 +215,9 @@ void ObscuranceThread::runDensitySmooth()
     QLinkedList<QPair<ushort, Vector3> > postponedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLineStart; j < m_endLineStart; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -347,10 +364,9 @@ void ObscuranceThread::runOpacity()
     QStack<QPair<double, Vector3> > unresolvedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLineStart; j < m_endLineStart; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -416,10 +432,9 @@ void ObscuranceThread::runOpacitySmooth()
     QLinkedList<QPair<double, Vector3> > postponedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLineStart; j < m_endLineStart; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -567,10 +582,9 @@ void ObscuranceThread::runOpacitySaliency()
     QStack<QPair<double, Vector3> > unresolvedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLineStart; j < m_endLineStart; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -637,10 +651,9 @@ void ObscuranceThread::runOpacitySmoothSaliency()
     QLinkedList<QPair<double, Vector3> > postponedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLineStart; j < m_endLineStart; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -805,10 +818,9 @@ void ObscuranceThread::runOpacityColorBleeding()
     QLinkedList<QPair<double, Vector3> > postponedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLineStart; j < m_endLineStart; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -960,11 +972,10 @@ void ObscuranceThread::runOpacitySmoothColorBleeding()
     QLinkedList<QPair<double, Vector3> > postponedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    const int nLineStarts = m_lineStarts.size();
 
     // u és el tapat, v és el que tapa
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLineStart; j < m_endLineStart; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -32,23 +32,25 @@ class Obscurance;
 /**
     Thread que implementa els mètodes de càlcul d'obscurances.
 
+    És un treballador persistent: agafa tasques (un rang de línies d'una direcció) de la cua compartida del thread principal fins que no n'hi ha més, i
+    acumula les obscurances al seu propi buffer.
+
     \author Grup de Gràfics de Girona (GGG) <vismed@ima.udg.edu>
   */
 class ObscuranceThread : public QThread {
 Q_OBJECT
 
 public:
-    ObscuranceThread(int id, int numberOfThreads, const TransferFunction &transferFunction, QObject *parent = 0);
+    ObscuranceThread(int id, ObscuranceMainThread *mainThread, const TransferFunction &transferFunction, QObject *parent = 0);
     virtual ~ObscuranceThread();
 
     /// Assigna l'estimador del gradient, d'on es treuran les normals.
     void setGradientEstimator(vtkEncodedGradientEstimator *gradientEstimator);
     void setData(const ushort *data, int dataSize, const int dimensions[3], const int increments[3]);
+    /// Assigna els paràmetres de les obscurances. Les obscurances s'acumulen a \a obscurance, que no pot compartir amb cap altre thread.
     void setObscuranceParameters(double obscuranceMaximumDistance, ObscuranceMainThread::Function obscuranceFunction,
                                  ObscuranceMainThread::Variant obscuranceVariant, Obscurance *obscurance);
     void setSaliency(const double *saliency, double fxSaliencyA, double fxSaliencyB, double fxSaliencyLow, double fxSaliencyHigh);
-    void setPerDirectionParameters(const Vector3 &direction, const Vector3 &forward, const int xyz[3], const int sXYZ[3],
-                                   const QVector<Vector3> &lineStarts, qptrdiff startDelta);
 
 protected:
     virtual void run();
@@ -58,6 +60,10 @@ private:
     typedef ObscuranceMainThread::Function Function;
     typedef ObscuranceMainThread::Variant Variant;
 
+    /// Assigna els paràmetres de la direcció i el rang de línies de la tasca.
+    void setTask(const ObscuranceMainThread::Task &task);
+    /// Calcula les obscurances de la tasca actual segons la variant.
+    void runTask();
     void runDensity();
     void runDensitySmooth();
     void runOpacity();
@@ -69,7 +75,8 @@ private:
     double obscurance(double distance) const;
     bool smoothBlocking(const Vector3 &blocking, const Vector3 &blocked, double distance, const float *blockedGradient) const;
 
-    int m_id, m_numberOfThreads;
+    int m_id;
+    ObscuranceMainThread *m_mainThread;
     const TransferFunction &m_transferFunction;
     vtkDirectionEncoder *m_directionEncoder;
     const ushort *m_encodedNormals;
@@ -90,6 +97,8 @@ private:
     const int *m_sXYZ;
     QVector<Vector3> m_lineStarts;
     qptrdiff m_startDelta;
+    /// Rang [m_firstLineStart, m_endLineStart) de començaments de línia de la tasca actual.
+    int m_firstLineStart, m_endLineStart;
 
 };
 
@@ -29,6 +29,7 @@ OrderImagesFillerStep::OrderImagesFillerStep()
 {
     m_requiredLabelsList << "ImageFillerStep";
     m_priority = HighPriority;
+    m_requiresPixelData = false;
 }
 
 OrderImagesFillerStep::~OrderImagesFillerStep()
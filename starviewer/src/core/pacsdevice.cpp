@@ -24,6 +24,7 @@ PacsDevice::PacsDevice()
 {
     m_queryRetrieveServicePort = -1;
     m_storeServicePort = -1;
+    m_numberOfStoreServiceAssociations = 1;
 }
 
 void PacsDevice::setAddress(const QString &address)
@@ -166,6 +167,16 @@ int PacsDevice::getStoreServicePort() const
     return m_storeServicePort;
 }
 
+void PacsDevice::setNumberOfStoreServiceAssociations(int numberOfStoreServiceAssociations)
+{
+    m_numberOfStoreServiceAssociations = numberOfStoreServiceAssociations;
+}
+
+int PacsDevice::getNumberOfStoreServiceAssociations() const
+{
+    return m_numberOfStoreServiceAssociations;
+}
+
 bool PacsDevice::isEmpty() const
 {
     if (m_AETitle.isEmpty() &&
@@ -201,7 +212,8 @@ bool PacsDevice::operator ==(const PacsDevice &device) const
         && m_isQueryRetrieveServiceEnabled == device.m_isQueryRetrieveServiceEnabled
         && m_queryRetrieveServicePort == device.m_queryRetrieveServicePort
         && m_isStoreServiceEnabled == device.m_isStoreServiceEnabled
-        && m_storeServicePort == device.m_storeServicePort;
+        && m_storeServicePort == device.m_storeServicePort
+        && m_numberOfStoreServiceAssociations == device.m_numberOfStoreServiceAssociations;
 }
 
 QString PacsDevice::getKeyName() const
@@ -89,6 +89,10 @@ public:
     void setStoreServicePort(int storeServicePort);
     int getStoreServicePort() const;
 
+    /// Assigna/Retorna quantes associacions s'obren en paral·lel per enviar imatges al PACS. Per defecte 1.
+    void setNumberOfStoreServiceAssociations(int numberOfStoreServiceAssociations);
+    int getNumberOfStoreServiceAssociations() const;
+
     /// Ens diu si aquest objecte conté dades o no
     bool isEmpty() const;
 
@@ -115,6 +119,7 @@ private:
     bool m_isQueryRetrieveServiceEnabled;
     bool m_isStoreServiceEnabled;
     int m_storeServicePort;
+    int m_numberOfStoreServiceAssociations;
 };
 
 }
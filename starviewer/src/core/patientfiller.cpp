@@ -14,12 +14,19 @@
 
 #include "patientfiller.h"
 
+#include <QMutex>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 #include <QTime>
+#include <QVector>
+#include <QWaitCondition>
 #include <QtAlgorithms>
 
 #include "patientfillerinput.h"
 #include "logging.h"
 #include "dicomtagreader.h"
+#include "coresettings.h"
 
 // TODO Include's temporals mentre no tenim un registre:
 #include "imagefillerstep.h"
@@ -35,6 +42,79 @@
 
 namespace udg {
 
+namespace {
+
+// Maximum number of files read ahead of the one being processed per reading thread, so that the read files don't pile up in memory
+const int MaximumFilesReadAheadPerThread = 16;
+
+// State shared between the threads that read the files and the thread that processes them.
+struct ParallelReadingState
+{
+    QStringList files;
+    DICOMTagReader::ReadMode readMode;
+    // Read files not yet processed, indexed as files
+    QVector<DICOMTagReader*> readFiles;
+    int nextFileToRead;
+    int nextFileToProcess;
+    int maximumFilesReadAhead;
+    QMutex mutex;
+    // Woken each time a file has been read
+    QWaitCondition fileReadCondition;
+    // Woken each time a file has been taken for processing
+    QWaitCondition fileTakenCondition;
+};
+
+// Worker function for the parallel reading. Takes the next file to read until there are no more files left, waiting while it's too far ahead of the
+// processing.
+void readDICOMFiles(ParallelReadingState *state)
+{
+    forever
+    {
+        int fileIndex;
+        {
+            QMutexLocker locker(&state->mutex);
+
+            while (state->nextFileToRead < state->files.count() &&
+                   state->nextFileToRead >= state->nextFileToProcess + state->maximumFilesReadAhead)
+            {
+                state->fileTakenCondition.wait(&state->mutex);
+            }
+
+            if (state->nextFileToRead >= state->files.count())
+            {
+                return;
+            }
+
+            fileIndex = state->nextFileToRead++;
+        }
+
+        DICOMTagReader *dicomTagReader = new DICOMTagReader(state->files.at(fileIndex), state->readMode);
+
+        QMutexLocker locker(&state->mutex);
+        state->readFiles[fileIndex] = dicomTagReader;
+        state->fileReadCondition.wakeAll();
+    }
+}
+
+// Runs readDICOMFiles() in a thread of the pool where it's started.
+class DICOMFilesReader : public QRunnable {
+public:
+    DICOMFilesReader(ParallelReadingState *state)
+        : m_state(state)
+    {
+    }
+
+    virtual void run()
+    {
+        readDICOMFiles(m_state);
+    }
+
+private:
+    ParallelReadingState *m_state;
+};
+
+}
+
 PatientFiller::PatientFiller(DICOMSource dicomSource, QObject *parent)
  : QObject(parent)
 {
@@ -42,6 +122,12 @@ PatientFiller::PatientFiller(DICOMSource dicomSource, QObject *parent)
     m_patientFillerInput = new PatientFillerInput();
     m_imageCounter = 0;
 
+    m_numberOfReadingThreads = Settings().getValue(CoreSettings::NumberOfThreadsForDICOMFileReading).toInt();
+    if (m_numberOfReadingThreads <= 0)
+    {
+        m_numberOfReadingThreads = QThread::idealThreadCount();
+    }
+
     m_patientFillerInput->setDICOMSource(dicomSource);
 }
 
@@ -55,6 +141,24 @@ PatientFiller::~PatientFiller()
     delete m_patientFillerInput;
 }
 
+DICOMTagReader::ReadMode PatientFiller::getDICOMFileReadMode() const
+{
+    foreach (PatientFillerStep *fillerStep, m_registeredSteps)
+    {
+        if (fillerStep->requiresPixelData())
+        {
+            return DICOMTagReader::ReadAllData;
+        }
+    }
+
+    return DICOMTagReader::ReadHeaderOnly;
+}
+
+void PatientFiller::setNumberOfReadingThreads(int numberOfThreads)
+{
+    m_numberOfReadingThreads = qMax(1, numberOfThreads);
+}
+
 // Mètode intern per poder realitzar l'ordenació dels patientfiller
 bool patientFillerMorePriorityFirst(const PatientFillerStep *s1, const PatientFillerStep *s2)
 {
@@ -186,16 +290,18 @@ QList<Patient*> PatientFiller::processMHDFiles(const QStringList &files)
 QList<Patient*> PatientFiller::processDICOMFiles(const QStringList &files)
 {
     m_imageCounter = 0;
+    DICOMTagReader::ReadMode readMode = getDICOMFileReadMode();
 
-    foreach (const QString &dicomFile, files)
+    if (m_numberOfReadingThreads > 1 && files.count() > 1)
     {
-        DICOMTagReader *dicomTagReader = new DICOMTagReader(dicomFile);
-        if (dicomTagReader->canReadFile())
+        readAndProcessDICOMFilesInParallel(files, readMode, qMin(m_numberOfReadingThreads, files.count()));
+    }
+    else
+    {
+        foreach (const QString &dicomFile, files)
         {
-            this->processDICOMFile(dicomTagReader);
+            processReadDICOMFile(new DICOMTagReader(dicomFile, readMode));
         }
-
-        emit progress(++m_imageCounter);
     }
 
     foreach (PatientFillerStep *fillerStep, m_registeredSteps)
@@ -206,4 +312,62 @@ QList<Patient*> PatientFiller::processDICOMFiles(const QStringList &files)
     return m_patientFillerInput->getPatientsList();
 }
 
+void PatientFiller::readAndProcessDICOMFilesInParallel(const QStringList &files, DICOMTagReader::ReadMode readMode, int numberOfThreads)
+{
+    // Només la lectura i el parsejat dels fitxers es fan en paral·lel. Els steps comparteixen l'estat de l'input (pacient, estudi i sèrie actuals,
+    // números de volum...) i depenen de l'ordre dels fitxers, per això s'executen en aquest thread i en l'ordre de la llista.
+    ParallelReadingState state;
+    state.files = files;
+    state.readMode = readMode;
+    state.readFiles.fill(0, files.count());
+    state.nextFileToRead = 0;
+    state.nextFileToProcess = 0;
+    state.maximumFilesReadAhead = MaximumFilesReadAheadPerThread * numberOfThreads;
+
+    // Els workers tenen un pool propi. Aquest thread els espera bloquejat i pot ser ell mateix un thread del pool global (per exemple en una descàrrega),
+    // que podria estar ple i no arribar a començar-los mai
+    QThreadPool readersPool;
+    readersPool.setMaxThreadCount(numberOfThreads);
+    for (int i = 0; i < numberOfThreads; i++)
+    {
+        readersPool.start(new DICOMFilesReader(&state));
+    }
+
+    for (int i = 0; i < files.count(); i++)
+    {
+        DICOMTagReader *dicomTagReader;
+        {
+            QMutexLocker locker(&state.mutex);
+
+            while (!state.readFiles.at(i))
+            {
+                state.fileReadCondition.wait(&state.mutex);
+            }
+
+            dicomTagReader = state.readFiles.at(i);
+            state.readFiles[i] = 0;
+            state.nextFileToProcess = i + 1;
+            state.fileTakenCondition.wakeAll();
+        }
+
+        processReadDICOMFile(dicomTagReader);
+    }
+
+    readersPool.waitForDone();
+}
+
+void PatientFiller::processReadDICOMFile(DICOMTagReader *dicomTagReader)
+{
+    if (dicomTagReader->canReadFile())
+    {
+        this->processDICOMFile(dicomTagReader);
+    }
+    else
+    {
+        delete dicomTagReader;
+    }
+
+    emit progress(++m_imageCounter);
+}
+
 }
@@ -18,13 +18,13 @@
 #include <QStringList>
 
 #include "dicomsource.h"
+#include "dicomtagreader.h"
 
 namespace udg {
 
 class PatientFillerInput;
 class PatientFillerStep;
 class Patient;
-class DICOMTagReader;
 
 /**
     Classe que s'encarrega de "omplir" un Patient a partir de fitxers DICOM. Bàsicament té dos modes d'operació: "asíncron" i "síncron".
@@ -49,6 +49,14 @@ public:
     PatientFiller(DICOMSource dicomSource = DICOMSource(), QObject *parent = 0);
     ~PatientFiller();
 
+    /// Returns the mode in which the DICOM files to process must be read. It's DICOMTagReader::ReadHeaderOnly unless some registered step requires
+    /// the pixel data.
+    DICOMTagReader::ReadMode getDICOMFileReadMode() const;
+
+    /// Sets the number of threads used to read the files in processFiles(). With 1 the files are read sequentially. By default it's taken from the
+    /// settings.
+    void setNumberOfReadingThreads(int numberOfThreads);
+
 public slots:
     /// Processem un fitxer DICOM. Ens permet anar passant fitxers un a un i, un cop acabem, cridar el mètode finishDICOMFilesProcess
     /// per obtenir el resultat a partir del signal patientProcessed.
@@ -83,6 +91,13 @@ private:
     /// Processa els arxius assumint que aquests són DICOM i ens retorna la pertinent llista de pacients
     QList<Patient*> processDICOMFiles(const QStringList &files);
 
+    /// Llegeix els fitxers en paral·lel amb el número de threads indicat i els va processant en aquest thread en el mateix ordre que la llista, de
+    /// manera que el resultat és el mateix que processant-los seqüencialment.
+    void readAndProcessDICOMFilesInParallel(const QStringList &files, DICOMTagReader::ReadMode readMode, int numberOfThreads);
+
+    /// Processa el fitxer llegit, si és vàlid, i emet el progrés. El DICOMTagReader passa a ser propietat del PatientFiller.
+    void processReadDICOMFile(DICOMTagReader *dicomTagReader);
+
 private:
     /// Registre d'steps
     QList<PatientFillerStep*> m_registeredSteps;
@@ -93,6 +108,9 @@ private:
 
     // Contador per saber el núm. d'imatge que estem tractant.
     int m_imageCounter;
+
+    /// Number of threads used to read the files in processFiles().
+    int m_numberOfReadingThreads;
 };
 
 }
@@ -19,7 +19,7 @@
 
 namespace udg {
 
-PatientFillerStep::PatientFillerStep() : m_input(0), m_priority(NormalPriority)
+PatientFillerStep::PatientFillerStep() : m_input(0), m_priority(NormalPriority), m_requiresPixelData(true)
 {
 }
 
@@ -50,6 +50,13 @@ public:
         return m_priority;
     }
 
+    /// Returns true if the step needs the pixel data of the files it processes. Steps that only use the header return false, so that the files can be
+    /// read with DICOMTagReader::ReadHeaderOnly.
+    bool requiresPixelData() const
+    {
+        return m_requiresPixelData;
+    }
+
     /// Donat l'input, omple la part de l'estructura Patient que li pertoca a l'step. Si no és capaç de tractar el
     /// que li toca retorna fals, true altrament. S'ha d'utilitzar passant els steps individualment fitxer a fitxer.
     virtual bool fillIndividually() = 0;
@@ -82,6 +89,10 @@ protected:
     /// alguna prioritat diferent.
     PriorityFlags m_priority;
 
+    /// Indica si l'step necessita les dades de píxel dels fitxers. Per defecte es considera que sí, els steps que només fan servir la capçalera ho
+    /// han d'indicar al seu constructor.
+    bool m_requiresPixelData;
+
 };
 
 }
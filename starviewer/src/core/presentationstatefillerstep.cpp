@@ -26,6 +26,7 @@ PresentationStateFillerStep::PresentationStateFillerStep()
  : PatientFillerStep()
 {
     m_requiredLabelsList << "DICOMFileClassifierFillerStep";
+    m_requiresPixelData = false;
 }
 
 PresentationStateFillerStep::~PresentationStateFillerStep()
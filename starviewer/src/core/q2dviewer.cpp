@@ -42,6 +42,8 @@
 #include "genericvolumedisplayunithandler.h"
 #include "patientbrowsermenu.h"
 #include "voiluthelper.h"
+#include "volumepixeldata.h"
+#include "volumerepository.h"
 
 // Qt
 #include <QResizeEvent>
@@ -55,10 +57,15 @@
 #include <vtkWindowToImageFilter.h>
 #include <vtkImageActor.h>
 #include <vtkMatrix4x4.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
 
 namespace udg {
 
 const QString Q2DViewer::OverlaysDrawerGroup("Overlays");
+const int Q2DViewer::LazyOverlaysPrefetchSlices = 2;
+const int Q2DViewer::LazyOverlaysEvictionDistance = 8;
 const QString Q2DViewer::DummyVolumeObjectName("Dummy Volume");
 
 Q2DViewer::Q2DViewer(QWidget *parent)
@@ -71,6 +78,7 @@ Q2DViewer::Q2DViewer(QWidget *parent)
     m_inputFinishedCommand = NULL;
 
     connect(m_volumeReaderManager, SIGNAL(readingFinished()), SLOT(volumeReaderJobFinished()));
+    connect(m_volumeReaderManager, SIGNAL(pixelDataAvailable()), SLOT(volumeReaderPixelDataAvailable()));
     connect(m_volumeReaderManager, SIGNAL(progress(int)), m_workInProgressWidget, SLOT(updateProgress(int)));
     connect(m_patientBrowserMenu, SIGNAL(selectedVolumes(QList<Volume*>)), this, SLOT(setInputAndRender(QList<Volume*>)));
 
@@ -88,6 +96,7 @@ Q2DViewer::Q2DViewer(QWidget *parent)
     // Inicialitzem el filtre de shutter
     m_showDisplayShutters = true;
     m_overlaysAreEnabled = true;
+    m_overlaysAreLoadedLazily = false;
 }
 
 Q2DViewer::~Q2DViewer()
@@ -396,6 +405,7 @@ void Q2DViewer::setInput(Volume *volume)
     m_volumeReaderManager->cancelReading();
     deleteInputFinishedCommand();
 
+    VolumeRepository::getRepository()->countPixelDataDisplayRequest(volume);
     setNewVolumes(QList<Volume*>() << volume);
 }
 
@@ -415,12 +425,18 @@ void Q2DViewer::setInputAsynchronously(const QList<Volume *> &volumes, QViewerCo
     m_volumeReaderManager->cancelReading();
     setInputFinishedCommand(inputFinishedCommand);
 
+    foreach (Volume *volume, volumes)
+    {
+        VolumeRepository::getRepository()->countPixelDataDisplayRequest(volume);
+    }
+
     bool allowAsynchronousVolumeLoading = Settings().getValue(CoreSettings::AllowAsynchronousVolumeLoading).toBool();
     bool thereAreVolumesNotLoaded = false;
     int i = 0;
     while (i < volumes.size() && !thereAreVolumesNotLoaded)
     {
-        thereAreVolumesNotLoaded = !volumes.at(i)->isPixelDataLoaded();
+        // A volume still being read progressively by another viewer is not loaded yet
+        thereAreVolumesNotLoaded = !volumes.at(i)->isPixelDataLoaded() || !volumes.at(i)->getPixelData()->areAllSlicesReady();
         i++;
     }
     if (thereAreVolumesNotLoaded && allowAsynchronousVolumeLoading)
@@ -486,7 +502,12 @@ void Q2DViewer::loadVolumesAsynchronously(const QList<Volume*> &volumes)
 
     // TODO: De moment no tenim cap més remei que especificar un volume fals. La resta del viewer (i els que en depenen) s'esperen
     // tenir un volum carregat després de cridar a setInput.
-    // També tenim el problema de que perquè surti al menú de botó dret com a seleccionat, cal posar-li el mateix id.
+    setDummyVolumes(volumes);
+}
+
+void Q2DViewer::setDummyVolumes(const QList<Volume*> &volumes)
+{
+    // Perquè surti al menú de botó dret com a seleccionat, cal posar-li el mateix id.
     QList<Volume*> dummies;
     foreach (Volume *volume, volumes) {
         Volume *dummyVolume = getDummyVolumeFromVolume(volume);
@@ -501,15 +522,111 @@ void Q2DViewer::volumeReaderJobFinished()
 {
     if (m_volumeReaderManager->readingSuccess())
     {
-        setNewVolumesAndExecuteCommand(m_volumeReaderManager->getVolumes());
+        QList<Volume*> volumes = m_volumeReaderManager->getVolumes();
+
+        if (hasInput() && getMainInput() == volumes.first())
+        {
+            // The volumes are already being displayed because they have been loaded progressively. Their automatic VOI LUTs were computed before
+            // their pixel data was decoded.
+            updateAutomaticVoiLuts();
+            refreshProgressivelyLoadedInputs();
+        }
+        else
+        {
+            setNewVolumesAndExecuteCommand(volumes);
+        }
     }
     else
     {
+        QList<Volume*> volumes = m_volumeReaderManager->getVolumes();
+
+        if (hasInput() && getMainInput() == volumes.first())
+        {
+            // The volumes were being displayed progressively, don't keep displaying their partially decoded data
+            setDummyVolumes(volumes);
+        }
+
         setViewerStatus(LoadingError);
         m_workInProgressWidget->showError(m_volumeReaderManager->getLastErrorMessageToUser());
     }
 }
 
+void Q2DViewer::volumeReaderPixelDataAvailable()
+{
+    QList<Volume*> volumes = m_volumeReaderManager->getVolumes();
+    setNewVolumesAndExecuteCommand(volumes);
+
+    if (hasInput() && getMainInput() == volumes.first())
+    {
+        VolumePixelData *pixelData = getMainInput()->getPixelData();
+        connect(pixelData, SIGNAL(sliceReady(int)), SLOT(pixelDataSliceReady(int)), Qt::UniqueConnection);
+        connect(pixelData, SIGNAL(allSlicesReady()), SLOT(pixelDataAllSlicesReady()), Qt::UniqueConnection);
+        updateProgressiveLoadingFocusSlice();
+    }
+}
+
+void Q2DViewer::pixelDataSliceReady(int slice)
+{
+    if (!hasInput() || sender() != getMainInput()->getPixelData())
+    {
+        return;
+    }
+
+    // Other planes and slabs span several slices, so they are refreshed only when all of them are ready
+    if (getCurrentViewPlane() == OrthogonalPlane::XYPlane && !isThickSlabActive()
+        && slice == getMainInput()->getImageIndex(getCurrentSlice(), getCurrentPhase()))
+    {
+        refreshProgressivelyLoadedInputs();
+    }
+}
+
+void Q2DViewer::pixelDataAllSlicesReady()
+{
+    if (hasInput() && sender() == getMainInput()->getPixelData())
+    {
+        refreshProgressivelyLoadedInputs();
+    }
+}
+
+void Q2DViewer::updateProgressiveLoadingFocusSlice()
+{
+    if (m_volumeReaderManager->isReading() && m_volumeReaderManager->isPixelDataAvailable() && getCurrentViewPlane() == OrthogonalPlane::XYPlane)
+    {
+        m_volumeReaderManager->setFocusSlice(getMainInput()->getImageIndex(getCurrentSlice(), getCurrentPhase()));
+    }
+}
+
+void Q2DViewer::refreshProgressivelyLoadedInputs()
+{
+    foreach (Volume *volume, getInputs())
+    {
+        // The scalars are modified too so that their cached range is computed again
+        vtkDataArray *scalars = volume->getVtkData()->GetPointData()->GetScalars();
+        if (scalars)
+        {
+            scalars->Modified();
+        }
+        volume->getVtkData()->Modified();
+    }
+
+    render();
+}
+
+void Q2DViewer::updateAutomaticVoiLuts()
+{
+    for (int i = 0; i < getNumberOfInputs(); i++)
+    {
+        VolumeDisplayUnit *unit = getDisplayUnit(i);
+        VoiLutHelper().updateAutomaticPreset(unit->getVoiLutData(), unit->getVolume());
+
+        // The main unit is updated through the signal/slot connection with its VOI LUT data
+        if (unit != getMainDisplayUnit())
+        {
+            unit->setVoiLut(unit->getVoiLutData()->getCurrentPreset());
+        }
+    }
+}
+
 void Q2DViewer::setNewVolumesAndExecuteCommand(const QList<Volume*> &volumes)
 {
     try
@@ -625,12 +742,21 @@ void Q2DViewer::setNewVolumes(const QList<Volume*> &volumes, bool setViewerStatu
 void Q2DViewer::removeViewerBitmaps()
 {
     // Eliminem els bitmaps que teníem fins ara
-    foreach (DrawerBitmap *bitmap, m_viewerBitmaps)
+    foreach (const QList<DrawerBitmap*> &sliceBitmaps, m_viewerBitmaps)
     {
-        bitmap->decreaseReferenceCount();
-        delete bitmap;
+        foreach (DrawerBitmap *bitmap, sliceBitmaps)
+        {
+            bitmap->decreaseReferenceCount();
+            delete bitmap;
+        }
     }
     m_viewerBitmaps.clear();
+
+    foreach (int sliceIndex, m_imagesWithOverlaysInUse.keys())
+    {
+        releaseOverlaysOfSlice(sliceIndex);
+    }
+    m_overlaysAreLoadedLazily = false;
 }
 
 void Q2DViewer::loadOverlays(Volume *volume)
@@ -645,55 +771,137 @@ void Q2DViewer::loadOverlays(Volume *volume)
         return;
     }
 
+    if (Settings().getValue(CoreSettings::EnableQ2DViewerLazyOverlayLoading).toBool())
+    {
+        // Els overlays es carregaran a mesura que es mostrin les llesques, començant per la inicial quan es reiniciï la vista
+        m_overlaysAreLoadedLazily = true;
+        return;
+    }
+
+    int numberOfSlices = volume->getNumberOfSlicesPerPhase();
+    for (int sliceIndex = 0; sliceIndex < numberOfSlices; ++sliceIndex)
+    {
+        if (!m_viewerBitmaps.contains(sliceIndex))
+        {
+            loadOverlaysOfSlice(volume, sliceIndex);
+        }
+    }
+
+    if (!m_overlaysAreEnabled)
+    {
+        showImageOverlays(m_overlaysAreEnabled);
+    }
+}
+
+void Q2DViewer::loadOverlaysOfSlice(Volume *volume, int sliceIndex)
+{
     double volumeSpacing[3];
     volume->getSpacing(volumeSpacing);
     double volumeOrigin[3];
     volume->getOrigin(volumeOrigin);
-    
-    int numberOfSlices = volume->getNumberOfSlicesPerPhase();
+
+    QList<DrawerBitmap*> sliceBitmaps;
+    QList<QPointer<Image> > sliceImages;
     int numberOfPhases = volume->getNumberOfPhases();
-    for (int sliceIndex = 0; sliceIndex < numberOfSlices; ++sliceIndex)
+    for (int phaseIndex = 0; phaseIndex < numberOfPhases; ++ phaseIndex)
     {
-        for (int phaseIndex = 0; phaseIndex < numberOfPhases; ++ phaseIndex)
+        Image *image = volume->getImage(sliceIndex, phaseIndex);
+        if (!image)
         {
-            Image *image = volume->getImage(sliceIndex, phaseIndex);
-            if (!image)
-            {
-                ERROR_LOG(QString("Error inesperat intentant accedir a la imatge amb índexs: %1(slice), %2(phase) del volum actual")
-                    .arg(sliceIndex).arg(phaseIndex));
-                DEBUG_LOG(QString("Error inesperat intentant accedir a la imatge amb índexs: %1(slice), %2(phase) del volum actual")
-                    .arg(sliceIndex).arg(phaseIndex));
-            }
-            else
+            ERROR_LOG(QString("Error inesperat intentant accedir a la imatge amb índexs: %1(slice), %2(phase) del volum actual")
+                .arg(sliceIndex).arg(phaseIndex));
+            DEBUG_LOG(QString("Error inesperat intentant accedir a la imatge amb índexs: %1(slice), %2(phase) del volum actual")
+                .arg(sliceIndex).arg(phaseIndex));
+        }
+        else
+        {
+            if (image->hasOverlays())
             {
-                if (image->hasOverlays())
+                // Calculem l'origen del bitmap corresponent a aquesta imatge
+                double imageOrigin[3];
+                imageOrigin[0] = volumeOrigin[0];
+                imageOrigin[1] = volumeOrigin[1];
+                imageOrigin[2] = volumeOrigin[2] + sliceIndex * volumeSpacing[2];
+                // Mentre tinguem la llesca carregada cap altre visor no alliberarà els overlays llegits de la imatge
+                image->increaseOverlaysReferenceCount();
+                sliceImages << image;
+                // Creem els bitmaps
+                foreach(const ImageOverlay &overlay, image->getOverlaysSplit())
                 {
-                    // Calculem l'origen del bitmap corresponent a aquesta imatge
-                    double imageOrigin[3];
-                    imageOrigin[0] = volumeOrigin[0];
-                    imageOrigin[1] = volumeOrigin[1];
-                    imageOrigin[2] = volumeOrigin[2] + sliceIndex * volumeSpacing[2];
-                    // Creem els bitmaps
-                    foreach(const ImageOverlay &overlay, image->getOverlaysSplit())
-                    {
-                        DrawerBitmap *overlayBitmap = overlay.getAsDrawerBitmap(imageOrigin, volumeSpacing);
-                        // Inicialment no serà, segons la llesca en que ens trobem el Drawer decidirà sobre la seva visibilitat
-                        overlayBitmap->setVisibility(false);
-                        // La primitiva no es podrà esborrar amb les tools
-                        overlayBitmap->setErasable(false);
-                        overlayBitmap->increaseReferenceCount();
-                        getDrawer()->draw(overlayBitmap, OrthogonalPlane::XYPlane, sliceIndex);
-                        getDrawer()->addToGroup(overlayBitmap, OverlaysDrawerGroup);
-                        m_viewerBitmaps << overlayBitmap;
-                    }
+                    DrawerBitmap *overlayBitmap = overlay.getAsDrawerBitmap(imageOrigin, volumeSpacing);
+                    // Inicialment no serà, segons la llesca en que ens trobem el Drawer decidirà sobre la seva visibilitat
+                    overlayBitmap->setVisibility(false);
+                    // La primitiva no es podrà esborrar amb les tools
+                    overlayBitmap->setErasable(false);
+                    overlayBitmap->increaseReferenceCount();
+                    getDrawer()->draw(overlayBitmap, OrthogonalPlane::XYPlane, sliceIndex);
+                    getDrawer()->addToGroup(overlayBitmap, OverlaysDrawerGroup);
+                    sliceBitmaps << overlayBitmap;
                 }
             }
         }
     }
 
-    if (!m_overlaysAreEnabled)
+    // Hi afegim la llesca encara que no tingui overlays per no tornar-la a processar
+    m_viewerBitmaps.insert(sliceIndex, sliceBitmaps);
+    m_imagesWithOverlaysInUse.insert(sliceIndex, sliceImages);
+}
+
+void Q2DViewer::removeOverlaysOfSlice(int sliceIndex)
+{
+    foreach (DrawerBitmap *bitmap, m_viewerBitmaps.take(sliceIndex))
     {
-        showImageOverlays(m_overlaysAreEnabled);
+        bitmap->decreaseReferenceCount();
+        delete bitmap;
+    }
+
+    releaseOverlaysOfSlice(sliceIndex);
+}
+
+void Q2DViewer::releaseOverlaysOfSlice(int sliceIndex)
+{
+    // Les imatges poden haver estat esborrades si s'ha tancat el pacient
+    foreach (const QPointer<Image> &image, m_imagesWithOverlaysInUse.take(sliceIndex))
+    {
+        if (image)
+        {
+            image->decreaseOverlaysReferenceCount();
+        }
+    }
+}
+
+void Q2DViewer::updateLazilyLoadedOverlays()
+{
+    // The overlays are only drawn on the acquisition plane. While they are disabled they are not loaded, they will be when enabled again.
+    if (!m_overlaysAreLoadedLazily || !m_overlaysAreEnabled || getCurrentViewPlane() != OrthogonalPlane::XYPlane)
+    {
+        return;
+    }
+
+    Volume *volume = getMainInput();
+    int currentSlice = getCurrentSlice();
+
+    QList<int> loadedSlices = m_viewerBitmaps.keys();
+    foreach (int sliceIndex, loadedSlices)
+    {
+        if (qAbs(sliceIndex - currentSlice) > LazyOverlaysEvictionDistance)
+        {
+            removeOverlaysOfSlice(sliceIndex);
+        }
+    }
+
+    // The current slice is loaded first so that it is displayed as soon as possible
+    int numberOfSlices = volume->getNumberOfSlicesPerPhase();
+    for (int distance = 0; distance <= LazyOverlaysPrefetchSlices; ++distance)
+    {
+        int slices[2] = { currentSlice - distance, currentSlice + distance };
+        for (int i = 0; i < (distance == 0 ? 1 : 2); ++i)
+        {
+            if (slices[i] >= 0 && slices[i] < numberOfSlices && !m_viewerBitmaps.contains(slices[i]))
+            {
+                loadOverlaysOfSlice(volume, slices[i]);
+            }
+        }
     }
 }
 
@@ -974,6 +1182,9 @@ void Q2DViewer::updateSliceToDisplay(int value, SliceDimension dimension)
                 break;
         }
 
+        updateProgressiveLoadingFocusSlice();
+        updateLazilyLoadedOverlays();
+
         // Then update display (image and associated annotations)
         updateDisplayExtents();
 
@@ -1019,13 +1230,14 @@ void Q2DViewer::updateSecondaryVolumesSlices()
         return;
     }
 
-    SliceLocator sliceLocator;
-    sliceLocator.setPlane(getCurrentViewPlane());
+    ImagePlane *currentImagePlane = getCurrentImagePlane();
 
     for (int i = 1; i < getNumberOfInputs(); i++)
     {
-        sliceLocator.setVolume(getDisplayUnit(i)->getVolume());
-        int nearestSlice = sliceLocator.getNearestSlice(getCurrentImagePlane());
+        // Each display unit keeps its own slice locator, so that the index of slice positions of its volume is built only once
+        SliceLocator *sliceLocator = getDisplayUnit(i)->getSliceLocator();
+        sliceLocator->setPlane(getCurrentViewPlane());
+        int nearestSlice = sliceLocator->getNearestSlice(currentImagePlane);
 
         if (nearestSlice >= 0)
         {
@@ -1038,6 +1250,8 @@ void Q2DViewer::updateSecondaryVolumesSlices()
             getDisplayUnit(i)->setSlice(0);
         }
     }
+
+    delete currentImagePlane;
 }
 
 void Q2DViewer::setOverlapMethod(OverlapMethod method)
@@ -1745,6 +1959,12 @@ void Q2DViewer::showImageOverlays(bool enable)
     }
 
     m_overlaysAreEnabled = enable;
+
+    if (enable && hasInput())
+    {
+        // Les llesques properes a l'actual poden no tenir els overlays carregats si s'han deshabilitat mentre es canviava de llesca
+        updateLazilyLoadedOverlays();
+    }
 }
 
 void Q2DViewer::showDisplayShutters(bool enable)
@@ -20,6 +20,7 @@
 #include "anatomicalplane.h"
 
 #include <QPointer>
+#include <QMap>
 
 // Fordward declarations
 // Vtk
@@ -473,6 +474,18 @@ private:
     void loadVolumeAsynchronously(Volume *volume);
     void loadVolumesAsynchronously(const QList<Volume *> &volumes);
 
+    /// Asks the volume reader manager to decode first the slices closest to the current one, when reading progressively.
+    void updateProgressiveLoadingFocusSlice();
+
+    /// Marks the image data of the inputs as modified and renders, so that the slices decoded after they were set are displayed.
+    void refreshProgressivelyLoadedInputs();
+
+    /// Computes again the automatic VOI LUTs of the inputs, which were computed before their pixel data was decoded when loaded progressively.
+    void updateAutomaticVoiLuts();
+
+    /// Sets dummy volumes with the identifiers of the given volumes as the inputs, to be displayed while the given volumes are not available.
+    void setDummyVolumes(const QList<Volume*> &volumes);
+
     /// Retorna un volum "dummy"
     Volume* getDummyVolumeFromVolume(Volume *volume);
 
@@ -494,8 +507,18 @@ private:
     /// Elimina els bitmaps que s'hagin creat per aquest viewer
     void removeViewerBitmaps();
     
-    /// Carrega en memòria els ImageOverlays del volum passat per paràmetre (sempre que no sigui un dummy) i els afegeix al Drawer
+    /// Carrega en memòria els ImageOverlays del volum passat per paràmetre (sempre que no sigui un dummy) i els afegeix al Drawer.
+    /// Si la càrrega mandrosa d'overlays està habilitada, només es prepara el visor perquè es carreguin els de les llesques properes a la llesca actual.
     void loadOverlays(Volume *volume);
+    /// Crea els bitmaps dels overlays de totes les fases de la llesca indicada del volum i els afegeix al Drawer
+    void loadOverlaysOfSlice(Volume *volume, int sliceIndex);
+    /// Elimina els bitmaps dels overlays de la llesca indicada i deixa de fer servir els overlays llegits de les seves imatges,
+    /// que s'alliberaran si cap altre visor no els fa servir
+    void removeOverlaysOfSlice(int sliceIndex);
+    /// Deixa de fer servir els overlays llegits de les imatges de la llesca indicada
+    void releaseOverlaysOfSlice(int sliceIndex);
+    /// When overlays are loaded lazily, loads the overlays of the slices around the current one and removes the ones of the slices far from it
+    void updateLazilyLoadedOverlays();
 
     /// Enum to define the different dimensions an image slice could be associated to
     enum SliceDimension { SpatialDimension, TemporalDimension };
@@ -528,6 +551,13 @@ private slots:
 
     void volumeReaderJobFinished();
 
+    /// Displays the volumes being read progressively as soon as their pixel data is available.
+    void volumeReaderPixelDataAvailable();
+    /// Refreshes the displayed image if the given slice (z index) of the main input has been decoded and is currently visible.
+    void pixelDataSliceReady(int slice);
+    /// Refreshes the displayed image once all the slices of the main input have been decoded.
+    void pixelDataAllSlicesReady();
+
 protected:
     /// Aquest és el segon volum afegit a solapar
     Volume *m_overlayVolume;
@@ -542,6 +572,11 @@ private:
     /// Nom del grups dins del drawer per als Overlays
     static const QString OverlaysDrawerGroup;
 
+    /// When overlays are loaded lazily, number of slices on each side of the current one whose overlays are loaded in advance
+    static const int LazyOverlaysPrefetchSlices;
+    /// When overlays are loaded lazily, the overlays of slices further than this number of slices from the current one are released
+    static const int LazyOverlaysEvictionDistance;
+
     /// Constant per a definir el nom d'objecte dels volums "dummy"
     static const QString DummyVolumeObjectName;
 
@@ -574,8 +609,14 @@ private:
 
     QViewerCommand *m_inputFinishedCommand;
 
-    /// Llistat d'overlays
-    QList<DrawerBitmap*> m_viewerBitmaps;
+    /// Bitmaps dels overlays carregats, per llesca. Una llesca sense overlays que ja s'ha carregat hi té una llista buida.
+    QMap<int, QList<DrawerBitmap*> > m_viewerBitmaps;
+
+    /// Imatges de les quals fem servir els overlays llegits, per llesca. Les imatges són compartides amb altres visors.
+    QMap<int, QList<QPointer<Image> > > m_imagesWithOverlaysInUse;
+
+    /// True if the overlays of the current input are loaded lazily, only for the slices around the current one
+    bool m_overlaysAreLoadedLazily;
 
     /// Controla si els overlays estan habilitats o no
     bool m_overlaysAreEnabled;
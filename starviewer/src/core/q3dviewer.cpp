@@ -25,11 +25,14 @@
 // Include's qt
 #include <QString>
 #include <QMessageBox>
+#include <QTimer>
 
 // Include's vtk
 
 // Pel setAutomaticImageCacheEnabled
 #include <QVTKWidget.h>
+#include <vtkEventQtSlotConnect.h>
+#include <vtkRenderWindowInteractor.h>
 #include <vtkRenderer.h>
 #include <vtkRenderWindow.h>
 // Rendering 3D
@@ -70,7 +73,9 @@
 #include "directilluminationvoxelshader.h"
 #include "obscurancevoxelshader.h"
 #include "contourvoxelshader.h"
+#include "minmaxbrickgrid.h"
 #include "vtk4dlinearregressiongradientestimator.h"
+#include "volumerepository.h"
 #include <vtkPointData.h>
 #include <vtkEncodedGradientShader.h>
 
@@ -79,6 +84,11 @@
 
 namespace udg {
 
+const int Q3DViewer::InteractiveMaximumNumberOfVoxels = 4 * 1024 * 1024;
+const double Q3DViewer::ReducedImageSampleDistance = 2.0;
+const double Q3DViewer::FullImageSampleDistance = 1.0;
+const int Q3DViewer::RefinementDelay = 100;
+
 Q3DViewer::Q3DViewer(QWidget *parent)
  : QViewer(parent), m_imageData(0), m_vtkVolume(0), m_volumeProperty(0), m_clippingPlanes(0)
 {
@@ -158,6 +168,30 @@ Q3DViewer::Q3DViewer(QWidget *parent)
     m_volumeRayCastDirectIlluminationContourObscuranceFunction->SetVoxelShader(m_directIlluminationContourObscuranceVoxelShader);
     m_volumeRayCastIsosurfaceFunction = vtkVolumeRayCastIsosurfaceFunction::New();
 
+    m_minMaxBrickGrid = new MinMaxBrickGrid();
+    m_volumeRayCastAmbientContourFunction->SetMinMaxBrickGrid(m_minMaxBrickGrid);
+    m_volumeRayCastDirectIlluminationContourFunction->SetMinMaxBrickGrid(m_minMaxBrickGrid);
+    m_volumeRayCastAmbientObscuranceFunction->SetMinMaxBrickGrid(m_minMaxBrickGrid);
+    m_volumeRayCastDirectIlluminationObscuranceFunction->SetMinMaxBrickGrid(m_minMaxBrickGrid);
+    m_volumeRayCastAmbientContourObscuranceFunction->SetMinMaxBrickGrid(m_minMaxBrickGrid);
+    m_volumeRayCastDirectIlluminationContourObscuranceFunction->SetMinMaxBrickGrid(m_minMaxBrickGrid);
+
+    // Nivells de detall: mentre s'interactua es renderitza amb un mapper a part que fa servir un volum reduït
+    m_levelOfDetailEnabled = false;
+    m_levelOfDetail = FullLevelOfDetail;
+    m_interactiveShrinkFactor = 1;
+    m_interactiveImageData = 0;
+    m_interactiveVolumeRayCastFunction = vtkVolumeRayCastCompositeFunction::New();
+    m_interactiveVolumeRayCastFunction->SetCompositeMethodToClassifyFirst();
+    m_interactiveVolumeMapper = vtkVolumeRayCastMapper::New();
+    m_interactiveVolumeMapper->SetVolumeRayCastFunction(m_interactiveVolumeRayCastFunction);
+    m_interactiveVolumeMapper->SetMinimumImageSampleDistance(ReducedImageSampleDistance);
+    m_refinementTimer = new QTimer(this);
+    m_refinementTimer->setSingleShot(true);
+    m_refinementTimer->setInterval(RefinementDelay);
+    connect(m_refinementTimer, SIGNAL(timeout()), SLOT(refineRendering()));
+    m_vtkQtConnections->Connect(getRenderWindow(), vtkCommand::StartEvent, this, SLOT(updateLevelOfDetail()));
+
     m_contourOn = false;
 
     m_firstRender = true;
@@ -174,6 +208,8 @@ Q3DViewer::Q3DViewer(QWidget *parent)
 
 Q3DViewer::~Q3DViewer()
 {
+    m_vtkQtConnections->Disconnect(getRenderWindow(), vtkCommand::StartEvent);
+
     /// \todo falta revisar què falta per destruir
     if (m_obscuranceMainThread && m_obscuranceMainThread->isRunning())
     {
@@ -193,6 +229,7 @@ Q3DViewer::~Q3DViewer()
     delete m_directIlluminationObscuranceVoxelShader;
     delete m_ambientContourObscuranceVoxelShader;
     delete m_directIlluminationContourObscuranceVoxelShader;
+    delete m_minMaxBrickGrid;
 
     // Eliminem tots els elements vtk creats
     if (m_4DLinearRegressionGradientEstimator)
@@ -203,6 +240,18 @@ Q3DViewer::~Q3DViewer()
     {
         m_imageData->Delete();
     }
+    if (m_interactiveImageData)
+    {
+        m_interactiveImageData->Delete();
+    }
+    if (m_interactiveVolumeMapper)
+    {
+        m_interactiveVolumeMapper->Delete();
+    }
+    if (m_interactiveVolumeRayCastFunction)
+    {
+        m_interactiveVolumeRayCastFunction->Delete();
+    }
     if (m_vtkVolume)
     {
         m_vtkVolume->Delete();
@@ -273,6 +322,7 @@ void Q3DViewer::setClippingPlanes(vtkPlanes *clippingPlanes)
         m_clippingPlanes = clippingPlanes;
         m_clippingPlanes->Register(0);
         m_volumeMapper->SetClippingPlanes(m_clippingPlanes);
+        m_interactiveVolumeMapper->SetClippingPlanes(m_clippingPlanes);
         m_gpuRayCastMapper->SetClippingPlanes(m_clippingPlanes);
     }
     else
@@ -392,6 +442,7 @@ void Q3DViewer::setInput(Volume *volume)
     // És necessari indicar que l'estat és VisualizingVolume, sinó el visor no s'actualitzarà correctament 
     // quan volguem fer canvis de window/level, zoom, moure, etc. ja que és condició necessària per dur a terme el render.
     setViewerStatus(VisualizingVolume);
+    VolumeRepository::getRepository()->countPixelDataDisplayRequest(volume);
     if (!checkInputVolume(volume))
     {
         unsetCursor();
@@ -407,6 +458,7 @@ void Q3DViewer::setInput(Volume *volume)
     if (m_clippingPlanes)
     {
         m_volumeMapper->RemoveAllClippingPlanes();
+        m_interactiveVolumeMapper->RemoveAllClippingPlanes();
         m_gpuRayCastMapper->RemoveAllClippingPlanes();
         m_clippingPlanes->Delete();
         m_clippingPlanes = 0;
@@ -421,6 +473,38 @@ void Q3DViewer::setInput(Volume *volume)
     unsigned short *data = reinterpret_cast<unsigned short*>(m_imageData->GetPointData()->GetScalars()->GetVoidPointer(0));
     m_ambientVoxelShader->setData(data, static_cast<unsigned short>(m_range));
     m_directIlluminationVoxelShader->setData(data, static_cast<unsigned short>(m_range));
+    m_minMaxBrickGrid->setData(data, m_imageData->GetDimensions());
+
+    // El volum reduït es crearà quan es comenci a interactuar
+    resetLevelOfDetail();
+    if (m_interactiveImageData)
+    {
+        m_interactiveImageData->Delete();
+        m_interactiveImageData = 0;
+    }
+    m_interactiveVolumeMapper->SetInputData(m_imageData);
+    m_levelOfDetailEnabled = Settings().getValue(CoreSettings::EnableQ3DViewerInteractiveLevelOfDetail).toBool();
+
+    // Factor de reducció del volum per interactuar: com en una piràmide, anem dividint cada dimensió per 2 fins que té prou pocs vòxels
+    int *imageDimensions = m_imageData->GetDimensions();
+    m_interactiveShrinkFactor = 1;
+    forever
+    {
+        int factor = m_interactiveShrinkFactor * 2;
+        if (imageDimensions[0] < 2 * factor || imageDimensions[1] < 2 * factor || imageDimensions[2] < 2 * factor)
+        {
+            break;
+        }
+
+        double numberOfVoxels = static_cast<double>(imageDimensions[0] / m_interactiveShrinkFactor) * (imageDimensions[1] / m_interactiveShrinkFactor) *
+                                (imageDimensions[2] / m_interactiveShrinkFactor);
+        if (numberOfVoxels <= InteractiveMaximumNumberOfVoxels)
+        {
+            break;
+        }
+
+        m_interactiveShrinkFactor = factor;
+    }
 
     if (m_obscuranceMainThread && m_obscuranceMainThread->isRunning())
     {
@@ -450,6 +534,8 @@ void Q3DViewer::applyCurrentRenderingMethod()
 {
     if (hasInput())
     {
+        resetLevelOfDetail();
+
         switch (m_renderFunction)
         {
             case Contouring:
@@ -503,6 +589,7 @@ void Q3DViewer::setTransferFunction(const TransferFunction &transferFunction)
     m_volumeProperty->SetColor(m_transferFunction.vtkColorTransferFunction());
     m_ambientVoxelShader->setTransferFunction(m_transferFunction);
     m_directIlluminationVoxelShader->setTransferFunction(m_transferFunction);
+    m_minMaxBrickGrid->setTransferFunction(m_transferFunction);
 
     if (m_volumeProperty->GetShade())
     {
@@ -1213,4 +1300,139 @@ bool Q3DViewer::isSupportedVolume(Volume *volume)
     return volume->getNumberOfScalarComponents() == 1 && range[1] > range[0];
 }
 
+bool Q3DViewer::canUseLevelOfDetail() const
+{
+    if (!m_levelOfDetailEnabled || !m_imageData)
+    {
+        return false;
+    }
+
+    if (m_renderFunction != RayCasting && m_renderFunction != RayCastingObscurance)
+    {
+        return false;
+    }
+
+    // Només quan el volum es renderitza amb el ray casting amb CPU
+    vtkAbstractVolumeMapper *mapper = m_vtkVolume->GetMapper();
+    return mapper == m_volumeMapper || mapper == m_interactiveVolumeMapper;
+}
+
+void Q3DViewer::applyLevelOfDetail(LevelOfDetail levelOfDetail)
+{
+    switch (levelOfDetail)
+    {
+        case InteractiveLevelOfDetail:
+        {
+            // Volum reduït amb vòxel més proper i menys raigs. La distància entre mostres s'escala amb els vòxels perquè n'hi hagi les mateixes
+            // per vòxel.
+            vtkImageData *interactiveImageData = getInteractiveImageData();
+            m_interactiveVolumeMapper->SetInputData(interactiveImageData);
+            m_interactiveVolumeMapper->SetSampleDistance(m_volumeMapper->GetSampleDistance() * m_interactiveShrinkFactor);
+            m_vtkVolume->SetMapper(m_interactiveVolumeMapper);
+            m_volumeProperty->SetInterpolationTypeToNearest();
+            break;
+        }
+
+        case IntermediateLevelOfDetail:
+            m_vtkVolume->SetMapper(m_volumeMapper);
+            m_volumeProperty->SetInterpolationTypeToLinear();
+            m_volumeMapper->SetMinimumImageSampleDistance(ReducedImageSampleDistance);
+            break;
+
+        case FullLevelOfDetail:
+            m_vtkVolume->SetMapper(m_volumeMapper);
+            m_volumeProperty->SetInterpolationTypeToLinear();
+            m_volumeMapper->SetMinimumImageSampleDistance(FullImageSampleDistance);
+            break;
+    }
+
+    m_levelOfDetail = levelOfDetail;
+}
+
+void Q3DViewer::resetLevelOfDetail()
+{
+    m_refinementTimer->stop();
+    m_volumeMapper->SetMinimumImageSampleDistance(FullImageSampleDistance);
+    m_levelOfDetail = FullLevelOfDetail;
+}
+
+vtkImageData* Q3DViewer::getInteractiveImageData()
+{
+    if (m_interactiveShrinkFactor > 1 && !m_interactiveImageData)
+    {
+        vtkImageShrink3D *shrink = vtkImageShrink3D::New();
+        shrink->SetInputData(m_imageData);
+        shrink->SetShrinkFactors(m_interactiveShrinkFactor, m_interactiveShrinkFactor, m_interactiveShrinkFactor);
+        shrink->MeanOn();
+
+        try
+        {
+            shrink->Update();
+            m_interactiveImageData = shrink->GetOutput();
+            m_interactiveImageData->Register(0);
+        }
+        catch (std::bad_alloc &e)
+        {
+            // Es continuarà interactuant amb el volum complet
+            ERROR_LOG(QString("Excepció al voler crear el volum reduït per interactuar: ") + e.what());
+            m_interactiveShrinkFactor = 1;
+        }
+
+        shrink->Delete();
+    }
+
+    return m_interactiveImageData ? m_interactiveImageData : m_imageData;
+}
+
+void Q3DViewer::updateLevelOfDetail()
+{
+    if (!canUseLevelOfDetail())
+    {
+        return;
+    }
+
+    if (isInteracting())
+    {
+        // El refinament començarà quan faci RefinementDelay ms que no hi ha cap render interactiu
+        applyLevelOfDetail(InteractiveLevelOfDetail);
+        m_refinementTimer->start();
+    }
+    else if (m_levelOfDetail == InteractiveLevelOfDetail)
+    {
+        // En acabar la interacció es fa un primer pas amb el volum complet i després es refina fins a la qualitat final
+        applyLevelOfDetail(IntermediateLevelOfDetail);
+        m_refinementTimer->start();
+    }
+}
+
+void Q3DViewer::refineRendering()
+{
+    if (m_levelOfDetail == FullLevelOfDetail || !canUseLevelOfDetail() || isInteracting())
+    {
+        return;
+    }
+
+    LevelOfDetail previousLevelOfDetail = m_levelOfDetail;
+    applyLevelOfDetail(previousLevelOfDetail == InteractiveLevelOfDetail ? IntermediateLevelOfDetail : FullLevelOfDetail);
+    render();
+
+    if (getRenderWindow()->GetAbortRender())
+    {
+        // AbortRenderCommand avorta el render si hi ha events pendents. En aquest cas es manté la imatge anterior i es torna a refinar més tard,
+        // si abans no es torna a interactuar.
+        applyLevelOfDetail(previousLevelOfDetail);
+        m_refinementTimer->start();
+    }
+    else if (m_levelOfDetail != FullLevelOfDetail)
+    {
+        m_refinementTimer->start();
+    }
+}
+
+bool Q3DViewer::isInteracting()
+{
+    // Mentre s'interactua, els tools i l'interactor style demanen un ritme d'actualització més alt que l'estàtic
+    return getRenderWindow()->GetDesiredUpdateRate() > getInteractor()->GetStillUpdateRate();
+}
+
 };  // End namespace udg {
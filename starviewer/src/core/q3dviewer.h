@@ -23,6 +23,7 @@
 
 // FWD declarations
 
+class QTimer;
 class vtkImageData;
 class vtkOpenGLGPUVolumeRayCastMapper;
 class vtkVolume;
@@ -43,6 +44,7 @@ class ObscuranceVoxelShader;
 class Vtk4DLinearRegressionGradientEstimator;
 class Obscurance;
 class ContourVoxelShader;
+class MinMaxBrickGrid;
 
 /**
     Classe base per als visualitzadors 3D
@@ -196,11 +198,45 @@ private slots:
     // TODO falta documentar el mètode
     void endComputeObscurance();
 
+    /// Abans de cada render, tria el nivell de detall del ray casting segons si l'usuari està interactuant o no.
+    void updateLevelOfDetail();
+
+    /// Fa el següent pas del refinament progressiu fins a la qualitat final.
+    void refineRendering();
+
 protected:
     /// La funció que es fa servir pel rendering
     RenderFunction m_renderFunction;
 
 private:
+    /// Nivells de detall del ray casting amb CPU: reduït mentre s'interactua, intermedi com a primer pas del refinament i qualitat final.
+    enum LevelOfDetail { InteractiveLevelOfDetail, IntermediateLevelOfDetail, FullLevelOfDetail };
+
+    /// Retorna cert si el mètode de rendering actual pot fer servir nivells de detall.
+    bool canUseLevelOfDetail() const;
+
+    /// Configura el volum, el mapper i les propietats per renderitzar amb el nivell de detall donat.
+    void applyLevelOfDetail(LevelOfDetail levelOfDetail);
+
+    /// Torna a la qualitat final i atura el refinament pendent. No canvia el mapper del volum.
+    void resetLevelOfDetail();
+
+    /// Retorna el volum reduït que es fa servir mentre s'interactua, i el crea si cal.
+    vtkImageData* getInteractiveImageData();
+
+    /// Retorna cert si l'usuari està interactuant amb el visor.
+    bool isInteracting();
+
+private:
+    /// Nombre màxim de vòxels del volum reduït que es fa servir mentre s'interactua.
+    static const int InteractiveMaximumNumberOfVoxels;
+    /// Distància mínima entre els píxels on es llancen raigs mentre s'interactua i en el pas intermedi del refinament.
+    static const double ReducedImageSampleDistance;
+    /// Distància mínima entre els píxels on es llancen raigs amb la qualitat final.
+    static const double FullImageSampleDistance;
+    /// Temps en mil·lisegons entre els passos del refinament.
+    static const int RefinementDelay;
+
     /// La imatge d'entrada dels mappers.
     vtkImageData *m_imageData;
 
@@ -246,6 +282,23 @@ private:
     vtkVolumeRayCastSingleVoxelShaderCompositeFunction<DirectIlluminationContourObscuranceVoxelShader> *m_volumeRayCastDirectIlluminationContourObscuranceFunction;
     vtkVolumeRayCastIsosurfaceFunction *m_volumeRayCastIsosurfaceFunction;
 
+    /// Graella de bricks amb el mínim i el màxim de m_imageData, per saltar l'espai buit en les funcions de ray cast amb voxel shaders.
+    MinMaxBrickGrid *m_minMaxBrickGrid;
+
+    /// Indica si es fan servir nivells de detall amb el ray casting amb CPU.
+    bool m_levelOfDetailEnabled;
+    /// Nivell de detall amb què s'està renderitzant.
+    LevelOfDetail m_levelOfDetail;
+    /// Factor de reducció de cada dimensió del volum que es fa servir mentre s'interactua. Si és 1 es fa servir m_imageData.
+    int m_interactiveShrinkFactor;
+    /// Volum reduït que es fa servir mentre s'interactua. Es crea la primera vegada que cal.
+    vtkImageData *m_interactiveImageData;
+    /// Mapper i funció de ray cast que es fan servir mentre s'interactua.
+    vtkVolumeRayCastMapper *m_interactiveVolumeMapper;
+    vtkVolumeRayCastCompositeFunction *m_interactiveVolumeRayCastFunction;
+    /// Temporitzador dels passos del refinament.
+    QTimer *m_refinementTimer;
+
     /// Current transfer function.
     TransferFunction m_transferFunction;
 
@@ -15,7 +15,8 @@
 #include "roidata.h"
 
 #include <QtCore/qmath.h>
-#include <cfloat>
+
+#include "logging.h"
 
 namespace udg {
 
@@ -30,11 +31,17 @@ ROIData::~ROIData()
 
 void ROIData::clear()
 {
-    m_voxels.clear();
-    m_statisticsAreOutdated = false;
-    m_mean = 0.0;
-    m_standardDeviation = 0.0;
+    m_numberOfVoxels = 0;
+    m_sum = 0.0;
+    m_runningMean = 0.0;
+    m_runningSumOfSquaredDeviations = 0.0;
+    m_sumOfSquaredDeviations = 0.0;
+    m_numberOfDeviations = 0;
+    m_minimum = 0.0;
     m_maximum = 0.0;
+    m_histogram.clear();
+    m_histogramMinimum = 0.0;
+    m_histogramMaximum = 0.0;
     m_units = "";
     m_modality = "";
 }
@@ -43,105 +50,127 @@ void ROIData::addVoxel(const Voxel &voxel)
 {
     if (!voxel.isEmpty())
     {
-        m_voxels << voxel;
-        m_statisticsAreOutdated = true;
+        addValue(voxel.getComponent(0));
     }
 }
 
-double ROIData::getMean()
+void ROIData::addValue(double value)
 {
-    computeStatistics();
-    return m_mean;
+    ++m_numberOfVoxels;
+    m_sum += value;
+
+    // Welford's update of the running mean and squared deviations
+    double delta = value - m_runningMean;
+    m_runningMean += delta / m_numberOfVoxels;
+    m_runningSumOfSquaredDeviations += delta * (value - m_runningMean);
+
+    if (m_numberOfVoxels == 1 || value < m_minimum)
+    {
+        m_minimum = value;
+    }
+
+    if (m_numberOfVoxels == 1 || value > m_maximum)
+    {
+        m_maximum = value;
+    }
+
+    if (!m_histogram.isEmpty())
+    {
+        int numberOfBins = m_histogram.size();
+        int bin = static_cast<int>((value - m_histogramMinimum) / (m_histogramMaximum - m_histogramMinimum) * numberOfBins);
+        ++m_histogram[qBound(0, bin, numberOfBins - 1)];
+    }
 }
 
-double ROIData::getStandardDeviation()
+void ROIData::addValueDeviation(double value)
 {
-    computeStatistics();
-    return m_standardDeviation;
+    double deviation = value - getMean();
+    m_sumOfSquaredDeviations += deviation * deviation;
+    ++m_numberOfDeviations;
 }
 
-double ROIData::getMaximum()
+double ROIData::getMean() const
 {
-    computeStatistics();
-    return m_maximum;
+    if (m_numberOfVoxels == 0)
+    {
+        return 0.0;
+    }
+
+    return m_sum / m_numberOfVoxels;
 }
 
-void ROIData::setUnits(const QString &units)
+double ROIData::getStandardDeviation() const
 {
-    m_units = units;
+    if (m_numberOfVoxels == 0)
+    {
+        return 0.0;
+    }
+
+    if (m_numberOfDeviations == m_numberOfVoxels)
+    {
+        return qSqrt(m_sumOfSquaredDeviations / m_numberOfVoxels);
+    }
+
+    if (m_numberOfDeviations > 0)
+    {
+        DEBUG_LOG(QString("Values added after the second pass of addValues() (%1 deviations for %2 voxels), using the one-pass standard deviation")
+            .arg(m_numberOfDeviations).arg(m_numberOfVoxels));
+    }
+
+    return qSqrt(m_runningSumOfSquaredDeviations / m_numberOfVoxels);
 }
 
-QString ROIData::getUnits() const
+double ROIData::getMinimum() const
 {
-    return m_units;
+    return m_minimum;
 }
 
-void ROIData::setModality(const QString &modality)
+double ROIData::getMaximum() const
 {
-    m_modality = modality;
+    return m_maximum;
 }
 
-QString ROIData::getModality() const
+int ROIData::getNumberOfVoxels() const
 {
-    return m_modality;
+    return m_numberOfVoxels;
 }
 
-void ROIData::computeStatistics()
+void ROIData::enableHistogram(double minimum, double maximum, int numberOfBins)
 {
-    if (!m_statisticsAreOutdated)
+    if (numberOfBins < 1 || maximum <= minimum)
     {
+        DEBUG_LOG(QString("Invalid histogram: [%1, %2] with %3 bins").arg(minimum).arg(maximum).arg(numberOfBins));
         return;
     }
 
-    computeMean();
-    computeStandardDeviation();
-    computeMaximum();
-
-    m_statisticsAreOutdated = false;
+    m_histogram.fill(0, numberOfBins);
+    m_histogramMinimum = minimum;
+    m_histogramMaximum = maximum;
 }
 
-void ROIData::computeMean()
+QVector<int> ROIData::getHistogram() const
 {
-    m_mean = 0.0;
-    foreach (const Voxel &voxel, m_voxels)
-    {
-        m_mean += voxel.getComponent(0);
-    }
-
-    m_mean = m_mean / m_voxels.size();
+    return m_histogram;
 }
 
-void ROIData::computeStandardDeviation()
+void ROIData::setUnits(const QString &units)
 {
-    m_standardDeviation = 0.0;
-    QList<double> deviations;
-    foreach (const Voxel &voxel, m_voxels)
-    {
-        double individualDeviation = voxel.getComponent(0) - m_mean;
-        deviations << (individualDeviation * individualDeviation);
-    }
-
-    foreach (double deviation, deviations)
-    {
-        m_standardDeviation += deviation;
-    }
+    m_units = units;
+}
 
-    m_standardDeviation /= deviations.size();
-    m_standardDeviation = qSqrt(m_standardDeviation);
+QString ROIData::getUnits() const
+{
+    return m_units;
 }
 
-void ROIData::computeMaximum()
+void ROIData::setModality(const QString &modality)
 {
-    m_maximum = -DBL_MAX;
+    m_modality = modality;
+}
 
-    foreach (const Voxel &voxel, m_voxels)
-    {
-        double value = voxel.getComponent(0);
-        if (value > m_maximum)
-        {
-            m_maximum = value;
-        }
-    }
+QString ROIData::getModality() const
+{
+    return m_modality;
 }
 
 } // End namespace udg
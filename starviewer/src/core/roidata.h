@@ -18,13 +18,17 @@
 #include "voxel.h"
 
 #include <QString>
+#include <QVector>
 
 namespace udg {
 
 /**
-    Class to save voxel data contained in a ROI and compute statistics from it.
+    Class to compute statistics from the voxel values contained in a ROI.
     Currently it only takes into account the first component of the voxel,
-    i.e. if the voxel is an RGB color voxel, it only will take into account the red channel
+    i.e. if the voxel is an RGB color voxel, it only will take into account the red channel.
+    The values are not stored. The mean, minimum, maximum, standard deviation and histogram are updated as the values are added.
+    When all the values are added at once with addValues() they are read twice, and the standard deviation is then exactly the one of the two-pass
+    computation instead of the one-pass estimate.
  */
 class ROIData {
 public:
@@ -37,10 +41,29 @@ public:
     /// Adds a voxel unless Voxel::isEmpty() is true
     void addVoxel(const Voxel &voxel);
 
-    /// Gets the mean/standard deviation/maximum corresponding to the current voxels
-    double getMean();
-    double getStandardDeviation();
-    double getMaximum();
+    /// Adds the value of a voxel
+    void addValue(double value);
+
+    /// Adds all the values given by the reader. It's the fastest way to add voxels when the scalars are read directly from the pixel data.
+    /// ValueReader must have a const method template <class Consumer> void readValues(Consumer &consumer), that calls consumer(value) for each value
+    /// in the same order each time it's called. The values are read twice: first to add them and then to add their deviations from the mean.
+    template <class ValueReader> void addValues(const ValueReader &reader);
+
+    /// Gets the mean/standard deviation/minimum/maximum corresponding to the current voxels
+    double getMean() const;
+    double getStandardDeviation() const;
+    double getMinimum() const;
+    double getMaximum() const;
+
+    /// Returns the number of voxels added
+    int getNumberOfVoxels() const;
+
+    /// Enables the histogram of the values added from now on, with numberOfBins bins of the same width between minimum and maximum.
+    /// Values out of this range are counted in the first or the last bin
+    void enableHistogram(double minimum, double maximum, int numberOfBins);
+
+    /// Returns the histogram of the added values. It's empty if the histogram is not enabled
+    QVector<int> getHistogram() const;
 
     /// Sets/gets the units of the voxels of this ROI
     void setUnits(const QString &units);
@@ -51,35 +74,69 @@ public:
     QString getModality() const;
 
 private:
-    /// Computes all statistics data if needed
-    void computeStatistics();
+    /// Consumers of the values given to addValues(), for each of the passes
+    class ValueAdder {
+    public:
+        ValueAdder(ROIData &roiData) : m_roiData(roiData) {}
+        void operator()(double value) { m_roiData.addValue(value); }
+    private:
+        ROIData &m_roiData;
+    };
+
+    class ValueDeviationAdder {
+    public:
+        ValueDeviationAdder(ROIData &roiData) : m_roiData(roiData) {}
+        void operator()(double value) { m_roiData.addValueDeviation(value); }
+    private:
+        ROIData &m_roiData;
+    };
+
+    /// Adds the squared deviation of the given value from the mean to the exact standard deviation
+    void addValueDeviation(double value);
+
+private:
+    /// Number of added voxels
+    int m_numberOfVoxels;
 
-    /// Computes voxels mean
-    void computeMean();
+    /// Sum of the added values, used to compute the mean
+    double m_sum;
 
-    /// Computes voxels standard deviation. Requires mean to be computed before, as it uses the m_mean value
-    void computeStandardDeviation();
+    /// Running mean and sum of the squared deviations from it of the added values, used to estimate the standard deviation in one pass
+    double m_runningMean;
+    double m_runningSumOfSquaredDeviations;
 
-    /// Computes voxels maximum value
-    void computeMaximum();
+    /// Sum of the squared deviations from the mean of the values added in the second pass of addValues(), and number of them.
+    /// The exact standard deviation is only valid when they are the deviations of all the added values.
+    double m_sumOfSquaredDeviations;
+    int m_numberOfDeviations;
 
-private:
-    /// The container of the ROI voxels
-    QVector<Voxel> m_voxels;
-    
-    /// Statistic data members
-    double m_mean;
-    double m_standardDeviation;
+    double m_minimum;
     double m_maximum;
 
-    /// Used to control whether the statistics data has to be computed or not when requested
-    bool m_statisticsAreOutdated;
+    /// Optional histogram of the added values and its range
+    QVector<int> m_histogram;
+    double m_histogramMinimum;
+    double m_histogramMaximum;
     
     /// Additional optional information of the ROI regarding the units of the voxels and their modality
     QString m_units;
     QString m_modality;
 };
 
+template <class ValueReader>
+void ROIData::addValues(const ValueReader &reader)
+{
+    // The deviations added before are not from the new mean
+    m_sumOfSquaredDeviations = 0.0;
+    m_numberOfDeviations = 0;
+
+    ValueAdder valueAdder(*this);
+    reader.readValues(valueAdder);
+
+    ValueDeviationAdder valueDeviationAdder(*this);
+    reader.readValues(valueDeviationAdder);
+}
+
 } // End namespace udg
 
 #endif
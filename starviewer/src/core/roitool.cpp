@@ -21,7 +21,6 @@
 #include "image.h"
 #include "mathtools.h"
 #include "areameasurecomputer.h"
-#include "voxel.h"
 #include "roidata.h"
 #include "roidataprinter.h"
 #include "petctfusionroidataprinter.h"
@@ -31,8 +30,77 @@
 
 #include <QApplication>
 
+#include <vtkSetGet.h>
+
 namespace udg {
 
+namespace {
+
+/// Passes to consumer the given number of scalars, beginning with firstScalar and separated by increment scalars
+template <typename T, class Consumer>
+void readScalars(const T *firstScalar, int numberOfScalars, int increment, Consumer &consumer)
+{
+    for (int i = 0; i < numberOfScalars; ++i)
+    {
+        consumer(static_cast<double>(firstScalar[i * increment]));
+    }
+}
+
+}
+
+class ROITool::VoxelSpansReader {
+public:
+    VoxelSpansReader(const QList<VoxelSpan> &voxelSpans, const OrthogonalPlane &view, VolumePixelData *pixelData, int phaseIndex)
+        : m_voxelSpans(voxelSpans), m_pixelData(pixelData), m_phaseIndex(phaseIndex)
+    {
+        pixelData->getExtent(m_extent);
+        m_numberOfPhases = pixelData->getNumberOfPhases();
+
+        // Number of scalars between two consecutive voxels along the scan direction
+        m_increment = pixelData->getNumberOfScalarComponents();
+        if (view.getXIndex() == 1)
+        {
+            m_increment *= m_extent[1] - m_extent[0] + 1;
+        }
+    }
+
+    template <class Consumer>
+    void readValues(Consumer &consumer) const
+    {
+        foreach (const VoxelSpan &voxelSpan, m_voxelSpans)
+        {
+            // Phase correction of the z index, as in VolumePixelData::computeCoordinateIndex()
+            int z = voxelSpan.firstVoxelIndex[2];
+            if (MathTools::isInsideRange(m_phaseIndex, 0, m_numberOfPhases - 1))
+            {
+                z = z * m_numberOfPhases + m_phaseIndex;
+            }
+
+            if (!MathTools::isInsideRange(z, m_extent[4], m_extent[5]))
+            {
+                continue;
+            }
+
+            void *firstScalar = m_pixelData->getScalarPointer(voxelSpan.firstVoxelIndex[0], voxelSpan.firstVoxelIndex[1], z);
+            switch (m_pixelData->getScalarType())
+            {
+                vtkTemplateMacro(readScalars(static_cast<VTK_TT*>(firstScalar), voxelSpan.numberOfVoxels, m_increment, consumer));
+                default:
+                    DEBUG_LOG(QString("Unexpected scalar type: %1").arg(m_pixelData->getScalarType()));
+                    return;
+            }
+        }
+    }
+
+private:
+    const QList<VoxelSpan> &m_voxelSpans;
+    VolumePixelData *m_pixelData;
+    int m_phaseIndex;
+    int m_extent[6];
+    int m_numberOfPhases;
+    int m_increment;
+};
+
 ROITool::ROITool(QViewer *viewer, QObject *parent)
  : MeasurementTool(viewer, parent), m_roiPolygon(0)
 {
@@ -92,7 +160,13 @@ QMap<int, ROIData> ROITool::computeROIData()
         // Compute the voxel values inside of the polygon if the input is visible and the images are monochrome
         if (m_2DViewer->isInputVisible(i) && !m_2DViewer->getInput(i)->getImage(0)->getPhotometricInterpretation().isColor())
         {
-            ROIData roiData = computeVoxelValues(m_roiPolygon->getSegments(), sweepLineBeginPoint, sweepLineEndPoint, verticalLimit, i);
+            int phaseIndex = 0;
+            if (m_2DViewer->getView() == OrthogonalPlane::XYPlane && m_2DViewer->doesInputHavePhases(i))
+            {
+                phaseIndex = m_2DViewer->getCurrentPhaseOnInput(i);
+            }
+
+            ROIData roiData = computeVoxelValues(m_roiPolygon->getSegments(), sweepLineBeginPoint, sweepLineEndPoint, verticalLimit, i, phaseIndex);
             
             // Set additional information of the ROI data
             roiData.setUnits(m_2DViewer->getInput(i)->getPixelUnits());
@@ -105,45 +179,55 @@ QMap<int, ROIData> ROITool::computeROIData()
     return roiDataMap;
 }
 
-ROIData ROITool::computeVoxelValues(const QList<Line3D> &polygonSegments, Point3D sweepLineBeginPoint, Point3D sweepLineEndPoint, double sweepLineEnd, int inputNumber)
+ROIData ROITool::computeVoxelValues(const QList<Line3D> &polygonSegments, Point3D sweepLineBeginPoint, Point3D sweepLineEndPoint, double sweepLineEnd,
+                                    int inputNumber, int phaseIndex)
 {
+    ROIData roiData;
+
     // We get the pointer of the pixel data to obtain voxels values from
     VolumePixelData *pixelData = m_2DViewer->getCurrentPixelDataFromInput(inputNumber);
     if (!pixelData)
     {
-        return ROIData();
+        return roiData;
     }
     
+    double currentZDepth = m_2DViewer->getCurrentDisplayedImageDepthOnInput(inputNumber);
+    QList<VoxelSpan> voxelSpans = computeVoxelSpans(polygonSegments, sweepLineBeginPoint, sweepLineEndPoint, sweepLineEnd, pixelData, currentZDepth);
+    addVoxelSpansValues(voxelSpans, m_2DViewer->getView(), pixelData, phaseIndex, roiData);
+
+    return roiData;
+}
+
+QList<ROITool::VoxelSpan> ROITool::computeVoxelSpans(const QList<Line3D> &polygonSegments, Point3D sweepLineBeginPoint, Point3D sweepLineEndPoint,
+                                                     double sweepLineEnd, VolumePixelData *pixelData, double currentZDepth)
+{
     OrthogonalPlane currentView = m_2DViewer->getView();
     int yIndex = currentView.getYIndex();
-    double currentZDepth = m_2DViewer->getCurrentDisplayedImageDepthOnInput(inputNumber);
     
     double spacing[3];
     pixelData->getSpacing(spacing);
     double verticalSpacingIncrement = spacing[yIndex];
-    
-    int phaseIndex = 0;
-    if (currentView == OrthogonalPlane::XYPlane && m_2DViewer->doesInputHavePhases(inputNumber))
-    {
-        phaseIndex = m_2DViewer->getCurrentPhaseOnInput(inputNumber);
-    }
 
-    // ROI voxel data to be obtained from the sweep line
-    ROIData roiData;
+    QList<VoxelSpan> voxelSpans;
     while (sweepLineBeginPoint.at(yIndex) <= sweepLineEnd)
     {
         // We get the intersections bewteen ROI segments and current sweep line
         QList<double*> intersectionList = getIntersectionPoints(polygonSegments, Line3D(sweepLineBeginPoint, sweepLineEndPoint), currentView);
 
-        // Adding the voxels from the current intersections of the current sweep line to the voxel values list
-        addVoxelsFromIntersections(intersectionList, currentZDepth, currentView, pixelData, phaseIndex, roiData);
+        // Adding the spans of voxels from the current intersections of the current sweep line
+        addVoxelSpansFromIntersections(intersectionList, currentZDepth, currentView, pixelData, voxelSpans);
+
+        foreach (double *intersection, intersectionList)
+        {
+            delete[] intersection;
+        }
         
         // Shift the sweep line the corresponding space in vertical direction
         sweepLineBeginPoint[yIndex] += verticalSpacingIncrement;
         sweepLineEndPoint[yIndex] += verticalSpacingIncrement;
     }
 
-    return roiData;
+    return voxelSpans;
 }
 
 QList<int> ROITool::getIndexOfSegmentsCrossingAtHeight(const QList<Line3D> &segments, double height, int heightIndex)
@@ -176,7 +260,11 @@ QList<double*> ROITool::getIntersectionPoints(const QList<Line3D> &polygonSegmen
                                                                     polygonSegments.at(segmentIndex).getSecondPoint().getAsDoubleArray(),
                                                                     sweepLine.getFirstPoint().getAsDoubleArray(), sweepLine.getSecondPoint().getAsDoubleArray(),
                                                                     intersectionState);
-        if (intersectionState == MathTools::LinesIntersect)
+        if (intersectionState != MathTools::LinesIntersect)
+        {
+            delete[] foundPoint;
+        }
+        else
         {
             // Must sort intersections horizontally in order to be able to get voxels inside polygon correctly
             bool found = false;
@@ -204,16 +292,21 @@ QList<double*> ROITool::getIntersectionPoints(const QList<Line3D> &polygonSegmen
     return intersectionPoints;
 }
 
-void ROITool::addVoxelsFromIntersections(const QList<double*> &intersectionPoints, double currentZDepth, const OrthogonalPlane &view, VolumePixelData *pixelData, int phaseIndex, ROIData &roiData)
+void ROITool::addVoxelSpansFromIntersections(const QList<double*> &intersectionPoints, double currentZDepth, const OrthogonalPlane &view,
+                                             VolumePixelData *pixelData, QList<VoxelSpan> &voxelSpans)
 {
     if (MathTools::isEven(intersectionPoints.count()))
     {
         int scanDirectionIndex = view.getXIndex();
+        int zIndex = view.getZIndex();
+
+        double origin[3];
         double spacing[3];
+        int extent[6];
+        pixelData->getOrigin(origin);
         pixelData->getSpacing(spacing);
+        pixelData->getExtent(extent);
         double scanDirectionIncrement = spacing[scanDirectionIndex];
-        
-        int zIndex = view.getZIndex();
 
         int limit = intersectionPoints.count() / 2;
         for (int i = 0; i < limit; ++i)
@@ -221,32 +314,64 @@ void ROITool::addVoxelsFromIntersections(const QList<double*> &intersectionPoint
             double *firstIntersection = intersectionPoints.at(i * 2);
             double *secondIntersection = intersectionPoints.at(i * 2 + 1);
             // First we check which will be the direction of the scan line
-            Point3D currentScanLinePoint;
-            double scanLineEnd;
-            if (firstIntersection[scanDirectionIndex] <= secondIntersection[scanDirectionIndex])
+            double *scanLineBegin = firstIntersection;
+            double scanLineEnd = secondIntersection[scanDirectionIndex];
+            if (firstIntersection[scanDirectionIndex] > secondIntersection[scanDirectionIndex])
             {
-                for (int i = 0; i < 3; ++i)
+                scanLineBegin = secondIntersection;
+                scanLineEnd = firstIntersection[scanDirectionIndex];
+            }
+
+            // The index of the voxels is computed as VolumePixelData::computeCoordinateIndex() does. It only changes along the scan direction, which is
+            // always the x or y axis of the volume, so the z index is checked when reading each phase
+            double coordinate[3] = { scanLineBegin[0], scanLineBegin[1], scanLineBegin[2] };
+            coordinate[zIndex] = currentZDepth;
+
+            VoxelSpan voxelSpan;
+            voxelSpan.numberOfVoxels = 0;
+            bool isScanLineInside = true;
+            for (int j = 0; j < 3; ++j)
+            {
+                voxelSpan.firstVoxelIndex[j] = qRound((coordinate[j] - origin[j]) / spacing[j]);
+                if (j != scanDirectionIndex && j != 2)
                 {
-                    currentScanLinePoint[i] = firstIntersection[i];
+                    isScanLineInside = isScanLineInside && MathTools::isInsideRange(voxelSpan.firstVoxelIndex[j], extent[j * 2], extent[j * 2 + 1]);
                 }
-                scanLineEnd = secondIntersection[scanDirectionIndex];
             }
-            else
+
+            if (!isScanLineInside)
             {
-                for (int i = 0; i < 3; ++i)
+                continue;
+            }
+
+            // Then we scan the line with the same steps as when the voxels were read one by one, so that the same voxels are visited, and join the
+            // consecutive ones in spans
+            double scanLinePosition = coordinate[scanDirectionIndex];
+            while (scanLinePosition <= scanLineEnd)
+            {
+                int voxelIndex = qRound((scanLinePosition - origin[scanDirectionIndex]) / spacing[scanDirectionIndex]);
+                if (MathTools::isInsideRange(voxelIndex, extent[scanDirectionIndex * 2], extent[scanDirectionIndex * 2 + 1]))
                 {
-                    currentScanLinePoint[i] = secondIntersection[i];
+                    if (voxelSpan.numberOfVoxels > 0 && voxelIndex == voxelSpan.firstVoxelIndex[scanDirectionIndex] + voxelSpan.numberOfVoxels)
+                    {
+                        ++voxelSpan.numberOfVoxels;
+                    }
+                    else
+                    {
+                        if (voxelSpan.numberOfVoxels > 0)
+                        {
+                            voxelSpans << voxelSpan;
+                        }
+                        voxelSpan.firstVoxelIndex[scanDirectionIndex] = voxelIndex;
+                        voxelSpan.numberOfVoxels = 1;
+                    }
                 }
-                scanLineEnd = firstIntersection[scanDirectionIndex];
+                scanLinePosition += scanDirectionIncrement;
             }
-            // Then we scan and get the voxels along the line
-            while (currentScanLinePoint.at(scanDirectionIndex) <= scanLineEnd)
+
+            if (voxelSpan.numberOfVoxels > 0)
             {
-                Point3D voxelCoordinate(currentScanLinePoint.getAsDoubleArray());
-                voxelCoordinate[zIndex] = currentZDepth;
-                
-                roiData.addVoxel(pixelData->getVoxelValue(voxelCoordinate.getAsDoubleArray(), phaseIndex));
-                currentScanLinePoint[scanDirectionIndex] += scanDirectionIncrement;
+                voxelSpans << voxelSpan;
             }
         }
     }
@@ -256,6 +381,12 @@ void ROITool::addVoxelsFromIntersections(const QList<double*> &intersectionPoint
     }
 }
 
+void ROITool::addVoxelSpansValues(const QList<VoxelSpan> &voxelSpans, const OrthogonalPlane &view, VolumePixelData *pixelData, int phaseIndex,
+                                  ROIData &roiData)
+{
+    roiData.addValues(VoxelSpansReader(voxelSpans, view, pixelData, phaseIndex));
+}
+
 void ROITool::printData()
 {
     QString annotation = getAnnotation();
@@ -62,9 +62,23 @@ private:
     /// The key is the index of the input on the viewer corresponding to the mapped ROIData
     QMap<int, ROIData> computeROIData();
     
-    /// Computes the voxel values contained inside polygonSegments corresponding to inputNumber volume. It will use the sweepLine algorithm, 
-    /// begining with the line defined with the given points and will end at sweepLineEnd height and returns them in a ROIData object
-    ROIData computeVoxelValues(const QList<Line3D> &polygonSegments, Point3D sweepLineBeginPoint, Point3D sweepLineEndPoint, double sweepLineEnd, int inputNumber);
+    /// Run of consecutive voxels inside the ROI along the scan direction of the view
+    struct VoxelSpan
+    {
+        /// Index of the first voxel of the span, without the phase correction of the z index
+        int firstVoxelIndex[3];
+        /// Number of voxels of the span
+        int numberOfVoxels;
+    };
+
+    /// Computes the statistics of the voxel values contained inside polygonSegments corresponding to inputNumber volume in the given phase
+    ROIData computeVoxelValues(const QList<Line3D> &polygonSegments, Point3D sweepLineBeginPoint, Point3D sweepLineEndPoint, double sweepLineEnd,
+                               int inputNumber, int phaseIndex);
+
+    /// Computes the spans of voxels of pixelData contained inside polygonSegments. It will use the sweepLine algorithm, begining with the line defined
+    /// with the given points and will end at sweepLineEnd height
+    QList<VoxelSpan> computeVoxelSpans(const QList<Line3D> &polygonSegments, Point3D sweepLineBeginPoint, Point3D sweepLineEndPoint, double sweepLineEnd,
+                                       VolumePixelData *pixelData, double currentZDepth);
     
     /// Returns a list with the indices of the corresponding segments of the given list which crosses the given height, that is, those segments
     /// which its initial and end point are between the specified heigh on the heightIndex
@@ -73,8 +87,15 @@ private:
     /// Gets the points that intersect with polygonSegments and the given sweepLine and orders them by the xIndex of view
     QList<double*> getIntersectionPoints(const QList<Line3D> &polygonSegments, const Line3D &sweepLine, const OrthogonalPlane &view);
 
-    /// Adds the voxels that are in the path of the intersection points to the given ROIData
-    void addVoxelsFromIntersections(const QList<double*> &intersectionPoints, double currentZDepth, const OrthogonalPlane &view, VolumePixelData *pixelData, int phaseIndex, ROIData &roiData);
+    /// Adds the spans of voxels that are in the path of the intersection points to the given list
+    void addVoxelSpansFromIntersections(const QList<double*> &intersectionPoints, double currentZDepth, const OrthogonalPlane &view, VolumePixelData *pixelData,
+                                        QList<VoxelSpan> &voxelSpans);
+
+    /// Reader of the values of the voxels of a list of spans for ROIData::addValues()
+    class VoxelSpansReader;
+
+    /// Adds the values of the voxels of the given spans in the given phase to roiData, reading them directly from the scalars of pixelData.
+    void addVoxelSpansValues(const QList<VoxelSpan> &voxelSpans, const OrthogonalPlane &view, VolumePixelData *pixelData, int phaseIndex, ROIData &roiData);
 
     /// Returns the appropiate ROIDataPrinter for the given roi data
     AbstractROIDataPrinter* getROIDataPrinter(const QMap<int, ROIData> &roiDataMap);
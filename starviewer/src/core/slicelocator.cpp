@@ -17,16 +17,29 @@
 #include "imageplane.h"
 #include "mathtools.h"
 #include "volume.h"
+#include "logging.h"
+
+#include <QtAlgorithms>
 
 namespace udg {
 
 /// With this value we consider an slice could be considered to be near if it's not greater than 1.5 slices far
 const double SliceLocator::SliceProximityFactor = 1.5;
 
+namespace {
+
+/// Maximum difference between the components of the normals of two slices to consider them parallel
+const double ParallelSlicesTolerance = 1.0e-4;
+
+}
+
 SliceLocator::SliceLocator()
 {
     m_volume = 0;
     m_volumePlane = OrthogonalPlane::XYPlane;
+    m_indexedVolume = 0;
+    m_indexedMaximumSlice = -1;
+    m_slicesAreParallel = false;
 }
 
 SliceLocator::~SliceLocator()
@@ -50,23 +63,17 @@ int SliceLocator::getNearestSlice(double point[3])
         return -1;
     }
     
-    double nearestSliceDistance = MathTools::DoubleMaximumValue;
-    int nearestSlice = -1;
-    
-    for (int i = 0; i <= m_volume->getMaximumSlice(m_volumePlane); ++i)
-    {
-        ImagePlane *currentPlane = m_volume->getImagePlane(i, m_volumePlane);
-        if (currentPlane)
-        {
-            double currentDistance = currentPlane->getDistanceToPoint(point);
-            if (currentDistance < nearestSliceDistance)
-            {
-                nearestSliceDistance = currentDistance;
-                nearestSlice = i;
-            }
+    updateSlicePositionsIndex();
 
-            delete currentPlane;
-        }
+    double nearestSliceDistance;
+    int nearestSlice;
+    if (m_slicesAreParallel)
+    {
+        nearestSlice = getNearestSliceFromIndex(point, nearestSliceDistance);
+    }
+    else
+    {
+        nearestSlice = getNearestSliceByLinearSearch(point, nearestSliceDistance);
     }
 
     if (isWithinProximityBounds(nearestSliceDistance))
@@ -113,4 +120,152 @@ bool SliceLocator::isWithinProximityBounds(double distanceToSlice)
     }
 }
 
+void SliceLocator::updateSlicePositionsIndex()
+{
+    if (isSlicePositionsIndexUpToDate())
+    {
+        return;
+    }
+
+    m_indexedVolume = m_volume;
+    m_indexedPlane = m_volumePlane;
+    m_indexedMaximumSlice = m_volume->getMaximumSlice(m_volumePlane);
+    m_volume->getOrigin(m_indexedOrigin);
+    m_volume->getSpacing(m_indexedSpacing);
+
+    m_slicePositions.clear();
+    m_slicePositions.reserve(m_indexedMaximumSlice + 1);
+    m_slicesAreParallel = true;
+
+    for (int i = 0; i <= m_indexedMaximumSlice && m_slicesAreParallel; ++i)
+    {
+        ImagePlane *currentPlane = m_volume->getImagePlane(i, m_volumePlane);
+        if (currentPlane)
+        {
+            double normal[3];
+            currentPlane->getNormalVector(normal);
+            double origin[3];
+            currentPlane->getOrigin(origin);
+            delete currentPlane;
+
+            if (m_slicePositions.isEmpty())
+            {
+                m_slicesNormal[0] = normal[0];
+                m_slicesNormal[1] = normal[1];
+                m_slicesNormal[2] = normal[2];
+            }
+            else if (qAbs(normal[0] - m_slicesNormal[0]) > ParallelSlicesTolerance || qAbs(normal[1] - m_slicesNormal[1]) > ParallelSlicesTolerance ||
+                     qAbs(normal[2] - m_slicesNormal[2]) > ParallelSlicesTolerance)
+            {
+                m_slicesAreParallel = false;
+            }
+
+            SlicePosition slicePosition;
+            slicePosition.position = MathTools::dotProduct(m_slicesNormal, origin);
+            slicePosition.slice = i;
+            m_slicePositions << slicePosition;
+        }
+    }
+
+    if (m_slicesAreParallel)
+    {
+        qSort(m_slicePositions.begin(), m_slicePositions.end(), slicePositionLessThan);
+    }
+    else
+    {
+        DEBUG_LOG("The slices are not parallel, the nearest slice will be searched comparing the distance to all of them");
+        m_slicePositions.clear();
+    }
+}
+
+bool SliceLocator::isSlicePositionsIndexUpToDate()
+{
+    if (m_indexedVolume != m_volume || m_indexedPlane != m_volumePlane || m_indexedMaximumSlice != m_volume->getMaximumSlice(m_volumePlane))
+    {
+        return false;
+    }
+
+    const double *origin = m_volume->getOrigin();
+    const double *spacing = m_volume->getSpacing();
+    for (int i = 0; i < 3; ++i)
+    {
+        if (origin[i] != m_indexedOrigin[i] || spacing[i] != m_indexedSpacing[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int SliceLocator::getNearestSliceFromIndex(double point[3], double &nearestSliceDistance)
+{
+    nearestSliceDistance = MathTools::DoubleMaximumValue;
+    if (m_slicePositions.isEmpty())
+    {
+        return -1;
+    }
+
+    SlicePosition pointPosition;
+    pointPosition.position = MathTools::dotProduct(m_slicesNormal, point);
+    pointPosition.slice = -1;
+
+    // The nearest slice is either the first one at or after the point or the last one before it. As in the linear search, when there are several slices at the
+    // same distance the one with the lowest index is returned, which is the first one of each group of slices with the same position.
+    QVector<SlicePosition>::const_iterator next = qLowerBound(m_slicePositions.constBegin(), m_slicePositions.constEnd(), pointPosition, slicePositionLessThan);
+
+    int nearestSlice = -1;
+    if (next != m_slicePositions.constEnd())
+    {
+        nearestSliceDistance = next->position - pointPosition.position;
+        nearestSlice = next->slice;
+    }
+
+    if (next != m_slicePositions.constBegin())
+    {
+        SlicePosition previousGroupPosition = *(next - 1);
+        previousGroupPosition.slice = -1;
+        QVector<SlicePosition>::const_iterator previous = qLowerBound(m_slicePositions.constBegin(), next, previousGroupPosition, slicePositionLessThan);
+
+        double previousDistance = pointPosition.position - previous->position;
+        if (previousDistance < nearestSliceDistance || (previousDistance == nearestSliceDistance && previous->slice < nearestSlice))
+        {
+            nearestSliceDistance = previousDistance;
+            nearestSlice = previous->slice;
+        }
+    }
+
+    return nearestSlice;
+}
+
+int SliceLocator::getNearestSliceByLinearSearch(double point[3], double &nearestSliceDistance)
+{
+    nearestSliceDistance = MathTools::DoubleMaximumValue;
+    int nearestSlice = -1;
+    
+    for (int i = 0; i <= m_volume->getMaximumSlice(m_volumePlane); ++i)
+    {
+        ImagePlane *currentPlane = m_volume->getImagePlane(i, m_volumePlane);
+        if (currentPlane)
+        {
+            double currentDistance = currentPlane->getDistanceToPoint(point);
+            if (currentDistance < nearestSliceDistance)
+            {
+                nearestSliceDistance = currentDistance;
+                nearestSlice = i;
+            }
+
+            delete currentPlane;
+        }
+    }
+
+    return nearestSlice;
+}
+
+bool SliceLocator::slicePositionLessThan(const SlicePosition &slicePosition1, const SlicePosition &slicePosition2)
+{
+    return slicePosition1.position < slicePosition2.position ||
+           (slicePosition1.position == slicePosition2.position && slicePosition1.slice < slicePosition2.slice);
+}
+
 } // End namespace udg
@@ -17,13 +17,19 @@
 
 #include "orthogonalplane.h"
 
+#include <QVector>
+
 namespace udg {
 
 class Volume;
 class ImagePlane;
 
 /**
-    Class that given a point locates an specific slice from a Volume
+    Class that given a point locates an specific slice from a Volume.
+
+    The positions of the slices along their normal are indexed the first time a slice is located for a volume and plane, so that the following lookups are
+    done with a binary search. The index is rebuilt when the volume, the plane or the geometry of the volume change. If the slices are not parallel, the
+    nearest slice is searched comparing the distance to all of them.
  */
 class SliceLocator {
 public:
@@ -47,7 +53,27 @@ private:
     /// regarding the slice spacing values of the current volume, false otherwise
     bool isWithinProximityBounds(double distanceToSlice);
 
+    /// Builds the index of slice positions for the current volume and plane if it doesn't exist or it has become outdated
+    void updateSlicePositionsIndex();
+    /// Returns true if the index of slice positions has been built for the current volume, plane and volume geometry
+    bool isSlicePositionsIndexUpToDate();
+
+    /// Returns the nearest slice to the given point searching in the index of slice positions and sets its distance to the point in nearestSliceDistance
+    int getNearestSliceFromIndex(double point[3], double &nearestSliceDistance);
+    /// Returns the nearest slice to the given point comparing its distance to all the slices and sets this distance in nearestSliceDistance
+    int getNearestSliceByLinearSearch(double point[3], double &nearestSliceDistance);
+
 private:
+    /// Position of a slice along the normal of the slices
+    struct SlicePosition
+    {
+        double position;
+        int slice;
+    };
+
+    /// Returns true if the position of the first slice is lower than the position of the second one, or the same and the first slice has a lower index
+    static bool slicePositionLessThan(const SlicePosition &slicePosition1, const SlicePosition &slicePosition2);
+
     /// This factor keeps the proportion factor of slices to determine if an slice could be considered to be near to another slice or not
     static const double SliceProximityFactor;
     
@@ -56,6 +82,20 @@ private:
     
     /// The plane upon computing will be taken
     OrthogonalPlane m_volumePlane;
+
+    /// Volume, plane and volume geometry (number of slices, origin and spacing) for which the index of slice positions has been built
+    Volume *m_indexedVolume;
+    OrthogonalPlane m_indexedPlane;
+    int m_indexedMaximumSlice;
+    double m_indexedOrigin[3];
+    double m_indexedSpacing[3];
+
+    /// True if all the slices are parallel and the index of slice positions can be used
+    bool m_slicesAreParallel;
+    /// Common normal of the slices
+    double m_slicesNormal[3];
+    /// Positions of the slices along their common normal, sorted by position
+    QVector<SlicePosition> m_slicePositions;
 };
 
 } // End namespace udg
@@ -28,6 +28,7 @@ TemporalDimensionFillerStep::TemporalDimensionFillerStep()
 : PatientFillerStep()
 {
     m_requiredLabelsList << "ImageFillerStep";
+    m_requiresPixelData = false;
 }
 
 TemporalDimensionFillerStep::~TemporalDimensionFillerStep()
@@ -71,6 +71,11 @@ void ThickSlabFilter::setAccumulatorType(AccumulatorFactory::AccumulatorType typ
     m_filter->SetAccumulatorType(type);
 }
 
+void ThickSlabFilter::setIncrementalProjection(bool incremental)
+{
+    m_filter->SetIncrementalProjection(incremental);
+}
+
 vtkAlgorithm* ThickSlabFilter::getVtkAlgorithm() const
 {
     return m_filter;
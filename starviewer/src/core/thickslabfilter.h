@@ -46,6 +46,8 @@ public:
     void setStride(int stride);
     /// Sets the accumulator type
     void setAccumulatorType(AccumulatorFactory::AccumulatorType type);
+    /// Sets whether the projection is updated incrementally when only the first slice changes
+    void setIncrementalProjection(bool incremental);
 
     /// Get the thickness
     int getSlabThickness();
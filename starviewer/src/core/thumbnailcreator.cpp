@@ -72,6 +72,11 @@ QImage ThumbnailCreator::getThumbnail(const Image *image, int resolution)
     return createImageThumbnail(image->getPath(), resolution);
 }
 
+QImage ThumbnailCreator::getThumbnail(const QString &dicomFilePath, int resolution)
+{
+    return createImageThumbnail(dicomFilePath, resolution);
+}
+
 QImage ThumbnailCreator::getThumbnail(DICOMTagReader *reader, int resolution)
 {
     return createThumbnail(reader, resolution);
@@ -93,7 +98,8 @@ QImage ThumbnailCreator::makeEmptyThumbnailWithCustomText(const QString &text, i
 
 QImage ThumbnailCreator::createImageThumbnail(const QString &imageFileName, int resolution)
 {
-    DICOMTagReader reader(imageFileName);
+    // Només es llegeix la capçalera, les dades de píxel les llegeix la DicomImage del fitxer, i només les del primer frame
+    DICOMTagReader reader(imageFileName, DICOMTagReader::ReadHeaderOnly);
     return createThumbnail(&reader, resolution);
 }
 
@@ -33,6 +33,9 @@ public:
     /// Crea el thumbnail de la imatge passada per paràmetre
     QImage getThumbnail(const Image *image, int resolution = 100);
 
+    /// Crea el thumbnail del fitxer DICOM passat per paràmetre
+    QImage getThumbnail(const QString &dicomFilePath, int resolution = 100);
+
     /// Obté el thumbnail a partir del DICOMTagReader
     QImage getThumbnail(DICOMTagReader *reader, int resolution = 100);
 
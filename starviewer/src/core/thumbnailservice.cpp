@@ -0,0 +1,215 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "thumbnailservice.h"
+
+#include "image.h"
+#include "logging.h"
+#include "series.h"
+#include "thumbnailcreator.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QImage>
+#include <QThread>
+
+#include <ThreadWeaver/Job>
+#include <ThreadWeaver/Queue>
+
+namespace udg {
+
+namespace {
+
+// Job that creates the thumbnail of a DICOM file, unless it has been given already created, and saves it to one or more files.
+class ThumbnailJob : public ThreadWeaver::Job {
+public:
+    ThumbnailJob(ThumbnailService *service, const QString &seriesInstanceUID, int volumeNumber, const QString &dicomFilePath,
+                 const QStringList &thumbnailFilePaths, bool keepExistingFiles)
+        : m_service(service), m_seriesInstanceUID(seriesInstanceUID), m_volumeNumber(volumeNumber), m_dicomFilePath(dicomFilePath),
+          m_thumbnailFilePaths(thumbnailFilePaths), m_keepExistingFiles(keepExistingFiles)
+    {
+    }
+
+    ThumbnailJob(ThumbnailService *service, const QString &seriesInstanceUID, int volumeNumber, const QImage &thumbnail,
+                 const QStringList &thumbnailFilePaths)
+        : m_service(service), m_seriesInstanceUID(seriesInstanceUID), m_volumeNumber(volumeNumber), m_thumbnail(thumbnail),
+          m_thumbnailFilePaths(thumbnailFilePaths), m_keepExistingFiles(false)
+    {
+    }
+
+protected:
+    virtual void run(ThreadWeaver::JobPointer self, ThreadWeaver::Thread *thread)
+    {
+        Q_UNUSED(self)
+        Q_UNUSED(thread)
+
+        // Thumbnails must not slow down retrieval, import or visualization
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+
+        QStringList thumbnailFilePaths;
+        foreach (const QString &thumbnailFilePath, m_thumbnailFilePaths)
+        {
+            if (!m_keepExistingFiles || !QFileInfo(thumbnailFilePath).exists())
+            {
+                thumbnailFilePaths << thumbnailFilePath;
+            }
+        }
+
+        // If all the files already exist the thumbnail is ready
+        bool thumbnailSaved = true;
+
+        if (!thumbnailFilePaths.isEmpty())
+        {
+            QImage thumbnail = m_thumbnail;
+
+            // If the file has been deleted in the meantime (e.g. the study has been deleted) there's nothing to do
+            if (thumbnail.isNull() && QFileInfo(m_dicomFilePath).exists())
+            {
+                thumbnail = ThumbnailCreator().getThumbnail(m_dicomFilePath);
+            }
+
+            if (thumbnail.isNull())
+            {
+                thumbnailSaved = false;
+            }
+            else
+            {
+                foreach (const QString &thumbnailFilePath, thumbnailFilePaths)
+                {
+                    if (!thumbnail.save(thumbnailFilePath, "PNG"))
+                    {
+                        WARN_LOG(QString("Can't save thumbnail %1").arg(thumbnailFilePath));
+                        thumbnailSaved = false;
+                    }
+                }
+            }
+        }
+
+        QMetaObject::invokeMethod(m_service, "jobFinished", Qt::QueuedConnection, Q_ARG(QString, m_seriesInstanceUID), Q_ARG(int, m_volumeNumber),
+                                  Q_ARG(bool, thumbnailSaved));
+    }
+
+private:
+    ThumbnailService *m_service;
+    QString m_seriesInstanceUID;
+    int m_volumeNumber;
+    QString m_dicomFilePath;
+    QImage m_thumbnail;
+    QStringList m_thumbnailFilePaths;
+    bool m_keepExistingFiles;
+};
+
+}
+
+const int ThumbnailService::SeriesThumbnailVolumeNumber = 0;
+
+ThumbnailService::ThumbnailService(QObject *parent)
+    : QObject(parent)
+{
+    // The service may be first used from a worker thread, but its signals must be emitted from the main thread
+    if (QCoreApplication::instance())
+    {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+
+    m_queue = new ThreadWeaver::Queue();
+    m_queue->setMaximumNumberOfThreads(1);
+}
+
+ThumbnailService::~ThumbnailService()
+{
+    // Only the running job is waited for. The queued ones are cancelled so that they don't delay the exit; the thumbnails of the images are created again
+    // when they are needed
+    m_queue->dequeue();
+    m_queue->finish();
+    delete m_queue;
+}
+
+void ThumbnailService::requestThumbnail(const QString &seriesInstanceUID, int volumeNumber, const QString &dicomFilePath,
+                                        const QStringList &thumbnailFilePaths, bool keepExistingFiles)
+{
+    if (!markJobAsPending(seriesInstanceUID, volumeNumber))
+    {
+        return;
+    }
+
+    m_queue->enqueue(ThreadWeaver::JobPointer(new ThumbnailJob(this, seriesInstanceUID, volumeNumber, dicomFilePath, thumbnailFilePaths,
+                                                                keepExistingFiles)));
+}
+
+void ThumbnailService::requestThumbnail(const QString &seriesInstanceUID, int volumeNumber, const QImage &thumbnail, const QStringList &thumbnailFilePaths)
+{
+    if (!markJobAsPending(seriesInstanceUID, volumeNumber))
+    {
+        return;
+    }
+
+    m_queue->enqueue(ThreadWeaver::JobPointer(new ThumbnailJob(this, seriesInstanceUID, volumeNumber, thumbnail, thumbnailFilePaths)));
+}
+
+void ThumbnailService::requestSeriesThumbnail(Series *series, const QString &thumbnailFilePath)
+{
+    if (QFileInfo(thumbnailFilePath).exists())
+    {
+        return;
+    }
+
+    // As in ThumbnailCreator::getThumbnail(const Series*), only the series of images with some image need to decode one
+    QString modality = series->getModality();
+    int numberOfImages = series->getImages().size();
+
+    if (modality == "KO" || modality == "PR" || modality == "SR" || numberOfImages == 0)
+    {
+        ThumbnailCreator().getThumbnail(series).save(thumbnailFilePath, "PNG");
+    }
+    else
+    {
+        requestThumbnail(series->getInstanceUID(), SeriesThumbnailVolumeNumber, series->getImages().at(numberOfImages / 2)->getPath(),
+                         QStringList() << thumbnailFilePath, true);
+    }
+}
+
+void ThumbnailService::jobFinished(const QString &seriesInstanceUID, int volumeNumber, bool thumbnailSaved)
+{
+    {
+        QMutexLocker locker(&m_pendingJobsMutex);
+        m_pendingJobs.remove(getJobKey(seriesInstanceUID, volumeNumber));
+    }
+
+    if (thumbnailSaved)
+    {
+        emit thumbnailReady(seriesInstanceUID, volumeNumber);
+    }
+}
+
+QString ThumbnailService::getJobKey(const QString &seriesInstanceUID, int volumeNumber)
+{
+    return seriesInstanceUID + "/" + QString::number(volumeNumber);
+}
+
+bool ThumbnailService::markJobAsPending(const QString &seriesInstanceUID, int volumeNumber)
+{
+    QMutexLocker locker(&m_pendingJobsMutex);
+    QString jobKey = getJobKey(seriesInstanceUID, volumeNumber);
+
+    if (m_pendingJobs.contains(jobKey))
+    {
+        return false;
+    }
+
+    m_pendingJobs.insert(jobKey);
+    return true;
+}
+
+} // End namespace udg
@@ -0,0 +1,94 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGTHUMBNAILSERVICE_H
+#define UDGTHUMBNAILSERVICE_H
+
+#include <QObject>
+#include "singleton.h"
+
+#include <QImage>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+
+namespace ThreadWeaver {
+class Queue;
+}
+
+namespace udg {
+
+class Series;
+
+/**
+    Service that creates and saves thumbnails in the background, so that the retrieval and import of studies don't have to wait for the images to be
+    decoded, scaled and encoded as PNG.
+
+    Jobs are keyed by series instance UID and volume number, and run one at a time in a low priority thread in the order they are requested. The
+    thumbnailReady() signal is emitted from the thread of the service (the main thread) each time one has been saved. The jobs still queued when the
+    service is destroyed are cancelled, so that they don't delay the exit of the application.
+  */
+class ThumbnailService : public QObject, public SingletonPointer<ThumbnailService> {
+Q_OBJECT
+public:
+    /// Volume number used for the thumbnail of a whole series.
+    static const int SeriesThumbnailVolumeNumber;
+
+    /// Requests the creation of the thumbnail of the given volume of the given series from the given DICOM file, which will be saved to each of the given
+    /// paths. If keepExistingFiles is true, the paths where a file already exists when the job runs are skipped. If a job for the same series and volume
+    /// is still pending, the request is ignored.
+    void requestThumbnail(const QString &seriesInstanceUID, int volumeNumber, const QString &dicomFilePath, const QStringList &thumbnailFilePaths,
+                          bool keepExistingFiles = false);
+
+    /// Requests saving the given thumbnail, already created, of the given volume of the given series to each of the given paths. It's meant for files that
+    /// are already in memory, such as multiframe files being filled, which would be more expensive to read again from disk than to decode now.
+    void requestThumbnail(const QString &seriesInstanceUID, int volumeNumber, const QImage &thumbnail, const QStringList &thumbnailFilePaths);
+
+    /// Requests the creation of the thumbnail of the given series, to be saved to the given path if there's no file there yet. The thumbnails that don't
+    /// need to decode any image (series without images, key object notes, presentation states and structured reports) are created immediately.
+    void requestSeriesThumbnail(Series *series, const QString &thumbnailFilePath);
+
+signals:
+    /// Emitted when the thumbnail of the given volume of the given series has been saved. It's not emitted if it couldn't be created or saved.
+    void thumbnailReady(const QString &seriesInstanceUID, int volumeNumber);
+
+protected:
+    friend class SingletonPointer<ThumbnailService>;
+    explicit ThumbnailService(QObject *parent = 0);
+    ~ThumbnailService();
+
+private slots:
+    /// Called from a job when it has finished. Unmarks the job as pending and emits thumbnailReady() if the thumbnail has been saved.
+    void jobFinished(const QString &seriesInstanceUID, int volumeNumber, bool thumbnailSaved);
+
+private:
+    /// Returns the key that identifies the job of the given volume of the given series.
+    static QString getJobKey(const QString &seriesInstanceUID, int volumeNumber);
+
+    /// Marks the job of the given volume of the given series as pending. Returns false if it was already pending.
+    bool markJobAsPending(const QString &seriesInstanceUID, int volumeNumber);
+
+private:
+    /// Queue where the jobs are run, with a single thread.
+    ThreadWeaver::Queue *m_queue;
+
+    /// Keys of the jobs enqueued and not finished yet.
+    QSet<QString> m_pendingJobs;
+    /// Protects m_pendingJobs, because the requests can be made from any thread.
+    mutable QMutex m_pendingJobsMutex;
+};
+
+} // End namespace udg
+
+#endif
@@ -16,14 +16,45 @@
 
 #include "volume.h"
 #include "volumehelper.h"
+#include "volumepixeldata.h"
 #include "voilutpresetstooldata.h"
 #include "image.h"
 #include "logging.h"
 
+#include <QtCore/qmath.h>
+
 namespace udg {
 
 const double VoiLutHelper::DefaultPETWindowWidthThreshold = 0.5;
 
+namespace {
+
+// Returns in range the range of values that the given image can contain according to its bits stored, pixel representation and rescale
+void getStoredValuesRange(Image *image, double range[2])
+{
+    range[0] = range[1] = 0.0;
+
+    if (!image || image->getBitsStored() <= 0)
+    {
+        return;
+    }
+
+    double minimum = 0.0;
+    double maximum = qPow(2.0, image->getBitsStored()) - 1.0;
+    if (image->getPixelRepresentation() == 1)
+    {
+        minimum = -qPow(2.0, image->getBitsStored() - 1);
+        maximum = qPow(2.0, image->getBitsStored() - 1) - 1.0;
+    }
+
+    double rescaled1 = minimum * image->getRescaleSlope() + image->getRescaleIntercept();
+    double rescaled2 = maximum * image->getRescaleSlope() + image->getRescaleIntercept();
+    range[0] = qMin(rescaled1, rescaled2);
+    range[1] = qMax(rescaled1, rescaled2);
+}
+
+}
+
 VoiLutHelper::VoiLutHelper()
 {
 }
@@ -110,6 +141,16 @@ void VoiLutHelper::selectDefaultPreset(VoiLutPresetsToolData *voiLutData, Volume
     }
 }
 
+void VoiLutHelper::updateAutomaticPreset(VoiLutPresetsToolData *voiLutData, Volume *volume)
+{
+    if (!voiLutData || !volume)
+    {
+        return;
+    }
+
+    voiLutData->updatePreset(getCurrentAutomaticWindowLevel(volume));
+}
+
 QString VoiLutHelper::getDefaultVoiLutDescription(int index)
 {
     return QObject::tr("Default %1").arg(index);
@@ -123,7 +164,17 @@ WindowLevel VoiLutHelper::getCurrentAutomaticWindowLevel(Volume *volume)
     if (volume)
     {
         double range[2];
-        volume->getScalarRange(range);
+        VolumePixelData *pixelData = volume->getLoadedPixelData();
+        if (pixelData && !pixelData->areAllSlicesReady())
+        {
+            // The pixel data is still being decoded, so its values can't be used yet. The range of the stored values of the central image is used instead
+            // until it's complete.
+            getStoredValuesRange(volume->getImage(volume->getNumberOfSlicesPerPhase() / 2), range);
+        }
+        else
+        {
+            volume->getScalarRange(range);
+        }
         
         double windowWidth = range[1] - range[0];
         if (VolumeHelper::isPrimaryPET(volume) || VolumeHelper::isPrimaryNM(volume))
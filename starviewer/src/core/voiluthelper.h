@@ -38,6 +38,10 @@ public:
     /// Selects the default preset to apply on the given VOI LUT data corresponding to the given volume.
     static void selectDefaultPreset(VoiLutPresetsToolData *voiLutData, Volume *volume);
 
+    /// Computes again the automatic preset of the given VOI LUT data from the given volume. Used when the pixel data of the volume has been decoded after
+    /// the VOI LUT data was initialized.
+    void updateAutomaticPreset(VoiLutPresetsToolData *voiLutData, Volume *volume);
+
 private:
     /// Computes the automatic window level for the current input
     WindowLevel getCurrentAutomaticWindowLevel(Volume *volume);
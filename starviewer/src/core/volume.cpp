@@ -24,9 +24,17 @@
 #include "imageplane.h"
 #include "dicomtagreader.h"
 #include "volumehelper.h"
+#include "volumerepository.h"
 
 namespace udg {
 
+namespace {
+
+// Incremented on each access to the pixel data of any volume, it gives the order of the accesses
+QAtomicInt pixelDataAccessClock;
+
+}
+
 Volume::Volume(QObject *parent)
 : QObject(parent), m_checkedImagesAnatomicalPlane(false)
 {
@@ -68,6 +76,7 @@ void Volume::setPixelData(VolumePixelData *pixelData)
     m_volumePixelData = pixelData;
     // Set the number of phases to the new pixel data
     m_volumePixelData->setNumberOfPhases(m_numberOfPhases);
+    m_lastPixelDataAccess.store(pixelDataAccessClock.fetchAndAddRelaxed(1) + 1);
 }
 
 VolumePixelData* Volume::getPixelData()
@@ -81,8 +90,13 @@ VolumePixelData* Volume::getPixelData()
 
         // Set the number of phases to the new pixel data
         m_volumePixelData->setNumberOfPhases(m_numberOfPhases);
+
+        // Make room for the new pixel data if needed
+        VolumeRepository::getRepository()->enforcePixelDataMemoryBudget(this);
     }
 
+    m_lastPixelDataAccess.store(pixelDataAccessClock.fetchAndAddRelaxed(1) + 1);
+
     return m_volumePixelData;
 }
 
@@ -91,6 +105,32 @@ bool Volume::isPixelDataLoaded() const
     return m_volumePixelData && m_volumePixelData->isLoaded();
 }
 
+VolumePixelData* Volume::getLoadedPixelData() const
+{
+    return isPixelDataLoaded() ? m_volumePixelData : 0;
+}
+
+void Volume::releasePixelData()
+{
+    if (!isPixelDataLoaded())
+    {
+        return;
+    }
+
+    // The pixel data object may still be referenced, so only its data is released and the object is kept until the volume is destroyed, even if it's
+    // replaced when the data is read again
+    m_volumePixelData->releaseData();
+    if (!m_volumePixelData->parent())
+    {
+        m_volumePixelData->setParent(this);
+    }
+}
+
+int Volume::getLastPixelDataAccess() const
+{
+    return m_lastPixelDataAccess.load();
+}
+
 void Volume::getOrigin(double xyz[3])
 {
     getVtkData()->GetOrigin(xyz);
@@ -22,6 +22,7 @@
 #include "anatomicalplane.h"
 #include "orthogonalplane.h"
 // Qt
+#include <QAtomicInt>
 #include <QPixmap>
 #include <QVector>
 // FWD declarations
@@ -73,6 +74,16 @@ public:
     /// Si no el té els mètodes que pregunten sobre dades del volum poden donar respostes incorrectes.
     bool isPixelDataLoaded() const;
 
+    /// Returns the pixel data if it's loaded, or null otherwise. Unlike getPixelData(), it never reads the pixel data nor counts as an access to it.
+    VolumePixelData* getLoadedPixelData() const;
+
+    /// Releases the data of the pixel data, which will be read again the next time it's requested. The pixel data object itself is kept alive until the
+    /// volume is destroyed. It must not be called while the pixel data is being read or its image data is used.
+    void releasePixelData();
+
+    /// Returns a stamp of the last time the pixel data was requested or assigned. Greater stamps correspond to more recent accesses.
+    int getLastPixelDataAccess() const;
+
     /// Obté l'origen del volum
     void getOrigin(double xyz[3]);
     double* getOrigin();
@@ -247,6 +258,9 @@ private:
     /// Pixel data del volume
     VolumePixelData *m_volumePixelData;
 
+    /// Stamp of the last access to the pixel data, used by the volume repository to release the least recently used pixel data first.
+    QAtomicInt m_lastPixelDataAccess;
+
     /// TODO membre temporal per la transició al tractament de fases
     int m_numberOfPhases;
     int m_numberOfSlicesPerPhase;
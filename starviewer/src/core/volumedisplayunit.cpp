@@ -16,6 +16,7 @@
 
 #include "imagepipeline.h"
 #include "slicehandler.h"
+#include "slicelocator.h"
 #include "volume.h"
 #include "voilutpresetstooldata.h"
 #include "volumepixeldata.h"
@@ -36,6 +37,7 @@ VolumeDisplayUnit::VolumeDisplayUnit()
     m_imageActor = vtkImageActor::New();
     m_imageActor->GetProperty()->SetInterpolationTypeToCubic();
     m_sliceHandler = new SliceHandler();
+    m_sliceLocator = new SliceLocator();
     m_imagePointPicker =  0;
     m_voiLutData = 0;
     m_currentThickSlabPixelData = 0;
@@ -46,6 +48,7 @@ VolumeDisplayUnit::~VolumeDisplayUnit()
     delete m_imagePipeline;
     m_imageActor->Delete();
     delete m_sliceHandler;
+    delete m_sliceLocator;
     
     if (m_imagePointPicker)
     {
@@ -63,6 +66,7 @@ void VolumeDisplayUnit::setVolume(Volume *volume)
 {
     m_volume = volume;
     m_sliceHandler->setVolume(volume);
+    m_sliceLocator->setVolume(volume);
 
     resetThickSlab();
 
@@ -366,4 +370,9 @@ void VolumeDisplayUnit::setShutterData(vtkImageData *shutterData)
     m_imagePipeline->setShutterData(shutterData);
 }
 
+SliceLocator* VolumeDisplayUnit::getSliceLocator() const
+{
+    return m_sliceLocator;
+}
+
 }
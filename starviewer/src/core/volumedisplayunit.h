@@ -28,6 +28,7 @@ class Image;
 class ImagePipeline;
 class OrthogonalPlane;
 class SliceHandler;
+class SliceLocator;
 class Volume;
 class VoiLut;
 class VoiLutPresetsToolData;
@@ -139,6 +140,9 @@ public:
     /// Sets the display shutter image data.
     void setShutterData(vtkImageData *shutterData);
 
+    /// Returns the slice locator of the volume. It keeps an index of the slice positions, so it should be reused to locate slices in the same volume.
+    SliceLocator* getSliceLocator() const;
+
 private:
     /// Called when setting a new volume to reset the thick slab filter.
     void resetThickSlab();
@@ -158,6 +162,9 @@ private:
     /// The slice handler that controls slices, phases and slabs.
     SliceHandler *m_sliceHandler;
 
+    /// Locates slices of the volume from points.
+    SliceLocator *m_sliceLocator;
+
     /// Point picker to probe pixels from the image to display
     vtkPropPicker *m_imagePointPicker;
 
@@ -18,15 +18,17 @@
 #include "voxel.h"
 #include "mathtools.h"
 
+#include <vtkDataArray.h>
 #include <vtkImageChangeInformation.h>
 #include <vtkImageData.h>
+#include <vtkPointData.h>
 
 #include "logging.h"
 
 namespace udg {
 
 VolumePixelData::VolumePixelData(QObject *parent) :
-    QObject(parent), m_loaded(false)
+    QObject(parent), m_loaded(false), m_numberOfPendingSlices(0)
 {
     setNumberOfPhases(1);
     
@@ -122,11 +124,156 @@ void VolumePixelData::setNumberOfPhases(int numberOfPhases)
     }
 }
 
+int VolumePixelData::getNumberOfPhases() const
+{
+    return m_numberOfPhases;
+}
+
 bool VolumePixelData::isLoaded() const
 {
     return m_loaded;
 }
 
+void VolumePixelData::setAllSlicesPending(int numberOfSlices)
+{
+    QMutexLocker locker(&m_pendingSlicesMutex);
+    m_pendingSlices.fill(true, qMax(0, numberOfSlices));
+    m_numberOfPendingSlices = m_pendingSlices.size();
+}
+
+void VolumePixelData::setSliceReady(int slice)
+{
+    bool allReady = false;
+
+    {
+        QMutexLocker locker(&m_pendingSlicesMutex);
+
+        if (slice < 0 || slice >= m_pendingSlices.size() || !m_pendingSlices.testBit(slice))
+        {
+            return;
+        }
+
+        m_pendingSlices.clearBit(slice);
+        m_numberOfPendingSlices--;
+        allReady = m_numberOfPendingSlices == 0;
+    }
+
+    emit sliceReady(slice);
+
+    if (allReady)
+    {
+        emit allSlicesReady();
+    }
+}
+
+void VolumePixelData::setAllSlicesReady()
+{
+    {
+        QMutexLocker locker(&m_pendingSlicesMutex);
+
+        if (m_numberOfPendingSlices == 0)
+        {
+            return;
+        }
+
+        m_pendingSlices.fill(false);
+        m_numberOfPendingSlices = 0;
+    }
+
+    emit allSlicesReady();
+}
+
+bool VolumePixelData::isSliceReady(int slice) const
+{
+    QMutexLocker locker(&m_pendingSlicesMutex);
+    return m_numberOfPendingSlices == 0 || slice < 0 || slice >= m_pendingSlices.size() || !m_pendingSlices.testBit(slice);
+}
+
+bool VolumePixelData::areAllSlicesReady() const
+{
+    QMutexLocker locker(&m_pendingSlicesMutex);
+    return m_numberOfPendingSlices == 0;
+}
+
+void VolumePixelData::setPendingScalars(vtkDataArray *scalars)
+{
+    QMutexLocker locker(&m_pendingSlicesMutex);
+    m_pendingScalars = scalars;
+}
+
+bool VolumePixelData::hasPendingScalars() const
+{
+    QMutexLocker locker(&m_pendingSlicesMutex);
+    return m_pendingScalars.GetPointer() != 0;
+}
+
+void VolumePixelData::applyPendingScalars()
+{
+    vtkSmartPointer<vtkDataArray> scalars;
+
+    {
+        QMutexLocker locker(&m_pendingSlicesMutex);
+        scalars = m_pendingScalars;
+        m_pendingScalars = 0;
+    }
+
+    if (scalars)
+    {
+        m_imageDataVTK->GetPointData()->SetScalars(scalars);
+        m_imageDataVTK->Modified();
+    }
+
+    setAllSlicesReady();
+}
+
+bool VolumePixelData::isReferencedExternally() const
+{
+    if (!m_imageDataVTK)
+    {
+        return false;
+    }
+
+    // References held by this object: the smart pointer and, when used, the import and export filters
+    int internalReferences = 1;
+    if (m_itkToVtkFilter->GetOutput() == m_imageDataVTK.GetPointer())
+    {
+        internalReferences++;
+    }
+    if (m_vtkToItkFilter->GetExporter()->GetInput() == m_imageDataVTK.GetPointer())
+    {
+        internalReferences++;
+
+        // The ITK image returned by getItkData() points to the same buffer, and it's only held by the importer if nobody else uses it
+        if (m_vtkToItkFilter->GetImporter()->GetOutput()->GetReferenceCount() > 1)
+        {
+            return true;
+        }
+    }
+
+    return m_imageDataVTK->GetReferenceCount() > internalReferences;
+}
+
+qint64 VolumePixelData::getMemorySize() const
+{
+    if (!m_imageDataVTK)
+    {
+        return 0;
+    }
+
+    // GetActualMemorySize() returns kibibytes
+    return qint64(m_imageDataVTK->GetActualMemorySize()) * 1024;
+}
+
+void VolumePixelData::releaseData()
+{
+    m_imageDataVTK = vtkSmartPointer<vtkImageData>::New();
+    m_loaded = false;
+
+    // The filters may keep references to the released data
+    m_itkToVtkFilter = ItkToVtkFilterType::New();
+    m_vtkToItkFilter = VtkToItkFilterType::New();
+}
+
 void* VolumePixelData::getScalarPointer(int x, int y, int z)
 {
     return this->getVtkData()->GetScalarPointer(x, y, z);
@@ -253,6 +400,8 @@ void VolumePixelData::convertToNeutralPixelData()
         }
     }
     m_loaded = true;
+
+    setAllSlicesReady();
 }
 
 void VolumePixelData::setOrigin(double origin[3])
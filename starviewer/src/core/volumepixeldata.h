@@ -15,6 +15,8 @@
 #ifndef UDGVOLUMEPIXELDATA_H
 #define UDGVOLUMEPIXELDATA_H
 
+#include <QBitArray>
+#include <QMutex>
 #include <QObject>
 #include <QVector>
 
@@ -27,6 +29,7 @@
 // Converts a VTK image into an ITK image and plugs a vtk data pipeline to an ITK datapipeline.
 #include "itkVTKImageToImageFilter.h"
 
+class vtkDataArray;
 class vtkImageData;
 
 namespace udg {
@@ -70,10 +73,42 @@ public:
     /// This information is needed to be able to access to the right pixels when accessing through world coordinate
     /// The minimum value must be 1, is less than, the method will do nothing
     void setNumberOfPhases(int numberOfPhases);
+    /// Returns the number of phases of this pixel data. Slice z of phase p is stored at the z index z * numberOfPhases + p.
+    int getNumberOfPhases() const;
     
     /// Retorna cert si conté dades carregades.
     bool isLoaded() const;
 
+    /// Marks all the given number of slices (z indices of the image data) as not yet decoded. Used by progressive readers, which publish the pixel data
+    /// before all the slices have been read. Until this is called, all slices are considered ready.
+    void setAllSlicesPending(int numberOfSlices);
+    /// Marks the given slice (z index of the image data) as decoded and emits sliceReady(). Can be called from any thread.
+    void setSliceReady(int slice);
+    /// Marks all the slices as decoded. Can be called from any thread.
+    void setAllSlicesReady();
+    /// Returns true if the given slice (z index of the image data) has already been decoded. Can be called from any thread.
+    bool isSliceReady(int slice) const;
+    /// Returns true if all the slices have been decoded. Can be called from any thread.
+    bool areAllSlicesReady() const;
+
+    /// Sets the scalars that must replace the current ones when applyPendingScalars() is called. Used by progressive readers that have had to decode the data
+    /// again into new scalars after publishing the pixel data, which can't be modified from the reader thread while it's being rendered. Can be called from
+    /// any thread.
+    void setPendingScalars(vtkDataArray *scalars);
+    /// Returns true if there are scalars set with setPendingScalars() not yet applied. Can be called from any thread.
+    bool hasPendingScalars() const;
+    /// Replaces the current scalars with the pending ones, if any, and marks all the slices as decoded. Must be called from the thread that renders the data.
+    void applyPendingScalars();
+
+    /// Returns true if the image data is referenced from outside this object, e.g. by a visualization pipeline or through an ITK image obtained with
+    /// getItkData(), so that releasing this object wouldn't free its memory.
+    bool isReferencedExternally() const;
+    /// Returns the memory used by the image data, in bytes.
+    qint64 getMemorySize() const;
+    /// Frees the image data, leaving this object as not loaded. The object remains valid, so that it can be released while other objects still point to it,
+    /// but the image data must not be referenced externally.
+    void releaseData();
+
     /// Returns a pointer to the raw pixel data at index [x, y, z]. Avoid its use if possible and prefer using an iterator instead.
     void* getScalarPointer(int x, int y, int z);
     /// Returns a pointer to the raw pixel data. Avoid its use if possible and prefer using an iterator instead.
@@ -128,7 +163,13 @@ public:
 
     //  Obté el nombre de punts
     int getNumberOfPoints();
-   
+
+signals:
+    /// Emitted when a slice (z index of the image data) of a progressively loaded pixel data has been decoded. It's usually emitted from a reader thread.
+    void sliceReady(int slice);
+    /// Emitted when all the slices of a progressively loaded pixel data have been decoded. It's usually emitted from a reader thread.
+    void allSlicesReady();
+
 private:
     /// Filtres per importar/exportar
     typedef itk::ImageToVTKImageFilter<ItkImageType> ItkToVtkFilterType;
@@ -142,6 +183,16 @@ private:
 
     /// Number of phases of the pixel data. Its minimum value must be 1
     int m_numberOfPhases;
+
+    /// Slices not yet decoded by a progressive reader. A bit set to true means the slice is pending.
+    QBitArray m_pendingSlices;
+    /// Number of bits set in m_pendingSlices.
+    int m_numberOfPendingSlices;
+    /// Protects m_pendingSlices and m_numberOfPendingSlices, which are written by reader threads and read by the viewers.
+    mutable QMutex m_pendingSlicesMutex;
+
+    /// Scalars that will replace the current ones when applyPendingScalars() is called. Protected by m_pendingSlicesMutex.
+    vtkSmartPointer<vtkDataArray> m_pendingScalars;
     
     /// Filtres per passar de vtk a itk
     ItkToVtkFilterType::Pointer m_itkToVtkFilter;
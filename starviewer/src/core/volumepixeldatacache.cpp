@@ -0,0 +1,495 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "volumepixeldatacache.h"
+
+#include "coresettings.h"
+#include "directoryutilities.h"
+#include "logging.h"
+#include "series.h"
+#include "study.h"
+#include "volume.h"
+#include "volumepixeldata.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QGlobalStatic>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QThreadPool>
+
+#include <vtkCommand.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <new>
+
+namespace udg {
+
+namespace {
+
+// Identifies the cache files and their format version
+const quint32 CacheFileMagicNumber = 0x53564443;
+const qint32 CacheFileVersion = 1;
+// The scalars start at this offset, so that they are suitably aligned when mapped
+const qint64 CacheFileHeaderSize = 512;
+// Maximum amount of bytes written at once
+const qint64 WriteChunkSize = 64 * 1024 * 1024;
+
+// Contents of the header of a cache file.
+struct CacheFileHeader
+{
+    qint32 scalarType;
+    qint32 numberOfComponents;
+    qint32 extent[6];
+    double origin[3];
+    double spacing[3];
+    qint32 numberOfPhases;
+    qint64 dataSize;
+};
+
+// Orders cache entries from the least to the most recently used
+bool lessRecentlyUsed(const QFileInfo &entry1, const QFileInfo &entry2)
+{
+    return qMax(entry1.lastRead(), entry1.lastModified()) < qMax(entry2.lastRead(), entry2.lastModified());
+}
+
+QByteArray writeHeader(const CacheFileHeader &header)
+{
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream << CacheFileMagicNumber << CacheFileVersion << header.scalarType << header.numberOfComponents;
+    for (int i = 0; i < 6; i++)
+    {
+        stream << header.extent[i];
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        stream << header.origin[i];
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        stream << header.spacing[i];
+    }
+    stream << header.numberOfPhases << header.dataSize;
+
+    bytes.append(QByteArray(CacheFileHeaderSize - bytes.size(), '\0'));
+    return bytes;
+}
+
+bool readHeader(QFile &file, CacheFileHeader &header)
+{
+    QByteArray bytes = file.read(CacheFileHeaderSize);
+    if (bytes.size() != CacheFileHeaderSize)
+    {
+        return false;
+    }
+
+    QDataStream stream(bytes);
+    quint32 magicNumber;
+    qint32 version;
+    stream >> magicNumber >> version;
+    if (magicNumber != CacheFileMagicNumber || version != CacheFileVersion)
+    {
+        return false;
+    }
+
+    stream >> header.scalarType >> header.numberOfComponents;
+    for (int i = 0; i < 6; i++)
+    {
+        stream >> header.extent[i];
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        stream >> header.origin[i];
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        stream >> header.spacing[i];
+    }
+    stream >> header.numberOfPhases >> header.dataSize;
+
+    return stream.status() == QDataStream::Ok;
+}
+
+// Owns the file that provides the memory of a data array, so that it's kept mapped as long as the array exists. It must observe the DeleteEvent of the
+// array.
+class MappedFileOwnerCommand : public vtkCommand {
+public:
+    static MappedFileOwnerCommand* New()
+    {
+        return new MappedFileOwnerCommand();
+    }
+
+    void setFile(QFile *file)
+    {
+        m_file.reset(file);
+    }
+
+    virtual void Execute(vtkObject *caller, unsigned long eventId, void *callData)
+    {
+        Q_UNUSED(caller)
+        Q_UNUSED(eventId)
+        Q_UNUSED(callData)
+
+        m_file.reset();
+    }
+
+private:
+    QScopedPointer<QFile> m_file;
+};
+
+// Saves an entry in the cache and then keeps the cache within its maximum size.
+class SaveCacheEntryTask : public QRunnable {
+public:
+    SaveCacheEntryTask(const QString &cacheDirectory, const QString &cacheFilePath, vtkImageData *imageData, int numberOfPhases, qint64 maximumSize)
+        : m_cacheDirectory(cacheDirectory), m_cacheFilePath(cacheFilePath), m_imageData(imageData), m_numberOfPhases(numberOfPhases),
+          m_maximumSize(maximumSize)
+    {
+    }
+
+    virtual void run()
+    {
+        VolumePixelDataCache cache(m_cacheDirectory);
+        if (cache.save(m_cacheFilePath, m_imageData.GetPointer(), m_numberOfPhases))
+        {
+            cache.enforceMaximumSize(m_maximumSize);
+        }
+    }
+
+private:
+    QString m_cacheDirectory;
+    QString m_cacheFilePath;
+    vtkSmartPointer<vtkImageData> m_imageData;
+    int m_numberOfPhases;
+    qint64 m_maximumSize;
+};
+
+// Entries are saved one at a time, so that saving doesn't compete with reading for the disk more than needed
+Q_GLOBAL_STATIC(QThreadPool, savingThreadPool)
+
+}
+
+VolumePixelDataCache::VolumePixelDataCache()
+{
+    m_cacheDirectory = Settings().getValue(CoreSettings::DecodedVolumeCachePath).toString();
+}
+
+VolumePixelDataCache::VolumePixelDataCache(const QString &cacheDirectory)
+    : m_cacheDirectory(cacheDirectory)
+{
+}
+
+VolumePixelDataCache::~VolumePixelDataCache()
+{
+}
+
+bool VolumePixelDataCache::isEnabled()
+{
+    return Settings().getValue(CoreSettings::UseDecodedVolumeCache).toBool();
+}
+
+QString VolumePixelDataCache::getCacheFilePath(const Volume *volume, const QStringList &files, const QList<int> &frameNumbers,
+                                               const QString &readerName) const
+{
+    Series *series = volume->getSeries();
+    if (!series || !series->getParentStudy() || series->getInstanceUID().isEmpty() || series->getParentStudy()->getInstanceUID().isEmpty())
+    {
+        return QString();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(readerName.toUtf8());
+
+    foreach (const QString &file, files)
+    {
+        QFileInfo fileInfo(file);
+        if (!fileInfo.exists())
+        {
+            return QString();
+        }
+
+        hash.addData(fileInfo.absoluteFilePath().toUtf8());
+        hash.addData(QByteArray::number(fileInfo.size()));
+        hash.addData(QByteArray::number(fileInfo.lastModified().toMSecsSinceEpoch()));
+    }
+
+    foreach (int frameNumber, frameNumbers)
+    {
+        hash.addData(QByteArray::number(frameNumber));
+    }
+
+    return QDir(m_cacheDirectory).filePath(series->getParentStudy()->getInstanceUID() + "/" + series->getInstanceUID() + "/" +
+                                           QString(hash.result().toHex()) + ".raw");
+}
+
+VolumePixelData* VolumePixelDataCache::load(const QString &cacheFilePath) const
+{
+    QScopedPointer<QFile> file(new QFile(cacheFilePath));
+    if (!file->open(QIODevice::ReadOnly))
+    {
+        return 0;
+    }
+
+    CacheFileHeader header;
+    if (!readHeader(*file, header) || header.dataSize <= 0 || file->size() != CacheFileHeaderSize + header.dataSize)
+    {
+        WARN_LOG(QString("Invalid decoded volume cache file: %1").arg(cacheFilePath));
+        return 0;
+    }
+
+    vtkSmartPointer<vtkDataArray> scalars = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(header.scalarType));
+    if (!scalars || header.numberOfComponents < 1)
+    {
+        WARN_LOG(QString("Invalid scalar type or number of components in decoded volume cache file: %1").arg(cacheFilePath));
+        return 0;
+    }
+
+    qint64 numberOfValues = qint64(header.extent[1] - header.extent[0] + 1) * (header.extent[3] - header.extent[2] + 1) *
+                            (header.extent[5] - header.extent[4] + 1) * header.numberOfComponents;
+    if (numberOfValues * scalars->GetDataTypeSize() != header.dataSize)
+    {
+        WARN_LOG(QString("Size mismatch in decoded volume cache file: %1").arg(cacheFilePath));
+        return 0;
+    }
+
+    scalars->SetNumberOfComponents(header.numberOfComponents);
+
+    bool mapped = false;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 4, 0)
+    uchar *data = file->map(CacheFileHeaderSize, header.dataSize, QFileDevice::MapPrivateOption);
+    if (data)
+    {
+        // The array doesn't own the memory, the mapping is released when the file is destroyed, which happens when the array is destroyed
+        scalars->SetVoidArray(data, numberOfValues, 1);
+        vtkSmartPointer<MappedFileOwnerCommand> fileOwner = vtkSmartPointer<MappedFileOwnerCommand>::New();
+        fileOwner->setFile(file.take());
+        scalars->AddObserver(vtkCommand::DeleteEvent, fileOwner);
+        mapped = true;
+    }
+#endif
+
+    if (!mapped)
+    {
+        try
+        {
+            scalars->SetNumberOfTuples(numberOfValues / header.numberOfComponents);
+        }
+        catch (std::bad_alloc &e)
+        {
+            WARN_LOG(QString("Not enough memory to read decoded volume cache file %1: %2").arg(cacheFilePath).arg(e.what()));
+            return 0;
+        }
+
+        if (!file->seek(CacheFileHeaderSize) || file->read(static_cast<char*>(scalars->GetVoidPointer(0)), header.dataSize) != header.dataSize)
+        {
+            WARN_LOG(QString("Can't read decoded volume cache file: %1").arg(cacheFilePath));
+            return 0;
+        }
+    }
+
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetExtent(header.extent);
+    imageData->SetOrigin(header.origin);
+    imageData->SetSpacing(header.spacing);
+    imageData->GetPointData()->SetScalars(scalars);
+
+    VolumePixelData *pixelData = new VolumePixelData();
+    pixelData->setData(imageData);
+    pixelData->setNumberOfPhases(header.numberOfPhases);
+
+    DEBUG_LOG(QString("Pixel data loaded from decoded volume cache file %1 (%2)").arg(cacheFilePath).arg(mapped ? "mapped" : "read"));
+
+    return pixelData;
+}
+
+bool VolumePixelDataCache::save(const QString &cacheFilePath, VolumePixelData *pixelData, int numberOfPhases) const
+{
+    return save(cacheFilePath, pixelData ? pixelData->getVtkData() : 0, numberOfPhases);
+}
+
+void VolumePixelDataCache::saveInBackground(const QString &cacheFilePath, VolumePixelData *pixelData, int numberOfPhases) const
+{
+    vtkImageData *imageData = pixelData ? pixelData->getVtkData() : 0;
+    if (!imageData || !imageData->GetPointData()->GetScalars())
+    {
+        return;
+    }
+
+    // The task keeps its own image data sharing the scalars, so that they are kept as they are now even if the pixel data changes or is released
+    vtkSmartPointer<vtkImageData> snapshot = vtkSmartPointer<vtkImageData>::New();
+    snapshot->ShallowCopy(imageData);
+
+    savingThreadPool()->setMaxThreadCount(1);
+    savingThreadPool()->start(new SaveCacheEntryTask(m_cacheDirectory, cacheFilePath, snapshot, numberOfPhases, getMaximumSize()));
+}
+
+bool VolumePixelDataCache::save(const QString &cacheFilePath, vtkImageData *imageData, int numberOfPhases) const
+{
+    if (!imageData || !imageData->GetPointData()->GetScalars())
+    {
+        return false;
+    }
+
+    vtkDataArray *scalars = imageData->GetPointData()->GetScalars();
+
+    CacheFileHeader header;
+    header.scalarType = scalars->GetDataType();
+    header.numberOfComponents = scalars->GetNumberOfComponents();
+    imageData->GetExtent(header.extent);
+    imageData->GetOrigin(header.origin);
+    imageData->GetSpacing(header.spacing);
+    header.numberOfPhases = numberOfPhases;
+    header.dataSize = qint64(scalars->GetNumberOfTuples()) * scalars->GetNumberOfComponents() * scalars->GetDataTypeSize();
+
+    if (!QDir().mkpath(QFileInfo(cacheFilePath).absolutePath()))
+    {
+        WARN_LOG(QString("Can't create the directory for decoded volume cache file: %1").arg(cacheFilePath));
+        return false;
+    }
+
+    QString temporaryFilePath = cacheFilePath + ".part";
+    QFile file(temporaryFilePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        WARN_LOG(QString("Can't create decoded volume cache file %1: %2").arg(temporaryFilePath).arg(file.errorString()));
+        return false;
+    }
+
+    bool ok = file.write(writeHeader(header)) == CacheFileHeaderSize;
+
+    const char *data = static_cast<const char*>(scalars->GetVoidPointer(0));
+    qint64 written = 0;
+    while (ok && written < header.dataSize)
+    {
+        qint64 chunkSize = qMin(WriteChunkSize, header.dataSize - written);
+        ok = file.write(data + written, chunkSize) == chunkSize;
+        written += chunkSize;
+    }
+
+    file.close();
+
+    if (!ok)
+    {
+        WARN_LOG(QString("Can't write decoded volume cache file %1: %2").arg(temporaryFilePath).arg(file.errorString()));
+        file.remove();
+        return false;
+    }
+
+    QFile::remove(cacheFilePath);
+    if (!QFile::rename(temporaryFilePath, cacheFilePath))
+    {
+        WARN_LOG(QString("Can't rename decoded volume cache file %1 to %2").arg(temporaryFilePath).arg(cacheFilePath));
+        QFile::remove(temporaryFilePath);
+        return false;
+    }
+
+    return true;
+}
+
+void VolumePixelDataCache::enforceMaximumSize(qint64 maximumSize) const
+{
+    if (maximumSize <= 0)
+    {
+        return;
+    }
+
+    QFileInfoList entries;
+    qint64 totalSize = 0;
+    foreach (const QFileInfo &studyDirectory, QDir(m_cacheDirectory).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        foreach (const QFileInfo &seriesDirectory, QDir(studyDirectory.absoluteFilePath()).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot))
+        {
+            foreach (const QFileInfo &entry, QDir(seriesDirectory.absoluteFilePath()).entryInfoList(QStringList("*.raw"), QDir::Files))
+            {
+                entries << entry;
+                totalSize += entry.size();
+            }
+        }
+    }
+
+    if (totalSize <= maximumSize)
+    {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), lessRecentlyUsed);
+
+    foreach (const QFileInfo &entry, entries)
+    {
+        if (totalSize <= maximumSize)
+        {
+            break;
+        }
+
+        // Mapped entries can still be removed, their data remains available until they are unmapped
+        if (QFile::remove(entry.absoluteFilePath()))
+        {
+            totalSize -= entry.size();
+
+            // Remove the series and study directories if they have been left empty
+            QDir directory = entry.absoluteDir();
+            QString seriesDirectoryName = directory.dirName();
+            directory.cdUp();
+            if (directory.rmdir(seriesDirectoryName))
+            {
+                QString studyDirectoryName = directory.dirName();
+                directory.cdUp();
+                directory.rmdir(studyDirectoryName);
+            }
+        }
+        else
+        {
+            WARN_LOG(QString("Can't remove decoded volume cache file: %1").arg(entry.absoluteFilePath()));
+        }
+    }
+
+    INFO_LOG(QString("Decoded volume cache reduced to %1 MB (maximum %2 MB)").arg(totalSize / (1024 * 1024)).arg(maximumSize / (1024 * 1024)));
+}
+
+qint64 VolumePixelDataCache::getMaximumSize()
+{
+    return Settings().getValue(CoreSettings::DecodedVolumeCacheMaximumSize).toLongLong() * 1024 * 1024;
+}
+
+bool VolumePixelDataCache::removeStudy(const QString &studyInstanceUID) const
+{
+    QString studyDirectory = QDir(m_cacheDirectory).filePath(studyInstanceUID);
+    if (studyInstanceUID.isEmpty() || !QDir(studyDirectory).exists())
+    {
+        return true;
+    }
+
+    return DirectoryUtilities().deleteDirectory(studyDirectory, true);
+}
+
+bool VolumePixelDataCache::removeSeries(const QString &studyInstanceUID, const QString &seriesInstanceUID) const
+{
+    QString seriesDirectory = QDir(m_cacheDirectory).filePath(studyInstanceUID + "/" + seriesInstanceUID);
+    if (studyInstanceUID.isEmpty() || seriesInstanceUID.isEmpty() || !QDir(seriesDirectory).exists())
+    {
+        return true;
+    }
+
+    return DirectoryUtilities().deleteDirectory(seriesDirectory, true);
+}
+
+} // End namespace udg
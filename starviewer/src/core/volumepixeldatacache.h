@@ -0,0 +1,89 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGVOLUMEPIXELDATACACHE_H
+#define UDGVOLUMEPIXELDATACACHE_H
+
+#include <QString>
+
+class vtkImageData;
+
+namespace udg {
+
+class Volume;
+class VolumePixelData;
+
+/**
+    On-disk cache of decoded pixel data, so that volumes that have already been read don't need to be decoded again.
+
+    Each entry is a raw file with a small header (scalar type, number of components, extent, origin, spacing and number of phases) followed by the scalars.
+    Entries are stored in a directory per study and series, and their names are computed from the paths, sizes and modification times of the files the
+    pixel data was read from, so that any change in the files invalidates the cached data.
+
+    When loaded, the scalars are memory-mapped copy-on-write from the cache file, so that they can be paged out without using the swap file and modifying
+    them doesn't modify the cache. The mapping lasts as long as the scalars array. With Qt versions older than 5.4, which can't map files privately, they are
+    read into memory instead.
+
+    The total size of the entries is limited by the setting CoreSettings::DecodedVolumeCacheMaximumSize. When it's exceeded after saving an entry, the least
+    recently used entries are removed.
+  */
+class VolumePixelDataCache {
+public:
+    /// Creates a cache stored in the directory set in the settings.
+    VolumePixelDataCache();
+    /// Creates a cache stored in the given directory.
+    explicit VolumePixelDataCache(const QString &cacheDirectory);
+    ~VolumePixelDataCache();
+
+    /// Returns true if the decoded volume cache is enabled in the settings.
+    static bool isEnabled();
+
+    /// Returns the path of the cache file for the pixel data read from the given files with the given frame numbers by the given kind of reader, or an empty
+    /// string if it can't be computed (some file doesn't exist or the volume has no study or series UID).
+    QString getCacheFilePath(const Volume *volume, const QStringList &files, const QList<int> &frameNumbers, const QString &readerName) const;
+
+    /// Loads the pixel data stored in the given cache file. Returns null if the file doesn't exist or it isn't valid. The returned pixel data may keep the
+    /// file mapped until it is destroyed.
+    VolumePixelData* load(const QString &cacheFilePath) const;
+
+    /// Saves the given pixel data to the given cache file, with the given number of phases. The file is written with a temporary name and renamed when
+    /// complete, so that an interrupted save doesn't leave a partial entry. Returns true if successful.
+    bool save(const QString &cacheFilePath, VolumePixelData *pixelData, int numberOfPhases) const;
+    bool save(const QString &cacheFilePath, vtkImageData *imageData, int numberOfPhases) const;
+
+    /// Saves the given pixel data to the given cache file in a background thread and then removes the least recently used entries if the cache exceeds its
+    /// maximum size. The current image data of the pixel data is saved, even if it's replaced or released before the save begins.
+    void saveInBackground(const QString &cacheFilePath, VolumePixelData *pixelData, int numberOfPhases) const;
+
+    /// Removes the least recently used entries until the total size of the entries is not greater than the given size, in bytes. If the size is 0 or less,
+    /// it does nothing.
+    void enforceMaximumSize(qint64 maximumSize) const;
+
+    /// Returns the maximum size of the cache set in the settings, in bytes, or 0 if there's no limit.
+    static qint64 getMaximumSize();
+
+    /// Removes all the cached entries of the given study.
+    bool removeStudy(const QString &studyInstanceUID) const;
+    /// Removes all the cached entries of the given series.
+    bool removeSeries(const QString &studyInstanceUID, const QString &seriesInstanceUID) const;
+
+private:
+    /// Directory where the cache files are stored.
+    QString m_cacheDirectory;
+
+};
+
+} // End namespace udg
+
+#endif
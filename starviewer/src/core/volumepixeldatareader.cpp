@@ -20,6 +20,7 @@ VolumePixelDataReader::VolumePixelDataReader(QObject *parent)
 : QObject(parent)
 {
     m_volumePixelData = NULL;
+    m_progressiveLoadingEnabled = false;
 }
 
 VolumePixelDataReader::~VolumePixelDataReader()
@@ -31,6 +32,21 @@ void VolumePixelDataReader::setFrameNumbers(const QList<int> &frameNumbers)
     m_frameNumbers = frameNumbers;
 }
 
+void VolumePixelDataReader::setProgressiveLoadingEnabled(bool enabled)
+{
+    m_progressiveLoadingEnabled = enabled;
+}
+
+bool VolumePixelDataReader::isProgressiveLoadingEnabled() const
+{
+    return m_progressiveLoadingEnabled;
+}
+
+void VolumePixelDataReader::setFocusSlice(int slice)
+{
+    Q_UNUSED(slice)
+}
+
 VolumePixelData* VolumePixelDataReader::getVolumePixelData()
 {
     return m_volumePixelData;
@@ -40,6 +40,16 @@ public:
     /// Sets the list of frame numbers in the order they must be read from a multiframe file.
     void setFrameNumbers(const QList<int> &frameNumbers);
 
+    /// Enables or disables progressive loading. When enabled, readers that support it create the pixel data as soon as it is allocated, emit
+    /// pixelDataAllocated() and then mark each slice as ready in the pixel data as it is decoded. Readers that don't support it ignore this setting.
+    void setProgressiveLoadingEnabled(bool enabled);
+    /// Returns true if progressive loading has been requested.
+    bool isProgressiveLoadingEnabled() const;
+
+    /// Asks the reader to decode first the slices (z indices) nearest to the given one. It can be called from any thread while reading.
+    /// By default it does nothing; readers that can choose the decoding order should reimplement it.
+    virtual void setFocusSlice(int slice);
+
     /// Donada una llista de noms de fitxer, la llegeix i omple
     /// l'estructura d'imatge que fem servir internament.
     /// Ens retorna un enter que ens indicarà si hi ha hagut alguna mena d'error en el
@@ -58,6 +68,10 @@ signals:
     /// Ens indica el progrés del procés de lectura
     void progress(int progress);
 
+    /// Emitted from the reading thread, when progressive loading is enabled, as soon as the pixel data has been allocated and before it has been filled.
+    /// From this moment getVolumePixelData() returns the pixel data being filled.
+    void pixelDataAllocated();
+
 protected:
     /// List of frame numbers in the order they must be read from a multiframe file. Can be ignored for single-frame files.
     QList<int> m_frameNumbers;
@@ -65,6 +79,9 @@ protected:
     /// Les dades d'imatge en format vtk
     VolumePixelData *m_volumePixelData;
 
+    /// True if progressive loading has been requested.
+    bool m_progressiveLoadingEnabled;
+
 };
 
 } // End namespace udg
@@ -14,13 +14,17 @@
 
 #include "volumepixeldatareadervtkdcmtk.h"
 
+#include "coresettings.h"
 #include "logging.h"
 #include "volumepixeldata.h"
 #include "vtkdcmtkimagereader.h"
 
 #include <QStringList>
+#include <QThread>
 
 #include <vtkEventQtSlotConnect.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
 #include <vtkStringArray.h>
 
 namespace udg {
@@ -33,6 +37,10 @@ VolumePixelDataReaderVTKDCMTK::VolumePixelDataReaderVTKDCMTK(QObject *parent) :
     // VTK progress
     m_vtkQtConnections = vtkEventQtSlotConnect::New();
     m_vtkQtConnections->Connect(m_reader, vtkCommand::ProgressEvent, this, SLOT(progressSlot()));
+    // Progressive loading
+    m_vtkQtConnections->Connect(m_reader, VtkDcmtkImageReader::OutputAllocatedEvent, this, SLOT(outputAllocatedSlot()));
+    m_vtkQtConnections->Connect(m_reader, VtkDcmtkImageReader::SliceDecodedEvent, this,
+                                SLOT(sliceDecodedSlot(vtkObject*, unsigned long, void*, void*)));
 }
 
 VolumePixelDataReaderVTKDCMTK::~VolumePixelDataReaderVTKDCMTK()
@@ -45,6 +53,8 @@ int VolumePixelDataReaderVTKDCMTK::read(const QStringList &filenames)
 {
     int errorCode = NoError;
     m_abortRequested = false;
+    m_publishedScalarsOutdated = false;
+    m_volumePixelData = NULL;
 
     if (filenames.isEmpty())
     {
@@ -75,6 +85,14 @@ int VolumePixelDataReaderVTKDCMTK::read(const QStringList &filenames)
     // Set frame numbers to the reader (needed for multiframe files)
     m_reader->setFrameNumbers(m_frameNumbers);
 
+    // Decode multi-file series in parallel
+    int numberOfDecodingThreads = Settings().getValue(CoreSettings::NumberOfThreadsForVtkDcmtkDecoding).toInt();
+    if (numberOfDecodingThreads <= 0)
+    {
+        numberOfDecodingThreads = QThread::idealThreadCount();
+    }
+    m_reader->setNumberOfDecodingThreads(numberOfDecodingThreads);
+
     try
     {
         m_reader->Update();
@@ -109,8 +127,27 @@ int VolumePixelDataReaderVTKDCMTK::read(const QStringList &filenames)
 
     emit progress(100);
 
-    m_volumePixelData = new VolumePixelData();
-    m_volumePixelData->setData(m_reader->GetOutput());
+    if (m_volumePixelData)
+    {
+        // Already published by progressive loading. It may be being rendered, so it is completed with the final scalars from the rendering thread through
+        // applyPendingScalars(). If the read has failed it is left as it is, to be converted to a neutral pixel data from that thread too.
+        if (errorCode == NoError)
+        {
+            if (m_publishedScalarsOutdated)
+            {
+                m_volumePixelData->setPendingScalars(m_reader->GetOutput()->GetPointData()->GetScalars());
+            }
+            else
+            {
+                m_volumePixelData->setAllSlicesReady();
+            }
+        }
+    }
+    else
+    {
+        m_volumePixelData = new VolumePixelData();
+        m_volumePixelData->setData(m_reader->GetOutput());
+    }
 
     return errorCode;
 }
@@ -121,9 +158,58 @@ void VolumePixelDataReaderVTKDCMTK::requestAbort()
     m_reader->AbortExecuteOn();
 }
 
+void VolumePixelDataReaderVTKDCMTK::setFocusSlice(int slice)
+{
+    m_reader->setDecodingFocusSlice(slice);
+}
+
 void VolumePixelDataReaderVTKDCMTK::progressSlot()
 {
     emit progress(static_cast<int>(m_reader->GetProgress() * 100));
 }
 
+void VolumePixelDataReaderVTKDCMTK::outputAllocatedSlot()
+{
+    if (!m_progressiveLoadingEnabled)
+    {
+        return;
+    }
+
+    vtkImageData *output = m_reader->GetOutput();
+    int extent[6];
+    output->GetExtent(extent);
+
+    if (!m_volumePixelData)
+    {
+        // The published image data is a different object sharing the scalars, so that the reader can allocate new scalars for its output if it has to
+        // restart the read without touching the image data being rendered
+        vtkImageData *publishedData = vtkImageData::New();
+        publishedData->ShallowCopy(output);
+
+        m_volumePixelData = new VolumePixelData();
+        m_volumePixelData->setData(publishedData);
+        m_volumePixelData->setAllSlicesPending(extent[5] - extent[4] + 1);
+        publishedData->Delete();
+        emit pixelDataAllocated();
+    }
+    else
+    {
+        // The read has been restarted with a new scalar type. The published pixel data keeps the old scalars until the read finishes, and the slices decoded
+        // from now on are not notified because they are not in them.
+        m_publishedScalarsOutdated = true;
+    }
+}
+
+void VolumePixelDataReaderVTKDCMTK::sliceDecodedSlot(vtkObject *caller, unsigned long eventId, void *clientData, void *callData)
+{
+    Q_UNUSED(caller)
+    Q_UNUSED(eventId)
+    Q_UNUSED(clientData)
+
+    if (m_progressiveLoadingEnabled && m_volumePixelData && !m_publishedScalarsOutdated)
+    {
+        m_volumePixelData->setSliceReady(*static_cast<int*>(callData));
+    }
+}
+
 } // end namespace udg
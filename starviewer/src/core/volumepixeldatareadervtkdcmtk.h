@@ -18,6 +18,7 @@
 #include "volumepixeldatareader.h"
 
 class vtkEventQtSlotConnect;
+class vtkObject;
 
 namespace udg {
 
@@ -41,10 +42,17 @@ public:
     /// Requests abortion of the current read operation.
     virtual void requestAbort();
 
+    /// Asks the reader to decode first the slices nearest to the given one.
+    virtual void setFocusSlice(int slice);
+
 private slots:
 
     /// Receives the VTK progress event from the reader and emits the Qt progress signal.
     void progressSlot();
+    /// Receives the output allocated event from the reader and, if progressive loading is enabled, publishes the pixel data being filled.
+    void outputAllocatedSlot();
+    /// Receives the slice decoded event from the reader and, if progressive loading is enabled, marks the slice as ready in the pixel data.
+    void sliceDecodedSlot(vtkObject *caller, unsigned long eventId, void *clientData, void *callData);
 
 private:
 
@@ -54,6 +62,9 @@ private:
     vtkEventQtSlotConnect *m_vtkQtConnections;
     /// True when a read abortion has been requested.
     bool m_abortRequested;
+    /// True when the read has been restarted with a new scalar type after publishing the pixel data, which keeps the scalars of the first attempt until the
+    /// read finishes.
+    bool m_publishedScalarsOutdated;
 
 };
 
@@ -19,8 +19,10 @@
 #include "postprocessor.h"
 #include "starviewerapplication.h"
 #include "volume.h"
+#include "volumepixeldatacache.h"
 #include "volumepixeldatareader.h"
 #include "volumepixeldatareaderfactory.h"
+#include "volumerepository.h"
 
 #include <QMessageBox>
 #include <QtConcurrentMap>
@@ -38,7 +40,8 @@ int getFrameNumber(const Image *image)
 }
 
 VolumeReader::VolumeReader(QObject *parent)
-    : QObject(parent), m_volumePixelDataReader(0), m_abortRequested(false)
+    : QObject(parent), m_volumePixelDataReader(0), m_abortRequested(false), m_progressiveLoadingEnabled(false), m_focusSlice(-1), m_volumeBeingRead(0),
+      m_pixelDataPublished(false)
 {
      m_lastError = VolumePixelDataReader::NoError;
 }
@@ -77,6 +80,8 @@ void VolumeReader::executePixelDataReader(Volume *volume)
             return;
         }
 
+        VolumeRepository::getRepository()->countPixelDataRead();
+
         // Posem a punt el reader i llegim les dades
         this->setUpReader(volume);
 
@@ -84,6 +89,28 @@ void VolumeReader::executePixelDataReader(Volume *volume)
         QList<int> frameNumbers = QtConcurrent::blockingMapped(volume->getImages(), getFrameNumber);
         m_volumePixelDataReader->setFrameNumbers(frameNumbers);
 
+        QString cacheFilePath;
+        if (VolumePixelDataCache::isEnabled())
+        {
+            cacheFilePath = VolumePixelDataCache().getCacheFilePath(volume, fileList, frameNumbers, m_volumePixelDataReader->metaObject()->className());
+            if (!cacheFilePath.isEmpty() && loadFromDecodedVolumeCache(volume, cacheFilePath))
+            {
+                emit progress(100);
+                return;
+            }
+        }
+
+        m_volumeBeingRead = volume;
+        m_pixelDataPublished = false;
+
+        if (m_progressiveLoadingEnabled)
+        {
+            // By default the first slice is the first one shown
+            m_volumePixelDataReader->setProgressiveLoadingEnabled(true);
+            m_volumePixelDataReader->setFocusSlice(m_focusSlice >= 0 ? m_focusSlice : 0);
+            connect(m_volumePixelDataReader, SIGNAL(pixelDataAllocated()), SLOT(publishPixelData()), Qt::DirectConnection);
+        }
+
         if (m_abortRequested)
         {
             m_lastError = VolumePixelDataReader::ReadAborted;
@@ -93,14 +120,27 @@ void VolumeReader::executePixelDataReader(Volume *volume)
             m_lastError = m_volumePixelDataReader->read(fileList);
             if (m_lastError == VolumePixelDataReader::NoError)
             {
-                // Tot ha anat ok, assignem les dades al volum
-                volume->setPixelData(m_volumePixelDataReader->getVolumePixelData());
-                runPostprocessors(volume);
-                fixSpacingIssues(volume);
+                // Tot ha anat ok, assignem les dades al volum si no s'ha fet ja durant la càrrega progressiva
+                if (!m_pixelDataPublished)
+                {
+                    volume->setPixelData(m_volumePixelDataReader->getVolumePixelData());
+                    runPostprocessors(volume);
+                    fixSpacingIssues(volume);
+                }
+
+                // If the read has been restarted after publishing the pixel data, its final scalars are not applied yet and it's not cached
+                if (!cacheFilePath.isEmpty() && !volume->getPixelData()->hasPendingScalars())
+                {
+                    VolumePixelDataCache().saveInBackground(cacheFilePath, volume->getPixelData(), volume->getNumberOfPhases());
+                }
             }
             else
             {
-                volume->convertToNeutralVolume();
+                // The published pixel data may be being rendered, so it's left to the caller to convert it from the rendering thread
+                if (!m_pixelDataPublished)
+                {
+                    volume->convertToNeutralVolume();
+                }
                 this->logWarningLastError(fileList);
             }
         }
@@ -130,6 +170,58 @@ void VolumeReader::requestAbort()
     m_abortRequested = true;
 }
 
+void VolumeReader::setProgressiveLoadingEnabled(bool enabled)
+{
+    m_progressiveLoadingEnabled = enabled;
+}
+
+void VolumeReader::setFocusSlice(int slice)
+{
+    m_focusSlice = slice;
+
+    if (m_volumePixelDataReader)
+    {
+        m_volumePixelDataReader->setFocusSlice(slice);
+    }
+}
+
+bool VolumeReader::hasPublishedPixelData() const
+{
+    return m_pixelDataPublished;
+}
+
+void VolumeReader::publishPixelData()
+{
+    if (!m_volumeBeingRead || !m_volumePixelDataReader->getVolumePixelData())
+    {
+        return;
+    }
+
+    // Geometry is already known at this point, so postprocessors can be run before the slices are decoded
+    m_volumeBeingRead->setPixelData(m_volumePixelDataReader->getVolumePixelData());
+    runPostprocessors(m_volumeBeingRead);
+    fixSpacingIssues(m_volumeBeingRead);
+    m_pixelDataPublished = true;
+
+    emit pixelDataAvailable();
+}
+
+bool VolumeReader::loadFromDecodedVolumeCache(Volume *volume, const QString &cacheFilePath)
+{
+    VolumePixelData *pixelData = VolumePixelDataCache().load(cacheFilePath);
+    if (!pixelData)
+    {
+        return false;
+    }
+
+    // The cached geometry is the one obtained after postprocessing, but postprocessors are run again to fill the volume information that depends on them
+    volume->setPixelData(pixelData);
+    runPostprocessors(volume);
+    fixSpacingIssues(volume);
+
+    return true;
+}
+
 void VolumeReader::showMessageBoxWithLastError() const
 {
     if (m_lastError == VolumePixelDataReader::NoError)
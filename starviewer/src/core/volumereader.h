@@ -57,12 +57,31 @@ public:
     /// Si no hi ha cap "últim error" es retorna un QString buit.
     QString getLastErrorMessageToUser() const;
 
+    /// Enables or disables progressive loading. When enabled and supported by the pixel data reader, the pixel data is assigned to the volume as soon as it
+    /// is allocated, pixelDataAvailable() is emitted and slices are marked as ready in the pixel data while they are decoded.
+    void setProgressiveLoadingEnabled(bool enabled);
+
+    /// Asks to decode first the slices (z indices) nearest to the given one. Can be called from any thread before or while reading.
+    void setFocusSlice(int slice);
+
+    /// Returns true if the last read has assigned the pixel data to the volume before decoding it, with progressive loading. In that case the pixel data may
+    /// be being rendered, so the caller must call applyPendingScalars() on it after a successful read, or convert the volume to a neutral volume after a
+    /// failed one, from the thread that renders it.
+    bool hasPublishedPixelData() const;
+
 signals:
     /// Ens indica el progrés del procés de lectura
     /// TODO: De moment quan es vulgui llegir només un fitxer, p.ex. multiframes, mamos, etc. per limitacions de la lectura,
     /// no tindrem cap tipus de progrés.
     void progress(int progress);
 
+    /// Emitted when progressive loading is enabled, once the volume has been assigned its pixel data and before all the slices have been decoded.
+    void pixelDataAvailable();
+
+private slots:
+    /// Assigns the pixel data being filled by the pixel data reader to the volume being read and emits pixelDataAvailable().
+    void publishPixelData();
+
 private:
     /// Executa el pixel reader i llegeix el volume
     void executePixelDataReader(Volume *volume);
@@ -71,6 +90,9 @@ private:
     /// Si no s'ha produit cap error, no fa res.
     void logWarningLastError(const QStringList &fileList) const;
 
+    /// Assigns to the volume the pixel data stored in the given decoded volume cache file and runs the postprocessors. Returns false if it can't be loaded.
+    bool loadFromDecodedVolumeCache(Volume *volume, const QString &cacheFilePath);
+
     /// Arregla l'spacing en els casos que sabem que les llibreries fallen en aquest càlcul
     void fixSpacingIssues(Volume *volume);
 
@@ -98,6 +120,15 @@ private:
     /// Used to know that abort has been requested before having the pixel data reader.
     bool m_abortRequested;
 
+    /// True if progressive loading has been requested.
+    bool m_progressiveLoadingEnabled;
+    /// Slice to decode first, or -1 if none has been requested.
+    int m_focusSlice;
+    /// Volume being read, needed to publish its pixel data during progressive loading.
+    Volume *m_volumeBeingRead;
+    /// True if the pixel data has already been assigned to the volume during progressive loading.
+    bool m_pixelDataPublished;
+
 };
 
 } // End namespace udg
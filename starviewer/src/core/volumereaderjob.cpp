@@ -16,7 +16,9 @@
 
 #include "volumereader.h"
 #include "volume.h"
+#include "volumepixeldata.h"
 #include "logging.h"
+#include "coresettings.h"
 
 namespace udg {
 
@@ -28,6 +30,8 @@ VolumeReaderJob::VolumeReaderJob(Volume *volume, QObject *parent)
     m_volumeReadSuccessfully = false;
     m_lastErrorMessageToUser = "";
     m_abortRequested = false;
+    m_pixelDataAvailable = false;
+    m_focusSlice = -1;
 }
 
 VolumeReaderJob::~VolumeReaderJob()
@@ -49,6 +53,22 @@ void VolumeReaderJob::requestAbort()
     }
 }
 
+void VolumeReaderJob::setFocusSlice(int slice)
+{
+    QMutexLocker locker(&m_volumeReaderToAbortMutex);
+
+    m_focusSlice = slice;
+    if (!m_volumeReaderToAbort.isNull())
+    {
+        m_volumeReaderToAbort.data()->setFocusSlice(slice);
+    }
+}
+
+bool VolumeReaderJob::isPixelDataAvailable() const
+{
+    return m_pixelDataAvailable;
+}
+
 bool VolumeReaderJob::success() const
 {
     return m_volumeReadSuccessfully && !m_abortRequested;
@@ -85,12 +105,21 @@ void VolumeReaderJob::run(ThreadWeaver::JobPointer self, ThreadWeaver::Thread *t
         // assegurar-nos que si salta una excepció s'alliberarà el lock.
         QMutexLocker locker(&m_volumeReaderToAbortMutex);
         m_volumeReaderToAbort = volumeReader;
+        volumeReader->setFocusSlice(m_focusSlice);
     }
 
     connect(volumeReader, SIGNAL(progress(int)), SLOT(updateProgress(int)));
+    connect(volumeReader, SIGNAL(pixelDataAvailable()), SLOT(notifyPixelDataAvailable()));
+    volumeReader->setProgressiveLoadingEnabled(Settings().getValue(CoreSettings::AllowProgressiveVolumeLoading).toBool());
     m_volumeReadSuccessfully = volumeReader->readWithoutShowingError(m_volumeToRead);
     m_lastErrorMessageToUser = volumeReader->getLastErrorMessageToUser();
 
+    if (volumeReader->hasPublishedPixelData())
+    {
+        // The pixel data may be being rendered, so it must be completed from the thread of the job object, before done() is received
+        QMetaObject::invokeMethod(this, "completePublishedPixelData", Qt::QueuedConnection);
+    }
+
     {
         QMutexLocker locker(&m_volumeReaderToAbortMutex);
 
@@ -117,4 +146,23 @@ void VolumeReaderJob::updateProgress(int value)
     emit progress(this, value);
 }
 
+void VolumeReaderJob::completePublishedPixelData()
+{
+    if (m_volumeReadSuccessfully)
+    {
+        m_volumeToRead->getPixelData()->applyPendingScalars();
+    }
+    else
+    {
+        // Don't leave a partially decoded volume
+        m_volumeToRead->convertToNeutralVolume();
+    }
+}
+
+void VolumeReaderJob::notifyPixelDataAvailable()
+{
+    m_pixelDataAvailable = true;
+    emit pixelDataAvailable(this);
+}
+
 } // End namespace udg
@@ -51,6 +51,12 @@ public:
     /// el codi d'error i és des de la interfície que es converteix en missatge a l'usuari.
     QString getLastErrorMessageToUser() const;
 
+    /// Asks to decode first the slices (z indices) nearest to the given one. Only useful with progressive loading.
+    void setFocusSlice(int slice);
+
+    /// Returns true if, with progressive loading, the volume has already been assigned its pixel data.
+    bool isPixelDataAvailable() const;
+
     /// Retorna el volume
     Volume* getVolume() const;
     /// Returns the identifier of the volume, even if the volume is destructed.
@@ -60,6 +66,8 @@ signals:
     /// Signal que s'emet amb el progrés de lectura
     void progress(VolumeReaderJob*, int progress);
     void done(ThreadWeaver::JobPointer);
+    /// Emitted with progressive loading when the volume has been assigned its pixel data, before all the slices have been decoded.
+    void pixelDataAvailable(VolumeReaderJob*);
 
 protected:
     /// Mètode on realment es fa la càrrega. S'executa en un thread de threadweaver.
@@ -69,6 +77,11 @@ protected:
 private slots:
     /// Slot to emit the current progress
     void updateProgress(int value);
+    /// Slot to emit pixelDataAvailable() in the thread of the job object.
+    void notifyPixelDataAvailable();
+    /// Applies the final scalars to the pixel data published with progressive loading or, if the read has failed, converts the volume to a neutral volume.
+    /// It's called in the thread of the job object, which is the one that renders the pixel data.
+    void completePublishedPixelData();
 private:
     Volume *m_volumeToRead;
     /// Keeps the identifier of the volume to have access to it even if the volume is deleted.
@@ -79,6 +92,11 @@ private:
     /// Ens indica si s'ha fet o no un requestAbort
     bool m_abortRequested;
 
+    /// True once the volume has been assigned its pixel data with progressive loading.
+    bool m_pixelDataAvailable;
+    /// Last focus slice requested, kept to apply it when the reader is created.
+    int m_focusSlice;
+
     /// Referència al volume reader per poder fer un requestAbort. Només serà vàlid mentre s'estigui executant "run()", a fora d'aquest no ho serà.
     /// Nota: no es pot fer el volumeReader membre de la classe ja que aquest crea objectes de Qt fills de "this" i this apuntaria a threads diferents
     /// (un a apuntaria al de gui, per ser crear al constructor, i els altres al del thread de threadweaver, per ser creats al run()).
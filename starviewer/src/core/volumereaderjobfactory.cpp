@@ -200,6 +200,12 @@ void VolumeReaderJobFactory::unmarkVolumeFromJobAsLoading(ThreadWeaver::JobPoint
     if (volumeReaderJob)
     {
         this->unmarkVolumeAsLoading(volumeReaderJob->getVolumeIdentifier());
+
+        // Make room for the new pixel data if needed
+        if (volumeReaderJob->success())
+        {
+            VolumeRepository::getRepository()->enforcePixelDataMemoryBudget(volumeReaderJob->getVolume());
+        }
     }
 }
 
@@ -50,6 +50,9 @@ public:
     /// Si volume no s'està carregant, l'esborrarà directament.
     void cancelLoadingAndDeleteVolume(Volume *volume);
 
+    /// Ens indica si el volume que se li passa s'està carregant
+    bool isVolumeLoading(Volume *volume) const;
+
 protected:
     friend class SingletonPointer<VolumeReaderJobFactory>;
     explicit VolumeReaderJobFactory(QObject *parent = 0);
@@ -60,8 +63,6 @@ private slots:
     void unmarkVolumeFromJobAsLoading(ThreadWeaver::JobPointer job);
 
 private:
-    /// Ens indica si el volume que se li passa s'està carregant
-    bool isVolumeLoading(Volume *volume) const;
 
     /// Marca el volume que se li passa conforme s'està carregant amb el job volumeReaderJob
     void markVolumeAsLoadingByJob(Volume *volume, QSharedPointer<VolumeReaderJob> volumeReaderJob);
@@ -38,6 +38,7 @@ void VolumeReaderManager::initialize()
     m_success = true;
     m_lastError = "";
     m_numberOfFinishedJobs = 0;
+    m_jobsWithPixelDataAvailable.clear();
 }
 
 void VolumeReaderManager::readVolume(Volume *volume)
@@ -61,6 +62,17 @@ void VolumeReaderManager::readVolumes(const QList<Volume*> &volumes)
         m_volumes << NULL;
         connect(job.data(), SIGNAL(done(ThreadWeaver::JobPointer)), SLOT(jobFinished(ThreadWeaver::JobPointer)));
         connect(job.data(), SIGNAL(progress(VolumeReaderJob*, int)), SLOT(updateProgress(VolumeReaderJob*, int)));
+        connect(job.data(), SIGNAL(pixelDataAvailable(VolumeReaderJob*)), SLOT(jobPixelDataAvailable(VolumeReaderJob*)));
+    }
+
+    // The job may be shared with another reader and have already published its pixel data
+    foreach (const QWeakPointer<ThreadWeaver::JobInterface> &jobPointer, m_volumeReaderJobs)
+    {
+        QSharedPointer<VolumeReaderJob> job = jobPointer.toStrongRef().dynamicCast<VolumeReaderJob>();
+        if (!job.isNull() && job->isPixelDataAvailable())
+        {
+            QMetaObject::invokeMethod(this, "jobPixelDataAvailable", Qt::QueuedConnection, Q_ARG(VolumeReaderJob*, job.data()));
+        }
     }
 }
 
@@ -75,6 +87,7 @@ void VolumeReaderManager::cancelReading()
         {
             disconnect(job.data(), SIGNAL(done(ThreadWeaver::JobPointer)), this, SLOT(jobFinished(ThreadWeaver::JobPointer)));
             disconnect(job.data(), SIGNAL(progress(VolumeReaderJob*, int)), this, SLOT(updateProgress(VolumeReaderJob*, int)));
+            disconnect(job.data(), SIGNAL(pixelDataAvailable(VolumeReaderJob*)), this, SLOT(jobPixelDataAvailable(VolumeReaderJob*)));
         }
         m_volumeReaderJobs[i].clear();
     }
@@ -102,6 +115,25 @@ QString VolumeReaderManager::getLastErrorMessageToUser()
     return m_lastError;
 }
 
+void VolumeReaderManager::setFocusSlice(int slice)
+{
+    if (m_volumeReaderJobs.isEmpty())
+    {
+        return;
+    }
+
+    QSharedPointer<VolumeReaderJob> job = m_volumeReaderJobs.first().toStrongRef().dynamicCast<VolumeReaderJob>();
+    if (!job.isNull())
+    {
+        job->setFocusSlice(slice);
+    }
+}
+
+bool VolumeReaderManager::isPixelDataAvailable()
+{
+    return !m_volumeReaderJobs.isEmpty() && m_jobsWithPixelDataAvailable.size() == m_volumeReaderJobs.size();
+}
+
 bool VolumeReaderManager::isReading()
 {
     return m_numberOfFinishedJobs < m_volumeReaderJobs.size();
@@ -137,6 +169,7 @@ void VolumeReaderManager::jobFinished(ThreadWeaver::JobPointer job)
         }
     }
 
+    m_jobsWithPixelDataAvailable.insert(volumeReaderJob.data());
     m_numberOfFinishedJobs++;
 
     if (!isReading())
@@ -145,4 +178,30 @@ void VolumeReaderManager::jobFinished(ThreadWeaver::JobPointer job)
     }
 }
 
+void VolumeReaderManager::jobPixelDataAvailable(VolumeReaderJob *job)
+{
+    int index = -1;
+    for (int i = 0; i < m_volumeReaderJobs.size() && index < 0; i++)
+    {
+        if (m_volumeReaderJobs[i].toStrongRef().dynamicCast<VolumeReaderJob>().data() == job)
+        {
+            index = i;
+        }
+    }
+
+    if (index < 0 || m_jobsWithPixelDataAvailable.contains(job))
+    {
+        // The job doesn't belong to the current reading or has already been counted
+        return;
+    }
+
+    m_volumes[index] = job->getVolume();
+    m_jobsWithPixelDataAvailable.insert(job);
+
+    if (isPixelDataAvailable() && isReading())
+    {
+        emit pixelDataAvailable();
+    }
+}
+
 } // namespace udg
@@ -18,6 +18,7 @@
 #include <QObject>
 #include <QPointer>
 #include <QHash>
+#include <QSet>
 
 #include "volumereaderjob.h"
 
@@ -56,17 +57,27 @@ public:
     /// Returns the last error messege. An empty string is retured if no error.
     QString getLastErrorMessageToUser();
 
+    /// Asks to decode first the slices (z indices) of the first volume nearest to the given one. Only useful with progressive loading.
+    void setFocusSlice(int slice);
+
+    /// Returns true if all the volumes being read already have their pixel data, even if some slices are still being decoded.
+    bool isPixelDataAvailable();
+
 signals:
     /// Signal emitted during the reading to report progress
     void progress(int progress);
     /// Signal emitted at the end of the reading
     void readingFinished();
+    /// Signal emitted with progressive loading when all the volumes have been assigned their pixel data, before the end of the reading.
+    void pixelDataAvailable();
 
 private slots:
     /// Updates the progress of the job and emits the global progress
     void updateProgress(VolumeReaderJob*, int);
     /// Slot executed when a job finished. It emits the signal readingFinished() if no jobs are reading.
     void jobFinished(ThreadWeaver::JobPointer job);
+    /// Slot executed when a job has assigned the pixel data to its volume. It emits pixelDataAvailable() if all the volumes have their pixel data.
+    void jobPixelDataAvailable(VolumeReaderJob *job);
 
 private:
     /// Initialize internal helpers
@@ -90,6 +101,9 @@ private:
 
     /// It counts the number of finished jobs
     int m_numberOfFinishedJobs;
+
+    /// Jobs whose volume already has its pixel data, either because of progressive loading or because they have finished.
+    QSet<VolumeReaderJob*> m_jobsWithPixelDataAvailable;
 };
 
 } // namespace udg
@@ -16,10 +16,27 @@
 #include "volume.h"
 #include "logging.h"
 #include "volumereaderjobfactory.h"
+#include "coresettings.h"
+
+#include <QApplication>
+#include <QThread>
+
+#include <algorithm>
 
 namespace udg {
 
+namespace {
+
+// Orders volumes from the least to the most recently used
+bool lessRecentlyUsed(const Volume *volume1, const Volume *volume2)
+{
+    return volume1->getLastPixelDataAccess() < volume2->getLastPixelDataAccess();
+}
+
+}
+
 VolumeRepository::VolumeRepository()
+    : m_pixelDataEvictions(0)
 {
 }
 
@@ -64,4 +81,105 @@ int VolumeRepository::getNumberOfVolumes()
     return this->getNumberOfItems();
 }
 
+VolumeRepository::PixelDataStatistics VolumeRepository::getPixelDataStatistics() const
+{
+    PixelDataStatistics statistics;
+    statistics.hits = m_pixelDataHits.load();
+    statistics.misses = m_pixelDataMisses.load();
+    statistics.evictions = m_pixelDataEvictions;
+    statistics.residentBytes = 0;
+    statistics.budgetBytes = getPixelDataMemoryBudget();
+
+    foreach (Volume *volume, this->getItems())
+    {
+        if (VolumePixelData *pixelData = volume->getLoadedPixelData())
+        {
+            statistics.residentBytes += pixelData->getMemorySize();
+        }
+    }
+
+    return statistics;
+}
+
+void VolumeRepository::countPixelDataDisplayRequest(Volume *volume)
+{
+    if (volume && volume->isPixelDataLoaded())
+    {
+        m_pixelDataHits.ref();
+    }
+}
+
+void VolumeRepository::countPixelDataRead()
+{
+    m_pixelDataMisses.ref();
+}
+
+void VolumeRepository::enforcePixelDataMemoryBudget(Volume *volumeToKeep)
+{
+    // Volumes are used without locking from the main thread, so they can only be released from it
+    if (!qApp || QThread::currentThread() != qApp->thread())
+    {
+        return;
+    }
+
+    qint64 budget = getPixelDataMemoryBudget();
+    if (budget <= 0)
+    {
+        return;
+    }
+
+    qint64 residentBytes = 0;
+    QList<Volume*> candidates;
+    foreach (Volume *volume, this->getItems())
+    {
+        VolumePixelData *pixelData = volume->getLoadedPixelData();
+        if (!pixelData)
+        {
+            continue;
+        }
+
+        residentBytes += pixelData->getMemorySize();
+
+        if (volume != volumeToKeep && !VolumeReaderJobFactory::instance()->isVolumeLoading(volume) && !pixelData->isReferencedExternally())
+        {
+            candidates << volume;
+        }
+    }
+
+    if (residentBytes <= budget)
+    {
+        return;
+    }
+
+    std::sort(candidates.begin(), candidates.end(), lessRecentlyUsed);
+
+    foreach (Volume *volume, candidates)
+    {
+        if (residentBytes <= budget)
+        {
+            break;
+        }
+
+        qint64 memorySize = volume->getLoadedPixelData()->getMemorySize();
+        volume->releasePixelData();
+        residentBytes -= memorySize;
+        m_pixelDataEvictions++;
+
+        INFO_LOG(QString("S'ha alliberat el pixel data del volum amb id %1 (%2 MB) per no superar el límit de memòria de %3 MB. Hits: %4, misses: %5, "
+                         "evictions: %6")
+                 .arg(volume->getIdentifier().getValue()).arg(memorySize / (1024 * 1024)).arg(budget / (1024 * 1024))
+                 .arg(m_pixelDataHits.load()).arg(m_pixelDataMisses.load()).arg(m_pixelDataEvictions));
+    }
+
+    if (residentBytes > budget)
+    {
+        INFO_LOG(QString("El pixel data en ús (%1 MB) supera el límit de memòria de %2 MB").arg(residentBytes / (1024 * 1024)).arg(budget / (1024 * 1024)));
+    }
+}
+
+qint64 VolumeRepository::getPixelDataMemoryBudget() const
+{
+    return Settings().getValue(CoreSettings::VolumePixelDataMemoryBudget).toLongLong() * 1024 * 1024;
+}
+
 }
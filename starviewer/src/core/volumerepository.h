@@ -19,6 +19,7 @@
 #include "volume.h"
 #include "identifier.h"
 
+#include <QAtomicInt>
 #include <QObject>
 
 namespace udg {
@@ -41,6 +42,10 @@ namespace udg {
     ...
     Volume* m_volume = m_volumeRepository->getVolume(id);
     \endcode
+
+    The repository can also limit the memory used by the pixel data of its volumes (setting CoreSettings::VolumePixelDataMemoryBudget). When the budget is
+    exceeded, the pixel data of the least recently used volumes that are not being read or displayed is released, and it's read again transparently the
+    next time it's requested (from the decoded volume cache, if enabled).
   */
 class VolumeRepository : public Repository<Volume> {
 Q_OBJECT
@@ -58,6 +63,36 @@ public:
     /// Retorna el nombre de volums que hi ha al repositori
     int getNumberOfVolumes();
 
+    /// Statistics about the pixel data of the volumes in the repository.
+    struct PixelDataStatistics
+    {
+        /// Number of times a viewer has been given a volume to display whose pixel data was loaded.
+        int hits;
+        /// Number of times the pixel data of a volume has had to be read, either to display it or on demand with Volume::getPixelData().
+        int misses;
+        /// Number of times the pixel data of a volume has been released to meet the memory budget.
+        int evictions;
+        /// Memory currently used by the loaded pixel data, in bytes.
+        qint64 residentBytes;
+        /// Memory budget for the pixel data, in bytes, or 0 if there's no limit.
+        qint64 budgetBytes;
+    };
+
+    /// Returns the current pixel data statistics.
+    PixelDataStatistics getPixelDataStatistics() const;
+
+    /// Counts a hit if the pixel data of the given volume, that a viewer has been given to display, is loaded. Otherwise reading it will count a miss.
+    /// Accesses to the pixel data while it's being displayed are not counted.
+    void countPixelDataDisplayRequest(Volume *volume);
+
+    /// Counts a miss, when the pixel data of a volume has to be read. Can be called from any thread.
+    void countPixelDataRead();
+
+    /// Releases the pixel data of the least recently used volumes until the memory used by the loaded pixel data fits in the budget, if any. Volumes that are
+    /// being read or whose data is referenced by a visualization pipeline, as well as the given volume, are never released. It does nothing if not called
+    /// from the main thread.
+    void enforcePixelDataMemoryBudget(Volume *volumeToKeep = 0);
+
     /// Ens retorna l'única instància del repositori.
     static VolumeRepository* getRepository()
     {
@@ -75,6 +110,15 @@ signals:
 private:
     /// Ha de quedar amagat perquè no poguem crear instàncies
     VolumeRepository();
+
+    /// Returns the memory budget for the pixel data in bytes, or 0 if there's no limit.
+    qint64 getPixelDataMemoryBudget() const;
+
+private:
+    /// Pixel data statistics counters. Hits and misses can be updated from any thread.
+    QAtomicInt m_pixelDataHits;
+    QAtomicInt m_pixelDataMisses;
+    int m_pixelDataEvictions;
 };
 
 }
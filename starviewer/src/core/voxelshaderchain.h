@@ -0,0 +1,158 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGVOXELSHADERCHAIN_H
+#define UDGVOXELSHADERCHAIN_H
+
+#include "voxelshader.h"
+
+#include <QList>
+#include <QStringList>
+
+#include <typeinfo>
+
+namespace udg {
+
+/**
+    Final d'una VoxelShaderChain. Retorna el color que rep.
+  */
+class VoxelShaderChainEnd {
+
+public:
+    /// Retorna el nombre de voxel shaders de la cadena.
+    static int length()
+    {
+        return 0;
+    }
+
+    /// No agafa cap voxel shader.
+    bool setVoxelShaders(const QList<VoxelShader*> &voxelShaders, int first = 0)
+    {
+        Q_UNUSED(voxelShaders);
+        Q_UNUSED(first);
+        return true;
+    }
+
+    /// Retorna baseColor.
+    HdrColor nvShade(const Vector3 &position, int offset, const Vector3 &direction, float remainingOpacity, const HdrColor &baseColor = HdrColor())
+    {
+        Q_UNUSED(position);
+        Q_UNUSED(offset);
+        Q_UNUSED(direction);
+        Q_UNUSED(remainingOpacity);
+        return baseColor;
+    }
+
+    /// Retorna baseColor.
+    HdrColor nvShade(const Vector3 &position, const Vector3 &direction, const TrilinearInterpolator *interpolator, float remainingOpacity,
+                     const HdrColor &baseColor = HdrColor())
+    {
+        Q_UNUSED(position);
+        Q_UNUSED(direction);
+        Q_UNUSED(interpolator);
+        Q_UNUSED(remainingOpacity);
+        return baseColor;
+    }
+
+    /// Afegeix la descripció dels voxel shaders de la cadena a strings.
+    void appendToStrings(QStringList &strings) const
+    {
+        Q_UNUSED(strings);
+    }
+
+};
+
+/**
+    Cadena de voxel shaders fixada en temps de compilació, que fa el mateix que aplicar-los un darrere l'altre com a la llista de
+    vtkVolumeRayCastVoxelShaderCompositeFunction però cridant els nvShade, de manera que el compilador pot fer inline tota la cadena.
+
+    VS és el primer voxel shader i Next la resta de la cadena. Per exemple, VoxelShaderChain<AmbientVoxelShader, VoxelShaderChain<ContourVoxelShader> >
+    equival a la llista {ambient, contorn}. Com a CombiningVoxelShader, els voxel shaders han d'implementar els nvShade.
+  */
+template <class VS, class Next = VoxelShaderChainEnd>
+class VoxelShaderChain {
+
+public:
+    VoxelShaderChain()
+     : m_voxelShader(0)
+    {
+    }
+
+    /// Retorna el nombre de voxel shaders de la cadena.
+    static int length()
+    {
+        return 1 + Next::length();
+    }
+
+    /// Agafa els voxel shaders de la cadena de la llista a partir de la posició first. Retorna fals si la llista no té exactament els tipus de la cadena en
+    /// el mateix ordre. No s'accepten subclasses perquè podrien redefinir els mètodes shade.
+    bool setVoxelShaders(const QList<VoxelShader*> &voxelShaders, int first = 0)
+    {
+        if (voxelShaders.size() - first != length())
+        {
+            return false;
+        }
+
+        VoxelShader *voxelShader = voxelShaders.at(first);
+        if (!voxelShader || typeid(*voxelShader) != typeid(VS))
+        {
+            return false;
+        }
+
+        m_voxelShader = static_cast<VS*>(voxelShader);
+        return m_next.setVoxelShaders(voxelShaders, first + 1);
+    }
+
+    /// Retorna el color corresponent al vòxel a la posició offset.
+    HdrColor nvShade(const Vector3 &position, int offset, const Vector3 &direction, float remainingOpacity, const HdrColor &baseColor = HdrColor())
+    {
+        Q_ASSERT(m_voxelShader);
+
+        return m_next.nvShade(position, offset, direction, remainingOpacity, m_voxelShader->nvShade(position, offset, direction, remainingOpacity, baseColor));
+    }
+
+    /// Retorna el color corresponent al vòxel a la posició position, fent servir valors interpolats.
+    HdrColor nvShade(const Vector3 &position, const Vector3 &direction, const TrilinearInterpolator *interpolator, float remainingOpacity,
+                     const HdrColor &baseColor = HdrColor())
+    {
+        Q_ASSERT(m_voxelShader);
+
+        return m_next.nvShade(position, direction, interpolator, remainingOpacity,
+                              m_voxelShader->nvShade(position, direction, interpolator, remainingOpacity, baseColor));
+    }
+
+    /// Afegeix la descripció dels voxel shaders de la cadena a strings.
+    void appendToStrings(QStringList &strings) const
+    {
+        strings << (m_voxelShader ? m_voxelShader->toString() : "null");
+        m_next.appendToStrings(strings);
+    }
+
+    /// Retorna un string representatiu de la cadena.
+    QString toString() const
+    {
+        QStringList strings;
+        appendToStrings(strings);
+        return "VoxelShaderChain<" + strings.join(", ") + ">";
+    }
+
+private:
+    VS *m_voxelShader;
+    Next m_next;
+
+};
+
+}
+
+#endif
@@ -24,6 +24,7 @@
 
 #include "vtkProjectionImageFilter.h"
 
+#include <vtkDataArray.h>
 #include <vtkImageData.h>
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
@@ -32,6 +33,15 @@
 
 #include "logging.h"
 
+#include <QtGlobal>
+
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STARVIEWER_PROJECTION_SSE2
+#endif
+
 
 vtkCxxRevisionMacro(vtkProjectionImageFilter, "$Revision: 1.0 $");
 vtkStandardNewMacro(vtkProjectionImageFilter);
@@ -48,6 +58,24 @@ vtkProjectionImageFilter/*<TAccumulator>*/::vtkProjectionImageFilter()
     FirstSlice = 0;
     NumberOfSlicesToProject = 1;
     Step = 1;
+    IncrementalProjection = false;
+    IncrementalStateValid = false;
+    IncrementalFirstSlice = 0;
+    IncrementalNumberOfSlicesToProject = 0;
+    IncrementalStep = 0;
+    IncrementalProjectionDimension = 0;
+    IncrementalAccumulatorType = udg::AccumulatorFactory::Maximum;
+    for (int i = 0; i < 6; i++)
+    {
+        IncrementalOutputExtent[i] = 0;
+    }
+    IncrementalScalarType = VTK_VOID;
+    IncrementalNumberOfComponents = 0;
+    IncrementalInput = 0;
+    IncrementalInputMTime = 0;
+    UseIncrementalState = false;
+    RecomputeIncrementalState = true;
+    IncrementalShift = 0;
 }
 
 
@@ -70,6 +98,7 @@ void vtkProjectionImageFilter::PrintSelf(ostream& os, vtkIndent indent)
     os << indent << "FirstSlice: " << FirstSlice << "\n";
     os << indent << "NumberOfSlicesToProject: " << NumberOfSlicesToProject << "\n";
     os << indent << "Step: " << Step << "\n";
+    os << indent << "IncrementalProjection: " << IncrementalProjection << "\n";
 
     os << std::flush;
 }
@@ -126,6 +155,14 @@ int vtkProjectionImageFilter::RequestUpdateExtent(
     // TODO veure això de l'extent
     updateExtent[2*ProjectionDimension] = FirstSlice;
     updateExtent[2*ProjectionDimension+1] = FirstSlice + Step * ( NumberOfSlicesToProject - 1 );
+
+    // The slices leaving the slab are needed to update the incremental state
+    if (IncrementalProjection && IsIncrementalStateCompatible())
+    {
+        updateExtent[2*ProjectionDimension] = qMin(updateExtent[2*ProjectionDimension], IncrementalFirstSlice);
+        updateExtent[2*ProjectionDimension+1] = qMax(updateExtent[2*ProjectionDimension+1],
+                                                     IncrementalFirstSlice + Step * ( NumberOfSlicesToProject - 1 ));
+    }
 //     updateExtent[2*ProjectionDimension] = 0;
 //     updateExtent[2*ProjectionDimension+1] = 0;
 
@@ -137,6 +174,290 @@ int vtkProjectionImageFilter::RequestUpdateExtent(
 }
 
 
+bool vtkProjectionImageFilter::IsIncrementalStateCompatible() const
+{
+    return IncrementalStateValid && IncrementalNumberOfSlicesToProject == NumberOfSlicesToProject && IncrementalStep == Step &&
+           IncrementalProjectionDimension == ProjectionDimension && IncrementalAccumulatorType == AccumulatorType;
+}
+
+int vtkProjectionImageFilter::RequestData(vtkInformation *request, vtkInformationVector **inputVector, vtkInformationVector *outputVector)
+{
+    vtkImageData *input = vtkImageData::GetData(inputVector[0]);
+    int outputExtent[6];
+    outputVector->GetInformationObject(0)->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), outputExtent);
+
+    int scalarType = input ? input->GetScalarType() : VTK_VOID;
+    bool isSupportedScalarType = scalarType != VTK_VOID && scalarType != VTK_FLOAT && scalarType != VTK_DOUBLE &&
+                                 vtkDataArray::GetDataTypeSize(scalarType) <= 4;
+    // Only the sum of the average can be updated in constant time per step. Keeping the maximum or minimum would need searching the slab again whenever
+    // it leaves it, which is as slow as projecting it again in the worst case.
+    UseIncrementalState = IncrementalProjection && isSupportedScalarType && AccumulatorType == udg::AccumulatorFactory::Average;
+
+    if (UseIncrementalState)
+    {
+        bool sameOutput = input == IncrementalInput && input->GetMTime() <= IncrementalInputMTime && scalarType == IncrementalScalarType &&
+                          input->GetNumberOfScalarComponents() == IncrementalNumberOfComponents;
+        for (int i = 0; i < 6 && sameOutput; i++)
+        {
+            // The extent along the projection axis is the first slice, which may change
+            sameOutput = i / 2 == static_cast<int>(ProjectionDimension) || outputExtent[i] == IncrementalOutputExtent[i];
+        }
+
+        int delta = FirstSlice - IncrementalFirstSlice;
+        RecomputeIncrementalState = true;
+        if (sameOutput && IsIncrementalStateCompatible() && delta % Step == 0)
+        {
+            // Beyond half the slab it's cheaper to compute it again
+            IncrementalShift = delta / Step;
+            RecomputeIncrementalState = 2 * qAbs(IncrementalShift) >= NumberOfSlicesToProject;
+        }
+
+        if (RecomputeIncrementalState)
+        {
+            vtkIdType size = input->GetNumberOfScalarComponents();
+            for (int i = 0; i < 3; i++)
+            {
+                size *= outputExtent[2 * i + 1] - outputExtent[2 * i] + 1;
+            }
+            IncrementalValues.resize(size);
+            IncrementalShift = 0;
+        }
+    }
+
+    // The state is not valid while it's being updated
+    IncrementalStateValid = false;
+    for (int i = 0; i < 6; i++)
+    {
+        IncrementalOutputExtent[i] = outputExtent[i];
+    }
+
+    int result = Superclass::RequestData(request, inputVector, outputVector);
+
+    if (UseIncrementalState && !AbortExecute)
+    {
+        IncrementalStateValid = true;
+        IncrementalFirstSlice = FirstSlice;
+        IncrementalNumberOfSlicesToProject = NumberOfSlicesToProject;
+        IncrementalStep = Step;
+        IncrementalProjectionDimension = ProjectionDimension;
+        IncrementalAccumulatorType = AccumulatorType;
+        IncrementalScalarType = scalarType;
+        IncrementalNumberOfComponents = input->GetNumberOfScalarComponents();
+        IncrementalInput = input;
+        IncrementalInputMTime = input->GetMTime();
+    }
+    else if (!UseIncrementalState)
+    {
+        IncrementalValues.clear();
+    }
+
+    return result;
+}
+
+namespace {
+
+// Projection policies. Each one combines a whole run of contiguous values of a slice with the accumulated values, so that the accumulator is chosen at
+// compile time and the loops can be inlined and vectorised. They give exactly the same results as the corresponding udg::Accumulator.
+
+template <class T>
+struct MaximumProjection
+{
+    static const bool UsesBuffer = false;
+
+    static inline void initialize(T *output, double *vtkNotUsed(buffer), const T *input, int length, double vtkNotUsed(size))
+    {
+        for (int i = 0; i < length; i++)
+        {
+            output[i] = input[i];
+        }
+    }
+
+    static inline void accumulate(T *output, double *vtkNotUsed(buffer), const T *input, int length, double vtkNotUsed(size))
+    {
+        // Same as qMax(output[i], input[i])
+        for (int i = 0; i < length; i++)
+        {
+            output[i] = output[i] < input[i] ? input[i] : output[i];
+        }
+    }
+
+    static inline void finish(T *vtkNotUsed(output), const double *vtkNotUsed(buffer), int vtkNotUsed(length))
+    {
+    }
+};
+
+template <class T>
+struct MinimumProjection
+{
+    static const bool UsesBuffer = false;
+
+    static inline void initialize(T *output, double *vtkNotUsed(buffer), const T *input, int length, double vtkNotUsed(size))
+    {
+        for (int i = 0; i < length; i++)
+        {
+            output[i] = input[i];
+        }
+    }
+
+    static inline void accumulate(T *output, double *vtkNotUsed(buffer), const T *input, int length, double vtkNotUsed(size))
+    {
+        // Same as qMin(output[i], input[i])
+        for (int i = 0; i < length; i++)
+        {
+            output[i] = output[i] < input[i] ? output[i] : input[i];
+        }
+    }
+
+    static inline void finish(T *vtkNotUsed(output), const double *vtkNotUsed(buffer), int vtkNotUsed(length))
+    {
+    }
+};
+
+template <class T>
+struct AverageProjection
+{
+    static const bool UsesBuffer = true;
+
+    static inline void initialize(T *vtkNotUsed(output), double *buffer, const T *input, int length, double size)
+    {
+        for (int i = 0; i < length; i++)
+        {
+            buffer[i] = input[i] / size;
+        }
+    }
+
+    static inline void accumulate(T *vtkNotUsed(output), double *buffer, const T *input, int length, double size)
+    {
+        for (int i = 0; i < length; i++)
+        {
+            buffer[i] += input[i] / size;
+        }
+    }
+
+    static inline void finish(T *output, const double *buffer, int length)
+    {
+        for (int i = 0; i < length; i++)
+        {
+            output[i] = static_cast<T>(qRound(buffer[i]));
+        }
+    }
+};
+
+#ifdef STARVIEWER_PROJECTION_SSE2
+// Signed short is by far the most common type for CT and MR, and SSE2 has packed max and min for it
+template <>
+inline void MaximumProjection<short>::accumulate(short *output, double *vtkNotUsed(buffer), const short *input, int length, double vtkNotUsed(size))
+{
+    int i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        __m128i accumulated = _mm_loadu_si128(reinterpret_cast<const __m128i*>(output + i));
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_max_epi16(accumulated, values));
+    }
+    for (; i < length; i++)
+    {
+        output[i] = output[i] < input[i] ? input[i] : output[i];
+    }
+}
+
+template <>
+inline void MinimumProjection<short>::accumulate(short *output, double *vtkNotUsed(buffer), const short *input, int length, double vtkNotUsed(size))
+{
+    int i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        __m128i accumulated = _mm_loadu_si128(reinterpret_cast<const __m128i*>(output + i));
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_min_epi16(accumulated, values));
+    }
+    for (; i < length; i++)
+    {
+        output[i] = output[i] < input[i] ? output[i] : input[i];
+    }
+}
+#endif
+
+// Projects the slab along the projection axis with the given projection policy.
+// When the projection axis is not the X axis, each output row is computed by combining the corresponding contiguous row of each slice of the slab in turn,
+// so that the reads are sequential and the accumulated row stays in cache. Otherwise the values to combine for each output voxel are already the closest
+// ones in memory, and they are combined one voxel at a time.
+template <class T, class TProjection>
+void projectSlab(vtkProjectionImageFilter *self, vtkImageData *inData, T *inPtr, vtkImageData *outData, T *outPtr, int inExt[6], int outExt[6])
+{
+    unsigned int iA = self->GetProjectionDimension();
+    int step = self->GetStep();
+    double size = self->GetNumberOfSlicesToProject();
+    int numberOfComponents = inData->GetNumberOfScalarComponents();
+
+    vtkIdType inIncs[3], outIncs[3];
+    inData->GetIncrements(inIncs);
+    outData->GetIncrements(outIncs);
+
+    int inMinA = inExt[2 * iA], inMaxA = inExt[2 * iA + 1];
+    vtkIdType sliceIncrement = step * inIncs[iA];
+
+    if (iA != 0)
+    {
+        // Rows along X are contiguous both in the input and the output, including all the components
+        unsigned int iRows = iA == 1 ? 2 : 1;
+        int rowLength = (outExt[1] - outExt[0] + 1) * numberOfComponents;
+        std::vector<double> buffer(TProjection::UsesBuffer ? rowLength : 0);
+        double *bufferPtr = TProjection::UsesBuffer ? &buffer[0] : 0;
+
+        T *inRowPtr = inPtr;
+        T *outRowPtr = outPtr;
+        for (int row = outExt[2 * iRows]; row <= outExt[2 * iRows + 1] && !self->AbortExecute; row++)
+        {
+            const T *inSlicePtr = inRowPtr;
+            TProjection::initialize(outRowPtr, bufferPtr, inSlicePtr, rowLength, size);
+            for (int slice = inMinA + step; slice <= inMaxA; slice += step)
+            {
+                inSlicePtr += sliceIncrement;
+                TProjection::accumulate(outRowPtr, bufferPtr, inSlicePtr, rowLength, size);
+            }
+            TProjection::finish(outRowPtr, bufferPtr, rowLength);
+
+            inRowPtr += inIncs[iRows];
+            outRowPtr += outIncs[iRows];
+        }
+    }
+    else
+    {
+        double buffer;
+        T *inPtr2 = inPtr;
+        T *outPtr2 = outPtr;
+        for (int index2 = outExt[4]; index2 <= outExt[5] && !self->AbortExecute; index2++)
+        {
+            T *inPtr1 = inPtr2;
+            T *outPtr1 = outPtr2;
+            for (int index1 = outExt[2]; index1 <= outExt[3]; index1++)
+            {
+                for (int component = 0; component < numberOfComponents; component++)
+                {
+                    const T *inSlicePtr = inPtr1 + component;
+                    T *outVoxelPtr = outPtr1 + component;
+                    TProjection::initialize(outVoxelPtr, &buffer, inSlicePtr, 1, size);
+                    for (int slice = inMinA + step; slice <= inMaxA; slice += step)
+                    {
+                        inSlicePtr += sliceIncrement;
+                        TProjection::accumulate(outVoxelPtr, &buffer, inSlicePtr, 1, size);
+                    }
+                    TProjection::finish(outVoxelPtr, &buffer, 1);
+                }
+
+                inPtr1 += inIncs[1];
+                outPtr1 += outIncs[1];
+            }
+
+            inPtr2 += inIncs[2];
+            outPtr2 += outIncs[2];
+        }
+    }
+}
+
+}
+
 template <class T>
 void vtkProjectionImageFilterExecute(vtkProjectionImageFilter *self,
                                      vtkImageData *inData, T *inPtr,
@@ -145,117 +466,133 @@ void vtkProjectionImageFilterExecute(vtkProjectionImageFilter *self,
                                      int vtkNotUsed(id) )
 {
     unsigned int projectionDimension = self->GetProjectionDimension();
-    unsigned int iA = projectionDimension, i0 = (iA + 1) % 3, i1 = (iA + 2) % 3;
 
     // per 1 thread això no cal, però per 2 o més potser sí
     // compute the input region for this thread
     for ( unsigned int i = 0; i < 6; i++ )
     {
-//         DEBUG_LOG( QString( "inExt[%1] = %2 | outExt[%1] = %3" ).arg( i ).arg( inExt[i] ).arg( outExt[i] ) );
         if( i / 2 != projectionDimension )
         {
             inExt[i] = outExt[i];
         }
     }
 
-    int inMin0, inMax0, inMin1, inMax1, inMinA, inMaxA;
-    inMin0 = inExt[2*i0]; inMax0 = inExt[2*i0+1];
-    inMin1 = inExt[2*i1]; inMax1 = inExt[2*i1+1];
-    inMinA = inExt[2*iA]; inMaxA = inExt[2*iA+1];
-
-//     DEBUG_LOG( QString( "inMin0 = %1, inMax0 = %2" ).arg( inMin0 ).arg( inMax0 ) );
-//     DEBUG_LOG( QString( "inMin1 = %1, inMax1 = %2" ).arg( inMin1 ).arg( inMax1 ) );
-//     DEBUG_LOG( QString( "inMinA = %1, inMaxA = %2" ).arg( inMinA ).arg( inMaxA ) );
-    /*
-    switch (projectionDimension)
+    switch (self->GetAccumulatorType())
     {
-        case 0:
-            inMin0 = inExt[2]; inMax0 = inExt[3];
-            inMin1 = inExt[4]; inMax1 = inExt[5];
-            inMinA = inExt[0]; inMaxA = inExt[1];
+        case udg::AccumulatorFactory::Maximum:
+            projectSlab<T, MaximumProjection<T> >(self, inData, inPtr, outData, outPtr, inExt, outExt);
             break;
-        case 1:
-            inMin0 = inExt[0]; inMax0 = inExt[1];
-            inMin1 = inExt[4]; inMax1 = inExt[5];
-            inMinA = inExt[2]; inMaxA = inExt[3];
+
+        case udg::AccumulatorFactory::Minimum:
+            projectSlab<T, MinimumProjection<T> >(self, inData, inPtr, outData, outPtr, inExt, outExt);
             break;
-        case 2:
-            inMin0 = inExt[0]; inMax0 = inExt[1];
-            inMin1 = inExt[2]; inMax1 = inExt[3];
-            inMinA = inExt[4]; inMaxA = inExt[5];
+
+        case udg::AccumulatorFactory::Average:
+            projectSlab<T, AverageProjection<T> >(self, inData, inPtr, outData, outPtr, inExt, outExt);
             break;
     }
-    */
+}
+
+
+template <class T>
+void vtkProjectionImageFilter::ExecuteIncremental(vtkImageData *inData, vtkImageData *outData, int outExt[6])
+{
+    unsigned int iA = ProjectionDimension;
+    int numberOfComponents = inData->GetNumberOfScalarComponents();
+    int firstSlice = FirstSlice;
+    int lastSlice = FirstSlice + Step * (NumberOfSlicesToProject - 1);
+    double size = NumberOfSlicesToProject;
 
+    int inExtent[6];
+    inData->GetExtent(inExtent);
+    int inputMinimumSlice = inExtent[2 * iA];
 
     vtkIdType inIncs[3], outIncs[3];
     inData->GetIncrements(inIncs);
     outData->GetIncrements(outIncs);
+    vtkIdType sliceIncrement = inIncs[iA];
 
+    // Input pointer at the first voxel of the output extent and the first slice of the input
+    int inIndex[3] = { outExt[0], outExt[2], outExt[4] };
+    inIndex[iA] = inputMinimumSlice;
+    T *inPtr = static_cast<T*>(inData->GetScalarPointer(inIndex));
+    T *outPtr = static_cast<T*>(outData->GetScalarPointerForExtent(outExt));
 
-
-    int outDims[3];
-    outData->GetDimensions( outDims );
-//     DEBUG_LOG(QString("out dims: (%1, %2, %3)").arg(outDims[0]).arg(outDims[1]).arg(outDims[2]));
-//     DEBUG_LOG(QString("size = %1").arg(outData->GetPointData()->GetScalars()->GetSize()));
-//     DEBUG_LOG(QString("out incs: (%1, %2, %3)").arg(outIncs[0]).arg(outIncs[1]).arg(outIncs[2]));
-
-
-
-    vtkIdType inInc0, inInc1, inIncA, outInc0, outInc1;
-    inInc0 = inIncs[i0]; inInc1 = inIncs[i1]; inIncA = inIncs[iA];
-//     DEBUG_LOG( QString( "inInc0 = %1" ).arg( inInc0 ) );
-//     DEBUG_LOG( QString( "inInc1 = %1" ).arg( inInc1 ) );
-//     DEBUG_LOG( QString( "inIncA = %1" ).arg( inIncA ) );
-    outInc0 = outIncs[i0]; outInc1 = outIncs[i1];
-
-    int step = self->GetStep();
-//     DEBUG_LOG( QString( "step = %1" ).arg( step ) );
-    unsigned long projectionSize = self->GetNumberOfSlicesToProject();
-
-    // instantiate the accumulator
-    udg::Accumulator<T> * accumulator = udg::AccumulatorFactory::getAccumulator<T>(self->GetAccumulatorType(), projectionSize);
-
-    // Fem tota la composició per cada component
-    // TODO Potser es podria millorar la coherència de cache o alguna història d'aquestes canviant l'ordre dels bucles
-    //      però de moment ja funciona bé.
-    int numberOfComponents = inData->GetNumberOfScalarComponents();
-
-    for (int component = 0; component < numberOfComponents; component++)
+    // The state has a value for each value of the whole output extent, which has a single slice along the projection axis
+    int stateDimensions[3];
+    for (int i = 0; i < 3; i++)
     {
-        // loop through pixels of input
-        T * inPtr0 = inPtr + component;
-        T * outPtr0 = outPtr + component;
+        stateDimensions[i] = IncrementalOutputExtent[2 * i + 1] - IncrementalOutputExtent[2 * i] + 1;
+    }
 
-        for ( int inIdx0 = inMin0; inIdx0 <= inMax0 && !self->AbortExecute; ++inIdx0 )
+    // Since the output has a single slice along the projection axis, each output row along X is contiguous both in the output, in the state and in each
+    // slice of the input, including all the components, as in projectSlab(). When projecting along X each row is a single voxel.
+    int rowLength = (outExt[1] - outExt[0] + 1) * numberOfComponents;
+
+    // Slices that leave and enter the slab when it moves from the slab of the state, one step at a time
+    int numberOfShifts = RecomputeIncrementalState ? 0 : qAbs(IncrementalShift);
+    int direction = IncrementalShift > 0 ? 1 : -1;
+    int stateFirstSlice = firstSlice - IncrementalShift * Step;
+    int stateLastSlice = lastSlice - IncrementalShift * Step;
+    vtkIdType firstLeavingOffset = ((direction > 0 ? stateFirstSlice : stateLastSlice) - inputMinimumSlice) * sliceIncrement;
+    vtkIdType firstEnteringOffset = ((direction > 0 ? stateLastSlice : stateFirstSlice) + direction * Step - inputMinimumSlice) * sliceIncrement;
+    vtkIdType shiftIncrement = direction * Step * sliceIncrement;
+
+    T *inPtr2 = inPtr;
+    T *outPtr2 = outPtr;
+    for (int index2 = outExt[4]; index2 <= outExt[5] && !AbortExecute; index2++)
+    {
+        T *inRowPtr = inPtr2;
+        T *outRowPtr = outPtr2;
+        for (int index1 = outExt[2]; index1 <= outExt[3]; index1++)
         {
-            T * inPtr1 = inPtr0;
-            T * outPtr1 = outPtr0;
+            vtkIdType stateIndex = ((vtkIdType(index2 - IncrementalOutputExtent[4]) * stateDimensions[1] + (index1 - IncrementalOutputExtent[2])) *
+                                    stateDimensions[0] + (outExt[0] - IncrementalOutputExtent[0])) * numberOfComponents;
+            double *sums = &IncrementalValues[stateIndex];
 
-            for ( int inIdx1 = inMin1; inIdx1 <= inMax1 && !self->AbortExecute; ++inIdx1 )
+            if (RecomputeIncrementalState)
             {
-                // init the accumulator before a new set of pixels
-                accumulator->initialize();
-
-                T * inPtrA = inPtr1;
-
-                for ( int inIdxA = inMinA; inIdxA <= inMaxA && !self->AbortExecute; inIdxA += step )
+                const T *inSlicePtr = inRowPtr + (firstSlice - inputMinimumSlice) * sliceIncrement;
+                for (int i = 0; i < rowLength; i++)
                 {
-                    accumulator->accumulate( *inPtrA );
-                    inPtrA += (step * inIncA);
+                    sums[i] = inSlicePtr[i];
                 }
+                for (int slice = firstSlice + Step; slice <= lastSlice; slice += Step)
+                {
+                    inSlicePtr += Step * sliceIncrement;
+                    for (int i = 0; i < rowLength; i++)
+                    {
+                        sums[i] += inSlicePtr[i];
+                    }
+                }
+            }
+            else
+            {
+                const T *leavingPtr = inRowPtr + firstLeavingOffset;
+                const T *enteringPtr = inRowPtr + firstEnteringOffset;
+                for (int shift = 0; shift < numberOfShifts; shift++)
+                {
+                    for (int i = 0; i < rowLength; i++)
+                    {
+                        sums[i] += static_cast<double>(enteringPtr[i]) - static_cast<double>(leavingPtr[i]);
+                    }
+                    leavingPtr += shiftIncrement;
+                    enteringPtr += shiftIncrement;
+                }
+            }
 
-                *outPtr1 = accumulator->getValue();
-
-                inPtr1 += inInc1;
-                outPtr1 += outInc1;
+            for (int i = 0; i < rowLength; i++)
+            {
+                outRowPtr[i] = static_cast<T>(qRound(sums[i] / size));
             }
 
-            inPtr0 += inInc0;
-            outPtr0 += outInc0;
+            inRowPtr += inIncs[1];
+            outRowPtr += outIncs[1];
         }
+
+        inPtr2 += inIncs[2];
+        outPtr2 += outIncs[2];
     }
-    delete accumulator;
 }
 
 
@@ -279,6 +616,8 @@ void vtkProjectionImageFilter::ThreadedRequestData(vtkInformation *vtkNotUsed(re
     unsigned int iA = ProjectionDimension, i0 = (iA + 1) % 3, i1 = (iA + 2) % 3;
     inExt[2*i0] = outExt[2*i0]; inExt[2*i0+1] = outExt[2*i0+1];
     inExt[2*i1] = outExt[2*i1]; inExt[2*i1+1] = outExt[2*i1+1];
+    // The update extent may also include the slices that have left the slab since the last incremental execution
+    inExt[2*iA] = FirstSlice; inExt[2*iA+1] = FirstSlice + Step * (NumberOfSlicesToProject - 1);
 
     void *inPtr = inData[0][0]->GetScalarPointerForExtent(inExt);
 //     void *inPtr0 = inData[0][0]->GetScalarPointer();
@@ -287,6 +626,7 @@ void vtkProjectionImageFilter::ThreadedRequestData(vtkInformation *vtkNotUsed(re
 
     /// \warning Restaurem el valor original
     inputVector[0]->GetInformationObject(0)->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), inExt);
+    inExt[2*iA] = FirstSlice; inExt[2*iA+1] = FirstSlice + Step * (NumberOfSlicesToProject - 1);
 
     // this filter expects the output type to be same as input
     if (outData[0]->GetScalarType() != inData[0][0]->GetScalarType())
@@ -297,6 +637,18 @@ void vtkProjectionImageFilter::ThreadedRequestData(vtkInformation *vtkNotUsed(re
         return;
     }
 
+    if (UseIncrementalState)
+    {
+        switch (inData[0][0]->GetScalarType())
+        {
+            vtkTemplateMacro(this->ExecuteIncremental<VTK_TT>(inData[0][0], outData[0], outExt));
+
+        default:
+            vtkErrorMacro(<< "Execute: Unknown ScalarType");
+        }
+        return;
+    }
+
     switch (inData[0][0]->GetScalarType())
     {
         vtkTemplateMacro(
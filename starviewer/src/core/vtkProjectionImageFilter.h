@@ -28,6 +28,8 @@
 #include <vtkThreadedImageAlgorithm.h>
 #include "accumulator.h"
 
+#include <vector>
+
 
 /** \class vtkProjectionImageFilter
  * \brief Implements an accumulation of an image along a selected direction.
@@ -87,6 +89,13 @@ public:
     vtkSetMacro(Step, int);
     vtkGetMacro(Step, int);
 
+    /// If enabled, the sum of the slab is kept between executions for the average projection, so that when only the first slice changes by less than half
+    /// the slab thickness the projection is updated with the slices that enter and leave the slab instead of being computed again.
+    /// Only used with integer scalar types of up to 32 bits. The average is then computed from the exact sum, which may round differently in a tie.
+    /// The maximum and minimum projections are always computed again.
+    vtkSetMacro(IncrementalProjection, bool);
+    vtkGetMacro(IncrementalProjection, bool);
+    vtkBooleanMacro(IncrementalProjection, bool);
 
 protected:
     vtkProjectionImageFilter();
@@ -96,6 +105,8 @@ protected:
                                     vtkInformationVector **,
                                     vtkInformationVector *);
     virtual int RequestUpdateExtent (vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+    /// Decides whether the incremental state can be used before the threaded execution, and keeps its parameters afterwards.
+    virtual int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
 
     void ThreadedRequestData(vtkInformation *request,
                              vtkInformationVector **inputVector,
@@ -124,6 +135,36 @@ private:
     int FirstSlice;
     int NumberOfSlicesToProject;
     int Step;
+    bool IncrementalProjection;
+
+    /// Computes the average projection of the given output extent row by row, computing the incremental state again or updating it with the slices
+    /// that enter and leave the slab.
+    template <class T> void ExecuteIncremental(vtkImageData *inData, vtkImageData *outData, int outExt[6]);
+
+    /// Returns true if the incremental state computed with the last execution is valid for the current parameters, except the first slice.
+    bool IsIncrementalStateCompatible() const;
+
+    /// Sum of the slab for each output value.
+    std::vector<double> IncrementalValues;
+    /// True if the incremental state is valid for the parameters below.
+    bool IncrementalStateValid;
+    /// Parameters and input the incremental state was computed with.
+    int IncrementalFirstSlice;
+    int IncrementalNumberOfSlicesToProject;
+    int IncrementalStep;
+    unsigned int IncrementalProjectionDimension;
+    udg::AccumulatorFactory::AccumulatorType IncrementalAccumulatorType;
+    int IncrementalOutputExtent[6];
+    int IncrementalScalarType;
+    int IncrementalNumberOfComponents;
+    vtkImageData *IncrementalInput;
+    unsigned long IncrementalInputMTime;
+    /// True if the current execution uses the incremental state.
+    bool UseIncrementalState;
+    /// True if the incremental state must be computed from scratch in the current execution.
+    bool RecomputeIncrementalState;
+    /// Number of steps (positive or negative) the slab moves from the incremental state in the current execution.
+    int IncrementalShift;
 
 };
 
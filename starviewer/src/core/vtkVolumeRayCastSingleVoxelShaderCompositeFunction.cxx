@@ -38,6 +38,7 @@
 #include <QColor>
 
 #include "hdrcolor.h"
+#include "minmaxbrickgrid.h"
 #include "trilinearinterpolator.h"
 #include "vector3.h"
 
@@ -72,6 +73,7 @@ vtkVolumeRayCastSingleVoxelShaderCompositeFunction<VS>::vtkVolumeRayCastSingleVo
     m_compositeMethod = ClassifyInterpolate;
     m_voxelShader = 0;
     m_interpolator = new TrilinearInterpolator();
+    m_minMaxBrickGrid = 0;
 }
 
 
@@ -98,6 +100,7 @@ void vtkVolumeRayCastSingleVoxelShaderCompositeFunction<VS>::PrintSelf( ostream
 
     os << indent << "Composite Method: " << this->GetCompositeMethodAsString() << "\n";
     os << indent << "Voxel Shader: " << ( this->m_voxelShader ? this->m_voxelShader->toString().toStdString() : "(none)" ) << "\n";
+    os << indent << "Min/Max Brick Grid: " << ( this->m_minMaxBrickGrid ? "on" : "off" ) << "\n";
 
     os << std::flush;
 }
@@ -160,6 +163,15 @@ void vtkVolumeRayCastSingleVoxelShaderCompositeFunction<VS>::CastRay( vtkVolumeR
     Vector3 rayPosition( RAY_START[0], RAY_START[1], RAY_START[2] );
     int voxel[3];
 
+    // Skip the samples at the start of the ray that fall in transparent bricks
+    int step = 0;
+
+    if ( m_minMaxBrickGrid )
+    {
+        step = m_minMaxBrickGrid->getNumberOfTransparentSteps( rayPosition, RAY_INCREMENT, N_STEPS );
+        if ( step > 0 ) rayPosition += step * RAY_INCREMENT;
+    }
+
     if ( !INTERPOLATION )
     {
         voxel[0] = qRound( rayPosition.x );
@@ -177,10 +189,10 @@ void vtkVolumeRayCastSingleVoxelShaderCompositeFunction<VS>::CastRay( vtkVolumeR
     float accumulatedRedIntensity = 0.0f, accumulatedGreenIntensity = 0.0f, accumulatedBlueIntensity = 0.0f;
     float remainingOpacity = 1.0f;
 
-    int stepsThisRay = 0;
+    int stepsThisRay = step;
 
     // For each step along the ray
-    for ( int step = 0; step < N_STEPS && remainingOpacity > MINIMUM_REMAINING_OPACITY; step++ )
+    for ( ; step < N_STEPS && remainingOpacity > MINIMUM_REMAINING_OPACITY; step++ )
     {
         // We've taken another step
         stepsThisRay++;
@@ -226,6 +238,19 @@ void vtkVolumeRayCastSingleVoxelShaderCompositeFunction<VS>::CastRay( vtkVolumeR
         // Increment our position and compute our voxel location
         rayPosition += RAY_INCREMENT;
 
+        // Jump over the following samples that fall in transparent bricks
+        if ( m_minMaxBrickGrid )
+        {
+            int skippedSteps = m_minMaxBrickGrid->getNumberOfTransparentSteps( rayPosition, RAY_INCREMENT, N_STEPS - step - 1 );
+
+            if ( skippedSteps > 0 )
+            {
+                rayPosition += skippedSteps * RAY_INCREMENT;
+                step += skippedSteps;
+                stepsThisRay += skippedSteps;
+            }
+        }
+
         if ( !INTERPOLATION )
         {
             voxel[0] = qRound( rayPosition.x );
@@ -269,6 +294,13 @@ void vtkVolumeRayCastSingleVoxelShaderCompositeFunction<VS>::SetVoxelShader( VS
 }
 
 
+template <class VS>
+void vtkVolumeRayCastSingleVoxelShaderCompositeFunction<VS>::SetMinMaxBrickGrid( const MinMaxBrickGrid *minMaxBrickGrid )
+{
+    m_minMaxBrickGrid = minMaxBrickGrid;
+}
+
+
 }
 
 
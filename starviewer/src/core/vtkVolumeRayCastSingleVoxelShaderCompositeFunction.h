@@ -30,11 +30,15 @@
 
 namespace udg {
 
+class MinMaxBrickGrid;
 class TrilinearInterpolator;
 
 /**
  * Classe que fa un ray casting permetent aplicar un voxel shader per decidir el color de cada vòxel. El tipus del voxel shader és un paràmetre de template per
  * evitar cridar mètodes virtuals.
+ *
+ * Si se li assigna una MinMaxBrickGrid, les mostres que cauen en bricks transparents se salten sense cridar el voxel shader. La graella ha de correspondre al
+ * volum que es renderitza i estar actualitzada amb la funció de transferència que fa servir el voxel shader.
  */
 template <class VS>
 class vtkVolumeRayCastSingleVoxelShaderCompositeFunction : public vtkVolumeRayCastFunction {
@@ -59,6 +63,8 @@ public:
     //ETX
 
     void SetVoxelShader(VS *voxelShader);
+    /// Assigna la graella de bricks per saltar l'espai buit. Amb 0 es fan totes les mostres.
+    void SetMinMaxBrickGrid(const MinMaxBrickGrid *minMaxBrickGrid);
 
 protected:
     vtkVolumeRayCastSingleVoxelShaderCompositeFunction();
@@ -71,6 +77,7 @@ protected:
     CompositeMethod m_compositeMethod;
     VS *m_voxelShader;
     TrilinearInterpolator *m_interpolator;
+    const MinMaxBrickGrid *m_minMaxBrickGrid;
 
 private:
     /// Opacitat mínima que ha de restar per continuar el ray casting.
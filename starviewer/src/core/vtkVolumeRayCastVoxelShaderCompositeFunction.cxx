@@ -33,14 +33,54 @@
 
 #include <QColor>
 
+#include "ambientvoxelshader.h"
+#include "contourvoxelshader.h"
+#include "directilluminationvoxelshader.h"
+#include "obscurancevoxelshader.h"
 #include "trilinearinterpolator.h"
 #include "vector3.h"
 #include "voxelshader.h"
+#include "voxelshaderchain.h"
 
 
 namespace udg {
 
 
+namespace {
+
+// Aplica els voxel shaders de la llista un darrere l'altre, amb crides virtuals. Es fa servir per les combinacions que no tenen una cadena.
+class VoxelShaderList {
+
+public:
+    VoxelShaderList( const QList<VoxelShader*> &voxelShaders ) : m_voxelShaders( voxelShaders ) {}
+
+    HdrColor nvShade( const Vector3 &position, int offset, const Vector3 &direction, float remainingOpacity, const HdrColor &baseColor )
+    {
+        HdrColor color = baseColor;
+        for ( int i = 0; i < m_voxelShaders.size(); i++ ) color = m_voxelShaders.at( i )->shade( position, offset, direction, remainingOpacity, color );
+        return color;
+    }
+
+    HdrColor nvShade( const Vector3 &position, const Vector3 &direction, const TrilinearInterpolator *interpolator, float remainingOpacity,
+                      const HdrColor &baseColor )
+    {
+        HdrColor color = baseColor;
+        for ( int i = 0; i < m_voxelShaders.size(); i++ ) color = m_voxelShaders.at( i )->shade( position, direction, interpolator, remainingOpacity, color );
+        return color;
+    }
+
+private:
+    const QList<VoxelShader*> &m_voxelShaders;
+
+};
+
+typedef VoxelShaderChain<ContourVoxelShader> ContourChain;
+typedef VoxelShaderChain<ObscuranceVoxelShader> ObscuranceChain;
+typedef VoxelShaderChain<ContourVoxelShader, ObscuranceChain> ContourObscuranceChain;
+
+}
+
+
 vtkCxxRevisionMacro( vtkVolumeRayCastVoxelShaderCompositeFunction, "$Revision: 1.0 $" );
 vtkStandardNewMacro( vtkVolumeRayCastVoxelShaderCompositeFunction );
 
@@ -50,12 +90,24 @@ vtkVolumeRayCastVoxelShaderCompositeFunction::vtkVolumeRayCastVoxelShaderComposi
 {
     m_compositeMethod = ClassifyInterpolate;
     m_interpolator = new TrilinearInterpolator();
+    m_currentVoxelShaderChain = 0;
+
+    // Combinacions habituals dels voxel shaders del core
+    AddVoxelShaderChain< VoxelShaderChain<AmbientVoxelShader> >();
+    AddVoxelShaderChain< VoxelShaderChain<AmbientVoxelShader, ContourChain> >();
+    AddVoxelShaderChain< VoxelShaderChain<AmbientVoxelShader, ObscuranceChain> >();
+    AddVoxelShaderChain< VoxelShaderChain<AmbientVoxelShader, ContourObscuranceChain> >();
+    AddVoxelShaderChain< VoxelShaderChain<DirectIlluminationVoxelShader> >();
+    AddVoxelShaderChain< VoxelShaderChain<DirectIlluminationVoxelShader, ContourChain> >();
+    AddVoxelShaderChain< VoxelShaderChain<DirectIlluminationVoxelShader, ObscuranceChain> >();
+    AddVoxelShaderChain< VoxelShaderChain<DirectIlluminationVoxelShader, ContourObscuranceChain> >();
 }
 
 
 vtkVolumeRayCastVoxelShaderCompositeFunction::~vtkVolumeRayCastVoxelShaderCompositeFunction()
 {
     delete m_interpolator;
+    qDeleteAll( m_voxelShaderChains );
 }
 
 
@@ -81,6 +133,8 @@ void vtkVolumeRayCastVoxelShaderCompositeFunction::PrintSelf( ostream &os, vtkIn
             os << indent << "  " << voxelShader->toString().toStdString() << "\n";
     }
 
+    os << indent << "Voxel Shader Chain: " << ( m_currentVoxelShaderChain ? m_currentVoxelShaderChain->toString().toStdString() : "(none)" ) << "\n";
+
     os << std::flush;
 }
 
@@ -110,132 +164,12 @@ void vtkVolumeRayCastVoxelShaderCompositeFunction::CastRay( vtkVolumeRayCastDyna
         return;
     }
 
-    const bool INTERPOLATION = staticInfo->InterpolationType == VTK_LINEAR_INTERPOLATION;
-    const bool CLASSIFY_INTERPOLATE = m_compositeMethod == ClassifyInterpolate;
-
-    // Move the increments into local variables
-    const int * const INCREMENTS = staticInfo->DataIncrement;
-    const int X_INC = INCREMENTS[0], Y_INC = INCREMENTS[1], Z_INC = INCREMENTS[2];
-
-    // Get the gradient opacity constant. If this number is greater than or equal to 0.0, then the gradient opacity transfer function is a constant at that
-    // value, otherwise it is not a constant function.
-//    const float GRADIENT_OPACITY_CONSTANT = staticInfo->Volume->GetGradientOpacityConstant();
-//    const bool GRADIENT_OPACITY_IS_CONSTANT = GRADIENT_OPACITY_CONSTANT >= 0.0f;
-
-    // Get a pointer to the gradient magnitudes for this volume
-//    const unsigned char * const GRADIENT_MAGNITUDES;
-//    if ( !GRADIENT_OPACITY_IS_CONSTANT ) GRADIENT_MAGNITUDES = staticInfo->GradientMagnitudes;
-
-    const int N_STEPS = dynamicInfo->NumberOfStepsToTake;
-    const float * const RAY_START = dynamicInfo->TransformedStart;
-    const float * const A_RAY_INCREMENT = dynamicInfo->TransformedIncrement;
-    const Vector3 RAY_INCREMENT( A_RAY_INCREMENT[0], A_RAY_INCREMENT[1], A_RAY_INCREMENT[2] );
-    const float * const A_DIRECTION = dynamicInfo->TransformedDirection;
-    Vector3 direction( A_DIRECTION[0], A_DIRECTION[1], A_DIRECTION[2] );
-    direction.normalize();
-
-    if ( INTERPOLATION ) m_interpolator->setIncrements( X_INC, Y_INC, Z_INC );
-
-    // Initialize the ray position and voxel location
-    Vector3 rayPosition( RAY_START[0], RAY_START[1], RAY_START[2] );
-    int voxel[3];
-
-    if ( !INTERPOLATION )
-    {
-        voxel[0] = qRound( rayPosition.x );
-        voxel[1] = qRound( rayPosition.y );
-        voxel[2] = qRound( rayPosition.z );
-    }
+    if ( m_currentVoxelShaderChain ) m_currentVoxelShaderChain->castRay( this, dynamicInfo, staticInfo );
     else
     {
-        voxel[0] = floor( rayPosition.x );
-        voxel[1] = floor( rayPosition.y );
-        voxel[2] = floor( rayPosition.z );
+        VoxelShaderList voxelShaderList( m_voxelShaderList );
+        CastRayWithShader( voxelShaderList, dynamicInfo, staticInfo );
     }
-
-    // So far we haven't accumulated anything
-    float accumulatedRedIntensity = 0.0f, accumulatedGreenIntensity = 0.0f, accumulatedBlueIntensity = 0.0f;
-    float remainingOpacity = 1.0f;
-
-    int stepsThisRay = 0, nShaders = m_voxelShaderList.size();
-
-    // For each step along the ray
-    for ( int step = 0; step < N_STEPS && remainingOpacity > MINIMUM_REMAINING_OPACITY; step++ )
-    {
-        // We've taken another step
-        stepsThisRay++;
-
-        HdrColor color;
-
-        if ( !INTERPOLATION )
-        {
-            int offset = voxel[0] * X_INC + voxel[1] * Y_INC + voxel[2] * Z_INC;
-            for ( int i = 0; i < nShaders; i++ ) color = m_voxelShaderList.at( i )->shade( rayPosition, offset, direction, remainingOpacity, color );
-        }
-        else if ( CLASSIFY_INTERPOLATE )
-        {
-            Vector3 positions[8];
-            int offsets[8];
-            double weights[8];
-
-            m_interpolator->getPositions( rayPosition, positions );
-            m_interpolator->getOffsetsAndWeights( rayPosition, offsets, weights );
-
-            for ( int j = 0; j < 8; j++ )
-            {
-                HdrColor tempColor;
-
-                for ( int i = 0; i < nShaders; i++ )
-                    tempColor = m_voxelShaderList.at( i )->shade( positions[j], offsets[j], direction, remainingOpacity, tempColor );
-
-                tempColor.alpha *= weights[j];
-                color += tempColor.multiplyColorBy( tempColor.alpha );
-            }
-        }
-        else //if ( !CLASSIFY_INTERPOLATE )
-        {
-            for ( int i = 0; i < nShaders; i++ ) color = m_voxelShaderList.at( i )->shade( rayPosition, direction, m_interpolator, remainingOpacity, color );
-        }
-
-        float opacity = color.alpha, f;
-
-        if ( !INTERPOLATION || !CLASSIFY_INTERPOLATE ) f = opacity * remainingOpacity;
-        else f = remainingOpacity;
-
-        accumulatedRedIntensity += f * color.red;
-        accumulatedGreenIntensity += f * color.green;
-        accumulatedBlueIntensity += f * color.blue;
-        remainingOpacity *= ( 1.0f - opacity );
-
-        // Increment our position and compute our voxel location
-        rayPosition += RAY_INCREMENT;
-
-        if ( !INTERPOLATION )
-        {
-            voxel[0] = qRound( rayPosition.x );
-            voxel[1] = qRound( rayPosition.y );
-            voxel[2] = qRound( rayPosition.z );
-        }
-        else
-        {
-            voxel[0] = floor( rayPosition.x );
-            voxel[1] = floor( rayPosition.y );
-            voxel[2] = floor( rayPosition.z );
-        }
-    }
-
-    // Cap the intensity value at 1.0
-    if ( accumulatedRedIntensity > 1.0f ) accumulatedRedIntensity = 1.0f;
-    if ( accumulatedGreenIntensity > 1.0f ) accumulatedGreenIntensity = 1.0f;
-    if ( accumulatedBlueIntensity > 1.0f ) accumulatedBlueIntensity = 1.0f;
-    if ( remainingOpacity < MINIMUM_REMAINING_OPACITY ) remainingOpacity = 0.0f;
-
-    // Set the return pixel value. The depth value is the distance to the center of the volume.
-    dynamicInfo->Color[0] = accumulatedRedIntensity;
-    dynamicInfo->Color[1] = accumulatedGreenIntensity;
-    dynamicInfo->Color[2] = accumulatedBlueIntensity;
-    dynamicInfo->Color[3] = 1.0f - remainingOpacity;
-    dynamicInfo->NumberOfStepsTaken = stepsThisRay;
 }
 
 
@@ -250,12 +184,14 @@ void vtkVolumeRayCastVoxelShaderCompositeFunction::AddVoxelShader( VoxelShader *
     Q_ASSERT( voxelShader );
 
     m_voxelShaderList << voxelShader;
+    UpdateCurrentVoxelShaderChain();
 }
 
 
 void vtkVolumeRayCastVoxelShaderCompositeFunction::InsertVoxelShader( int i, VoxelShader *voxelShader )
 {
     m_voxelShaderList.insert( i, voxelShader );
+    UpdateCurrentVoxelShaderChain();
 }
 
 
@@ -268,19 +204,36 @@ int vtkVolumeRayCastVoxelShaderCompositeFunction::IndexOfVoxelShader( VoxelShade
 void vtkVolumeRayCastVoxelShaderCompositeFunction::RemoveVoxelShader( int i )
 {
     m_voxelShaderList.removeAt( i );
+    UpdateCurrentVoxelShaderChain();
 }
 
 
 void vtkVolumeRayCastVoxelShaderCompositeFunction::RemoveVoxelShader( VoxelShader *voxelShader )
 {
     int index = m_voxelShaderList.indexOf( voxelShader );
-    if ( index >= 0 ) m_voxelShaderList.removeAt( index );
+    if ( index >= 0 ) RemoveVoxelShader( index );
 }
 
 
 void vtkVolumeRayCastVoxelShaderCompositeFunction::RemoveAllVoxelShaders()
 {
     m_voxelShaderList.clear();
+    UpdateCurrentVoxelShaderChain();
+}
+
+
+void vtkVolumeRayCastVoxelShaderCompositeFunction::UpdateCurrentVoxelShaderChain()
+{
+    m_currentVoxelShaderChain = 0;
+
+    foreach ( VoxelShaderChainRayCaster *voxelShaderChain, m_voxelShaderChains )
+    {
+        if ( voxelShaderChain->setVoxelShaders( m_voxelShaderList ) )
+        {
+            m_currentVoxelShaderChain = voxelShaderChain;
+            break;
+        }
+    }
 }
 
 
@@ -29,14 +29,25 @@
 #include <vtkVolumeRayCastFunction.h>
 
 #include <QList>
+#include <QString>
+
+#include <cmath>
+
+#include "hdrcolor.h"
+#include "trilinearinterpolator.h"
+#include "vector3.h"
 
 namespace udg {
 
-class TrilinearInterpolator;
 class VoxelShader;
 
 /**
     Classe que fa un ray casting permetent aplicar un voxel shader per decidir el color de cada vòxel.
+
+    Els voxel shaders s'apliquen en l'ordre de la llista, amb una crida virtual per cada voxel shader i mostra. Per evitar-ho, es poden afegir cadenes de voxel
+    shaders (VoxelShaderChain) amb AddVoxelShaderChain(): quan la llista correspon exactament a una de les cadenes, el ray casting es fa amb un bucle
+    especialitzat per aquella combinació, com el de vtkVolumeRayCastSingleVoxelShaderCompositeFunction. Per defecte hi ha les combinacions d'il·luminació
+    ambient o directa amb contorn i obscurances.
   */
 class vtkVolumeRayCastVoxelShaderCompositeFunction : public vtkVolumeRayCastFunction {
 
@@ -66,6 +77,10 @@ public:
     void RemoveVoxelShader(VoxelShader *voxelShader);
     void RemoveAllVoxelShaders();
 
+    /// Afegeix la cadena de voxel shaders Chain, que es farà servir en lloc de la llista quan hi correspongui exactament.
+    template <class Chain>
+    void AddVoxelShaderChain();
+
 protected:
     vtkVolumeRayCastVoxelShaderCompositeFunction();
     ~vtkVolumeRayCastVoxelShaderCompositeFunction();
@@ -79,14 +94,200 @@ protected:
     TrilinearInterpolator *m_interpolator;
 
 private:
+    /// Ray casting especialitzat per una combinació de voxel shaders.
+    class VoxelShaderChainRayCaster {
+    public:
+        virtual ~VoxelShaderChainRayCaster() {}
+        /// Si la llista correspon a la combinació de voxel shaders, se la queda i retorna cert.
+        virtual bool setVoxelShaders(const QList<VoxelShader*> &voxelShaders) = 0;
+        virtual void castRay(vtkVolumeRayCastVoxelShaderCompositeFunction *function, vtkVolumeRayCastDynamicInfo *dynamicInfo,
+                             vtkVolumeRayCastStaticInfo *staticInfo) = 0;
+        virtual QString toString() const = 0;
+    };
+
+    template <class Chain>
+    class VoxelShaderChainRayCasterTemplate;
+
+    /// Fa el ray casting amb shader, que ha d'implementar els nvShade. Com que és una plantilla, les crides a nvShade no són virtuals.
+    template <class Shader>
+    void CastRayWithShader(Shader &shader, vtkVolumeRayCastDynamicInfo *dynamicInfo, vtkVolumeRayCastStaticInfo *staticInfo);
+
+    /// Escull la cadena de voxel shaders que correspon a la llista actual, si n'hi ha.
+    void UpdateCurrentVoxelShaderChain();
+
     /// Opacitat mínima que ha de restar per continuar el ray casting.
     static const float MINIMUM_REMAINING_OPACITY;
 
+    /// Cadenes de voxel shaders que es poden fer servir.
+    QList<VoxelShaderChainRayCaster*> m_voxelShaderChains;
+    /// Cadena que correspon a la llista actual, o nul si no n'hi ha cap.
+    VoxelShaderChainRayCaster *m_currentVoxelShaderChain;
+
     vtkVolumeRayCastVoxelShaderCompositeFunction(const vtkVolumeRayCastVoxelShaderCompositeFunction&);    // Not implemented.
     void operator=(const vtkVolumeRayCastVoxelShaderCompositeFunction&);                                  // Not implemented.
 
 };
 
+template <class Chain>
+class vtkVolumeRayCastVoxelShaderCompositeFunction::VoxelShaderChainRayCasterTemplate
+    : public vtkVolumeRayCastVoxelShaderCompositeFunction::VoxelShaderChainRayCaster {
+public:
+    virtual bool setVoxelShaders(const QList<VoxelShader*> &voxelShaders)
+    {
+        return m_chain.setVoxelShaders(voxelShaders);
+    }
+
+    virtual void castRay(vtkVolumeRayCastVoxelShaderCompositeFunction *function, vtkVolumeRayCastDynamicInfo *dynamicInfo,
+                         vtkVolumeRayCastStaticInfo *staticInfo)
+    {
+        function->CastRayWithShader(m_chain, dynamicInfo, staticInfo);
+    }
+
+    virtual QString toString() const
+    {
+        return m_chain.toString();
+    }
+
+private:
+    Chain m_chain;
+};
+
+template <class Chain>
+void vtkVolumeRayCastVoxelShaderCompositeFunction::AddVoxelShaderChain()
+{
+    m_voxelShaderChains << new VoxelShaderChainRayCasterTemplate<Chain>();
+    UpdateCurrentVoxelShaderChain();
+}
+
+template <class Shader>
+void vtkVolumeRayCastVoxelShaderCompositeFunction::CastRayWithShader(Shader &shader, vtkVolumeRayCastDynamicInfo *dynamicInfo,
+                                                                     vtkVolumeRayCastStaticInfo *staticInfo)
+{
+    const bool INTERPOLATION = staticInfo->InterpolationType == VTK_LINEAR_INTERPOLATION;
+    const bool CLASSIFY_INTERPOLATE = m_compositeMethod == ClassifyInterpolate;
+
+    // Move the increments into local variables
+    const int * const INCREMENTS = staticInfo->DataIncrement;
+    const int X_INC = INCREMENTS[0], Y_INC = INCREMENTS[1], Z_INC = INCREMENTS[2];
+
+    // Get the gradient opacity constant. If this number is greater than or equal to 0.0, then the gradient opacity transfer function is a constant at that
+    // value, otherwise it is not a constant function.
+//    const float GRADIENT_OPACITY_CONSTANT = staticInfo->Volume->GetGradientOpacityConstant();
+//    const bool GRADIENT_OPACITY_IS_CONSTANT = GRADIENT_OPACITY_CONSTANT >= 0.0f;
+
+    // Get a pointer to the gradient magnitudes for this volume
+//    const unsigned char * const GRADIENT_MAGNITUDES;
+//    if ( !GRADIENT_OPACITY_IS_CONSTANT ) GRADIENT_MAGNITUDES = staticInfo->GradientMagnitudes;
+
+    const int N_STEPS = dynamicInfo->NumberOfStepsToTake;
+    const float * const RAY_START = dynamicInfo->TransformedStart;
+    const float * const A_RAY_INCREMENT = dynamicInfo->TransformedIncrement;
+    const Vector3 RAY_INCREMENT( A_RAY_INCREMENT[0], A_RAY_INCREMENT[1], A_RAY_INCREMENT[2] );
+    const float * const A_DIRECTION = dynamicInfo->TransformedDirection;
+    Vector3 direction( A_DIRECTION[0], A_DIRECTION[1], A_DIRECTION[2] );
+    direction.normalize();
+
+    if ( INTERPOLATION ) m_interpolator->setIncrements( X_INC, Y_INC, Z_INC );
+
+    // Initialize the ray position and voxel location
+    Vector3 rayPosition( RAY_START[0], RAY_START[1], RAY_START[2] );
+    int voxel[3];
+
+    if ( !INTERPOLATION )
+    {
+        voxel[0] = qRound( rayPosition.x );
+        voxel[1] = qRound( rayPosition.y );
+        voxel[2] = qRound( rayPosition.z );
+    }
+    else
+    {
+        voxel[0] = floor( rayPosition.x );
+        voxel[1] = floor( rayPosition.y );
+        voxel[2] = floor( rayPosition.z );
+    }
+
+    // So far we haven't accumulated anything
+    float accumulatedRedIntensity = 0.0f, accumulatedGreenIntensity = 0.0f, accumulatedBlueIntensity = 0.0f;
+    float remainingOpacity = 1.0f;
+
+    int stepsThisRay = 0;
+
+    // For each step along the ray
+    for ( int step = 0; step < N_STEPS && remainingOpacity > MINIMUM_REMAINING_OPACITY; step++ )
+    {
+        // We've taken another step
+        stepsThisRay++;
+
+        HdrColor color;
+
+        if ( !INTERPOLATION )
+        {
+            int offset = voxel[0] * X_INC + voxel[1] * Y_INC + voxel[2] * Z_INC;
+            color = shader.nvShade( rayPosition, offset, direction, remainingOpacity, color );
+        }
+        else if ( CLASSIFY_INTERPOLATE )
+        {
+            Vector3 positions[8];
+            int offsets[8];
+            double weights[8];
+
+            m_interpolator->getPositions( rayPosition, positions );
+            m_interpolator->getOffsetsAndWeights( rayPosition, offsets, weights );
+
+            for ( int j = 0; j < 8; j++ )
+            {
+                HdrColor tempColor = shader.nvShade( positions[j], offsets[j], direction, remainingOpacity, HdrColor() );
+
+                tempColor.alpha *= weights[j];
+                color += tempColor.multiplyColorBy( tempColor.alpha );
+            }
+        }
+        else //if ( !CLASSIFY_INTERPOLATE )
+        {
+            color = shader.nvShade( rayPosition, direction, m_interpolator, remainingOpacity, color );
+        }
+
+        float opacity = color.alpha, f;
+
+        if ( !INTERPOLATION || !CLASSIFY_INTERPOLATE ) f = opacity * remainingOpacity;
+        else f = remainingOpacity;
+
+        accumulatedRedIntensity += f * color.red;
+        accumulatedGreenIntensity += f * color.green;
+        accumulatedBlueIntensity += f * color.blue;
+        remainingOpacity *= ( 1.0f - opacity );
+
+        // Increment our position and compute our voxel location
+        rayPosition += RAY_INCREMENT;
+
+        if ( !INTERPOLATION )
+        {
+            voxel[0] = qRound( rayPosition.x );
+            voxel[1] = qRound( rayPosition.y );
+            voxel[2] = qRound( rayPosition.z );
+        }
+        else
+        {
+            voxel[0] = floor( rayPosition.x );
+            voxel[1] = floor( rayPosition.y );
+            voxel[2] = floor( rayPosition.z );
+        }
+    }
+
+    // Cap the intensity value at 1.0
+    if ( accumulatedRedIntensity > 1.0f ) accumulatedRedIntensity = 1.0f;
+    if ( accumulatedGreenIntensity > 1.0f ) accumulatedGreenIntensity = 1.0f;
+    if ( accumulatedBlueIntensity > 1.0f ) accumulatedBlueIntensity = 1.0f;
+    if ( remainingOpacity < MINIMUM_REMAINING_OPACITY ) remainingOpacity = 0.0f;
+
+    // Set the return pixel value. The depth value is the distance to the center of the volume.
+    dynamicInfo->Color[0] = accumulatedRedIntensity;
+    dynamicInfo->Color[1] = accumulatedGreenIntensity;
+    dynamicInfo->Color[2] = accumulatedBlueIntensity;
+    dynamicInfo->Color[3] = 1.0f - remainingOpacity;
+    dynamicInfo->NumberOfStepsTaken = stepsThisRay;
+}
+
 }
 
 #endif
@@ -23,8 +23,13 @@
 #include "photometricinterpretation.h"
 #include "imageorientation.h"
 
+#include <QFuture>
+#include <QMutexLocker>
 #include <QSharedPointer>
 #include <QStringList>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+#include <QtCore/qmath.h>
 
 #include <vtkDataArray.h>
 #include <vtkImageCast.h>
@@ -36,6 +41,7 @@
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkStringArray.h>
 
+#include <dcdeftag.h>   // DCM_BitsStored, DCM_RescaleSlope...
 #include <dcfilefo.h>   // DcmFileFormat
 #include <dcmimage.h>   // DicomImage
 
@@ -242,6 +248,180 @@ QSharedPointer<DcmDataset> getDataset(const char *filename)
     return QSharedPointer<DcmDataset>(dicomFile.getAndRemoveDataset());
 }
 
+// Elements longer than this are not loaded into memory when reading only the header of a file. This leaves out the pixel data.
+const Uint32 HeaderOnlyMaxReadLength = 4096;
+
+// Range of stored pixel values and rescale read from the header of a file.
+struct StoredRangeAndRescale
+{
+    double minimum;
+    double maximum;
+    double slope;
+    double intercept;
+};
+
+// Reads the actual range of stored pixel values and the rescale from the given dataset. The range is Smallest/Largest Image Pixel Value, or Smallest/Largest
+// Pixel Value In Series, clamped to the range allowed by Bits Stored and Pixel Representation. Returns false if the needed tags are not present: the whole
+// Bits Stored range would overestimate most images (e.g. 12-bit CT stored as 16-bit unsigned with a negative intercept would need int instead of short).
+bool readStoredRangeAndRescale(DcmDataset *dataset, StoredRangeAndRescale &storedRangeAndRescale)
+{
+    Uint16 bitsStored = 0;
+    Uint16 pixelRepresentation = 0;
+
+    if (dataset->findAndGetUint16(DCM_BitsStored, bitsStored).bad() || bitsStored == 0 || bitsStored > 32)
+    {
+        return false;
+    }
+
+    dataset->findAndGetUint16(DCM_PixelRepresentation, pixelRepresentation);
+
+    if (pixelRepresentation == 0)
+    {
+        storedRangeAndRescale.minimum = 0.0;
+        storedRangeAndRescale.maximum = qPow(2.0, bitsStored) - 1.0;
+    }
+    else
+    {
+        storedRangeAndRescale.minimum = -qPow(2.0, bitsStored - 1);
+        storedRangeAndRescale.maximum = qPow(2.0, bitsStored - 1) - 1.0;
+    }
+
+    long int smallest, largest;
+
+    if (!(dataset->findAndGetLongInt(DCM_SmallestImagePixelValue, smallest).good() && dataset->findAndGetLongInt(DCM_LargestImagePixelValue, largest).good())
+        && !(dataset->findAndGetLongInt(DCM_SmallestPixelValueInSeries, smallest).good()
+             && dataset->findAndGetLongInt(DCM_LargestPixelValueInSeries, largest).good()))
+    {
+        return false;
+    }
+
+    if (smallest > largest)
+    {
+        return false;
+    }
+
+    storedRangeAndRescale.minimum = qMax(storedRangeAndRescale.minimum, static_cast<double>(smallest));
+    storedRangeAndRescale.maximum = qMin(storedRangeAndRescale.maximum, static_cast<double>(largest));
+
+    storedRangeAndRescale.slope = 1.0;
+    storedRangeAndRescale.intercept = 0.0;
+    Float64 slope, intercept;
+
+    if (dataset->findAndGetFloat64(DCM_RescaleSlope, slope).good() && dataset->findAndGetFloat64(DCM_RescaleIntercept, intercept).good() && slope != 0.0)
+    {
+        storedRangeAndRescale.slope = slope;
+        storedRangeAndRescale.intercept = intercept;
+    }
+
+    return true;
+}
+
+// Reads the actual range of stored pixel values and the rescale from the header of the given file without loading the pixel data.
+bool readStoredRangeAndRescale(const QString &filename, StoredRangeAndRescale &storedRangeAndRescale)
+{
+    DcmFileFormat dicomFile;
+    OFCondition status = dicomFile.loadFile(qPrintable(filename), EXS_Unknown, EGL_noChange, HeaderOnlyMaxReadLength);
+
+    if (status.bad())
+    {
+        return false;
+    }
+
+    return readStoredRangeAndRescale(dicomFile.getDataset(), storedRangeAndRescale);
+}
+
+// Scalar type predicted for one or more files, with the maximum value they can contain. VTK_VOID is used when nothing could be predicted.
+struct ScalarTypePrediction
+{
+    int scalarType;
+    double maximum;
+};
+
+// Returns the smaller VTK integer scalar type that can hold the values obtained applying the given rescale to the given range of stored values. This mimics the
+// choice of internal representation made by DCMTK.
+ScalarTypePrediction predictScalarType(double storedMinimum, double storedMaximum, double slope, double intercept)
+{
+    double rescaled1 = storedMinimum * slope + intercept;
+    double rescaled2 = storedMaximum * slope + intercept;
+    double minimum = qFloor(qMin(rescaled1, rescaled2));
+    double maximum = qCeil(qMax(rescaled1, rescaled2));
+
+    ScalarTypePrediction prediction;
+    prediction.maximum = maximum;
+
+    if (minimum < 0.0)
+    {
+        if (minimum >= SCHAR_MIN && maximum <= SCHAR_MAX)
+        {
+            prediction.scalarType = VTK_SIGNED_CHAR;
+        }
+        else if (minimum >= SHRT_MIN && maximum <= SHRT_MAX)
+        {
+            prediction.scalarType = VTK_SHORT;
+        }
+        else
+        {
+            prediction.scalarType = VTK_INT;
+        }
+    }
+    else
+    {
+        if (maximum <= UCHAR_MAX)
+        {
+            prediction.scalarType = VTK_UNSIGNED_CHAR;
+        }
+        else if (maximum <= USHRT_MAX)
+        {
+            prediction.scalarType = VTK_UNSIGNED_SHORT;
+        }
+        else
+        {
+            prediction.scalarType = VTK_UNSIGNED_INT;
+        }
+    }
+
+    return prediction;
+}
+
+// Predicts the scalar type from the given stored range and rescale, or returns an empty prediction if they couldn't be read.
+ScalarTypePrediction predictScalarType(bool hasStoredRangeAndRescale, const StoredRangeAndRescale &storedRangeAndRescale)
+{
+    if (!hasStoredRangeAndRescale)
+    {
+        ScalarTypePrediction prediction = { VTK_VOID, 0.0 };
+        return prediction;
+    }
+
+    return predictScalarType(storedRangeAndRescale.minimum, storedRangeAndRescale.maximum, storedRangeAndRescale.slope, storedRangeAndRescale.intercept);
+}
+
+// Predicts the scalar type for the given file reading only its header.
+ScalarTypePrediction predictScalarType(const QString &filename)
+{
+    StoredRangeAndRescale storedRangeAndRescale;
+    bool hasStoredRangeAndRescale = readStoredRangeAndRescale(filename, storedRangeAndRescale);
+
+    return predictScalarType(hasStoredRangeAndRescale, storedRangeAndRescale);
+}
+
+// Combines the given prediction into the accumulated result, so that the result can hold the values of both.
+void combineScalarTypePredictions(ScalarTypePrediction &result, const ScalarTypePrediction &prediction)
+{
+    if (prediction.scalarType == VTK_VOID)
+    {
+        return;
+    }
+
+    if (result.scalarType == VTK_VOID)
+    {
+        result = prediction;
+        return;
+    }
+
+    result.maximum = qMax(result.maximum, prediction.maximum);
+    result.scalarType = decideNewScalarType(result.scalarType, prediction.scalarType, result.maximum);
+}
+
 const char* booleanToString(bool b)
 {
     return b ? "yes" : "no";
@@ -261,6 +441,7 @@ void VtkDcmtkImageReader::PrintSelf(std::ostream &os, vtkIndent indent)
     os << indent << "Frame size: " << m_frameSize << " bytes\n";
     os << indent << "Maximum voxel value: " << m_maximumVoxelValue << "\n";
     os << indent << "Needs float scalar type: " << booleanToString(m_needsFloatScalarType) << "\n";
+    os << indent << "Number of decoding threads: " << m_numberOfDecodingThreads << "\n";
 }
 
 void VtkDcmtkImageReader::setFrameNumbers(const QList<int> &frameNumbers)
@@ -268,7 +449,23 @@ void VtkDcmtkImageReader::setFrameNumbers(const QList<int> &frameNumbers)
     m_frameNumbers = frameNumbers;
 }
 
+void VtkDcmtkImageReader::setNumberOfDecodingThreads(int numberOfThreads)
+{
+    m_numberOfDecodingThreads = qMax(1, numberOfThreads);
+}
+
+int VtkDcmtkImageReader::getNumberOfDecodingThreads() const
+{
+    return m_numberOfDecodingThreads;
+}
+
+void VtkDcmtkImageReader::setDecodingFocusSlice(int slice)
+{
+    m_decodingFocusSlice.store(slice);
+}
+
 VtkDcmtkImageReader::VtkDcmtkImageReader()
+    : m_numberOfDecodingThreads(1), m_decodingFocusSlice(-1)
 {
     this->SetNumberOfInputPorts(0);
     this->SetNumberOfOutputPorts(1);
@@ -298,13 +495,18 @@ int VtkDcmtkImageReader::RequestInformation(vtkInformation *vtkNotUsed(request),
     // At the beginning we don't need a float scalar type. This will be set to true by the upcoming methods if needed.
     m_needsFloatScalarType = false;
 
-    if (!readInformation(filename))
+    // The header of the first file is read only once and shared by all the steps
+    DICOMTagReader dicomTagReader(filename);
+
+    if (!dicomTagReader.canReadFile())
     {
         ERROR_LOG("Error reading information.");
         return 0;
     }
 
-    if (!decideInitialScalarTypeAndNumberOfComponents())
+    readInformation(dicomTagReader);
+
+    if (!decideInitialScalarTypeAndNumberOfComponents(dicomTagReader))
     {
         throw CantReadImageException("Can't decide a scalar type for the image. This may be due to corrupt data.");
     }
@@ -370,15 +572,8 @@ int VtkDcmtkImageReader::RequestData(vtkInformation *vtkNotUsed(request), vtkInf
     return 1;
 }
 
-bool VtkDcmtkImageReader::readInformation(const QString &filename)
+void VtkDcmtkImageReader::readInformation(const DICOMTagReader &dicomTagReader)
 {
-    DICOMTagReader dicomTagReader(filename);
-
-    if (!dicomTagReader.canReadFile())
-    {
-        return false;
-    }
-
     readExtent(dicomTagReader);
     readSpacing(dicomTagReader);
     readOrigin(dicomTagReader);
@@ -389,8 +584,6 @@ bool VtkDcmtkImageReader::readInformation(const QString &filename)
     {
         readPerFrameRescale(dicomTagReader);
     }
-
-    return true;
 }
 
 void VtkDcmtkImageReader::readExtent(const DICOMTagReader &dicomTagReader)
@@ -591,34 +784,8 @@ void VtkDcmtkImageReader::readPerFrameRescale(const DICOMTagReader &dicomTagRead
     }
 }
 
-bool VtkDcmtkImageReader::decideInitialScalarTypeAndNumberOfComponents()
-{
-    bool hasDecidedScalarType = false;
-
-    if (this->FileName)
-    {
-        hasDecidedScalarType = decideInitialScalarTypeAndNumberOfComponents(this->FileName);
-    }
-    else if (this->FileNames && this->FileNames->GetNumberOfValues() > 0)
-    {
-        for (int i = 0; !hasDecidedScalarType && i < this->FileNames->GetNumberOfValues(); i++)
-        {
-            hasDecidedScalarType = decideInitialScalarTypeAndNumberOfComponents(this->FileNames->GetValue(i));
-        }
-    }
-
-    return hasDecidedScalarType;
-}
-
-bool VtkDcmtkImageReader::decideInitialScalarTypeAndNumberOfComponents(const char *filename)
+bool VtkDcmtkImageReader::decideInitialScalarTypeAndNumberOfComponents(const DICOMTagReader &dicomTagReader)
 {
-    DICOMTagReader dicomTagReader(filename);
-
-    if (!dicomTagReader.canReadFile())
-    {
-        return false;
-    }
-
     PhotometricInterpretation photometricInterpretation(dicomTagReader.getValueAttributeAsQString(DICOMPhotometricInterpretation));
 
     if (!photometricInterpretation.isColor())
@@ -644,9 +811,70 @@ bool VtkDcmtkImageReader::decideInitialScalarTypeAndNumberOfComponents(const cha
         m_isMonochrome = false;
     }
 
+    // Compute the final scalar type for the whole data from the headers of all the files before allocating anything, so that pixel data is decoded only once
+    if (m_isMonochrome && !m_needsFloatScalarType)
+    {
+        prescanScalarType(dicomTagReader);
+    }
+
     return true;
 }
 
+void VtkDcmtkImageReader::prescanScalarType(const DICOMTagReader &firstFileTagReader)
+{
+    ScalarTypePrediction prediction = { VTK_VOID, 0.0 };
+    StoredRangeAndRescale firstFileStoredRangeAndRescale;
+
+    // The range of stored values is given by optional tags, usually absent in CT and MR. The files of a series are normally written alike, so if the first
+    // one doesn't have them the rest are not read for nothing.
+    if (!readStoredRangeAndRescale(firstFileTagReader.getDcmDataset(), firstFileStoredRangeAndRescale))
+    {
+        DEBUG_LOG("The first file doesn't have the range of its stored values. The initial scalar type may change while reading the data.");
+        return;
+    }
+
+    if (this->FileName && m_isMultiframe && m_hasPerFrameRescale)
+    {
+        foreach (const Rescale &rescale, m_perFrameRescale)
+        {
+            combineScalarTypePredictions(prediction, predictScalarType(firstFileStoredRangeAndRescale.minimum, firstFileStoredRangeAndRescale.maximum,
+                                                                       rescale.slope, rescale.intercept));
+        }
+    }
+    else
+    {
+        prediction = predictScalarType(true, firstFileStoredRangeAndRescale);
+
+        if (!this->FileName && this->FileNames && this->FileNames->GetNumberOfValues() > 1)
+        {
+            // The first file has already been read, only the headers of the rest are needed
+            QStringList filenames;
+
+            for (int i = 1; i < this->FileNames->GetNumberOfValues(); i++)
+            {
+                filenames << QString::fromStdString(this->FileNames->GetValue(i));
+            }
+
+            ScalarTypePrediction otherFilesPrediction = QtConcurrent::blockingMappedReduced<ScalarTypePrediction>(
+                filenames, static_cast<ScalarTypePrediction(*)(const QString&)>(predictScalarType), combineScalarTypePredictions);
+            combineScalarTypePredictions(prediction, otherFilesPrediction);
+        }
+    }
+
+    if (prediction.scalarType == VTK_VOID)
+    {
+        DEBUG_LOG("Couldn't predict the scalar type from the headers. The initial scalar type may change while reading the data.");
+        return;
+    }
+
+    if (prediction.scalarType != this->DataScalarType)
+    {
+        DEBUG_LOG(QString("Scalar type predicted from the headers: %1 (initially %2)").arg(prediction.scalarType).arg(this->DataScalarType));
+    }
+
+    this->DataScalarType = prediction.scalarType;
+}
+
 bool VtkDcmtkImageReader::loadData(int updateExtent[6])
 {
     vtkImageData *output = this->GetOutput(0);
@@ -654,6 +882,9 @@ bool VtkDcmtkImageReader::loadData(int updateExtent[6])
     output->AllocateScalars(this->GetOutputInformation(0));
     output->GetPointData()->GetScalars()->SetName("DCMTKImage");
 
+    // Let observers publish the output before it is filled
+    this->InvokeEvent(OutputAllocatedEvent);
+
     void *scalarPointer = output->GetScalarPointerForExtent(updateExtent);
 
     if (this->FileName)
@@ -661,12 +892,18 @@ bool VtkDcmtkImageReader::loadData(int updateExtent[6])
         if (!m_isMultiframe)
         {
             this->loadSingleFrameFile(this->FileName, scalarPointer);
+            this->notifySliceDecoded(updateExtent[4]);
         }
         else
         {
             this->loadMultiframeFile(this->FileName, scalarPointer, updateExtent);
         }
     }
+    else if (this->FileNames && this->FileNames->GetNumberOfValues() > 0 && updateExtent[5] > updateExtent[4]
+             && (m_numberOfDecodingThreads > 1 || m_decodingFocusSlice.load() >= 0))
+    {
+        this->loadSingleFrameFilesInParallel(scalarPointer, updateExtent);
+    }
     else if (this->FileNames && this->FileNames->GetNumberOfValues() > 0)
     {
         double total = updateExtent[5] - updateExtent[4] + 1;
@@ -675,6 +912,7 @@ bool VtkDcmtkImageReader::loadData(int updateExtent[6])
         for (int i = updateExtent[4]; i <= updateExtent[5] && !this->AbortExecute; i++)
         {
             this->loadSingleFrameFile(this->FileNames->GetValue(i), scalarPointer);
+            this->notifySliceDecoded(i);
             scalarPointer = static_cast<char*>(scalarPointer) + m_frameSize;
             this->UpdateProgress((i - updateExtent[4] + 1) / total);
         }
@@ -688,6 +926,11 @@ bool VtkDcmtkImageReader::loadData(int updateExtent[6])
     return !this->AbortExecute;
 }
 
+void VtkDcmtkImageReader::notifySliceDecoded(int slice)
+{
+    this->InvokeEvent(SliceDecodedEvent, &slice);
+}
+
 void VtkDcmtkImageReader::loadSingleFrameFile(const char *filename, void *buffer)
 {
     QSharedPointer<DcmDataset> dataset = getDataset(filename);
@@ -696,6 +939,206 @@ void VtkDcmtkImageReader::loadSingleFrameFile(const char *filename, void *buffer
     copyDcmtkImageToBuffer(buffer, image);
 }
 
+void VtkDcmtkImageReader::loadSingleFrameFilesInParallel(void *buffer, int updateExtent[6])
+{
+    int numberOfSlices = updateExtent[5] - updateExtent[4] + 1;
+    int numberOfThreads = qMin(m_numberOfDecodingThreads, numberOfSlices);
+    double total = numberOfSlices;
+
+    m_claimedSlices.fill(false, numberOfSlices);
+    m_nextUnclaimedSlice = updateExtent[4];
+    m_decodedSlicesToNotify.clear();
+    m_numberOfDecodedSlices.store(0);
+    m_stopParallelDecoding.store(0);
+    m_parallelDecodingError = NoParallelDecodingError;
+    m_parallelDecodingNewScalarType = this->DataScalarType;
+    m_parallelDecodingErrorMessage.clear();
+
+    this->UpdateProgress(0.0);
+
+    // Each slice goes to its own slot of the buffer, thus workers don't need to synchronize the pixel data writes
+    QList< QFuture<void> > workers;
+
+    for (int i = 0; i < numberOfThreads; i++)
+    {
+        workers.append(QtConcurrent::run(this, &VtkDcmtkImageReader::decodeSingleFrameFilesWorker, buffer, updateExtent[4], updateExtent[5]));
+    }
+
+    // VTK events must be invoked from this thread, so we wait here for the workers and report progress and decoded slices as they come
+    m_parallelDecodingMutex.lock();
+
+    foreach (const QFuture<void> &worker, workers)
+    {
+        bool finished = false;
+
+        while (!finished)
+        {
+            finished = worker.isFinished();
+
+            if (!finished && m_decodedSlicesToNotify.isEmpty())
+            {
+                m_sliceDecodedCondition.wait(&m_parallelDecodingMutex, 100);
+            }
+
+            QList<int> decodedSlices = m_decodedSlicesToNotify;
+            m_decodedSlicesToNotify.clear();
+            m_parallelDecodingMutex.unlock();
+
+            foreach (int slice, decodedSlices)
+            {
+                this->notifySliceDecoded(slice);
+            }
+
+            this->UpdateProgress(m_numberOfDecodedSlices.load() / total);
+            m_parallelDecodingMutex.lock();
+        }
+    }
+
+    ParallelDecodingError error = m_parallelDecodingError;
+    m_parallelDecodingMutex.unlock();
+
+    switch (error)
+    {
+        case NoParallelDecodingError:
+            break;
+        case ChangeScalarTypeError:
+            // Restart the read with a scalar type that satisfies all the workers
+            throw ChangeScalarTypeException(m_parallelDecodingNewScalarType);
+        case CantLoadFileError:
+            throw CantLoadFileException();
+        case OutOfMemoryError:
+            throw std::bad_alloc();
+        case UnexpectedError:
+            throw std::runtime_error(m_parallelDecodingErrorMessage);
+    }
+}
+
+int VtkDcmtkImageReader::takeNextSliceToDecode(int firstSlice, int lastSlice)
+{
+    QMutexLocker locker(&m_parallelDecodingMutex);
+
+    int slice = -1;
+    int focus = m_decodingFocusSlice.load();
+
+    if (focus >= firstSlice && focus <= lastSlice)
+    {
+        // Take the pending slice nearest to the focus, looking alternately after and before it
+        for (int distance = 0; slice < 0 && (focus - distance >= firstSlice || focus + distance <= lastSlice); distance++)
+        {
+            if (focus + distance <= lastSlice && !m_claimedSlices.testBit(focus + distance - firstSlice))
+            {
+                slice = focus + distance;
+            }
+            else if (focus - distance >= firstSlice && !m_claimedSlices.testBit(focus - distance - firstSlice))
+            {
+                slice = focus - distance;
+            }
+        }
+    }
+    else
+    {
+        while (m_nextUnclaimedSlice <= lastSlice && m_claimedSlices.testBit(m_nextUnclaimedSlice - firstSlice))
+        {
+            m_nextUnclaimedSlice++;
+        }
+
+        if (m_nextUnclaimedSlice <= lastSlice)
+        {
+            slice = m_nextUnclaimedSlice;
+        }
+    }
+
+    if (slice >= 0)
+    {
+        m_claimedSlices.setBit(slice - firstSlice);
+    }
+
+    return slice;
+}
+
+void VtkDcmtkImageReader::decodeSingleFrameFilesWorker(void *buffer, int firstSlice, int lastSlice)
+{
+    while (!this->AbortExecute && m_stopParallelDecoding.load() == 0)
+    {
+        int slice = takeNextSliceToDecode(firstSlice, lastSlice);
+
+        if (slice < 0)
+        {
+            break;
+        }
+
+        void *sliceBuffer = static_cast<char*>(buffer) + (slice - firstSlice) * m_frameSize;
+        bool decoded = false;
+
+        // Exceptions can't cross the thread boundary, so they are recorded here and rethrown by the calling thread
+        try
+        {
+            this->loadSingleFrameFile(this->FileNames->GetValue(slice), sliceBuffer);
+            decoded = true;
+        }
+        catch (const ChangeScalarTypeException &exception)
+        {
+            QMutexLocker locker(&m_parallelDecodingMutex);
+
+            if (m_parallelDecodingError == NoParallelDecodingError || m_parallelDecodingError == ChangeScalarTypeError)
+            {
+                if (m_parallelDecodingError == NoParallelDecodingError)
+                {
+                    m_parallelDecodingNewScalarType = exception.getNewScalarType();
+                }
+                else
+                {
+                    // Another worker has already asked for a new scalar type: choose one that can hold the values found by both
+                    QMutexLocker maximumLocker(&m_maximumVoxelValueMutex);
+                    m_parallelDecodingNewScalarType = decideNewScalarType(m_parallelDecodingNewScalarType, exception.getNewScalarType(),
+                                                                          m_maximumVoxelValue);
+                }
+
+                m_parallelDecodingError = ChangeScalarTypeError;
+            }
+
+            m_stopParallelDecoding.store(1);
+        }
+        catch (const CantLoadFileException &)
+        {
+            QMutexLocker locker(&m_parallelDecodingMutex);
+            m_parallelDecodingError = qMax(m_parallelDecodingError, CantLoadFileError);
+            m_stopParallelDecoding.store(1);
+        }
+        catch (const std::bad_alloc &)
+        {
+            QMutexLocker locker(&m_parallelDecodingMutex);
+            m_parallelDecodingError = qMax(m_parallelDecodingError, OutOfMemoryError);
+            m_stopParallelDecoding.store(1);
+        }
+        catch (const std::exception &exception)
+        {
+            QMutexLocker locker(&m_parallelDecodingMutex);
+            m_parallelDecodingError = UnexpectedError;
+            m_parallelDecodingErrorMessage = exception.what();
+            m_stopParallelDecoding.store(1);
+        }
+        catch (...)
+        {
+            QMutexLocker locker(&m_parallelDecodingMutex);
+            m_parallelDecodingError = UnexpectedError;
+            m_parallelDecodingErrorMessage = "Unknown exception while decoding slice";
+            m_stopParallelDecoding.store(1);
+        }
+
+        if (decoded)
+        {
+            QMutexLocker locker(&m_parallelDecodingMutex);
+            m_decodedSlicesToNotify.append(slice);
+        }
+
+        m_numberOfDecodedSlices.ref();
+        m_sliceDecodedCondition.wakeAll();
+    }
+
+    m_sliceDecodedCondition.wakeAll();
+}
+
 void VtkDcmtkImageReader::loadMultiframeFile(const char *filename, void *buffer, int updateExtent[6])
 {
     QSharedPointer<DcmDataset> dataset = getDataset(filename);
@@ -725,6 +1168,7 @@ void VtkDcmtkImageReader::loadMultiframeFile(const char *filename, void *buffer,
             copyDcmtkImageToBuffer(buffer, image);
         }
 
+        this->notifySliceDecoded(frameIndex);
         buffer = static_cast<char*>(buffer) + m_frameSize;
         this->UpdateProgress((frameIndex - updateExtent[4] + 1) / total);
     }
@@ -745,9 +1189,13 @@ void VtkDcmtkImageReader::copyDcmtkImageToBuffer(void *buffer, DicomImage &dicom
         double minimum, maximum;
         dicomImage.getMinMaxValues(minimum, maximum);
 
-        if (maximum > m_maximumVoxelValue)
         {
-            m_maximumVoxelValue = maximum;
+            QMutexLocker locker(&m_maximumVoxelValueMutex);
+
+            if (maximum > m_maximumVoxelValue)
+            {
+                m_maximumVoxelValue = maximum;
+            }
         }
 
         int dcmtkInternalDataScalarType = dcmtkRepresentationToVtkScalarType(dcmtkInternalData->getRepresentation());
@@ -785,6 +1233,7 @@ void VtkDcmtkImageReader::copyDcmtkImageToBuffer(void *buffer, DicomImage &dicom
         {
             // Internal data scalar type is different from the image data scalar type and can't be converted to it
             // Need to find a new scalar type suitable for both and restart read
+            QMutexLocker locker(&m_maximumVoxelValueMutex);
             int newScalarType = decideNewScalarType(this->DataScalarType, dcmtkInternalDataScalarType, m_maximumVoxelValue);
             throw ChangeScalarTypeException(newScalarType);
         }
@@ -17,9 +17,14 @@
 
 #include <stdexcept>
 
+#include <vtkCommand.h>
 #include <vtkImageReader2.h>
 
+#include <QAtomicInt>
+#include <QBitArray>
 #include <QList>
+#include <QMutex>
+#include <QWaitCondition>
 
 class DicomImage;
 
@@ -36,6 +41,15 @@ public:
 
     class CantReadImageException;
 
+    /// Events invoked by the reader while executing, always from the thread that called Update().
+    enum Events {
+        /// Invoked when the output scalars have been allocated, before any slice is decoded. It can be invoked more than once if the read is restarted with a
+        /// new scalar type.
+        OutputAllocatedEvent = vtkCommand::UserEvent + 1,
+        /// Invoked after each slice (or frame) has been decoded into the output. Call data is a pointer to an int with the z index of the slice.
+        SliceDecodedEvent
+    };
+
 public:
 
     vtkTypeMacro(VtkDcmtkImageReader, vtkImageReader2);
@@ -50,6 +64,16 @@ public:
     /// Sets the list of frame numbers in the order they must be read from a multiframe file. No need to specify for single-frame files.
     void setFrameNumbers(const QList<int> &frameNumbers);
 
+    /// Sets the number of threads used to decode multi-file series. A value of 1 (the default) decodes the files sequentially in the calling thread.
+    void setNumberOfDecodingThreads(int numberOfThreads);
+    /// Returns the number of threads used to decode multi-file series.
+    int getNumberOfDecodingThreads() const;
+
+    /// Asks the reader to decode the slices of a multi-file series nearest to the given one (z index) first. It can be called from any thread while reading,
+    /// and the order is updated for the slices not yet started. A negative value restores the sequential order. When set before the read starts, the series
+    /// is decoded by the worker pool even with a single decoding thread.
+    void setDecodingFocusSlice(int slice);
+
 protected:
 
     VtkDcmtkImageReader();
@@ -64,8 +88,8 @@ private:
     VtkDcmtkImageReader(const VtkDcmtkImageReader &);   // Not implemented
     void operator=(const VtkDcmtkImageReader &);        // Not implemented
 
-    /// Reads image information from the given file.
-    bool readInformation(const QString &filename);
+    /// Reads image information from the given DICOM tag reader.
+    void readInformation(const DICOMTagReader &dicomTagReader);
     /// Fills data extent from the given DICOM tag reader.
     void readExtent(const DICOMTagReader &dicomTagReader);
     /// Fills data spacing from the given DICOM tag reader.
@@ -78,18 +102,30 @@ private:
     void readOrigin(const DICOMTagReader &dicomTagReader);
     /// Reads rescale values from the DICOM per-frame functional groups sequence, if present.
     void readPerFrameRescale(const DICOMTagReader &dicomTagReader);
-    /// Decides the appropiate initial scalar type for the image data according to the range of values contained in one frame of the image and sets the number
-    /// of scalar components. The scalar type may change to a bigger one while reading all the data. Returns false in case of error, if it can't decide the
-    /// scalar type.
-    bool decideInitialScalarTypeAndNumberOfComponents();
-    /// Decides the appropiate initial scalar type for the image data according to given image file and sets the number of scalar components.
-    /// Returns false in case of error, if it can't decide the scalar type.
-    bool decideInitialScalarTypeAndNumberOfComponents(const char *filename);
+    /// Decides the appropiate initial scalar type for the image data according to the given DICOM tag reader of the first file and sets the number of scalar
+    /// components. The scalar type may change to a bigger one while reading all the data. Returns false in case of error, if it can't decide the scalar type.
+    bool decideInitialScalarTypeAndNumberOfComponents(const DICOMTagReader &dicomTagReader);
+    /// Predicts the scalar type needed to hold the data of all the files from their headers only (actual range of stored values and rescale, including the
+    /// per-frame rescale of multiframe files), and sets it as the data scalar type. The first file is taken from the given DICOM tag reader and only the headers
+    /// of the rest are read. Pixel data is not read. Nothing is predicted if the first file doesn't have the range of its stored values, and other files without
+    /// it are left out. The data scalar type can still be changed for them while reading the data.
+    void prescanScalarType(const DICOMTagReader &firstFileTagReader);
 
     /// Loads image data from the file(s) for the given update extent.
     bool loadData(int updateExtent[6]);
     /// Loads image data from a single frame file into the given buffer.
     void loadSingleFrameFile(const char *filename, void *buffer);
+    /// Loads image data from the single frame files in the given update extent into the given buffer using a pool of worker threads.
+    /// Progress is reported and abortion is checked from the calling thread.
+    void loadSingleFrameFilesInParallel(void *buffer, int updateExtent[6]);
+    /// Returns the next slice to decode between the given ones, taking the focus slice into account, and marks it as taken. Returns -1 if all of them have
+    /// already been taken.
+    int takeNextSliceToDecode(int firstSlice, int lastSlice);
+    /// Invokes the slice decoded event for the given slice.
+    void notifySliceDecoded(int slice);
+    /// Worker function for the parallel decoding. Takes slices from the shared pending set and decodes them into their slot of the given buffer until there are no
+    /// more slices left, the read is aborted or another worker has requested to stop.
+    void decodeSingleFrameFilesWorker(void *buffer, int firstSlice, int lastSlice);
     /// Loads image data from a multiframe file, for the given update extent, into the given buffer.
     void loadMultiframeFile(const char *filename, void *buffer, int updateExtent[6]);
     /// Copies the image data stored in the given dicom image into the given buffer.
@@ -121,6 +157,37 @@ private:
     double m_maximumVoxelValue;
     /// If it's true, a float scalar type will be used.
     bool m_needsFloatScalarType;
+    /// Protects m_maximumVoxelValue, which may be updated by several decoding threads at once.
+    QMutex m_maximumVoxelValueMutex;
+
+    /// Number of threads used to decode multi-file series.
+    int m_numberOfDecodingThreads;
+
+    /// Possible errors found by a decoding worker. They are rethrown in the calling thread once all the workers have finished.
+    enum ParallelDecodingError { NoParallelDecodingError, ChangeScalarTypeError, CantLoadFileError, OutOfMemoryError, UnexpectedError };
+
+    /// Slice that must be decoded first, or -1 to decode in order.
+    QAtomicInt m_decodingFocusSlice;
+    /// Slices already taken by a worker, relative to the first slice of the update extent.
+    QBitArray m_claimedSlices;
+    /// First slice that may still not have been taken by a worker.
+    int m_nextUnclaimedSlice;
+    /// Slices decoded by the workers whose slice decoded event has not been invoked yet.
+    QList<int> m_decodedSlicesToNotify;
+    /// Number of slices already decoded by the workers.
+    QAtomicInt m_numberOfDecodedSlices;
+    /// When different from 0, workers stop taking new slices.
+    QAtomicInt m_stopParallelDecoding;
+    /// Protects the parallel decoding state (taken and decoded slices, errors) and is used together with m_sliceDecodedCondition.
+    QMutex m_parallelDecodingMutex;
+    /// Woken each time a worker decodes a slice or finishes, so that the calling thread can report progress.
+    QWaitCondition m_sliceDecodedCondition;
+    /// Most severe error found by the workers.
+    ParallelDecodingError m_parallelDecodingError;
+    /// New scalar type requested by the workers that have found a wider internal representation.
+    int m_parallelDecodingNewScalarType;
+    /// Message of the unexpected exception found by a worker, if any.
+    std::string m_parallelDecodingErrorMessage;
 
 };
 
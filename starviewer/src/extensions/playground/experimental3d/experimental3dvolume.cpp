@@ -21,6 +21,7 @@
 #include "vomigammavoxelshader.h"
 #include "vomivoxelshader.h"
 #include "voxelsaliencyvoxelshader.h"
+#include "voxelshaderchain.h"
 #include "vtk4dlinearregressiongradientestimator.h"
 #include "vtkVolumeRayCastVoxelShaderCompositeFunction.h"
 #include "whitevoxelshader.h"
@@ -545,6 +546,25 @@ void Experimental3DVolume::createVolumeRayCastFunctions()
 {
     m_simpleVolumeRayCastFunction = vtkVolumeRayCastCompositeFunction::New();
     m_shaderVolumeRayCastFunction = vtkVolumeRayCastVoxelShaderCompositeFunction::New();
+
+    // Combinacions que es poden fer des de l'extensió amb la il·luminació ambient o completa, el contorn i les obscurances, perquè no facin crides virtuals
+    typedef VoxelShaderChain<ContourVoxelShader> ContourChain;
+    typedef VoxelShaderChain<ObscuranceVoxelShader> ObscuranceChain;
+    typedef VoxelShaderChain<ColorBleedingVoxelShader> ColorBleedingChain;
+    typedef VoxelShaderChain<ContourVoxelShader, ObscuranceChain> ContourObscuranceChain;
+    typedef VoxelShaderChain<ContourVoxelShader, ColorBleedingChain> ContourColorBleedingChain;
+    m_shaderVolumeRayCastFunction->AddVoxelShaderChain< VoxelShaderChain<AmbientVoxelShader2> >();
+    m_shaderVolumeRayCastFunction->AddVoxelShaderChain< VoxelShaderChain<AmbientVoxelShader2, ContourChain> >();
+    m_shaderVolumeRayCastFunction->AddVoxelShaderChain< VoxelShaderChain<AmbientVoxelShader2, ObscuranceChain> >();
+    m_shaderVolumeRayCastFunction->AddVoxelShaderChain< VoxelShaderChain<AmbientVoxelShader2, ColorBleedingChain> >();
+    m_shaderVolumeRayCastFunction->AddVoxelShaderChain< VoxelShaderChain<AmbientVoxelShader2, ContourObscuranceChain> >();
+    m_shaderVolumeRayCastFunction->AddVoxelShaderChain< VoxelShaderChain<AmbientVoxelShader2, ContourColorBleedingChain> >();
+    m_shaderVolumeRayCastFunction->AddVoxelShaderChain< VoxelShaderChain<DirectIlluminationVoxelShader2> >();
+    m_shaderVolumeRayCastFunction->AddVoxelShaderChain< VoxelShaderChain<DirectIlluminationVoxelShader2, ContourChain> >();
+    m_shaderVolumeRayCastFunction->AddVoxelShaderChain< VoxelShaderChain<DirectIlluminationVoxelShader2, ObscuranceChain> >();
+    m_shaderVolumeRayCastFunction->AddVoxelShaderChain< VoxelShaderChain<DirectIlluminationVoxelShader2, ColorBleedingChain> >();
+    m_shaderVolumeRayCastFunction->AddVoxelShaderChain< VoxelShaderChain<DirectIlluminationVoxelShader2, ContourObscuranceChain> >();
+    m_shaderVolumeRayCastFunction->AddVoxelShaderChain< VoxelShaderChain<DirectIlluminationVoxelShader2, ContourColorBleedingChain> >();
 }
 
 void Experimental3DVolume::createVoxelShaders()
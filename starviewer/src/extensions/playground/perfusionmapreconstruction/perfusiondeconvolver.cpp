@@ -0,0 +1,167 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "perfusiondeconvolver.h"
+
+#include "logging.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace udg {
+
+namespace {
+
+// Same directions used by itk::VnlForwardFFTImageFilter and itk::VnlInverseFFTImageFilter
+const int ForwardTransformDirection = -1;
+const int InverseTransformDirection = 1;
+
+/// Returns true if the given number of samples only has 2, 3 and 5 as prime factors, which is what the VNL FFT supports.
+bool isLegalNumberOfSamples(int numberOfSamples)
+{
+    if (numberOfSamples < 1)
+    {
+        return false;
+    }
+
+    const int factors[3] = { 2, 3, 5 };
+    for (int i = 0; i < 3; i++)
+    {
+        while (numberOfSamples % factors[i] == 0)
+        {
+            numberOfSamples /= factors[i];
+        }
+    }
+
+    return numberOfSamples == 1;
+}
+
+}
+
+QVector<PerfusionDeconvolver::Complex> PerfusionDeconvolver::computeAIFInverseFilter(const QVector<double> &aifSpectrumReal,
+                                                                                     const QVector<double> &aifSpectrumImaginary,
+                                                                                     const QVector<double> &omega, double regularizationFactor,
+                                                                                     double regularizationExponent)
+{
+    QVector<Complex> filter(aifSpectrumReal.size());
+    for (int i = 0; i < filter.size(); i++)
+    {
+        Complex aif(aifSpectrumReal[i], aifSpectrumImaginary[i]);
+
+        if (regularizationFactor > 1e-6 || (std::fabs(aif.real()) + std::fabs(aif.imag())) > 1e-6)
+        {
+            filter[i] = std::conj(aif) / (aif * std::conj(aif) + regularizationFactor * std::pow(-1.0, regularizationExponent) *
+                                                                  std::pow(omega[i], 2 * regularizationExponent));
+        }
+        else
+        {
+            filter[i] = Complex(0.0, 0.0);
+        }
+    }
+
+    return filter;
+}
+
+PerfusionDeconvolver::PerfusionDeconvolver(const QVector<Complex> &aifInverseFilter)
+    : m_aifInverseFilter(aifInverseFilter), m_isValid(isLegalNumberOfSamples(aifInverseFilter.size())),
+      m_fft(m_isValid ? aifInverseFilter.size() : 1), m_signal(aifInverseFilter.size())
+{
+    if (!m_isValid)
+    {
+        ERROR_LOG(QString("Can't deconvolve curves with %1 samples, the number of samples must only have 2, 3 and 5 as prime factors")
+                      .arg(aifInverseFilter.size()));
+    }
+}
+
+PerfusionDeconvolver::~PerfusionDeconvolver()
+{
+}
+
+int PerfusionDeconvolver::getNumberOfSamples() const
+{
+    return m_aifInverseFilter.size();
+}
+
+bool PerfusionDeconvolver::isValid() const
+{
+    return m_isValid;
+}
+
+void PerfusionDeconvolver::deconvolve(const double *tissueCurve, double *residueFunction)
+{
+    int numberOfSamples = getNumberOfSamples();
+    if (!m_isValid)
+    {
+        std::fill(residueFunction, residueFunction + numberOfSamples, 0.0);
+        return;
+    }
+
+    deconvolveIntoSignal(tissueCurve);
+
+    for (int i = 0; i < numberOfSamples; i++)
+    {
+        residueFunction[i] = m_signal[i].real() / numberOfSamples;
+    }
+}
+
+void PerfusionDeconvolver::computeResidueFunctionMaxima(const double *tissueCurves, int numberOfCurves, double *residueFunctionMaxima)
+{
+    int numberOfSamples = getNumberOfSamples();
+    if (!m_isValid || numberOfSamples == 0)
+    {
+        std::fill(residueFunctionMaxima, residueFunctionMaxima + numberOfCurves, 0.0);
+        return;
+    }
+
+    for (int curve = 0; curve < numberOfCurves; curve++)
+    {
+        deconvolveIntoSignal(tissueCurves + curve * numberOfSamples);
+
+        // Compare the same values deconvolve() returns, so that the result doesn't depend on rounding
+        double maximum = m_signal[0].real() / numberOfSamples;
+        for (int i = 1; i < numberOfSamples; i++)
+        {
+            double value = m_signal[i].real() / numberOfSamples;
+            if (value > maximum)
+            {
+                maximum = value;
+            }
+        }
+
+        residueFunctionMaxima[curve] = maximum;
+    }
+}
+
+void PerfusionDeconvolver::deconvolveIntoSignal(const double *tissueCurve)
+{
+    int numberOfSamples = getNumberOfSamples();
+    Complex *signal = m_signal.data_block();
+    const Complex *filter = m_aifInverseFilter.constData();
+
+    for (int i = 0; i < numberOfSamples; i++)
+    {
+        signal[i] = Complex(tissueCurve[i], 0.0);
+    }
+
+    m_fft.transform(signal, ForwardTransformDirection);
+
+    for (int i = 0; i < numberOfSamples; i++)
+    {
+        signal[i] = signal[i] * filter[i];
+    }
+
+    m_fft.transform(signal, InverseTransformDirection);
+}
+
+} // End namespace udg
@@ -0,0 +1,86 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGPERFUSIONDECONVOLVER_H
+#define UDGPERFUSIONDECONVOLVER_H
+
+#include <QVector>
+
+#include <complex>
+
+#include <vnl/algo/vnl_fft_1d.h>
+#include <vnl/vnl_vector.h>
+
+namespace udg {
+
+/**
+    Deconvolves tissue concentration curves with the arterial input function (AIF) to obtain their residue functions.
+
+    The deconvolution is done in the frequency domain with a regularised inverse of the AIF spectrum, which is computed once with
+    computeAIFInverseFilter() and shared by all the deconvolvers. Each deconvolver keeps its own FFT plan and scratch buffer, so that
+    deconvolving a curve doesn't allocate any memory, and must be used by a single thread at a time: create one per worker thread.
+
+    The transforms are the same ones the VNL FFT image filters of ITK compute, so the results are the same ones obtained with them.
+  */
+class PerfusionDeconvolver {
+public:
+    typedef std::complex<double> Complex;
+
+    /// Computes the regularised inverse of the AIF spectrum given its real and imaginary parts, the angular frequency of each sample and the
+    /// regularisation factor and exponent.
+    static QVector<Complex> computeAIFInverseFilter(const QVector<double> &aifSpectrumReal, const QVector<double> &aifSpectrumImaginary,
+                                                    const QVector<double> &omega, double regularizationFactor, double regularizationExponent);
+
+    /// Creates a deconvolver that uses the given regularised inverse of the AIF spectrum. Curves must have as many samples as the filter.
+    explicit PerfusionDeconvolver(const QVector<Complex> &aifInverseFilter);
+    ~PerfusionDeconvolver();
+
+    /// Returns the number of samples of the curves.
+    int getNumberOfSamples() const;
+
+    /// Returns false if the number of samples can't be transformed (it must only have 2, 3 and 5 as prime factors). In this case all the residue
+    /// functions are zero.
+    bool isValid() const;
+
+    /// Deconvolves the given tissue curve and writes its residue function in residueFunction. Both must have getNumberOfSamples() values.
+    void deconvolve(const double *tissueCurve, double *residueFunction);
+
+    /// Deconvolves numberOfCurves tissue curves stored one after the other in tissueCurves and writes the maximum of the residue function of each one
+    /// in residueFunctionMaxima.
+    void computeResidueFunctionMaxima(const double *tissueCurves, int numberOfCurves, double *residueFunctionMaxima);
+
+private:
+    PerfusionDeconvolver(const PerfusionDeconvolver&);              // Not implemented
+    PerfusionDeconvolver& operator=(const PerfusionDeconvolver&);   // Not implemented
+
+    /// Deconvolves the given tissue curve leaving the residue function, multiplied by the number of samples, in the real part of m_signal.
+    void deconvolveIntoSignal(const double *tissueCurve);
+
+private:
+    /// Regularised inverse of the AIF spectrum.
+    QVector<Complex> m_aifInverseFilter;
+
+    /// True if the number of samples can be transformed.
+    bool m_isValid;
+
+    /// FFT plan for the number of samples.
+    vnl_fft_1d<double> m_fft;
+
+    /// Scratch buffer where the transforms are computed.
+    vnl_vector<Complex> m_signal;
+};
+
+} // End namespace udg
+
+#endif
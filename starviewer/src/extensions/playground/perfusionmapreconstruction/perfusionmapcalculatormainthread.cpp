@@ -6,7 +6,8 @@
  ***************************************************************************/
 
 #include "perfusionmapcalculatormainthread.h"
-#include "perfusionmapcalculatorthread.h"
+#include "perfusiondeconvolver.h"
+#include "perfusiontaskscheduler.h"
 
 #include "logging.h"
 #include "series.h"
@@ -16,12 +17,14 @@
 // Qt
 #include <QTime>
 #include <QPair>
-// VTK
-#include <vtkMultiThreader.h>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
 // ITK
 #include <itkCastImageFilter.h>
+#include <itkImageRegionIterator.h>
 #include <itkVnlForwardFFTImageFilter.h>
-#include <itkVnlInverseFFTImageFilter.h>
 
 //Fourier Transform
 //#include <fftw3.h>
@@ -33,10 +36,365 @@ namespace udg {
 const double PerfusionMapCalculatorMainThread::TE = 25.0;
 const double PerfusionMapCalculatorMainThread::TR = 1.5;
 
+namespace {
+
+// Nombre de vòxels de cada tros en què es reparteixen les etapes que recorren els vòxels
+const int VoxelsPerChunk = 4096;
+
+// Mostres de la línia base de la corba de cada vòxel
+const int BaselineStart = 1;
+const int BaselineEnd = 10; //9 + 1;
+
+// Les imatges calculades tenen els vòxels en l'ordre del buffer (x, y, z) i la imatge de deltaR hi té totes les mostres temporals de cada
+// vòxel una darrera l'altra. Al volum DSC, en canvi, les fases de cada llesca estan una darrera l'altra.
+
+// Calcula els moments de la corba v de numberOfSamples mostres
+void computeMomentsOfCurve(const double *v, int numberOfSamples, double &m0, double &m1, double &m2)
+{
+    int i;
+    m0=0.0;
+    m1=0.0;
+    m2=0.0;
+    for(i=0;i<numberOfSamples;i++)
+    {
+        m0+=v[i];
+    }
+
+    for(i=0;i<numberOfSamples;i++)
+    {
+        m1+=i*v[i];
+    }
+    if(m1>0 && m1<m0*(double)numberOfSamples)
+    {
+        m1= m1/m0;
+    }
+    else
+    {
+        m1=0;
+    }
+
+    for(i=0;i<numberOfSamples;i++)
+    {
+        m2+=(i-m1)*(i-m1)*v[i];
+    }
+    if(m2>0)
+    {
+        m2= sqrt(m2/m0);
+    }
+    else
+    {
+        m2=0;
+    }
+    if(m2>(double)numberOfSamples/2.0)
+    {
+        m2=0;
+    }
+}
+
+// Decideix quins vòxels són vàlids i calcula la corba de deltaR dels vàlids
+class DeltaRTask : public PerfusionTaskScheduler::Task {
+public:
+    DeltaRTask(const Volume::ItkImageType::PixelType *dscData, int sliceSize, int numberOfPhases, double echoTime, bool *checkData,
+               double *deltaRData)
+        : m_dscData(dscData), m_sliceSize(sliceSize), m_numberOfPhases(numberOfPhases), m_echoTime(echoTime), m_checkData(checkData),
+          m_deltaRData(deltaRData)
+    {
+    }
+
+    virtual void processChunk(int begin, int end, int workerIndex)
+    {
+        Q_UNUSED(workerIndex);
+
+        QVector<signed int> timeseries(m_numberOfPhases);
+        for (int voxel = begin; voxel < end; voxel++)
+        {
+            const Volume::ItkImageType::PixelType *samples = m_dscData + static_cast<qint64>(voxel / m_sliceSize) * m_numberOfPhases * m_sliceSize +
+                                                             voxel % m_sliceSize;
+            double min = 10e6;
+            for (int t = 0; t < m_numberOfPhases; t++)
+            {
+                timeseries[t] = samples[static_cast<qint64>(t) * m_sliceSize];
+                if(timeseries[t]<min)
+                {
+                    min=timeseries[t];
+                }
+            }
+            double meanbl = 0.0;
+            for (int t = BaselineStart; t < BaselineEnd; t++)
+            {
+                meanbl += timeseries[t];
+            }
+            meanbl = meanbl / (double)(BaselineEnd - BaselineStart);
+            double stdbl = 0.0;
+            for (int t = BaselineStart; t < BaselineEnd; t++)
+            {
+                stdbl += (timeseries[t]-meanbl)*(timeseries[t]-meanbl);
+            }
+            stdbl = sqrt(stdbl / (double)(BaselineEnd - BaselineStart - 1));
+            //SNR of 10 at least --> else the voxel is discarded
+            bool valid = (meanbl > 10*stdbl)&&(stdbl > 0)&&(min > 3*stdbl);
+            m_checkData[voxel] = valid;
+
+            double *deltaR = m_deltaRData + static_cast<qint64>(voxel) * m_numberOfPhases;
+            for (int t = 0; t < m_numberOfPhases; t++)
+            {
+                deltaR[t] = valid ? -log(timeseries[t]/meanbl)/m_echoTime : 0.0;
+            }
+        }
+    }
+
+private:
+    const Volume::ItkImageType::PixelType *m_dscData;
+    int m_sliceSize;
+    int m_numberOfPhases;
+    double m_echoTime;
+    bool *m_checkData;
+    double *m_deltaRData;
+};
+
+// Suma les corbes de deltaR dels vòxels vàlids de cada llesca i en compta els vòxels vàlids
+class MeanDeltaRPerSliceTask : public PerfusionTaskScheduler::Task {
+public:
+    MeanDeltaRPerSliceTask(const bool *checkData, const double *deltaRData, int sliceSize, int numberOfPhases, double *sums, int *counts)
+        : m_checkData(checkData), m_deltaRData(deltaRData), m_sliceSize(sliceSize), m_numberOfPhases(numberOfPhases), m_sums(sums),
+          m_counts(counts)
+    {
+    }
+
+    virtual void processChunk(int begin, int end, int workerIndex)
+    {
+        Q_UNUSED(workerIndex);
+
+        for (int slice = begin; slice < end; slice++)
+        {
+            double *sum = m_sums + slice * m_numberOfPhases;
+            int firstVoxel = slice * m_sliceSize;
+            for (int voxel = firstVoxel; voxel < firstVoxel + m_sliceSize; voxel++)
+            {
+                if (m_checkData[voxel])
+                {
+                    const double *deltaR = m_deltaRData + static_cast<qint64>(voxel) * m_numberOfPhases;
+                    for (int t = 0; t < m_numberOfPhases; t++)
+                    {
+                        sum[t] += deltaR[t];
+                    }
+                    m_counts[slice]++;
+                }
+            }
+        }
+    }
+
+private:
+    const bool *m_checkData;
+    const double *m_deltaRData;
+    int m_sliceSize;
+    int m_numberOfPhases;
+    double *m_sums;
+    int *m_counts;
+};
+
+// Calcula els moments de la corba de deltaR de cada vòxel vàlid
+class MomentsTask : public PerfusionTaskScheduler::Task {
+public:
+    MomentsTask(const bool *checkData, const double *deltaRData, int numberOfPhases, double *m0Data, double *m1Data, double *m2Data)
+        : m_checkData(checkData), m_deltaRData(deltaRData), m_numberOfPhases(numberOfPhases), m_m0Data(m0Data), m_m1Data(m1Data),
+          m_m2Data(m2Data)
+    {
+    }
+
+    virtual void processChunk(int begin, int end, int workerIndex)
+    {
+        Q_UNUSED(workerIndex);
+
+        int numberOfValidVoxels = 0;
+        int numberOfVoxelsWithoutM0 = 0;
+        for (int voxel = begin; voxel < end; voxel++)
+        {
+            double m0 = 0.0;
+            double m1 = 0.0;
+            double m2 = 0.0;
+            if (m_checkData[voxel])
+            {
+                computeMomentsOfCurve(m_deltaRData + static_cast<qint64>(voxel) * m_numberOfPhases, m_numberOfPhases, m0, m1, m2);
+                if(m0<=0.0)
+                {
+                    numberOfVoxelsWithoutM0++;
+                    m0=0.0;
+                    m1=0.0;
+                    m2=0.0;
+                }
+                numberOfValidVoxels++;
+            }
+            m_m0Data[voxel] = m0;
+            m_m1Data[voxel] = m1;
+            m_m2Data[voxel] = m2;
+        }
+
+        m_numberOfValidVoxels.fetchAndAddRelaxed(numberOfValidVoxels);
+        m_numberOfVoxelsWithoutM0.fetchAndAddRelaxed(numberOfVoxelsWithoutM0);
+    }
+
+    int getNumberOfValidVoxels() const
+    {
+        return m_numberOfValidVoxels.load();
+    }
+
+    int getNumberOfVoxelsWithoutM0() const
+    {
+        return m_numberOfVoxelsWithoutM0.load();
+    }
+
+private:
+    const bool *m_checkData;
+    const double *m_deltaRData;
+    int m_numberOfPhases;
+    double *m_m0Data;
+    double *m_m1Data;
+    double *m_m2Data;
+    QAtomicInt m_numberOfValidVoxels;
+    QAtomicInt m_numberOfVoxelsWithoutM0;
+};
+
+// Recull els vòxels vàlids amb moment 0 positiu, que són els candidats a AIF
+class AIFCandidatesTask : public PerfusionTaskScheduler::Task {
+public:
+    AIFCandidatesTask(const bool *checkData, const double *m0Data)
+        : m_checkData(checkData), m_m0Data(m0Data), m_numberOfValidVoxels(0)
+    {
+    }
+
+    virtual void processChunk(int begin, int end, int workerIndex)
+    {
+        Q_UNUSED(workerIndex);
+
+        QVector<QPair<double, int> > candidates;
+        int numberOfValidVoxels = 0;
+        for (int voxel = begin; voxel < end; voxel++)
+        {
+            if (m_checkData[voxel])
+            {
+                numberOfValidVoxels++;
+                if(m_m0Data[voxel] > 0.000001)
+                {
+                    candidates << qMakePair(m_m0Data[voxel], voxel);
+                }
+            }
+        }
+
+        QMutexLocker locker(&m_mutex);
+        m_candidates << candidates;
+        m_numberOfValidVoxels += numberOfValidVoxels;
+    }
+
+    /// Retorna els candidats (moment 0, índex del vòxel) en cap ordre concret
+    const QVector<QPair<double, int> >& getCandidates() const
+    {
+        return m_candidates;
+    }
+
+    int getNumberOfValidVoxels() const
+    {
+        return m_numberOfValidVoxels;
+    }
+
+private:
+    const bool *m_checkData;
+    const double *m_m0Data;
+    QMutex m_mutex;
+    QVector<QPair<double, int> > m_candidates;
+    int m_numberOfValidVoxels;
+};
+
+// Calcula els valors de perfusió de cada vòxel. Cada fil té el seu propi deconvolucionador i les corbes dels vòxels vàlids consecutius es
+// deconvolucionen juntes.
+class PerfusionTask : public PerfusionTaskScheduler::Task {
+public:
+    PerfusionTask(const QVector<PerfusionDeconvolver::Complex> &aifInverseFilter, int numberOfWorkers, const bool *checkData, const double *m0Data,
+                  const double *deltaRData, double m0aif, double repetitionTime, double *cbvData, double *cbfData, double *mttData,
+                  Volume::ItkImageType::PixelType *cbvMapData, Volume::ItkImageType::PixelType *cbfMapData, Volume::ItkImageType::PixelType *mttMapData)
+        : m_checkData(checkData), m_m0Data(m0Data), m_deltaRData(deltaRData), m_m0aif(m0aif), m_repetitionTime(repetitionTime), m_cbvData(cbvData),
+          m_cbfData(cbfData), m_mttData(mttData), m_cbvMapData(cbvMapData), m_cbfMapData(cbfMapData), m_mttMapData(mttMapData)
+    {
+        for (int i = 0; i < numberOfWorkers; i++)
+        {
+            m_deconvolvers << new PerfusionDeconvolver(aifInverseFilter);
+        }
+    }
+
+    ~PerfusionTask()
+    {
+        qDeleteAll(m_deconvolvers);
+    }
+
+    virtual void processChunk(int begin, int end, int workerIndex)
+    {
+        PerfusionDeconvolver *deconvolver = m_deconvolvers.at(workerIndex);
+        int numberOfSamples = deconvolver->getNumberOfSamples();
+        QVector<double> residueFunctionMaxima(end - begin);
+
+        int voxel = begin;
+        while (voxel < end)
+        {
+            if (!m_checkData[voxel])
+            {
+                m_cbvData[voxel] = 0.0;
+                m_cbfData[voxel] = 0.0;
+                m_mttData[voxel] = 0.0;
+                m_cbvMapData[voxel] = 0;
+                m_cbfMapData[voxel] = 0;
+                m_mttMapData[voxel] = 0;
+                ++voxel;
+                continue;
+            }
+
+            int runEnd = voxel + 1;
+            while (runEnd < end && m_checkData[runEnd])
+            {
+                ++runEnd;
+            }
+
+            deconvolver->computeResidueFunctionMaxima(m_deltaRData + static_cast<qint64>(voxel) * numberOfSamples, runEnd - voxel,
+                                                      residueFunctionMaxima.data());
+
+            for (int i = 0; voxel < runEnd; ++i, ++voxel)
+            {
+                double valueCbv = 100*0.7*m_m0Data[voxel]/m_m0aif; //in ml/100g --> Peter dixit!!
+                double valueCbf = residueFunctionMaxima[i]*100*60*0.7/m_repetitionTime; //ml/100g*min --> Peter dixit!!
+                double valueMtt = (60*valueCbv)/valueCbf; // TR (in sec.)
+                m_cbvData[voxel] = 10.0*valueCbv;   //JUST FOR A GOOD VISUALIZATION!!!!!!
+                m_cbvMapData[voxel] = (int)(10*valueCbv);
+                m_cbfData[voxel] = valueCbf;
+                m_cbfMapData[voxel] = (int)(valueCbf);
+                m_mttData[voxel] = 10.0*valueMtt;   //JUST FOR A GOOD VISUALIZATION!!!!!!
+                m_mttMapData[voxel] = (int)(10*valueMtt);
+            }
+        }
+    }
+
+private:
+    QVector<PerfusionDeconvolver*> m_deconvolvers;
+    const bool *m_checkData;
+    const double *m_m0Data;
+    const double *m_deltaRData;
+    double m_m0aif;
+    double m_repetitionTime;
+    double *m_cbvData;
+    double *m_cbfData;
+    double *m_mttData;
+    Volume::ItkImageType::PixelType *m_cbvMapData;
+    Volume::ItkImageType::PixelType *m_cbfMapData;
+    Volume::ItkImageType::PixelType *m_mttMapData;
+};
+
+}
+
 PerfusionMapCalculatorMainThread::PerfusionMapCalculatorMainThread(QObject *parent)
- : QObject(parent), m_DSCVolume(0), m_map0Volume(0), m_map1Volume(0), m_map2Volume(0), reg_fact(1.0), reg_exp(2.0),m_AIFIsSet(false)
+ : QObject(parent), m_DSCVolume(0), m_map0Volume(0), m_map1Volume(0), m_map2Volume(0), reg_fact(1.0), reg_exp(2.0),m_AIFIsSet(false),
+   m_stageFirstPercent(0), m_stageLastPercent(0)
 {
     m_aifIndex.resize(3);
+    m_scheduler = new PerfusionTaskScheduler(this);
+    connect(m_scheduler, SIGNAL(progress(int, int)), SLOT(updateStageProgress(int, int)));
 }
 
 
@@ -46,7 +404,8 @@ PerfusionMapCalculatorMainThread::~PerfusionMapCalculatorMainThread()
 
 void PerfusionMapCalculatorMainThread::stop()
 {
-    m_stopped = true;
+    // Es pot cridar des de qualsevol fil, els trossos que s'estan calculant s'acaben però no se'n comencen més
+    m_scheduler->cancel();
 }
 
 
@@ -54,6 +413,8 @@ void PerfusionMapCalculatorMainThread::run()
 {
     Q_ASSERT(m_DSCVolume);
 
+    m_scheduler->resetCancellation();
+
     QTime time;
     int deltaRtime = 0;
     int momentstime = 0;
@@ -62,17 +423,35 @@ void PerfusionMapCalculatorMainThread::run()
     time.restart();
     DEBUG_LOG("Compute deltaR");
     this->computeDeltaR();
+    if (m_scheduler->isCancelled())
+    {
+        DEBUG_LOG("Perfusion map computation stopped while computing deltaR");
+        emit stopped();
+        return;
+    }
     deltaRtime += time.elapsed();
     time.restart();
     //\TODO: Si m_AIFIsSet només caldria calcular el moment 0!!!
     DEBUG_LOG("Compute Moments");
     this->computeMoments();
+    if (m_scheduler->isCancelled())
+    {
+        DEBUG_LOG("Perfusion map computation stopped while computing moments");
+        emit stopped();
+        return;
+    }
     momentstime += time.elapsed();
     time.restart();
     if(!m_AIFIsSet)
     {
         DEBUG_LOG("Find AIF");
         this->findAIF();
+        if (m_scheduler->isCancelled())
+        {
+            DEBUG_LOG("Perfusion map computation stopped while finding AIF");
+            emit stopped();
+            return;
+        }
         findAiftime += time.elapsed();
         time.restart();
         m_AIFIsSet = true;
@@ -85,6 +464,12 @@ void PerfusionMapCalculatorMainThread::run()
     DEBUG_LOG("Compute Perfusion");
     //return;
     this->computePerfusion();
+    if (m_scheduler->isCancelled())
+    {
+        DEBUG_LOG("Perfusion map computation stopped while computing perfusion");
+        emit stopped();
+        return;
+    }
     DEBUG_LOG("Done!");
     computePerfusiontime += time.elapsed();
     DEBUG_LOG(QString("TEMPS COMPUTANT DELTAR : %1ms ").arg(deltaRtime));
@@ -94,18 +479,29 @@ void PerfusionMapCalculatorMainThread::run()
     emit computed();
 }
 
-void PerfusionMapCalculatorMainThread::computeDeltaR()
+bool PerfusionMapCalculatorMainThread::runStage(PerfusionTaskScheduler::Task *task, int numberOfElements, int chunkSize, int firstPercent,
+                                                int lastPercent)
+{
+    m_stageFirstPercent = firstPercent;
+    m_stageLastPercent = lastPercent;
+    emit progress(firstPercent);
+
+    return m_scheduler->run(task, numberOfElements, chunkSize);
+}
+
+void PerfusionMapCalculatorMainThread::updateStageProgress(int processedElements, int numberOfElements)
 {
-    //TODO with threads!!! --> pasar a l'altre classe
+    emit progress(m_stageFirstPercent + static_cast<int>(static_cast<qint64>(m_stageLastPercent - m_stageFirstPercent) * processedElements /
+                                                         numberOfElements));
+}
 
+void PerfusionMapCalculatorMainThread::computeDeltaR()
+{
     if(!m_DSCVolume)
     {
         return;
     }
 
-    static const int Nbaselinestart = 1;
-    static const int Nbaselineend = 10; //9 + 1;
-
     DoubleTemporalImageType::RegionType regiont;
     DoubleTemporalImageType::IndexType startt;
     startt[0]=0;
@@ -116,22 +512,16 @@ void PerfusionMapCalculatorMainThread::computeDeltaR()
     DoubleTemporalImageType::SizeType sizet;
     sizet[0] = m_DSCVolume->getNumberOfPhases();  //les mostres temporals
     sizet[1] = m_DSCVolume->getItkData()->GetBufferedRegion().GetSize()[0];  //les X
-    sizet[2] = m_DSCVolume->getItkData()->GetBufferedRegion().GetSize()[0];  //les Y
+    sizet[2] = m_DSCVolume->getItkData()->GetBufferedRegion().GetSize()[1];  //les Y
     sizet[3] = m_DSCVolume->getNumberOfSlicesPerPhase();  //les Z
     //Ho definim així perquè l'iterador passi per totes les mostres temporals
     regiont.SetSize(sizet);
     regiont.SetIndex(startt);
 
-    QTime time;
-    int time1 = 0;
-    int time2 = 0;
-
     deltaRImage = DoubleTemporalImageType::New();
     deltaRImage->SetRegions(regiont);
     deltaRImage->Allocate();
 
-    Volume::ItkImageType::Pointer  inputImage = m_DSCVolume->getItkData();
-
     int iend = m_DSCVolume->getDimensions()[0];
     int jend = m_DSCVolume->getDimensions()[1];
     int kend = m_DSCVolume->getNumberOfSlicesPerPhase();
@@ -152,267 +542,40 @@ void PerfusionMapCalculatorMainThread::computeDeltaR()
     checkImage->SetRegions(region);
     checkImage->Allocate();
 
-    typedef itk::ImageRegionIterator<DoubleTemporalImageType> DoubleTempIterator;
-    DoubleTempIterator imIter(deltaRImage, deltaRImage->GetBufferedRegion());
-
-    //Iniciem els Threads per calcular la check image
-    time.restart();
-    int numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();  /// \todo QThread::idealThreadCount() amb Qt >= 4.3
-    DEBUG_LOG(QString("Number of threads = %1").arg(numberOfThreads));
-    QVector<PerfusionMapCalculatorThread*> threads(numberOfThreads);
-
-    for (int i = 0; i < numberOfThreads; i++)
-    {
-        PerfusionMapCalculatorThread * thread = new PerfusionMapCalculatorThread(i, numberOfThreads);
-        thread->setDSCImage(m_DSCVolume->getItkData());
-        thread->setVolumeSize(iend, jend, kend, tend);
-        thread->setCheckImage(checkImage);
-        thread->setCheckImageMode();
-        threads[i] = thread;
-    }
-
-    // iniciem els threads
-    for (int j = 0; j < numberOfThreads; j++)
-    {
-        PerfusionMapCalculatorThread * thread = threads[j];
-        thread->start();
-    }
-
-    // esperem que acabin els threads
-    for (int j = 0; j < numberOfThreads; j++)
-    {
-        threads[j]->wait();
-    }
-    for (int j = 0; j < numberOfThreads; j++)
-    {
-        delete threads[j];
-    }
-
-    //S'acaba els threads check image
-    QVector<signed int> timeseries(tend);
-    //std::ofstream fout("rcbv.dat", ios::out);
-/*    imIter.GoToBegin();
-    m_aif = QVector<double>(tend);
-
-    //unim resultats
-    for (k=0;k<kend;k++)
-    {
-        indexVoxel[2]=k;
-        for (j=0;j<jend;j++)
-        {
-            indexVoxel[1]=j;
-            for (i=0;i<iend;i++)
-            {
-                indexVoxel[0]=i;
-                checkImage->SetPixel(indexVoxel,threads[(i*numberOfThreads)/iend]->getCheckImage()->GetPixel(indexVoxel));
-            }
-        }
-    }*/
-    DEBUG_LOG("Done check image");
-    //Init check image ABANS!!
-    //Calculem els pixels vàlids
-/*    for (k=0;k<kend;k++)
-    {
-        slice=k*tend;
-        indexVoxel[2]=k;
-        for (j=0;j<jend;j++)
-        {
-            index[1]=j;
-            indexVoxel[1]=j;
-            for (i=0;i<iend;i++)
-            {
-                index[0]=i;
-                indexVoxel[0]=i;
-                min=10e6;
-                for (t=0;t<tend;t++)
-                {
-                    index[2]=slice+t;
-                    //timeseries[t] = m_DSCVolume->getItkData()->GetPixel(index);
-                    timeseries[t] = inputImage->GetPixel(index);
-                    if(timeseries[t]<min)
-                    {
-                        min=timeseries[t];
-                    }
-                }
-                meanbl = 0.0;
-                for (t=Nbaselinestart;t<Nbaselineend;t++)
-                {
-                    meanbl += timeseries[t];
-                }
-                meanbl = meanbl / (double)(Nbaselineend - Nbaselinestart);
-                stdbl = 0.0;
-                for (t=Nbaselinestart;t<Nbaselineend;t++)
-                {
-                    stdbl += (timeseries[t]-meanbl)*(timeseries[t]-meanbl);
-                }
-                stdbl = sqrt(stdbl / (double)(Nbaselineend - Nbaselinestart - 1));
-                //SNR of 10 at least --> else the voxel is discarded
-                valid = (meanbl > 10*stdbl)&&(stdbl > 0)&&(min > 3*stdbl);
-                checkImage->SetPixel(indexVoxel,valid);
-            }
-        }
-    }*/
-    time1 += time.elapsed();
-    time.restart();
-
-    // iniciem els threads
-    for (int i = 0; i < numberOfThreads; i++)
-    {
-        PerfusionMapCalculatorThread * thread = new PerfusionMapCalculatorThread(i, numberOfThreads);
-        thread->setDSCImage(m_DSCVolume->getItkData());
-        thread->setVolumeSize(iend, jend, kend, tend);
-        thread->setCheckImage(checkImage);
-        thread->setDeltaRImage(deltaRImage);
-        thread->setDeltaRImageMode();
-        threads[i] = thread;
-    }
-    // iniciem els threads
-    for (int j = 0; j < numberOfThreads; j++)
-    {
-        PerfusionMapCalculatorThread * thread = threads[j];
-        thread->start();
-    }
+    DEBUG_LOG(QString("Number of threads = %1").arg(m_scheduler->getNumberOfWorkers()));
 
-    // esperem que acabin els threads
-    for (int j = 0; j < numberOfThreads; j++)
+    DeltaRTask task(m_DSCVolume->getItkData()->GetBufferPointer(), iend * jend, tend, TE, checkImage->GetBufferPointer(),
+                    deltaRImage->GetBufferPointer());
+    if (!runStage(&task, iend * jend * kend, VoxelsPerChunk, 0, 30))
     {
-        threads[j]->wait();
+        return;
     }
 
-    //S'acaba els threads deltaR image
-
-/*    //Init deltaR image ABANS!!
-    typedef itk::ImageRegionIterator<BoolImageType> BoolIterator;
-    BoolIterator boolIter(checkImage, checkImage->GetBufferedRegion());
-
-    boolIter.GoToBegin();
-    imIter.GoToBegin();
-
-    for (k=0;k<kend;k++)
-    {
-        slice=k*tend;
-        indexVoxel[2]=k;
-        for (j=0;j<jend;j++)
-        {
-            index[1]=j;
-            indexVoxel[1]=j;
-            for (i=0;i<iend;i++)
-            {
-                index[0]=i;
-                min=10e6;
-                indexVoxel[0]=i;
-                if(boolIter.Get())
-                {
-                    for (t=0;t<tend;t++)
-                    {
-                        index[2]=slice+t;
-                        //timeseries[t] = m_DSCVolume->getItkData()->GetPixel(index);
-                        timeseries[t] = inputImage->GetPixel(index);
-                    }
-                    meanbl = 0.0;
-                    for (t=Nbaselinestart;t<Nbaselineend;t++)
-                    {
-                        meanbl += timeseries[t];
-                    }
-                    meanbl = meanbl / (double)(Nbaselineend - Nbaselinestart);
-                    for (t=0;t<tend;t++)
-                    {
-                        value = -log(timeseries[t]/meanbl)/TE;
-                        //Sense iteradors
-                        //index[2]=slice+t;
-                        //deltaRImage->SetPixel(index, value);
-                        //Amb iteradors
-                        imIter.Set(value);
-                        ++imIter;
-                        //fout<<value<<std::endl;
-                    }
-                }
-                else
-                {
-                    for (t=0;t<tend;t++)
-                    {
-                        //Sense iteradors
-                        //index[2]=slice+t;
-                        //deltaRImage->SetPixel(index, 0.0);
-                        //Amb iteradors
-                        imIter.Set(0.0);
-                        ++imIter;
-                    }
-                }
-                if(checkImage->GetPixel(indexVoxel) != boolIter.Get()) 
-                {
-                    std::cout<<"."<<std::endl;
-                }
-                ++boolIter;
-            }
-        }
-    }*/
-    time2 += time.elapsed();
-
-    DEBUG_LOG(QString("-- TEMPS Computant checkImage : %1ms ").arg(time1));
-    DEBUG_LOG(QString("-- TEMPS Computant deltaR : %1ms ").arg(time2));
-
-    // destruïm els threads
-    for (int j = 0; j < numberOfThreads; j++)
-    {
-        delete threads[j];
-    }
-    //fout.close();
     this->computeMeanDeltaRPerSlice();
 }
 
 void PerfusionMapCalculatorMainThread::computeMeanDeltaRPerSlice()
 {
-    int i,j,k,t;
-    //prenem la i perquè sol ser el valor més gran
-    //TODO:Compte quan un no és múltiple de l'altre!!!
     int iend = m_DSCVolume->getDimensions()[0];
     int jend = m_DSCVolume->getDimensions()[1];
     int kend = m_DSCVolume->getNumberOfSlicesPerPhase();
     int tend = m_DSCVolume->getNumberOfPhases();
-    m_meanseries = QVector<QVector<double> > (kend,QVector<double> (tend,0.0));
-    QVector<signed int > contseries(kend,0);
-
-    typedef itk::ImageRegionIteratorWithIndex<BoolImageType> BoolIterator;
-    BoolIterator boolIter(checkImage, checkImage->GetBufferedRegion());
-
-    typedef itk::ImageRegionIteratorWithIndex<DoubleTemporalImageType> DoubleTempIterator;
-    DoubleTempIterator imIter(deltaRImage, deltaRImage->GetBufferedRegion());
 
-    boolIter.GoToBegin();
-    imIter.GoToBegin();
-
-    for (k=0;k<kend;k++)
+    // Cada llesca és un element, així les sumes es fan en el mateix ordre que recorrent el volum
+    QVector<double> sums(kend * tend, 0.0);
+    QVector<int> counts(kend, 0);
+    MeanDeltaRPerSliceTask task(checkImage->GetBufferPointer(), deltaRImage->GetBufferPointer(), iend * jend, tend, sums.data(), counts.data());
+    if (!runStage(&task, kend, 1, 30, 35))
     {
-        for (j=0;j<jend;j++)
-        {
-            for (i=0;i<iend;i++)
-            {
-                if(boolIter.Get())
-                {
-                    for (t=0;t<tend;t++)
-                    {
-                        m_meanseries[k][t] += (double)imIter.Get();
-                        ++imIter;
-                    }
-                    contseries[k]++;
-                }
-                else
-                {
-                    for (t=0;t<tend;t++)
-                    {
-                        ++imIter;
-                    }
-                }
-                ++boolIter;
-            }
-        }
+        return;
     }
-    for (k=0;k<kend;k++)
+
+    m_meanseries = QVector<QVector<double> > (kend,QVector<double> (tend,0.0));
+    for (int k=0;k<kend;k++)
     {
-        for (t=0;t<tend;t++)
+        for (int t=0;t<tend;t++)
         {
-            m_meanseries[k][t] = m_meanseries[k][t]/(double)contseries[k];
+            m_meanseries[k][t] = sums[k*tend + t]/(double)counts[k];
         }
     }
 }
@@ -445,130 +608,47 @@ void PerfusionMapCalculatorMainThread::computeMoments()
     m2Image->SetRegions(region);
     m2Image->Allocate();
 
-    int i,j,k,t;
     int iend = m_DSCVolume->getDimensions()[0];
     int jend = m_DSCVolume->getDimensions()[1];
     int kend = m_DSCVolume->getNumberOfSlicesPerPhase();
     int tend = m_DSCVolume->getNumberOfPhases();
-    DoubleTemporalImageType::IndexType index;
-    Volume::ItkImageType::IndexType indexMoment;
-    //int slice;
-    QVector<double> timeseries(tend);
-    double m0,m1,m2;
-//     std::ofstream fout0("m0.dat", ios::out);
-//     std::ofstream fout1("m1.dat", ios::out);
-//     std::ofstream fout2("m2.dat", ios::out);
-
-    typedef itk::ImageRegionIterator<DoubleTemporalImageType> DoubleTempIterator;
-    DoubleTempIterator imIter(deltaRImage, deltaRImage->GetBufferedRegion());
-    imIter.GoToBegin();
-    int contvalid=0;
-    int contm0=0;
-
-    for (k=0;k<kend;k++)
+
+    MomentsTask task(checkImage->GetBufferPointer(), deltaRImage->GetBufferPointer(), tend, m0Image->GetBufferPointer(), m1Image->GetBufferPointer(),
+                     m2Image->GetBufferPointer());
+    if (!runStage(&task, iend * jend * kend, VoxelsPerChunk, 35, 55))
     {
-        index[3]=k;
-        indexMoment[2]=k;
-        for (j=0;j<jend;j++)
-        {
-            index[2]=j;
-            indexMoment[1]=j;
-            for (i=0;i<iend;i++)
-            {
-                index[1]=i;
-                indexMoment[0]=i;
-                if(checkImage->GetPixel(indexMoment))
-                {
-                    //slice=k*tend;
-                    for (t=0;t<tend;t++)
-                    {
-                        //Sense iteradors
-                        //index[2]=slice+t;
-                        //timeseries[t] = deltaRImage->GetPixel(index);
-                        //Amb iteradors
-                        timeseries[t] = imIter.Get();
-                        //std::cout<<imIter.Get()<<" ";
-                        ++imIter;
-                    }
-                    //std::cout<<std::endl;
-                    this->computeMomentsVoxel(timeseries, m0,m1,m2);
-                    if(m0<=0.0)
-                    {
-                        //std::cout<<"m's = 0"<<std::endl;
-                        contm0++;
-                        m0=0.0;
-                        m1=0.0;
-                        m2=0.0;
-                    }
-                    contvalid++;
-                }
-                else
-                {
-                    m0=0.0;
-                    m1=0.0;
-                    m2=0.0;
-                    //posem l'iterador a la posició que toca //Segurament millorable
-                    for (t=0;t<tend;t++)
-                    {
-                        ++imIter;
-                    }
-                }
-                //fout0<<m0<<std::endl;
-                //fout1<<m1<<std::endl;
-                //fout2<<m2<<std::endl;
-                m0Image->SetPixel(indexMoment, m0);
-                m1Image->SetPixel(indexMoment, m1);
-                m2Image->SetPixel(indexMoment, m2);
-            }
-        }
+        return;
     }
+
+    int contvalid = task.getNumberOfValidVoxels();
+    int contm0 = task.getNumberOfVoxelsWithoutM0();
     DEBUG_LOG(QString("A compute moments hi ha %1 voxels valids").arg(contvalid));
     DEBUG_LOG(QString("A compute moments hi ha %1 voxels m0").arg(contm0));
     DEBUG_LOG(QString("A compute moments hi ha %1 voxels molt valids").arg(contvalid-contm0));
-/*    fout0.close();
-    fout1.close();
-    fout2.close();*/
 }
 
 void PerfusionMapCalculatorMainThread::findAIF()
 {
     static const int firstSelection = 100;
     static const int secondSelection = 10;
-    int i,j,k;
+    int i;
     int iend = m_DSCVolume->getDimensions()[0];
     int jend = m_DSCVolume->getDimensions()[1];
     int kend = m_DSCVolume->getNumberOfSlicesPerPhase();
     Volume::ItkImageType::IndexType index;
-    int indexint;
     double value;//, valuem2;
     m_aif.resize(m_DSCVolume->getNumberOfPhases());
 
-    QVector< QPair< double, int > > sortedMoment1;
-    QVector< QPair< double, int > > sortedMoment0;
-    int contm0=0;
-    for (i=0;i<iend;i++)
+    AIFCandidatesTask task(checkImage->GetBufferPointer(), m0Image->GetBufferPointer());
+    if (!runStage(&task, iend * jend * kend, VoxelsPerChunk, 55, 65))
     {
-        index[0]=i;
-        for (j=0;j<jend;j++)
-        {
-            index[1]=j;
-            for (k=0;k<kend;k++)
-            {
-                index[2]=k;
-                if(checkImage->GetPixel(index))
-                {
-                    value =  m0Image->GetPixel(index);
-                    contm0++;
-                    //valuem2 =  m2Image->GetPixel(index);    //excloem els que tenen també una m2 negativa
-                    if(value > 0.000001)
-                    {
-                        indexint = i + j*iend + k*jend*iend;
-                        sortedMoment0 << qMakePair(value, indexint);
-                    }
-                }
-            }
-        }
+        return;
     }
+
+    QVector< QPair< double, int > > sortedMoment1;
+    // L'ordre en què els fils han recollit els candidats no importa, l'ordenació els desempata per índex
+    QVector< QPair< double, int > > sortedMoment0 = task.getCandidates();
+    int contm0 = task.getNumberOfValidVoxels();
     qSort(sortedMoment0);    // sort in ascending order
     DEBUG_LOG(QString("sortedMoment 0 size: %1").arg(sortedMoment0.size()));
     DEBUG_LOG(QString("A sorted moments0 hi ha %1 voxels").arg(contm0));
@@ -669,7 +749,7 @@ void PerfusionMapCalculatorMainThread::updateAIF()
     }
     //Variables q no serveixen per res
     double m1aif,m2aif;
-    this->computeMomentsVoxel(m_aif, m_m0aif,m1aif,m2aif);
+    computeMomentsOfCurve(m_aif.constData(), m_aif.size(), m_m0aif,m1aif,m2aif);
     //std::cout<<"m_m0aif="<<m_m0aif<<", m1aif="<<m1aif<<", m2aif="<<m2aif<<std::endl;
     this->fftAIF();
     //std::cout<<"End fftAIF"<<std::endl;
@@ -716,129 +796,23 @@ void PerfusionMapCalculatorMainThread::computePerfusion()
     map2Image->SetRegions(region);
     map2Image->Allocate();
 
-    //With threads!!!
-/*
-    int numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();  /// \todo QThread::idealThreadCount() amb Qt >= 4.3
-    //numberOfThreads = 1;
-    std::cout<<"Number of threads = "<<numberOfThreads<<std::endl;
-    QVector<PerfusionMapCalculatorThread *> threads(numberOfThreads);
-    int iend = m_DSCVolume->getDimensions()[0];
-    int jend = m_DSCVolume->getDimensions()[1];
-    int kend = m_DSCVolume->getNumberOfSlicesPerPhase();
-    int tend = m_DSCVolume->getNumberOfPhases();
-
-    for (int i = 0; i < numberOfThreads; i++)
-    {
-        PerfusionMapCalculatorThread * thread = new PerfusionMapCalculatorThread(i, numberOfThreads);
-        thread->setVolumeSize(iend, jend, kend, tend);
-        thread->setCheckImage(checkImage);
-        thread->setDeltaRImage(deltaRImage);
-        thread->setm0Aif(m_m0aif);
-        thread->setFFTAif(fftaifreal,fftaifimag);
-        thread->setOmega(omega);
-        thread->setm0Image(m0Image);
-        thread->setCBVImage(cbvImage);
-        thread->setCBFImage(cbfImage);
-        thread->setMTTImage(mttImage);
-        thread->setCBVMapImage(map0Image);
-        thread->setCBFMapImage(map2Image);
-        thread->setMTTMapImage(map1Image);
-        thread->setPerfusionImageMode();
-        threads[i] = thread;
-    }
-
-    // iniciem els threads
-    for (int j = 0; j < numberOfThreads; j++)
-    {
-        PerfusionMapCalculatorThread * thread = threads[j];
-        thread->start();
-        //thread->runPerfusionImage();
-    }
-
-    // esperem que acabin els threads
-    for (int j = 0; j < numberOfThreads; j++)
-    {
-        threads[j]->wait();
-    }
-    for (int j = 0; j < numberOfThreads; j++)
-    {
-        delete threads[j];
-    }
-
-*/
-  
-    //std::cout<<"Init Bucle"<<std::endl;
-    //Init com estava abans!!!!!!!!!!
-    int i,j,k,t;
     int iend = m_DSCVolume->getDimensions()[0];
     int jend = m_DSCVolume->getDimensions()[1];
     int kend = m_DSCVolume->getNumberOfSlicesPerPhase();
     int tend = m_DSCVolume->getNumberOfPhases();
-    Volume::ItkImageType::IndexType index;
-    double max;
-    double valueCbv, valueCbf, valueMtt;
+    Q_ASSERT(tend == m_aif.size());
+    Q_UNUSED(tend);
 
-    QVector<  double > timeseries(m_aif.size());
-    QVector<  double > residueFunction(m_aif.size());
-
-    typedef itk::ImageRegionIterator<DoubleTemporalImageType> DoubleTempIterator;
-    DoubleTempIterator imIter(deltaRImage, deltaRImage->GetBufferedRegion());
-    imIter.GoToBegin();
-
-    for (k=0;k<kend;k++)
+    // El filtre invers de l'AIF és el mateix per tots els vòxels, el calculem només un cop
+    PerfusionTask task(PerfusionDeconvolver::computeAIFInverseFilter(fftaifreal, fftaifimag, omega, reg_fact, reg_exp),
+                       m_scheduler->getNumberOfWorkers(), checkImage->GetBufferPointer(), m0Image->GetBufferPointer(), deltaRImage->GetBufferPointer(),
+                       m_m0aif, TR, cbvImage->GetBufferPointer(), cbfImage->GetBufferPointer(), mttImage->GetBufferPointer(),
+                       map0Image->GetBufferPointer(), map1Image->GetBufferPointer(), map2Image->GetBufferPointer());
+    if (!runStage(&task, iend * jend * kend, VoxelsPerChunk, 65, 100))
     {
-        index[2]=k;
-        for (j=0;j<jend;j++)
-        {
-            index[1]=j;
-            for (i=0;i<iend;i++)
-            {
-                index[0]=i;
-                if(checkImage->GetPixel(index))
-                {
-                    for (t=0;t<tend;t++)
-                    {
-                        timeseries[t] = imIter.Get();
-                        ++imIter;
-                    }
-                    this->deconvolve(timeseries, residueFunction);
-                    max=residueFunction[0];
-                    for (t=1;t<tend;t++)
-                    {
-                        if(residueFunction[t] > max)
-                        {
-                            max = residueFunction[t];
-                        }
-                    }
-                    valueCbv = 100*0.7*m0Image->GetPixel(index)/m_m0aif; //in ml/100g --> Peter dixit!!
-                    valueCbf = max*100*60*0.7/TR; //ml/100g*min --> Peter dixit!!
-                    valueMtt = (60*valueCbv)/valueCbf; // TR (in sec.)
-                    cbvImage->SetPixel(index, 10.0*valueCbv);   //JUST FOR A GOOD VISUALIZATION!!!!!!
-                    map0Image->SetPixel(index, (int)(10*valueCbv));
-                    cbfImage->SetPixel(index, valueCbf);
-                    map1Image->SetPixel(index, (int)(valueCbf));
-                    mttImage->SetPixel(index, 10.0*valueMtt);   //JUST FOR A GOOD VISUALIZATION!!!!!!
-                    map2Image->SetPixel(index, (int)(10*valueMtt));
-                }
-                else
-                {
-                    cbvImage->SetPixel(index, 0.0);
-                    cbfImage->SetPixel(index, 0.0);
-                    mttImage->SetPixel(index, 0.0);
-                    map0Image->SetPixel(index, 0);
-                    map1Image->SetPixel(index, 0);
-                    map2Image->SetPixel(index, 0);
-                    for (t=0;t<tend;t++)
-                    {
-                       ++imIter;
-                    }
-                }
-            }
-        }
+        return;
     }
 
-    //std::cout<<"End Bucle"<<std::endl;
-
     time1 += time.elapsed();
     time.restart();
 
@@ -862,6 +836,14 @@ void PerfusionMapCalculatorMainThread::computePerfusion()
     m_map2Volume->setImages(m_DSCVolume->getPhaseImages(0));
     m_map2Volume->setData(map1Image);
 
+    // El càlcul es fa en un fil a part, els volums els fa servir el fil del volum d'entrada
+    if (m_map0Volume->thread() == QThread::currentThread())
+    {
+        m_map0Volume->moveToThread(m_DSCVolume->thread());
+    }
+    m_map1Volume->moveToThread(m_DSCVolume->thread());
+    m_map2Volume->moveToThread(m_DSCVolume->thread());
+
     time2 += time.elapsed();
     DEBUG_LOG(QString("Done!!"));
 
@@ -959,202 +941,6 @@ void PerfusionMapCalculatorMainThread::fftAIF()
     }
 }
 
-void PerfusionMapCalculatorMainThread::deconvolve(QVector<double> tissue, QVector<double>& residuefunc)
-{
-    typedef std::complex<double> complexd;
-    complexd num1, num2, num3;
-
-//     //Usant fftw
-//     fftw_complex* in;
-//     fftw_complex* out;
-//
-//     in = new fftw_complex[tissue.size()];
-//     out = new fftw_complex[tissue.size()];
-//
-//     fftw_plan pf, pb;
-//
-//     pf = fftw_plan_dft_1d(tissue.size(), in, out, FFTW_FORWARD, FFTW_ESTIMATE);
-//     pb = fftw_plan_dft_1d(tissue.size(), in, out, FFTW_BACKWARD, FFTW_ESTIMATE);
-//
-//     int i;
-//     for(i=0;i<tissue.size();i++)
-//     {
-//         in[i][0]=tissue[i];
-//         in[i][1]=0.0;
-//     }
-//
-//     fftw_execute(pf);
-//
-//     for(i=0;i<tissue.size();i++)
-//     {
-//         num1=complexd(fftaifreal[i],fftaifimag[i]);
-//         num2=complexd(out[i][0],out[i][1]);
-//
-//         if((reg_fact > 1e-6) || ((fabs(num1.real()) + fabs(num1.imag()))> 1e-6))
-//         {
-//             num3 = num2* (conj(num1) / (num1*conj(num1) + reg_fact*pow(-1,reg_exp)*pow(omega[i],2*reg_exp)));
-//             in[i][0] = num3.real();
-//             in[i][1] = num3.imag();
-//         }
-//         else
-//         {
-//             in[i][0] = 0.0;
-//             in[i][1] = 0.0;
-//         }
-//     }
-//     fftw_execute(pb);
-//     for(i=0;i<tissue.size();i++)
-//     {
-//         residuefunc[i]=out[i][0]/tissue.size();
-//     }
-//     fftw_destroy_plan(pf);
-//     fftw_destroy_plan(pb);
-//     free(in);
-//     free(out);
-
-    //Usant itk's
-    //std::cout<<"Usant itk's"<<std::endl;
-    typedef itk::Image< double, 1 > VectorImageType;
-    VectorImageType::RegionType region;
-    VectorImageType::IndexType start;
-    start[0]=0;
-    VectorImageType::SizeType size;
-    size[0] = m_aif.size();  //les mostres temporals
-    region.SetSize(size);
-    region.SetIndex(start);
-
-    VectorImageType::Pointer tissueImage = VectorImageType::New();
-    tissueImage->SetRegions(region);
-    tissueImage->Allocate();
-
-    typedef itk::ImageRegionIterator<VectorImageType> VectorIteratorType;
-    VectorIteratorType tissueIter(tissueImage, tissueImage->GetBufferedRegion());
-
-    typedef itk::VnlForwardFFTImageFilter< VectorImageType >  FFTFilterType;
-    FFTFilterType::Pointer fftFilter = FFTFilterType::New();
-
-    int i;
-    tissueIter.GoToBegin();
-
-    for(i=0;i<tissue.size();i++)
-    {
-        tissueIter.Set(tissue[i]);
-        ++tissueIter;
-    }
-    fftFilter->SetInput(tissueImage);
-
-    try
-        {
-        fftFilter->Update();
-        }
-    catch(itk::ExceptionObject & excp)
-        {
-        DEBUG_LOG(QString("Exception caught ! %1").arg(excp.GetDescription()));
-        return;
-        }
-
-    typedef FFTFilterType::OutputImageType ComplexImageType;
-    ComplexImageType::Pointer residualFFTImage = ComplexImageType::New();
-    residualFFTImage->SetRegions(region);
-    residualFFTImage->Allocate();
-
-    typedef itk::ImageRegionIterator<ComplexImageType> ComplexIteratorType;
-    ComplexIteratorType fftTissueIter(fftFilter->GetOutput(), fftFilter->GetOutput()->GetBufferedRegion());
-    fftTissueIter.GoToBegin();
-
-    ComplexIteratorType fftResidualIter(residualFFTImage, residualFFTImage->GetBufferedRegion());
-    fftResidualIter.GoToBegin();
-
-    for(i=0;i<tissue.size();i++)
-    {
-        num1=complexd(fftaifreal[i],fftaifimag[i]);
-        num2=complexd(fftTissueIter.Get().real(),fftTissueIter.Get().imag());
-
-        if((reg_fact > 1e-6) || ((fabs(num1.real()) + fabs(num1.imag()))> 1e-6))
-        {
-            num3 = num2* (conj(num1) / (num1*conj(num1) + reg_fact*pow(-1,reg_exp)*pow(omega[i],2*reg_exp)));
-            fftResidualIter.Set(num3);
-        }
-        else
-        {
-            num3 = complexd(0.0, 0.0);
-            fftResidualIter.Set(num3);
-        }
-        ++fftTissueIter;
-        ++fftResidualIter;
-    }
-
-    typedef itk::VnlInverseFFTImageFilter< ComplexImageType >  IFFTFilterType;
-    IFFTFilterType::Pointer fftInverseFilter = IFFTFilterType::New();
-    fftInverseFilter->SetInput(residualFFTImage);
-
-    try
-        {
-        fftInverseFilter->Update();
-        }
-    catch(itk::ExceptionObject & excp)
-        {
-        DEBUG_LOG(QString("Exception caught ! %1").arg(excp.GetDescription()));
-        return;
-        }
-
-    VectorIteratorType residualIter(fftInverseFilter->GetOutput(), fftInverseFilter->GetOutput()->GetBufferedRegion());
-    residualIter.GoToBegin();
-
-    for(i=0;i<tissue.size();i++)
-    {
-        //if(residuefunc[i]!=residualIter.Get()) std::cout<<"Resultat residuefunc diferent: "<<residuefunc[i]<<" ," <<residualIter.Get()/tissue.size()<<std::endl;
-
-        residuefunc[i]=residualIter.Get();
-        ++residualIter;
-    }
-
-}
-
-void PerfusionMapCalculatorMainThread::computeMomentsVoxel(QVector<double> v, double &m0, double &m1, double &m2)
-{
-    int i;
-    m0=0.0;
-    m1=0.0;
-    m2=0.0;
-    //std::cout<<"compute moments size "<<v.size()<<std::endl;
-    for(i=0;i<v.size();i++)
-    {
-        m0+=v[i];
-    }
-
-    for(i=0;i<v.size();i++)
-    {
-        m1+=i*v[i];
-    }
-    if(m1>0 && m1<m0*(double)v.size())
-    {
-        m1= m1/m0;
-    }
-    else
-    {
-        m1=0;
-    }
-
-    for(i=0;i<v.size();i++)
-    {
-        m2+=(i-m1)*(i-m1)*v[i];
-    }
-    if(m2>0)
-    {
-        m2= sqrt(m2/m0);
-    }
-    else
-    {
-        m2=0;
-    }
-    if(m2>(double)v.size()/2.0)
-    {
-        m2=0;
-    }
-
-}
-
 void PerfusionMapCalculatorMainThread::getOmega()
 {
     //! returns omega axis for fft for dt=1
@@ -8,16 +8,18 @@
 #ifndef UDGPERFUSIONMAPCALCULATORMAINTHREAD_H
 #define UDGPERFUSIONMAPCALCULATORMAINTHREAD_H
 
+#include "perfusiontaskscheduler.h"
+
 #include <itkImage.h>
 
-#include <QThread>
+#include <QObject>
 #include <QVector>
 
 namespace udg {
 
 class Volume;
 /**
- * Thread principal per al càlcul d'obscurances. Controla els altres threads.
+ * Calcula els mapes de perfusió. Cada etapa del càlcul es reparteix en trossos que el PerfusionTaskScheduler executa en paral·lel.
  */
 class PerfusionMapCalculatorMainThread : public QObject {
 
@@ -56,8 +58,11 @@ public slots:
 
 signals:
 
+    /// S'emet a mesura que s'acaba cada tros de cada etapa
     void progress(int percent);
     void computed();
+    /// S'emet quan s'acaba el càlcul perquè s'ha cridat stop()
+    void stopped();
 
 //protected:
 
@@ -69,16 +74,23 @@ private:
     void computeDeltaR();
     void computeMeanDeltaRPerSlice();
     void computeMoments();
-    //Xapussa: posem directament el tipus dels voxels del Volume
-    void computeMomentsVoxel(QVector<double> v, double &m0, double &m1, double &m2);
     void findAIF();
     void updateAIF();
     void fftAIF();
     void getOmega();
     void computePerfusion();
-    void deconvolve(QVector<double> tissue, QVector<double>& residuefunc);
     void changeMap(int value);
 
+    /// Executa una etapa amb el planificador. El progrés de l'etapa va de firstPercent a lastPercent del progrés total.
+    /// Retorna fals si s'ha aturat el càlcul.
+    bool runStage(PerfusionTaskScheduler::Task *task, int numberOfElements, int chunkSize, int firstPercent, int lastPercent);
+
+private slots:
+    /// Tradueix el progrés de l'etapa actual a progrés total
+    void updateStageProgress(int processedElements, int numberOfElements);
+
+private:
+
 
     Volume *m_DSCVolume;
     Volume* m_map0Volume;
@@ -107,10 +119,15 @@ private:
 
     double reg_fact, reg_exp;
 
-    bool m_stopped;
-
     bool m_AIFIsSet;
 
+    /// Executa les etapes del càlcul
+    PerfusionTaskScheduler *m_scheduler;
+
+    /// Rang de progrés de l'etapa actual
+    int m_stageFirstPercent;
+    int m_stageLastPercent;
+
 };
 
 }
@@ -8,17 +8,21 @@ FORMS += qperfusionmapreconstructionextensionbase.ui \
 HEADERS += qperfusionmapreconstructionextension.h \
            perfusionmapreconstructionextensionmediator.h  \
            perfusionmapreconstructionsettings.h \
-           perfusionmapcalculatorthread.h \
            perfusionmapcalculatormainthread.h \
+           perfusiondeconvolver.h \
+           perfusiontaskscheduler.h \
            qgraphicplotwidget.h
 SOURCES += qperfusionmapreconstructionextension.cpp \
            perfusionmapreconstructionextensionmediator.cpp  \
            perfusionmapreconstructionsettings.cpp \
-           perfusionmapcalculatorthread.cpp \
            perfusionmapcalculatormainthread.cpp \
+           perfusiondeconvolver.cpp \
+           perfusiontaskscheduler.cpp \
            qgraphicplotwidget.cpp
 RESOURCES += perfusionmapreconstruction.qrc
 
+QT += concurrent
+
 EXTENSION_DIR = $$PWD
 include(../../basicconfextensions.pri)
 
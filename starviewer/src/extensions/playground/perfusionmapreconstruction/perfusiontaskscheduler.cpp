@@ -0,0 +1,139 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "perfusiontaskscheduler.h"
+
+#include <QFuture>
+#include <QList>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+namespace udg {
+
+PerfusionTaskScheduler::PerfusionTaskScheduler(QObject *parent)
+    : QObject(parent), m_task(0), m_numberOfElements(0), m_chunkSize(1), m_numberOfChunks(0), m_processedElements(0), m_runningWorkers(0)
+{
+    m_numberOfWorkers = qMax(1, qMin(QThread::idealThreadCount(), QThreadPool::globalInstance()->maxThreadCount()));
+}
+
+PerfusionTaskScheduler::~PerfusionTaskScheduler()
+{
+}
+
+int PerfusionTaskScheduler::getNumberOfWorkers() const
+{
+    return m_numberOfWorkers;
+}
+
+bool PerfusionTaskScheduler::run(Task *task, int numberOfElements, int chunkSize)
+{
+    Q_ASSERT(task);
+
+    if (isCancelled())
+    {
+        return false;
+    }
+
+    if (numberOfElements <= 0)
+    {
+        return true;
+    }
+
+    m_task = task;
+    m_numberOfElements = numberOfElements;
+    m_chunkSize = qMax(chunkSize, 1);
+    m_numberOfChunks = (numberOfElements - 1) / m_chunkSize + 1;
+    m_nextChunk.store(0);
+    m_processedElements = 0;
+    m_runningWorkers = qMin(m_numberOfWorkers, m_numberOfChunks);
+
+    QList<QFuture<void> > workers;
+    for (int i = 0; i < m_runningWorkers; i++)
+    {
+        workers << QtConcurrent::run(this, &PerfusionTaskScheduler::runWorker, i);
+    }
+
+    int processedElements = 0;
+    QMutexLocker locker(&m_progressMutex);
+    while (m_runningWorkers > 0)
+    {
+        m_progressChanged.wait(&m_progressMutex);
+
+        if (m_processedElements != processedElements)
+        {
+            processedElements = m_processedElements;
+            locker.unlock();
+            emit progress(processedElements, numberOfElements);
+            locker.relock();
+        }
+    }
+    processedElements = m_processedElements;
+    locker.unlock();
+
+    foreach (QFuture<void> worker, workers)
+    {
+        worker.waitForFinished();
+    }
+    m_task = 0;
+
+    return processedElements == numberOfElements;
+}
+
+void PerfusionTaskScheduler::cancel()
+{
+    m_cancelled.store(1);
+}
+
+bool PerfusionTaskScheduler::isCancelled() const
+{
+    return m_cancelled.load() != 0;
+}
+
+void PerfusionTaskScheduler::resetCancellation()
+{
+    m_cancelled.store(0);
+}
+
+void PerfusionTaskScheduler::runWorker(int workerIndex)
+{
+    forever
+    {
+        if (isCancelled())
+        {
+            break;
+        }
+
+        int chunk = m_nextChunk.fetchAndAddOrdered(1);
+        if (chunk >= m_numberOfChunks)
+        {
+            break;
+        }
+
+        int begin = chunk * m_chunkSize;
+        int end = qMin(begin + m_chunkSize, m_numberOfElements);
+        m_task->processChunk(begin, end, workerIndex);
+
+        QMutexLocker locker(&m_progressMutex);
+        m_processedElements += end - begin;
+        m_progressChanged.wakeAll();
+    }
+
+    QMutexLocker locker(&m_progressMutex);
+    m_runningWorkers--;
+    m_progressChanged.wakeAll();
+}
+
+} // End namespace udg
@@ -0,0 +1,99 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGPERFUSIONTASKSCHEDULER_H
+#define UDGPERFUSIONTASKSCHEDULER_H
+
+#include <QObject>
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+
+namespace udg {
+
+/**
+    Runs the stages of the perfusion map computation splitting their elements (voxels, slices...) in chunks that are processed in parallel.
+
+    The worker threads of the global thread pool take the chunks one at a time from a shared counter until there are none left, so the work
+    is balanced even when some chunks are more expensive than others. The thread that calls run() waits for the workers and emits progress()
+    each time a chunk is finished. A run can be cancelled from any thread with cancel(): the chunks being processed are finished and no more
+    chunks are started.
+  */
+class PerfusionTaskScheduler : public QObject {
+Q_OBJECT
+public:
+    /// Work to be done on each chunk of elements.
+    class Task {
+    public:
+        virtual ~Task() {}
+
+        /// Processes the elements in [begin, end). The chunks processed by the same worker thread receive the same workerIndex, which is between
+        /// 0 and getNumberOfWorkers() - 1, so that the task can keep scratch data per worker.
+        virtual void processChunk(int begin, int end, int workerIndex) = 0;
+    };
+
+    explicit PerfusionTaskScheduler(QObject *parent = 0);
+    ~PerfusionTaskScheduler();
+
+    /// Returns the maximum number of worker threads used in a run.
+    int getNumberOfWorkers() const;
+
+    /// Processes numberOfElements elements with the given task in chunks of chunkSize elements and waits until they are done.
+    /// Returns true if all the elements have been processed and false if the run has been cancelled.
+    bool run(Task *task, int numberOfElements, int chunkSize);
+
+    /// Cancels the current run and the following ones until resetCancellation() is called. Can be called from any thread.
+    void cancel();
+
+    /// Returns true if cancel() has been called since the last resetCancellation().
+    bool isCancelled() const;
+
+    /// Allows new runs after a cancellation.
+    void resetCancellation();
+
+signals:
+    /// Emitted from the thread that called run() each time a chunk is finished.
+    void progress(int processedElements, int numberOfElements);
+
+private:
+    /// Processes chunks of the current run until there are none left or the run is cancelled.
+    void runWorker(int workerIndex);
+
+private:
+    /// Maximum number of worker threads.
+    int m_numberOfWorkers;
+
+    /// Different than zero when the runs are cancelled.
+    QAtomicInt m_cancelled;
+
+    /// Parameters of the current run.
+    Task *m_task;
+    int m_numberOfElements;
+    int m_chunkSize;
+    int m_numberOfChunks;
+
+    /// Next chunk to be processed in the current run.
+    QAtomicInt m_nextChunk;
+
+    /// Protects the progress of the current run and signals its changes.
+    QMutex m_progressMutex;
+    QWaitCondition m_progressChanged;
+    int m_processedElements;
+    int m_runningWorkers;
+};
+
+} // End namespace udg
+
+#endif
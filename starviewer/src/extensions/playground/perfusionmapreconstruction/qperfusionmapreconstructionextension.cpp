@@ -39,6 +39,8 @@
 #include <QAction>
 #include <QToolBar>
 #include <QMessageBox>
+#include <QProgressDialog>
+#include <QThread>
 #include <QContextMenuEvent>
 #include <QDataStream>
 #include <QDir>
@@ -66,12 +68,26 @@ const double QPerfusionMapReconstructionExtension::TE = 25.0;
 const double QPerfusionMapReconstructionExtension::TR = 1.5;
 
 QPerfusionMapReconstructionExtension::QPerfusionMapReconstructionExtension(QWidget *parent)
- : QWidget(parent), m_mainVolume(0), m_DSCVolume(0), m_isLeftButtonPressed(false), m_seedToolData(0), m_mapCalculator(0), m_aifDrawPoint(0)
+ : QWidget(parent), m_mainVolume(0), m_DSCVolume(0), m_isLeftButtonPressed(false), m_seedToolData(0), m_mapCalculator(0), m_aifDrawPoint(0),
+   m_isComputingPerfusionMap(false)
 {
     setupUi(this);
     PerfusionMapReconstructionSettings().init();
 
     m_mapCalculator = new PerfusionMapCalculatorMainThread;
+    m_mapCalculatorThread = new QThread(this);
+    m_mapCalculator->moveToThread(m_mapCalculatorThread);
+    m_mapCalculatorThread->start();
+
+    m_progressDialog = new QProgressDialog(this);
+    m_progressDialog->setWindowModality(Qt::WindowModal);
+    m_progressDialog->setRange(0, 100);
+    m_progressDialog->setMinimumDuration(0);
+    m_progressDialog->setWindowTitle(tr("Perfusion Maps"));
+    m_progressDialog->setLabelText(tr("Computing perfusion maps..."));
+    m_progressDialog->setAutoReset(false);
+    m_progressDialog->setAutoClose(false);
+    m_progressDialog->reset();
 
     initializeTools();
     createConnections();
@@ -86,6 +102,11 @@ QPerfusionMapReconstructionExtension::QPerfusionMapReconstructionExtension(QWidg
 
 QPerfusionMapReconstructionExtension::~QPerfusionMapReconstructionExtension()
 {
+    m_mapCalculator->stop();
+    m_mapCalculatorThread->quit();
+    m_mapCalculatorThread->wait();
+    delete m_mapCalculator;
+
     delete m_toolManager;
     writeSettings();
 }
@@ -148,7 +169,11 @@ void QPerfusionMapReconstructionExtension::createConnections()
   connect(m_computePerfusionPushButton, SIGNAL(clicked()), SLOT(computePerfusionMap()));
   //connect(m_filterPushButton, SIGNAL(clicked()), SLOT(applyFilterMapImage()));
   connect(m_mapViewComboBox, SIGNAL(currentIndexChanged (int)), SLOT(changeMap(int)));
-  connect(m_mapCalculator, SIGNAL(computed()), SLOT(paintMap()));
+  connect(this, SIGNAL(perfusionMapComputationRequested()), m_mapCalculator, SLOT(run()));
+  connect(m_mapCalculator, SIGNAL(progress(int)), SLOT(updatePerfusionMapComputationProgress(int)));
+  connect(m_mapCalculator, SIGNAL(computed()), SLOT(perfusionMapComputed()));
+  connect(m_mapCalculator, SIGNAL(stopped()), SLOT(perfusionMapComputationFinished()));
+  connect(m_progressDialog, SIGNAL(canceled()), SLOT(cancelPerfusionMapComputation()));
 }
 
 void QPerfusionMapReconstructionExtension::setInput(Volume *input)
@@ -229,7 +254,6 @@ void QPerfusionMapReconstructionExtension::changeMap(int value)
 
 void QPerfusionMapReconstructionExtension::computePerfusionMap()
 {
-    QApplication::setOverrideCursor(Qt::WaitCursor);
     if(m_seedToolData)
     {
         if(m_seedToolData->getPoint())
@@ -246,7 +270,33 @@ void QPerfusionMapReconstructionExtension::computePerfusionMap()
         }
     }
     m_mapCalculator->setDSCVolume(m_DSCVolume);
-    m_mapCalculator->run();
+
+    // El calculador no es torna a tocar fins que acaba, el botó queda desactivat mentrestant
+    m_computePerfusionPushButton->setEnabled(false);
+    m_isComputingPerfusionMap = true;
+    m_progressDialog->setValue(0);
+    emit perfusionMapComputationRequested();
+}
+
+void QPerfusionMapReconstructionExtension::updatePerfusionMapComputationProgress(int percent)
+{
+    // Després de cancel·lar encara poden arribar progressos dels trossos que s'estaven calculant
+    if (m_isComputingPerfusionMap)
+    {
+        m_progressDialog->setValue(percent);
+    }
+}
+
+void QPerfusionMapReconstructionExtension::cancelPerfusionMapComputation()
+{
+    // El fil de càlcul està ocupat mentre calcula, per això no hi enviem cap senyal: stop() es pot cridar des de qualsevol fil
+    m_isComputingPerfusionMap = false;
+    m_mapCalculator->stop();
+}
+
+void QPerfusionMapReconstructionExtension::perfusionMapComputed()
+{
+    this->paintMap();
 
     m_meanseries = m_mapCalculator->getMeanDeltaRPerSlice();
 
@@ -271,8 +321,14 @@ void QPerfusionMapReconstructionExtension::computePerfusionMap()
     roiData->setTemporalImage(m_mapCalculator->getDeltaRImage());
     m_toolManager->triggerTool("SlicingTool");
 
+    this->perfusionMapComputationFinished();
+}
 
-    QApplication::restoreOverrideCursor();
+void QPerfusionMapReconstructionExtension::perfusionMapComputationFinished()
+{
+    m_isComputingPerfusionMap = false;
+    m_progressDialog->reset();
+    m_computePerfusionPushButton->setEnabled(true);
 }
 
 
@@ -17,6 +17,8 @@
 
 // FWD declarations
 class QAction;
+class QProgressDialog;
+class QThread;
 class vtkImageMask;
 class vtkActor;
 class vtkUnsignedCharArray;
@@ -43,6 +45,10 @@ public slots:
     /// Li assigna el volum principal
     void setInput(Volume *input);
 
+signals:
+    /// Demana al fil de càlcul que calculi els mapes de perfusió
+    void perfusionMapComputationRequested();
+
 private:
     typedef itk::Image<bool, 3> BoolImageType;
     typedef itk::Image<double, 3> DoubleImageType;
@@ -66,6 +72,14 @@ private:
 private slots:
 
     void computePerfusionMap();
+    /// Actualitza el diàleg de progrés si el càlcul no s'ha cancel·lat
+    void updatePerfusionMapComputationProgress(int percent);
+    /// Atura el càlcul dels mapes de perfusió
+    void cancelPerfusionMapComputation();
+    /// Mostra els mapes un cop calculats
+    void perfusionMapComputed();
+    /// Deixa la interfície com estava abans de començar el càlcul
+    void perfusionMapComputationFinished();
     void paintMap();
     void changeMap(int value);
 
@@ -124,6 +138,15 @@ private:
     ///Calculadora de mapes de perfusió
     PerfusionMapCalculatorMainThread* m_mapCalculator;
 
+    /// Fil on es calculen els mapes de perfusió, per no bloquejar la interfície
+    QThread *m_mapCalculatorThread;
+
+    /// Mostra el progrés del càlcul i permet cancel·lar-lo
+    QProgressDialog *m_progressDialog;
+
+    /// Indica si s'estan calculant els mapes i no s'ha cancel·lat el càlcul
+    bool m_isComputingPerfusionMap;
+
     DrawerPoint* m_aifDrawPoint;
     int m_aifIndex[3];
     int m_aifSlice;
@@ -0,0 +1,126 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "cacheevictionservice.h"
+
+#include <QMutexLocker>
+
+#include "harddiskinformation.h"
+#include "inputoutputsettings.h"
+#include "localdatabasemanager.h"
+#include "logging.h"
+
+namespace udg {
+
+const unsigned long CacheEvictionService::CheckIntervalInMilliseconds = 5 * 60 * 1000;
+
+CacheEvictionService::CacheEvictionService()
+ : m_isCheckRequested(false), m_isStopRequested(false)
+{
+}
+
+CacheEvictionService::~CacheEvictionService()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_isStopRequested = true;
+        m_checkRequested.wakeAll();
+    }
+
+    // LocalDatabaseManager::freeSpaceDeletingStudies() comprova la interrupció entre estudi i estudi, per tant com a molt s'espera que acabi d'esborrar
+    // l'estudi que està esborrant
+    requestInterruption();
+    wait();
+}
+
+void CacheEvictionService::requestCheck()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_isCheckRequested = true;
+    m_checkRequested.wakeAll();
+
+    if (!isRunning())
+    {
+        start(QThread::LowPriority);
+    }
+}
+
+void CacheEvictionService::run()
+{
+    forever
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+
+            if (!m_isCheckRequested && !m_isStopRequested)
+            {
+                m_checkRequested.wait(&m_mutex, CheckIntervalInMilliseconds);
+            }
+
+            if (m_isStopRequested)
+            {
+                return;
+            }
+
+            m_isCheckRequested = false;
+        }
+
+        freeSpaceIfNeeded();
+    }
+}
+
+void CacheEvictionService::freeSpaceIfNeeded()
+{
+    Settings settings;
+
+    if (!settings.getValue(InputOutputSettings::DeleteLeastRecentlyUsedStudiesNoFreeSpaceCriteria).toBool())
+    {
+        return;
+    }
+
+    quint64 minimumFreeMBytes = settings.getValue(InputOutputSettings::MinimumFreeGigaBytesForCache).toULongLong() * 1024;
+    quint64 MBytesToFreeIfCacheIsFull = settings.getValue(InputOutputSettings::MinimumGigaBytesToFreeIfCacheIsFull).toULongLong() * 1024;
+    quint64 lowWatermarkMBytes = minimumFreeMBytes + MBytesToFreeIfCacheIsFull;
+    quint64 highWatermarkMBytes = lowWatermarkMBytes + MBytesToFreeIfCacheIsFull;
+
+    HardDiskInformation hardDiskInformation;
+    quint64 freeMBytes = hardDiskInformation.getNumberOfFreeMBytes(LocalDatabaseManager::getCachePath());
+
+    if (freeMBytes >= lowWatermarkMBytes)
+    {
+        return;
+    }
+
+    INFO_LOG(QString("L'espai lliure de la cache (%1 MB) es per sota de la marca baixa (%2 MB), s'esborraran estudis fins arribar a %3 MB")
+                .arg(freeMBytes).arg(lowWatermarkMBytes).arg(highWatermarkMBytes));
+
+    LocalDatabaseManager localDatabaseManager;
+    // El signal s'emet des d'aquest thread, així els objectes de la interfície connectats al servei el reben quan estan lliures
+    connect(&localDatabaseManager, SIGNAL(studyWillBeDeleted(QString)), this, SIGNAL(studyWillBeDeleted(QString)), Qt::DirectConnection);
+
+    localDatabaseManager.freeSpaceDeletingStudies(lowWatermarkMBytes, highWatermarkMBytes);
+
+    if (localDatabaseManager.getLastError() != LocalDatabaseManager::Ok)
+    {
+        ERROR_LOG("S'ha produit un error alliberant espai de la cache en segon pla");
+    }
+    else
+    {
+        INFO_LOG(QString("Espai lliure de la cache despres d'esborrar estudis: %1 MB")
+                    .arg(hardDiskInformation.getNumberOfFreeMBytes(LocalDatabaseManager::getCachePath())));
+    }
+}
+
+}
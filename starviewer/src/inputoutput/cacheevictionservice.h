@@ -0,0 +1,72 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGCACHEEVICTIONSERVICE_H
+#define UDGCACHEEVICTIONSERVICE_H
+
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "singleton.h"
+
+namespace udg {
+
+/**
+    Manté l'espai lliure del disc de la caché entre dues marques esborrant en un thread a part els estudis que fa més temps que no es visualitzen,
+    perquè les descàrregues no hagin d'esperar a alliberar espai abans de començar.
+
+    Quan l'espai lliure baixa de la marca baixa s'esborren estudis fins arribar a la marca alta. Les marques es deriven de la configuració de la caché:
+    la baixa és l'espai mínim per descarregar més els GB a alliberar quan la caché està plena, i l'alta hi suma un altre cop els GB a alliberar. Així
+    l'espai lliure no arriba al mínim per descarregar mentre el servei pugui esborrar al ritme que es descarrega.
+
+    La comprovació es fa periòdicament i cada cop que es demana amb requestCheck(), per exemple en acabar una descàrrega. Només s'esborren estudis si està
+    activada l'opció d'esborrar estudis quan no hi ha espai lliure.
+  */
+class CacheEvictionService : public QThread, public Singleton<CacheEvictionService> {
+Q_OBJECT
+public:
+    /// Demana que es comprovi l'espai lliure sense esperar a la següent comprovació periòdica. El primer cop engega el thread del servei.
+    void requestCheck();
+
+signals:
+    /// S'emet des del thread del servei abans d'esborrar un estudi de la caché
+    void studyWillBeDeleted(const QString &studyInstanceUID);
+
+protected:
+    friend class Singleton<CacheEvictionService>;
+    CacheEvictionService();
+    ~CacheEvictionService();
+
+private:
+    /// Espera les peticions de comprovació i allibera espai quan cal
+    void run();
+
+    /// Si l'espai lliure és per sota de la marca baixa esborra estudis fins arribar a la marca alta
+    void freeSpaceIfNeeded();
+
+private:
+    /// Temps màxim entre dues comprovacions de l'espai lliure
+    static const unsigned long CheckIntervalInMilliseconds;
+
+    /// Protegeix les peticions de comprovació i d'aturar el servei
+    QMutex m_mutex;
+    QWaitCondition m_checkRequested;
+    bool m_isCheckRequested;
+    bool m_isStopRequested;
+};
+
+}
+
+#endif
@@ -85,6 +85,27 @@ QString DatabaseConnection::formatTextToValidSQLSyntax(QChar qchar)
     return qchar.isNull() ? "" : QString(qchar);
 }
 
+sqlite3_stmt* DatabaseConnection::getPreparedStatement(const QString &sql)
+{
+    sqlite3_stmt *statement = m_preparedStatements.value(sql);
+
+    if (statement)
+    {
+        sqlite3_reset(statement);
+        sqlite3_clear_bindings(statement);
+        return statement;
+    }
+
+    if (sqlite3_prepare_v2(getConnection(), sql.toUtf8().constData(), -1, &statement, 0) != SQLITE_OK)
+    {
+        sqlite3_finalize(statement);
+        return NULL;
+    }
+
+    m_preparedStatements.insert(sql, statement);
+    return statement;
+}
+
 sqlite3* DatabaseConnection::getConnection()
 {
     if (!isConnected())
@@ -104,11 +125,23 @@ void DatabaseConnection::close()
 {
     if (isConnected())
     {
+        // Les sentències s'han d'alliberar abans de tancar la connexió, sinó no es pot tancar
+        finalizePreparedStatements();
         sqlite3_close(m_databaseConnection);
         m_databaseConnection = NULL;
     }
 }
 
+void DatabaseConnection::finalizePreparedStatements()
+{
+    foreach (sqlite3_stmt *statement, m_preparedStatements)
+    {
+        sqlite3_finalize(statement);
+    }
+
+    m_preparedStatements.clear();
+}
+
 QString DatabaseConnection::getLastErrorMessage()
 {
     return sqlite3_errmsg(m_databaseConnection);
@@ -15,10 +15,12 @@
 #ifndef UDGDATABASECONNECTION_H
 #define UDGDATABASECONNECTION_H
 
+#include <QHash>
 #include <QString>
 
 class QSemaphore;
 struct sqlite3;
+struct sqlite3_stmt;
 
 namespace udg {
 
@@ -45,6 +47,11 @@ public:
     // @return connexio a la base de dades, si el punter és nul, és que hi hagut error alhora de connectar, o que el path no és correcte
     sqlite3* getConnection();
 
+    /// Retorna la sentència preparada per l'SQL donat. La primera vegada es prepara i després es reaprofita fins que es tanca la connexió, de manera que les
+    /// sentències que s'executen moltes vegades (per exemple inserir les imatges d'un estudi) només es compilen un cop. La sentència es retorna reiniciada i
+    /// sense paràmetres assignats. Si hi ha error en preparar-la retorna null i l'error es pot consultar amb getLastErrorCode().
+    sqlite3_stmt* getPreparedStatement(const QString &sql);
+
     /// Retorna l'últim missatge d'error produït a la base de dades
     QString getLastErrorMessage();
 
@@ -73,6 +80,9 @@ private:
     /// Tanca la connexió de la base de dades
     void close();
 
+    /// Allibera totes les sentències preparades
+    void finalizePreparedStatements();
+
     /// Indica s'esta connectat a la base de dades
     /// @return indica si s'esta connectat a la base de dades
     bool isConnected();
@@ -84,6 +94,9 @@ private:
     QSemaphore *m_transactionLock;
 
     QString m_databasePath;
+
+    /// Sentències preparades de la connexió, indexades per l'SQL
+    QHash<QString, sqlite3_stmt*> m_preparedStatements;
 };
 }; // End namespace
 
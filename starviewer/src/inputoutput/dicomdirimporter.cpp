@@ -40,6 +40,8 @@ void DICOMDIRImporter::import(QString dicomdirPath, QString studyUID, QString se
     PatientFiller patientFiller;
     QThread fillersThread;
 
+    m_dicomFileReadMode = patientFiller.getDICOMFileReadMode();
+
     // Comprovem si hi ha suficient espai lliure per importar l'estudi
     if (!localDatabaseManager.thereIsAvailableSpaceOnHardDisk())
     {
@@ -249,7 +251,7 @@ bool DICOMDIRImporter::copyDicomdirImageToLocal(QString dicomdirImagePath, QStri
                 WARN_LOG("No hem pogut canviar els permisos de lectura/escriptura pel fitxer importat [" + localImagePath + "]");
         }
         // TODO perquè cal fer aquest DICOMTagReader? Encara es fa servir la cache de dicom tag reader????
-        DICOMTagReader *dicomTagReader = new DICOMTagReader(localImagePath);
+        DICOMTagReader *dicomTagReader = new DICOMTagReader(localImagePath, m_dicomFileReadMode);
         emit imageImportedToDisk(dicomTagReader);
 
         m_qprogressDialog->setValue(m_qprogressDialog->value() + 1);
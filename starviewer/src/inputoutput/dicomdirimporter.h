@@ -18,6 +18,7 @@
 #include <QObject>
 
 #include "dicomdirreader.h"
+#include "dicomtagreader.h"
 #include <QProgressDialog>
 
 class QString;
@@ -26,7 +27,6 @@ class QThread;
 namespace udg {
 
 class Image;
-class DICOMTagReader;
 class PatientFiller;
 class LocalDatabaseManager;
 
@@ -59,6 +59,8 @@ private:
     DICOMDIRReader m_readDicomdir;
     DICOMDIRImporterError m_lastError;
     QProgressDialog *m_qprogressDialog;
+    /// Mode en què s'han de llegir les imatges importades perquè les processi el PatientFiller
+    DICOMTagReader::ReadMode m_dicomFileReadMode;
 
     /// Crea les connexions necessàries per importar dicomdir
     void createConnections(PatientFiller *patientFiller, LocalDatabaseManager *localDatabaseManager, QThread *fillersThread);
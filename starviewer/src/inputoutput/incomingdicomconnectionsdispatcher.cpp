@@ -0,0 +1,339 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "incomingdicomconnectionsdispatcher.h"
+
+// Make sure OS specific configuration is included first
+#include <osconfig.h>
+#include <diutil.h>
+#include <dcuid.h>
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include "retrievedicomfilesfrompacs.h"
+#include "inputoutputsettings.h"
+#include "portinuse.h"
+#include "logging.h"
+
+namespace udg {
+
+/**
+    Processa una subassociació en nom de la descàrrega a qui va dirigida.
+  */
+class IncomingDICOMConnectionsDispatcher::SubAssociationServer : public QRunnable {
+public:
+    SubAssociationServer(RetrieveDICOMFilesFromPACS *retrieve, T_ASC_Association *subAssociation, const FirstCommand &firstCommand)
+     : m_retrieve(retrieve), m_subAssociation(subAssociation), m_firstCommand(firstCommand)
+    {
+    }
+
+    void run()
+    {
+        IncomingDICOMConnectionsDispatcher::instance()->serveSubAssociation(m_retrieve, m_subAssociation, m_firstCommand);
+    }
+
+private:
+    RetrieveDICOMFilesFromPACS *m_retrieve;
+    T_ASC_Association *m_subAssociation;
+    FirstCommand m_firstCommand;
+};
+
+IncomingDICOMConnectionsDispatcher::IncomingDICOMConnectionsDispatcher()
+ : m_network(NULL), m_nextMoveMessageID(0)
+{
+    // Com a màxim hi haurà una subassociació per cada descàrrega que es fa simultàniament
+    m_threadPool = new QThreadPool();
+    m_threadPool->setMaxThreadCount(qMax(Settings().getValue(InputOutputSettings::MaximumConcurrentRetrieves).toInt(), 1));
+}
+
+IncomingDICOMConnectionsDispatcher::~IncomingDICOMConnectionsDispatcher()
+{
+}
+
+DIC_US IncomingDICOMConnectionsDispatcher::getNextMoveMessageID()
+{
+    // Els identificadors de missatge són de 16 bits i el 0 no es fa servir
+    return static_cast<DIC_US>(m_nextMoveMessageID.fetchAndAddOrdered(1) % 65535 + 1);
+}
+
+bool IncomingDICOMConnectionsDispatcher::registerRetrieve(RetrieveDICOMFilesFromPACS *retrieve, const QString &pacsAETitle, DIC_US moveMessageID)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_network == NULL)
+    {
+        Settings settings;
+        int localPort = settings.getValue(InputOutputSettings::IncomingDICOMConnectionsPort).toInt();
+
+        if (PortInUse().isPortInUse(localPort))
+        {
+            ERROR_LOG("El port " + QString::number(localPort) + " per a connexions entrants del PACS, esta en us, no es pot descarregar l'estudi");
+            return false;
+        }
+
+        int timeout = settings.getValue(InputOutputSettings::PACSConnectionTimeout).toInt();
+        OFCondition condition = ASC_initializeNetwork(NET_ACCEPTOR, localPort, timeout, &m_network);
+        if (!condition.good())
+        {
+            ERROR_LOG("No s'ha pogut obrir el port " + QString::number(localPort) + " per a connexions entrants del PACS, descripcio error: " +
+                      QString(condition.text()));
+            m_network = NULL;
+            return false;
+        }
+    }
+
+    RegisteredRetrieve registeredRetrieve;
+    registeredRetrieve.retrieve = retrieve;
+    registeredRetrieve.pacsAETitle = pacsAETitle.trimmed();
+    registeredRetrieve.moveMessageID = moveMessageID;
+    registeredRetrieve.servedSubAssociations = 0;
+    m_registeredRetrieves.append(registeredRetrieve);
+
+    return true;
+}
+
+void IncomingDICOMConnectionsDispatcher::unregisterRetrieve(RetrieveDICOMFilesFromPACS *retrieve)
+{
+    QMutexLocker locker(&m_mutex);
+
+    int index = indexOfRegisteredRetrieve(retrieve);
+    // Les subassociacions que es processen en altres threads fan servir l'objecte retrieve, per això s'ha d'esperar que acabin
+    while (index >= 0 && m_registeredRetrieves.at(index).servedSubAssociations > 0)
+    {
+        m_subAssociationServed.wait(&m_mutex);
+        index = indexOfRegisteredRetrieve(retrieve);
+    }
+
+    if (index < 0)
+    {
+        return;
+    }
+
+    m_registeredRetrieves.removeAt(index);
+
+    if (m_registeredRetrieves.isEmpty())
+    {
+        OFCondition condition = ASC_dropNetwork(&m_network);
+        if (!condition.good())
+        {
+            ERROR_LOG("Error al tancar el port de connexions entrants, descripcio error: " + QString(condition.text()));
+        }
+        m_network = NULL;
+    }
+}
+
+T_ASC_Network* IncomingDICOMConnectionsDispatcher::getNetwork()
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_network;
+}
+
+T_ASC_Association* IncomingDICOMConnectionsDispatcher::acceptSubAssociation(RetrieveDICOMFilesFromPACS *retrieve, FirstCommand *firstCommand)
+{
+    firstCommand->isValid = false;
+
+    T_ASC_Association *subAssociation = NULL;
+    {
+        // Totes les descàrregues veuen la subassociació que espera, però només una la pot rebre. La xarxa no es tanca mentrestant perquè retrieve
+        // està registrada.
+        QMutexLocker acceptLocker(&m_acceptMutex);
+
+        T_ASC_Network *network = getNetwork();
+        if (network == NULL || !ASC_associationWaiting(network, 0))
+        {
+            return NULL;
+        }
+
+        OFCondition condition = receiveSubAssociation(network, &subAssociation);
+        if (!condition.good())
+        {
+            ERROR_LOG("S'ha produit un error negociant l'associacio de la connexio DICOM entrant, descripcio error: " + QString(condition.text()));
+            return NULL;
+        }
+    }
+
+    DIC_AE callingAETitle;
+    ASC_getAPTitles(subAssociation->params, callingAETitle, NULL, NULL);
+    QString pacsAETitle = QString(callingAETitle).trimmed();
+
+    bool needsFirstCommand;
+    {
+        QMutexLocker locker(&m_mutex);
+        needsFirstCommand = getSubAssociationOwnerCandidates(pacsAETitle).size() > 1;
+    }
+
+    if (needsFirstCommand)
+    {
+        // Hi ha diverses descàrregues que poden ser del PACS, el C-STORE ens diu quin C-MOVE l'ha originat. Es llegeix sense el lock perquè pot trigar
+        // fins al timeout i bloquejaria la resta de descàrregues.
+        int timeout = Settings().getValue(InputOutputSettings::PACSConnectionTimeout).toInt();
+        firstCommand->condition = DIMSE_receiveCommand(subAssociation, DIMSE_NONBLOCKING, timeout, &firstCommand->presentationContextID,
+                                                       &firstCommand->message, NULL);
+        firstCommand->isValid = true;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    RetrieveDICOMFilesFromPACS *owner = getSubAssociationOwner(pacsAETitle, *firstCommand);
+    if (owner == retrieve)
+    {
+        return subAssociation;
+    }
+
+    INFO_LOG("La connexio DICOM entrant es d'una altra descarrega, es processara en un thread a part");
+    m_registeredRetrieves[indexOfRegisteredRetrieve(owner)].servedSubAssociations++;
+    m_threadPool->start(new SubAssociationServer(owner, subAssociation, *firstCommand));
+    firstCommand->isValid = false;
+
+    return NULL;
+}
+
+OFCondition IncomingDICOMConnectionsDispatcher::receiveSubAssociation(T_ASC_Network *network, T_ASC_Association **subAssociation)
+{
+    const char *knownAbstractSyntaxes[] = { UID_VerificationSOPClass };
+    const char *transferSyntaxes[] = { NULL, NULL, NULL, NULL };
+    int numTransferSyntaxes;
+
+    OFCondition condition = ASC_receiveAssociation(network, subAssociation, ASC_DEFAULTMAXPDU);
+
+    if (condition.good())
+    {
+#ifndef DISABLE_COMPRESSION_EXTENSION
+        // Si disposem de compressió la demanem, i podrem accelerar el temps de descàrrega considerablement
+        // De moment demanem la compressió lossless que tot PACS que suporti compressió ha
+        // de proporcionar: JPEGLossless:Non-Hierarchical-1stOrderPrediction
+        transferSyntaxes[0] = UID_JPEGProcess14SV1TransferSyntax;
+        transferSyntaxes[1] = UID_LittleEndianExplicitTransferSyntax;
+        transferSyntaxes[2] = UID_BigEndianExplicitTransferSyntax;
+        transferSyntaxes[3] = UID_LittleEndianImplicitTransferSyntax;
+        numTransferSyntaxes = 4;
+#else
+        // Defined in dcxfer.h
+        if (gLocalByteOrder == EBO_LittleEndian)
+        {
+        transferSyntaxes[0] = UID_LittleEndianExplicitTransferSyntax;
+        transferSyntaxes[1] = UID_BigEndianExplicitTransferSyntax;
+        }
+        else
+        {
+        transferSyntaxes[0] = UID_BigEndianExplicitTransferSyntax;
+        transferSyntaxes[1] = UID_LittleEndianExplicitTransferSyntax;
+        }
+        transferSyntaxes[2] = UID_LittleEndianImplicitTransferSyntax;
+        numTransferSyntaxes = 3;
+#endif
+
+        // Accept the Verification SOP Class if presented
+        condition = ASC_acceptContextsWithPreferredTransferSyntaxes((*subAssociation)->params, knownAbstractSyntaxes, DIM_OF(knownAbstractSyntaxes),
+                                                                    transferSyntaxes, numTransferSyntaxes);
+
+        if (condition.good())
+        {
+            // The array of Storage SOP Class UIDs comes from dcuid.h
+            condition = ASC_acceptContextsWithPreferredTransferSyntaxes((*subAssociation)->params, dcmAllStorageSOPClassUIDs,
+                                                                        numberOfAllDcmStorageSOPClassUIDs, transferSyntaxes, numTransferSyntaxes);
+        }
+    }
+
+    if (condition.good())
+    {
+        condition = ASC_acknowledgeAssociation(*subAssociation);
+    }
+    else
+    {
+        ASC_dropAssociation(*subAssociation);
+        ASC_destroyAssociation(subAssociation);
+    }
+    return condition;
+}
+
+QList<int> IncomingDICOMConnectionsDispatcher::getSubAssociationOwnerCandidates(const QString &pacsAETitle) const
+{
+    QList<int> candidates;
+    for (int i = 0; i < m_registeredRetrieves.size(); i++)
+    {
+        if (m_registeredRetrieves.at(i).pacsAETitle == pacsAETitle)
+        {
+            candidates << i;
+        }
+    }
+
+    if (candidates.isEmpty())
+    {
+        for (int i = 0; i < m_registeredRetrieves.size(); i++)
+        {
+            candidates << i;
+        }
+    }
+
+    return candidates;
+}
+
+RetrieveDICOMFilesFromPACS* IncomingDICOMConnectionsDispatcher::getSubAssociationOwner(const QString &pacsAETitle, const FirstCommand &firstCommand) const
+{
+    QList<int> candidates = getSubAssociationOwnerCandidates(pacsAETitle);
+
+    if (candidates.size() == 1)
+    {
+        return m_registeredRetrieves.at(candidates.first()).retrieve;
+    }
+
+    if (firstCommand.isValid && firstCommand.condition.good() && firstCommand.message.CommandField == DIMSE_C_STORE_RQ &&
+        (firstCommand.message.msg.CStoreRQ.opts & O_STORE_MOVEORIGINATORID))
+    {
+        foreach (int candidate, candidates)
+        {
+            if (m_registeredRetrieves.at(candidate).moveMessageID == firstCommand.message.msg.CStoreRQ.MoveOriginatorID)
+            {
+                return m_registeredRetrieves.at(candidate).retrieve;
+            }
+        }
+    }
+
+    WARN_LOG("No s'ha pogut saber de quina descarrega es la connexio DICOM entrant del PACS " + pacsAETitle + ", l'assignem a la primera que s'ha iniciat");
+    return m_registeredRetrieves.at(candidates.first()).retrieve;
+}
+
+int IncomingDICOMConnectionsDispatcher::indexOfRegisteredRetrieve(RetrieveDICOMFilesFromPACS *retrieve) const
+{
+    for (int i = 0; i < m_registeredRetrieves.size(); i++)
+    {
+        if (m_registeredRetrieves.at(i).retrieve == retrieve)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void IncomingDICOMConnectionsDispatcher::serveSubAssociation(RetrieveDICOMFilesFromPACS *retrieve, T_ASC_Association *subAssociation,
+                                                             const FirstCommand &firstCommand)
+{
+    retrieve->serveSubAssociation(subAssociation, firstCommand);
+
+    QMutexLocker locker(&m_mutex);
+
+    int index = indexOfRegisteredRetrieve(retrieve);
+    if (index >= 0)
+    {
+        m_registeredRetrieves[index].servedSubAssociations--;
+    }
+    m_subAssociationServed.wakeAll();
+}
+
+}
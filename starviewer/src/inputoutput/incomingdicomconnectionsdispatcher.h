@@ -0,0 +1,130 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGINCOMINGDICOMCONNECTIONSDISPATCHER_H
+#define UDGINCOMINGDICOMCONNECTIONSDISPATCHER_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+
+#include <ofcond.h>
+#include <dimse.h>
+
+#include "singleton.h"
+
+class QThreadPool;
+
+namespace udg {
+
+class RetrieveDICOMFilesFromPACS;
+
+/**
+    Comparteix el port de connexions entrants entre les descàrregues que es fan simultàniament.
+
+    En una descàrrega el PACS obre una subassociació cap al port de connexions entrants per enviar-nos els fitxers amb C-STORE. Com el port és únic,
+    totes les descàrregues en curs esperen les subassociacions a la mateixa xarxa, i la primera que en detecta una l'accepta a través d'aquesta classe,
+    que decideix de quina descàrrega és:
+    - Si només hi ha una descàrrega del PACS amb l'AE Title que obre la subassociació, és seva. Si no n'hi ha cap es consideren totes les descàrregues,
+      perquè hi ha PACS que envien els fitxers amb un altre AE Title.
+    - Si n'hi ha més d'una, es llegeix la primera ordre de la subassociació, sense bloquejar la resta de descàrregues, i es tria la descàrrega que ha
+      enviat el C-MOVE indicat pel Move Originator Message ID del C-STORE. Per això els identificadors de missatge dels C-MOVE els dóna aquesta classe i són únics.
+    Si la subassociació és de la descàrrega que l'ha acceptada la processa ella mateixa, sinó es processa en un thread a part en nom de la descàrrega
+    a qui va dirigida.
+
+    El port s'obre quan es registra la primera descàrrega i es tanca quan es desregistra l'última.
+  */
+class IncomingDICOMConnectionsDispatcher : public Singleton<IncomingDICOMConnectionsDispatcher> {
+public:
+    /// Primera ordre d'una subassociació, quan s'ha hagut de llegir per saber de quina descàrrega és
+    struct FirstCommand
+    {
+        bool isValid;
+        OFCondition condition;
+        T_DIMSE_Message message;
+        T_ASC_PresentationContextID presentationContextID;
+    };
+
+    /// Retorna un identificador de missatge per a un C-MOVE diferent dels de les altres descàrregues en curs
+    DIC_US getNextMoveMessageID();
+
+    /// Registra una descàrrega que enviarà un C-MOVE amb l'identificador moveMessageID al PACS amb AE Title pacsAETitle. Si és la primera descàrrega
+    /// registrada obre el port de connexions entrants. Retorna fals si el port està en ús o no s'ha pogut obrir.
+    bool registerRetrieve(RetrieveDICOMFilesFromPACS *retrieve, const QString &pacsAETitle, DIC_US moveMessageID);
+
+    /// Desregistra la descàrrega, esperant que acabin les subassociacions que s'estan processant en nom seu. Si era l'última tanca el port.
+    void unregisterRetrieve(RetrieveDICOMFilesFromPACS *retrieve);
+
+    /// Retorna la xarxa que escolta el port de connexions entrants, o NULL si no hi ha cap descàrrega registrada
+    T_ASC_Network* getNetwork();
+
+    /// Accepta la subassociació que espera al port, si encara no ho ha fet una altra descàrrega. Si és de retrieve la retorna, i si se n'ha llegit
+    /// la primera ordre la deixa a firstCommand. Si és d'una altra descàrrega la processa en un thread a part i retorna NULL.
+    T_ASC_Association* acceptSubAssociation(RetrieveDICOMFilesFromPACS *retrieve, FirstCommand *firstCommand);
+
+protected:
+    friend class Singleton<IncomingDICOMConnectionsDispatcher>;
+    IncomingDICOMConnectionsDispatcher();
+    ~IncomingDICOMConnectionsDispatcher();
+
+private:
+    class SubAssociationServer;
+
+    struct RegisteredRetrieve
+    {
+        RetrieveDICOMFilesFromPACS *retrieve;
+        QString pacsAETitle;
+        DIC_US moveMessageID;
+        /// Subassociacions que s'estan processant en nom de la descàrrega en altres threads
+        int servedSubAssociations;
+    };
+
+    /// Rep la subassociació que espera a la xarxa i n'accepta els presentation contexts de verificació i d'emmagatzematge
+    OFCondition receiveSubAssociation(T_ASC_Network *network, T_ASC_Association **subAssociation);
+
+    /// Retorna els índexs a m_registeredRetrieves de les descàrregues a qui pot anar dirigida una subassociació del PACS amb AE Title pacsAETitle.
+    /// Cal tenir m_mutex.
+    QList<int> getSubAssociationOwnerCandidates(const QString &pacsAETitle) const;
+
+    /// Retorna la descàrrega registrada a qui va dirigida una subassociació del PACS amb AE Title pacsAETitle, fent servir la primera ordre de la
+    /// subassociació si n'hi ha diverses candidates i s'ha llegit. Cal tenir m_mutex.
+    RetrieveDICOMFilesFromPACS* getSubAssociationOwner(const QString &pacsAETitle, const FirstCommand &firstCommand) const;
+
+    /// Retorna l'índex de la descàrrega a m_registeredRetrieves, o -1 si no hi és
+    int indexOfRegisteredRetrieve(RetrieveDICOMFilesFromPACS *retrieve) const;
+
+    /// Processa la subassociació en nom de retrieve. S'executa en un thread de m_threadPool.
+    void serveSubAssociation(RetrieveDICOMFilesFromPACS *retrieve, T_ASC_Association *subAssociation, const FirstCommand &firstCommand);
+
+private:
+    /// Protegeix la xarxa i les descàrregues registrades
+    QMutex m_mutex;
+    /// Fa que només una descàrrega alhora rebi la subassociació que espera. Es pot agafar m_mutex amb aquest agafat, però no a l'inrevés.
+    QMutex m_acceptMutex;
+    QWaitCondition m_subAssociationServed;
+
+    T_ASC_Network *m_network;
+    QList<RegisteredRetrieve> m_registeredRetrieves;
+    QAtomicInt m_nextMoveMessageID;
+
+    /// Threads on es processen les subassociacions de les descàrregues que no les han acceptat. Com a PacsManager, no es destrueix perquè no s'esperi
+    /// a tancar Starviewer que acabi una subassociació que el PACS ha deixat de respondre.
+    QThreadPool *m_threadPool;
+};
+
+}
+
+#endif
@@ -28,6 +28,9 @@ HEADERS += databaseconnection.h \
     pacsconnection.h \
     dimsecservice.h \
     retrievedicomfilesfrompacs.h \
+    incomingdicomconnectionsdispatcher.h \
+    retrieveddicomfileswriter.h \
+    pipelinestagemetrics.h \
     status.h \
     converttodicomdir.h \
     convertdicomtolittleendian.h \
@@ -55,6 +58,7 @@ HEADERS += databaseconnection.h \
     localdatabasepatientdal.h \
     localdatabaseutildal.h \
     qdeleteoldstudiesthread.h \
+    cacheevictionservice.h \
     databaseinstallation.h \
     qlocaldatabaseconfigurationscreen.h \
     parsexmlrispierrequest.h \
@@ -104,6 +108,9 @@ SOURCES += databaseconnection.cpp \
     pacsconnection.cpp \
     dimsecservice.cpp \
     retrievedicomfilesfrompacs.cpp \
+    incomingdicomconnectionsdispatcher.cpp \
+    retrieveddicomfileswriter.cpp \
+    pipelinestagemetrics.cpp \
     status.cpp \
     converttodicomdir.cpp \
     convertdicomtolittleendian.cpp \
@@ -131,6 +138,7 @@ SOURCES += databaseconnection.cpp \
     localdatabasepatientdal.cpp \
     localdatabaseutildal.cpp \
     qdeleteoldstudiesthread.cpp \
+    cacheevictionservice.cpp \
     databaseinstallation.cpp \
     qlocaldatabaseconfigurationscreen.cpp \
     parsexmlrispierrequest.cpp \
@@ -193,4 +201,5 @@ include(../compilationtype.pri)
 include(../threadweaver.pri)
 QT += xml \
     network \
-    widgets
+    widgets \
+    concurrent
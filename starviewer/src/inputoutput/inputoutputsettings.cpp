@@ -69,6 +69,9 @@ const QString InputOutputSettings::IncomingDICOMConnectionsPort(PACSParametersBa
 const QString InputOutputSettings::LocalAETitle(PACSParametersBase + "AETitle");
 const QString InputOutputSettings::PACSConnectionTimeout(PACSParametersBase + "timeout");
 const QString InputOutputSettings::MaximumPACSConnections(PACSParametersBase + "MaxConnects");
+const QString InputOutputSettings::MaximumConcurrentRetrieves(PACSParametersBase + "maximumConcurrentRetrieves");
+const QString InputOutputSettings::MaximumConcurrentRetrievesPerPACS(PACSParametersBase + "maximumConcurrentRetrievesPerPACS");
+const QString InputOutputSettings::MaximumQueuedRetrievedFiles(PACSParametersBase + "maximumQueuedRetrievedFiles");
 
 //TODO: Clau duplicada a CoreSettings
 const QString InputOutputSettings::PacsListConfigurationSectionName = "PacsList";
@@ -128,6 +131,9 @@ void InputOutputSettings::init()
     settingsRegistry->addSetting(LocalAETitle, QHostInfo::localHostName(), Settings::Parseable);
     settingsRegistry->addSetting(PACSConnectionTimeout, 20);
     settingsRegistry->addSetting(MaximumPACSConnections, 3);
+    settingsRegistry->addSetting(MaximumConcurrentRetrieves, 1);
+    settingsRegistry->addSetting(MaximumConcurrentRetrievesPerPACS, 1);
+    settingsRegistry->addSetting(MaximumQueuedRetrievedFiles, 32);
 
     settingsRegistry->addSetting(ConvertDICOMDIRImagesToLittleEndianKey, false);
 #if defined(Q_OS_WIN)
@@ -70,6 +70,12 @@ public:
     static const QString IncomingDICOMConnectionsPort;
     static const QString PACSConnectionTimeout;
     static const QString MaximumPACSConnections;
+    /// Nombre màxim de descàrregues que es poden fer simultàniament en total i des d'un mateix PACS
+    static const QString MaximumConcurrentRetrieves;
+    static const QString MaximumConcurrentRetrievesPerPACS;
+    /// Nombre màxim de fitxers rebuts d'una descàrrega que poden estar esperant a cada etapa (guardar-se a disc, processar-se) abans que deixem de
+    /// respondre el PACS
+    static const QString MaximumQueuedRetrievedFiles;
 
     /// Llista de PACS
     //TODO: Clau duplicada a CoreSettings
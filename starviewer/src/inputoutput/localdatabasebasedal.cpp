@@ -55,4 +55,39 @@ void LocalDatabaseBaseDAL::logError(const QString &sqlSentence)
     }
 }
 
+sqlite3_stmt* LocalDatabaseBaseDAL::prepareStatement(const QString &sqlSentence)
+{
+    sqlite3_stmt *statement = m_dbConnection->getPreparedStatement(sqlSentence);
+
+    if (!statement)
+    {
+        m_lastSqliteError = m_dbConnection->getLastErrorCode();
+        logError(sqlSentence);
+    }
+
+    return statement;
+}
+
+void LocalDatabaseBaseDAL::bindText(sqlite3_stmt *statement, int index, const QString &text)
+{
+    QByteArray utf8Text = text.toUtf8();
+    sqlite3_bind_text(statement, index, utf8Text.constData(), utf8Text.size(), SQLITE_TRANSIENT);
+}
+
+void LocalDatabaseBaseDAL::executeStatement(sqlite3_stmt *statement, const QString &sqlSentence)
+{
+    m_lastSqliteError = sqlite3_step(statement);
+
+    if (m_lastSqliteError == SQLITE_DONE || m_lastSqliteError == SQLITE_ROW)
+    {
+        m_lastSqliteError = SQLITE_OK;
+    }
+    else
+    {
+        logError(sqlSentence);
+    }
+
+    sqlite3_reset(statement);
+}
+
 }
@@ -18,6 +18,7 @@
 #define UDGLOCALDATABASEBASEDAL_H
 
 class QString;
+struct sqlite3_stmt;
 
 namespace udg {
 
@@ -40,6 +41,15 @@ protected:
     /// Ens fa un ErrorLog d'una sentència sql. No es té en compte l'error és SQL_CONSTRAINT (clau duplicada)
     void logError(const QString &sqlSentence);
 
+    /// Retorna la sentència preparada de la connexió per l'SQL donat, reiniciada i sense paràmetres. Si hi ha error el registra i retorna null.
+    sqlite3_stmt* prepareStatement(const QString &sqlSentence);
+
+    /// Assigna el text donat al paràmetre \a index de la sentència. Els textos nuls s'assignen com a text buit, igual que es feia en construir l'SQL.
+    static void bindText(sqlite3_stmt *statement, int index, const QString &text);
+
+    /// Executa la sentència preparada donada i en guarda el resultat com a últim error (SQLITE_OK si tot va bé). Si hi ha error el registra amb l'SQL donat.
+    void executeStatement(sqlite3_stmt *statement, const QString &sqlSentence);
+
 protected:
     int m_lastSqliteError;
     DatabaseConnection *m_dbConnection;
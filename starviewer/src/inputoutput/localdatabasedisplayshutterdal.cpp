@@ -23,6 +23,9 @@
 
 namespace udg {
 
+const QString LocalDatabaseDisplayShutterDAL::SqlInsert("INSERT INTO DisplayShutter (Shape, ShutterValue, PointsList, ImageInstanceUID, ImageFrameNumber) "
+                                                        "VALUES (?1, ?2, ?3, ?4, ?5)");
+
 LocalDatabaseDisplayShutterDAL::LocalDatabaseDisplayShutterDAL(DatabaseConnection *dbConnection)
  : LocalDatabaseBaseDAL(dbConnection)
 {
@@ -30,11 +33,16 @@ LocalDatabaseDisplayShutterDAL::LocalDatabaseDisplayShutterDAL(DatabaseConnectio
 
 void LocalDatabaseDisplayShutterDAL::insert(const DisplayShutter &shutter, Image *shuttersImage)
 {
-    m_lastSqliteError = sqlite3_exec(m_dbConnection->getConnection(), buildSQLInsert(shutter, shuttersImage).toUtf8().constData(), 0, 0, 0);
+    sqlite3_stmt *statement = prepareStatement(SqlInsert);
 
-    if (getLastError() != SQLITE_OK)
+    if (statement)
     {
-        logError(buildSQLInsert(shutter, shuttersImage));
+        bindText(statement, 1, shutter.getShapeAsDICOMString());
+        sqlite3_bind_int(statement, 2, shutter.getShutterValue());
+        bindText(statement, 3, shutter.getPointsAsString());
+        bindText(statement, 4, shuttersImage->getSOPInstanceUID());
+        sqlite3_bind_int(statement, 5, shuttersImage->getFrameNumber());
+        executeStatement(statement, SqlInsert);
     }
 }
 
@@ -126,20 +134,6 @@ QString LocalDatabaseDisplayShutterDAL::buildSQLSelect(const DicomMask &mask)
     return selectSentence + buildWhereSentence(mask);
 }
 
-QString LocalDatabaseDisplayShutterDAL::buildSQLInsert(const DisplayShutter &shutter, Image *shuttersImage)
-{
-    QString insertSentence = "INSERT INTO DisplayShutter ";
-    insertSentence += "(Shape, ShutterValue, PointsList, ImageInstanceUID, ImageFrameNumber) ";
-    insertSentence += QString("VALUES ('%1', %2, '%3', '%4', %5)")
-        .arg(DatabaseConnection::formatTextToValidSQLSyntax(shutter.getShapeAsDICOMString()))
-        .arg(shutter.getShutterValue())
-        .arg(DatabaseConnection::formatTextToValidSQLSyntax(shutter.getPointsAsString()))
-        .arg(DatabaseConnection::formatTextToValidSQLSyntax(shuttersImage->getSOPInstanceUID()))
-        .arg(shuttersImage->getFrameNumber());
-
-    return insertSentence;
-}
-
 QString LocalDatabaseDisplayShutterDAL::buildSQLDelete(const DicomMask &mask)
 {
     return "DELETE FROM DisplayShutter " + buildWhereSentence(mask);
@@ -45,8 +45,8 @@ public:
     QList<DisplayShutter> query(const DicomMask &mask);
 
 private:
-    /// Construeix la sentència SQL per inserir un DisplayShutter
-    QString buildSQLInsert(const DisplayShutter &shutter, Image *shuttersImage);
+    /// Sentència preparada per inserir un DisplayShutter
+    static const QString SqlInsert;
 
     /// Construeix la sentència SQL per seleccionar els DisplayShutters que coincideixin amb els criteris de la màscara
     QString buildSQLSelect(const DicomMask &mask);
@@ -35,6 +35,59 @@
 
 namespace udg {
 
+// Els paràmetres estan numerats perquè l'insert i l'update facin servir la mateixa assignació de valors (bindImage())
+const QString LocalDatabaseImageDAL::SqlInsert("Insert into Image (SOPInstanceUID, FrameNumber, StudyInstanceUID, SeriesInstanceUID, InstanceNumber,"
+                                                                 "ImageOrientationPatient, PatientOrientation, PixelSpacing, SliceThickness,"
+                                                                 "PatientPosition, SamplesPerPixel, Rows, Columns, BitsAllocated, BitsStored,"
+                                                                 "PixelRepresentation, RescaleSlope, WindowLevelWidth, WindowLevelCenter,"
+                                                                 "WindowLevelExplanations, SliceLocation,"
+                                                                 "RescaleIntercept, PhotometricInterpretation, ImageType, ViewPosition,"
+                                                                 "ImageLaterality, ViewCodeMeaning, PhaseNumber, ImageTime, VolumeNumberInSeries,"
+                                                                 "OrderNumberInVolume, RetrievedDate, RetrievedTime, State, NumberOfOverlays, RetrievedPACSID,"
+                                                                 "ImagerPixelSpacing, EstimatedRadiographicMagnificationFactor, TransferSyntaxUID) "
+                                               "values (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12, ?13, ?14, ?15, ?16, ?17, ?18, ?19, ?20, "
+                                                       "?21, ?22, ?23, ?24, ?25, ?26, ?27, ?28, ?29, ?30, ?31, ?32, ?33, ?34, ?35, ?36, ?37, ?38, ?39)");
+
+const QString LocalDatabaseImageDAL::SqlUpdate("Update Image set StudyInstanceUID = ?3, "
+                                                                "SeriesInstanceUID = ?4, "
+                                                                "InstanceNumber = ?5, "
+                                                                "ImageOrientationPatient = ?6, "
+                                                                "PatientOrientation = ?7, "
+                                                                "PixelSpacing = ?8, "
+                                                                "SliceThickness = ?9, "
+                                                                "PatientPosition = ?10, "
+                                                                "SamplesPerPixel = ?11, "
+                                                                "Rows = ?12, "
+                                                                "Columns = ?13, "
+                                                                "BitsAllocated = ?14, "
+                                                                "BitsStored = ?15, "
+                                                                "PixelRepresentation = ?16, "
+                                                                "RescaleSlope = ?17, "
+                                                                "WindowLevelWidth = ?18, "
+                                                                "WindowLevelCenter = ?19, "
+                                                                "WindowLevelExplanations = ?20, "
+                                                                "SliceLocation = ?21, "
+                                                                "RescaleIntercept = ?22, "
+                                                                "PhotometricInterpretation = ?23, "
+                                                                "ImageType = ?24, "
+                                                                "ViewPosition = ?25, "
+                                                                "ImageLaterality = ?26, "
+                                                                "ViewCodeMeaning = ?27, "
+                                                                "PhaseNumber = ?28, "
+                                                                "ImageTime = ?29, "
+                                                                "VolumeNumberInSeries = ?30, "
+                                                                "OrderNumberInVolume = ?31, "
+                                                                "RetrievedDate = ?32, "
+                                                                "RetrievedTime = ?33, "
+                                                                "State = ?34, "
+                                                                "NumberOfOverlays = ?35, "
+                                                                "RetrievedPACSID = ?36, "
+                                                                "ImagerPixelSpacing = ?37, "
+                                                                "EstimatedRadiographicMagnificationFactor = ?38, "
+                                                                "TransferSyntaxUID = ?39 "
+                                               "Where SOPInstanceUID = ?1 And "
+                                                     "FrameNumber = ?2");
+
 LocalDatabaseImageDAL::LocalDatabaseImageDAL(DatabaseConnection *dbConnection)
  : LocalDatabaseBaseDAL(dbConnection)
 {
@@ -42,11 +95,12 @@ LocalDatabaseImageDAL::LocalDatabaseImageDAL(DatabaseConnection *dbConnection)
 
 void LocalDatabaseImageDAL::insert(Image *newImage)
 {
-    m_lastSqliteError = sqlite3_exec(m_dbConnection->getConnection(), buildSqlInsert(newImage).toUtf8().constData(), 0, 0, 0);
+    sqlite3_stmt *statement = prepareStatement(SqlInsert);
 
-    if (getLastError() != SQLITE_OK)
+    if (statement)
     {
-        logError(buildSqlInsert(newImage));
+        bindImage(statement, newImage);
+        executeStatement(statement, SqlInsert);
     }
 }
 
@@ -62,11 +116,12 @@ void LocalDatabaseImageDAL::del(const DicomMask &imageMaskToDelete)
 
 void LocalDatabaseImageDAL::update(Image *imageToUpdate)
 {
-    m_lastSqliteError = sqlite3_exec(m_dbConnection->getConnection(), buildSqlUpdate(imageToUpdate).toUtf8().constData(), 0, 0, 0);
+    sqlite3_stmt *statement = prepareStatement(SqlUpdate);
 
-    if (getLastError() != SQLITE_OK)
+    if (statement)
     {
-        logError(buildSqlUpdate(imageToUpdate));
+        bindImage(statement, imageToUpdate);
+        executeStatement(statement, SqlUpdate);
     }
 }
 
@@ -225,156 +280,60 @@ QString LocalDatabaseImageDAL::buildSqlSelectCountImages(const DicomMask &imageM
     return selectSentence + buildWhereSentence(imageMaskToSelect);
 }
 
-QString LocalDatabaseImageDAL::buildSqlInsert(Image *newImage)
+void LocalDatabaseImageDAL::bindImage(sqlite3_stmt *statement, Image *image)
 {
     QString windowWidth, windowCenter, windowExplanation;
-    getWindowLevelInformationAsQString(newImage, windowWidth, windowCenter, windowExplanation);
-    
-    QString insertSentence = QString("Insert into Image (SOPInstanceUID, FrameNumber, StudyInstanceUID, SeriesInstanceUID, InstanceNumber,"
-                                             "ImageOrientationPatient, PatientOrientation, PixelSpacing, SliceThickness,"
-                                             "PatientPosition, SamplesPerPixel, Rows, Columns, BitsAllocated, BitsStored,"
-                                             "PixelRepresentation, RescaleSlope, WindowLevelWidth, WindowLevelCenter,"
-                                             "WindowLevelExplanations, SliceLocation,"
-                                             "RescaleIntercept, PhotometricInterpretation, ImageType, ViewPosition,"
-                                             "ImageLaterality, ViewCodeMeaning, PhaseNumber, ImageTime, VolumeNumberInSeries,"
-                                             "OrderNumberInVolume, RetrievedDate, RetrievedTime, State, NumberOfOverlays, RetrievedPACSID,"
-                                             "ImagerPixelSpacing, EstimatedRadiographicMagnificationFactor, TransferSyntaxUID) "
-                                     "values ('%1', %2, '%3', '%4', '%5', "
-                                             "'%6', '%7', '%8', %9,"
-                                             "'%10', %11, %12, %13, %14, %15, "
-                                             "%16, %17,'%18', '%19', "
-                                             "'%20', '%21', "
-                                             "%22, '%23', '%24', '%25',"
-                                             "'%26',  '%27', %28, '%29', %30,"
-                                             "%31, '%32', '%33', %34, %35, %36, '%37', %38, '%39')")
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getSOPInstanceUID()))
-                            .arg(newImage->getFrameNumber())
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getParentSeries()->getParentStudy()->getInstanceUID()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getParentSeries()->getInstanceUID()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getInstanceNumber()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getImageOrientationPatient().getDICOMFormattedImageOrientation()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getPatientOrientation().getDICOMFormattedPatientOrientation()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(getPixelSpacingAsQString(newImage)))
-                            .arg(newImage->getSliceThickness())
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(getPatientPositionAsQString(newImage)))
-                            .arg(newImage->getSamplesPerPixel())
-                            .arg(newImage->getRows())
-                            .arg(newImage->getColumns())
-                            .arg(newImage->getBitsAllocated())
-                            .arg(newImage->getBitsStored())
-                            .arg(newImage->getPixelRepresentation())
-                            .arg(newImage->getRescaleSlope())
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(windowWidth))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(windowCenter))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(windowExplanation))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getSliceLocation()))
-                            .arg(newImage->getRescaleIntercept())
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getPhotometricInterpretation().getAsQString()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getImageType()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getViewPosition()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getImageLaterality()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getViewCodeMeaning()))
-                            .arg(newImage->getPhaseNumber())
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getImageTime()))
-                            .arg (newImage->getVolumeNumberInSeries())
-                            .arg(newImage->getOrderNumberInVolume())
-                            .arg(newImage->getRetrievedDate().toString("yyyyMMdd"))
-                            .arg(newImage->getRetrievedTime().toString("hhmmss"))
-                            .arg(0)
-                            .arg(newImage->getNumberOfOverlays())
-                            .arg(getIDPACSInDatabaseFromDICOMSource(newImage->getDICOMSource()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(getImagerPixelSpacingAsQString(newImage)))
-                            .arg(newImage->getEstimatedRadiographicMagnificationFactor())
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(newImage->getTransferSyntaxUID()));
-
-    return insertSentence;
-}
+    getWindowLevelInformationAsQString(image, windowWidth, windowCenter, windowExplanation);
+
+    bindText(statement, 1, image->getSOPInstanceUID());
+    sqlite3_bind_int(statement, 2, image->getFrameNumber());
+    bindText(statement, 3, image->getParentSeries()->getParentStudy()->getInstanceUID());
+    bindText(statement, 4, image->getParentSeries()->getInstanceUID());
+    bindText(statement, 5, image->getInstanceNumber());
+    bindText(statement, 6, image->getImageOrientationPatient().getDICOMFormattedImageOrientation());
+    bindText(statement, 7, image->getPatientOrientation().getDICOMFormattedPatientOrientation());
+    bindText(statement, 8, getPixelSpacingAsQString(image));
+    sqlite3_bind_double(statement, 9, image->getSliceThickness());
+    bindText(statement, 10, getPatientPositionAsQString(image));
+    sqlite3_bind_int(statement, 11, image->getSamplesPerPixel());
+    sqlite3_bind_int(statement, 12, image->getRows());
+    sqlite3_bind_int(statement, 13, image->getColumns());
+    sqlite3_bind_int(statement, 14, image->getBitsAllocated());
+    sqlite3_bind_int(statement, 15, image->getBitsStored());
+    sqlite3_bind_int(statement, 16, image->getPixelRepresentation());
+    sqlite3_bind_double(statement, 17, image->getRescaleSlope());
+    bindText(statement, 18, windowWidth);
+    bindText(statement, 19, windowCenter);
+    bindText(statement, 20, windowExplanation);
+    bindText(statement, 21, image->getSliceLocation());
+    sqlite3_bind_double(statement, 22, image->getRescaleIntercept());
+    bindText(statement, 23, image->getPhotometricInterpretation().getAsQString());
+    bindText(statement, 24, image->getImageType());
+    bindText(statement, 25, image->getViewPosition());
+    bindText(statement, 26, DatabaseConnection::formatTextToValidSQLSyntax(image->getImageLaterality()));
+    bindText(statement, 27, image->getViewCodeMeaning());
+    sqlite3_bind_int(statement, 28, image->getPhaseNumber());
+    bindText(statement, 29, image->getImageTime());
+    sqlite3_bind_int(statement, 30, image->getVolumeNumberInSeries());
+    sqlite3_bind_int(statement, 31, image->getOrderNumberInVolume());
+    bindText(statement, 32, image->getRetrievedDate().toString("yyyyMMdd"));
+    bindText(statement, 33, image->getRetrievedTime().toString("hhmmss"));
+    sqlite3_bind_int(statement, 34, 0);
+    sqlite3_bind_int(statement, 35, image->getNumberOfOverlays());
+
+    QString retrievedPACSID = getIDPACSInDatabaseFromDICOMSource(image->getDICOMSource());
+    if (retrievedPACSID == "null")
+    {
+        sqlite3_bind_null(statement, 36);
+    }
+    else
+    {
+        sqlite3_bind_int64(statement, 36, retrievedPACSID.toLongLong());
+    }
 
-QString LocalDatabaseImageDAL::buildSqlUpdate(Image *imageToUpdate)
-{
-    QString windowWidth, windowCenter, windowExplanation;
-    getWindowLevelInformationAsQString(imageToUpdate, windowWidth, windowCenter, windowExplanation);
-    
-    QString updateSentence = QString("Update Image set StudyInstanceUID = '%1',"
-                                              "SeriesInstanceUID = '%2',"
-                                              "InstanceNumber = '%3',"
-                                              "ImageOrientationPatient = '%4',"
-                                              "PatientOrientation = '%5',"
-                                              "PixelSpacing = '%6',"
-                                              "SliceThickness = '%7',"
-                                              "PatientPosition = '%8',"
-                                              "SamplesPerPixel = '%9',"
-                                              "Rows = '%10',"
-                                              "Columns = '%11',"
-                                              "BitsAllocated = '%12',"
-                                              "BitsStored = '%13',"
-                                              "PixelRepresentation = '%14',"
-                                              "RescaleSlope = '%15',"
-                                              "WindowLevelWidth = '%16',"
-                                              "WindowLevelCenter = '%17',"
-                                              "WindowLevelExplanations = '%18',"
-                                              "SliceLocation = '%19',"
-                                              "RescaleIntercept = '%20', "
-                                              "PhotometricInterpretation = '%21', "
-                                              "ImageType = '%22', "
-                                              "ViewPosition = '%23', "
-                                              "ImageLaterality = '%24', "
-                                              "ViewCodeMeaning = '%25', "
-                                              "PhaseNumber = %26, "
-                                              "ImageTime = '%27', "
-                                              "VolumeNumberInSeries = %28, "
-                                              "OrderNumberInVolume = '%29', "
-                                              "RetrievedDate = '%30', "
-                                              "RetrievedTime = '%31', "
-                                              "State = %32, "
-                                              "NumberOfOverlays = %33, "
-                                              "RetrievedPACSID = %34, "
-                                              "ImagerPixelSpacing = '%37', "
-                                              "EstimatedRadiographicMagnificationFactor = %38, "
-                                              "TransferSyntaxUID = '%39' "
-                                     "Where SOPInstanceUID = '%35' And "
-                                           "FrameNumber = %36")
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getParentSeries()->getParentStudy()->getInstanceUID()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getParentSeries()->getInstanceUID()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getInstanceNumber()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getImageOrientationPatient().getDICOMFormattedImageOrientation()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getPatientOrientation().getDICOMFormattedPatientOrientation()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(getPixelSpacingAsQString(imageToUpdate)))
-                            .arg(imageToUpdate->getSliceThickness())
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(getPatientPositionAsQString(imageToUpdate)))
-                            .arg(imageToUpdate->getSamplesPerPixel())
-                            .arg(imageToUpdate->getRows())
-                            .arg(imageToUpdate->getColumns())
-                            .arg(imageToUpdate->getBitsAllocated())
-                            .arg(imageToUpdate->getBitsStored())
-                            .arg(imageToUpdate->getPixelRepresentation())
-                            .arg(imageToUpdate->getRescaleSlope())
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(windowWidth))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(windowCenter))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(windowExplanation))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getSliceLocation()))
-                            .arg(imageToUpdate->getRescaleIntercept())
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getPhotometricInterpretation().getAsQString()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getImageType()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getViewPosition()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getImageLaterality()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getViewCodeMeaning()))
-                            .arg (imageToUpdate->getPhaseNumber())
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getImageTime()))
-                            .arg (imageToUpdate->getVolumeNumberInSeries())
-                            .arg(imageToUpdate->getOrderNumberInVolume())
-                            .arg(imageToUpdate->getRetrievedDate().toString("yyyyMMdd"))
-                            .arg(imageToUpdate->getRetrievedTime().toString("hhmmss"))
-                            .arg(0)
-                            .arg(imageToUpdate->getNumberOfOverlays())
-                            .arg(getIDPACSInDatabaseFromDICOMSource(imageToUpdate->getDICOMSource()))
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getSOPInstanceUID()))
-                            .arg(imageToUpdate->getFrameNumber())
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(getImagerPixelSpacingAsQString(imageToUpdate)))
-                            .arg(imageToUpdate->getEstimatedRadiographicMagnificationFactor())
-                            .arg(DatabaseConnection::formatTextToValidSQLSyntax(imageToUpdate->getTransferSyntaxUID()));
-
-    return updateSentence;
+    bindText(statement, 37, getImagerPixelSpacingAsQString(image));
+    sqlite3_bind_double(statement, 38, image->getEstimatedRadiographicMagnificationFactor());
+    bindText(statement, 39, image->getTransferSyntaxUID());
 }
 
 QString LocalDatabaseImageDAL::buildSqlDelete(const DicomMask &imageMaskToDelete)
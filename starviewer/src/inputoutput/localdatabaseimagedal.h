@@ -22,6 +22,8 @@
 #include "localdatabasebasedal.h"
 #include "image.h"
 
+struct sqlite3_stmt;
+
 namespace udg {
 
 class DicomMask;
@@ -56,6 +58,10 @@ public:
     int count(const DicomMask &imageMaskToCount);
 
 private:
+    /// Sentències preparades per inserir i updatar imatges
+    static const QString SqlInsert;
+    static const QString SqlUpdate;
+
     double m_imageOrientationPatient[6];
     double m_pixelSpacing[2];
     double m_patientPosition[3];
@@ -76,11 +82,8 @@ private:
     /// SOPInstanceUID
     QString buildSqlSelectCountImages(const DicomMask &imageMaskToSelect);
 
-    /// Genera la sentència sql per inserir la nova imatge a la base de dades
-    QString buildSqlInsert(Image *newImage);
-
-    /// Genera la sentència sql per updatar la imatge a la base de dades
-    QString buildSqlUpdate(Image *imageToUpdate);
+    /// Assigna els valors de la imatge als paràmetres de la sentència preparada d'insert o d'update
+    void bindImage(sqlite3_stmt *statement, Image *image);
 
     /// Genera la sentencia Sql per esborrar Imatges, de la màscara només té en compte per construir la sentència el StudyUID, SeriesUID i SOPInstanceUID
     QString buildSqlDelete(const DicomMask &imageMaskToDelete);
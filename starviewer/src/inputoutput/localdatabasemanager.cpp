@@ -15,6 +15,10 @@
 #include "localdatabasemanager.h"
 
 #include <QDir>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QThread>
 
 #include "patient.h"
 #include "study.h"
@@ -33,10 +37,17 @@
 #include "inputoutputsettings.h"
 #include "starviewerapplication.h"
 #include "harddiskinformation.h"
-#include "thumbnailcreator.h"
+#include "thumbnailservice.h"
+#include "volumepixeldatacache.h"
 
 namespace udg {
 
+// Protegeix la llista d'estudis que s'estan descarregant, que poden modificar diverses descàrregues simultànies
+static QMutex RetrievingStudiesMutex;
+// Fa que només s'alliberi espai de la caché des d'un thread a la vegada, perquè el servei d'esborrat en segon pla i les descàrregues no esborrin els
+// mateixos estudis comptant cadascun la seva mida
+static QMutex FreeingSpaceMutex;
+
 namespace {
 
 /// Inserts in the database all the VOI LUTs that are LUTs in the given image.
@@ -193,7 +204,12 @@ void LocalDatabaseManager::save(Series *seriesToSave)
         QList<Series*> seriesList;
         seriesList.append(seriesToSave);
 
-        saveSeries(&dbConnect, seriesList, currentDate, currentTime);
+        status = saveSeries(&dbConnect, seriesList, currentDate, currentTime);
+
+        if (status == SQLITE_OK)
+        {
+            status = saveStudySizeInBytes(&dbConnect, studyParent->getInstanceUID());
+        }
 
         if (status != SQLITE_OK)
         {
@@ -264,33 +280,12 @@ QList<Series*> LocalDatabaseManager::querySeries(const DicomMask &seriesMaskToQu
 {
     DatabaseConnection dbConnect;
     LocalDatabaseSeriesDAL seriesDAL(&dbConnect);
-    LocalDatabaseImageDAL imageDAL(&dbConnect);
     QList<Series*> queryResult;
-    DicomMask maskToCountNumberOfImage = seriesMaskToQuery;
 
-    queryResult = seriesDAL.query(seriesMaskToQuery);
-
-    if (seriesDAL.getLastError() != SQLITE_OK)
-    {
-        setLastError(seriesDAL.getLastError());
-        return queryResult;
-    }
-
-    // Consultem el número d'imatges de la Sèrie
-    foreach (Series *series, queryResult)
-    {
-        maskToCountNumberOfImage.setSeriesInstanceUID(series->getInstanceUID());
-        series->setNumberOfImages(imageDAL.count(maskToCountNumberOfImage));
-
-        if (imageDAL.getLastError() != SQLITE_OK)
-        {
-            break;
-        }
-    }
-    setLastError(imageDAL.getLastError());
-
-    // Carreguem els thumbnails de les series consultades
-    loadSeriesThumbnail(seriesMaskToQuery.getStudyInstanceUID(), queryResult);
+    // Les sèries es consulten juntament amb el seu número d'imatges en una sola sentència. Els thumbnails no es carreguen aquí, els carrega qui els
+    // hagi de mostrar a partir de getSeriesThumbnailPath()
+    queryResult = seriesDAL.queryWithNumberOfImages(seriesMaskToQuery);
+    setLastError(seriesDAL.getLastError());
 
     return queryResult;
 }
@@ -429,6 +424,11 @@ void LocalDatabaseManager::deleteSeries(const QString &studyInstanceUID, const Q
 
             int status = deleteSeriesStructureFromDatabase(&dbConnect, studyInstanceUID, seriesInstanceUID);
 
+            if (status == SQLITE_OK)
+            {
+                status = saveStudySizeInBytes(&dbConnect, studyInstanceUID);
+            }
+
             if (status != SQLITE_OK)
             {
                 setLastError(status);
@@ -516,7 +516,6 @@ bool LocalDatabaseManager::thereIsAvailableSpaceOnHardDisk()
     Settings settings;
     quint64 freeSpaceInHardDisk = hardDiskInformation.getNumberOfFreeMBytes(LocalDatabaseManager::getCachePath());
     quint64 minimumSpaceRequired = quint64(settings.getValue(InputOutputSettings::MinimumFreeGigaBytesForCache).toULongLong() * 1024);
-    quint64 MbytesToFree;
     quint64 MbytesToEraseWhereNotEnoughSpaceAvailableInHardDisk =
         settings.getValue(InputOutputSettings::MinimumGigaBytesToFreeIfCacheIsFull).toULongLong() * 1024;
 
@@ -531,12 +530,9 @@ bool LocalDatabaseManager::thereIsAvailableSpaceOnHardDisk()
         {
             INFO_LOG("s'intentara esborrar estudis vells per alliberar suficient espai");
 
-            // No hi ha suficient espai indiquem quina és la quantitat de MB d'estudis vells que intentem alliberar. Aquest és el número de Mbytes fins arribar
-            // l'espai míninm necessari (minimumSpaceRequired - freeSpaceInHardDisk), més una quantitat fixa, per assegurar que disposem de prou espai per
-            // descarregar estudis grans, i no haver d'estar en cada descarrega alliberant espai
-            MbytesToFree = (minimumSpaceRequired - freeSpaceInHardDisk) + MbytesToEraseWhereNotEnoughSpaceAvailableInHardDisk;
-
-            freeSpaceDeletingStudies(MbytesToFree);
+            // No hi ha suficient espai, alliberem fins arribar a l'espai míninm necessari més una quantitat fixa, per assegurar que disposem de prou espai
+            // per descarregar estudis grans, i no haver d'estar en cada descarrega alliberant espai
+            freeSpaceDeletingStudies(minimumSpaceRequired, minimumSpaceRequired + MbytesToEraseWhereNotEnoughSpaceAvailableInHardDisk);
             if (getLastError() != LocalDatabaseManager::Ok)
             {
                 ERROR_LOG("S'ha produit un error intentant alliberar espai");
@@ -575,22 +571,43 @@ LocalDatabaseManager::LastError LocalDatabaseManager::getLastError()
 
 bool LocalDatabaseManager::setStudyRetrieving(const QString &studyInstanceUID)
 {
-    Settings settings;
-
-    if (!settings.contains(InputOutputSettings::RetrievingStudy) && !studyInstanceUID.isEmpty())
+    if (studyInstanceUID.isEmpty())
     {
-        settings.setValue(InputOutputSettings::RetrievingStudy, studyInstanceUID);
-        return true;
+        return false;
     }
-    else
+
+    // Es poden descarregar diversos estudis a la vegada, per tant la llista es llegeix i s'escriu de manera atòmica
+    QMutexLocker locker(&RetrievingStudiesMutex);
+    Settings settings;
+    // Les versions anteriors hi guardaven un sol UID, que toStringList() converteix en una llista d'un element
+    QStringList retrievingStudies = settings.getValue(InputOutputSettings::RetrievingStudy).toStringList();
+
+    if (retrievingStudies.contains(studyInstanceUID))
     {
         return false;
     }
+
+    retrievingStudies.append(studyInstanceUID);
+    settings.setValue(InputOutputSettings::RetrievingStudy, retrievingStudies);
+    return true;
 }
 
-void LocalDatabaseManager::setStudyRetrieveFinished()
+void LocalDatabaseManager::setStudyRetrieveFinished(const QString &studyInstanceUID)
 {
-    Settings().remove(InputOutputSettings::RetrievingStudy);
+    QMutexLocker locker(&RetrievingStudiesMutex);
+    Settings settings;
+    QStringList retrievingStudies = settings.getValue(InputOutputSettings::RetrievingStudy).toStringList();
+
+    retrievingStudies.removeAll(studyInstanceUID);
+
+    if (retrievingStudies.isEmpty())
+    {
+        settings.remove(InputOutputSettings::RetrievingStudy);
+    }
+    else
+    {
+        settings.setValue(InputOutputSettings::RetrievingStudy, retrievingStudies);
+    }
 }
 
 void LocalDatabaseManager::checkNoStudiesRetrieving()
@@ -598,27 +615,30 @@ void LocalDatabaseManager::checkNoStudiesRetrieving()
     if (isStudyRetrieving())
     {
         Settings settings;
-        QString studyNotFullRetrieved = settings.getValue(InputOutputSettings::RetrievingStudy).toString();
+        QStringList studiesNotFullRetrieved = settings.getValue(InputOutputSettings::RetrievingStudy).toStringList();
 
-        INFO_LOG("L'estudi " + studyNotFullRetrieved + " s'estava descarregant al tancar-se la ultima execucio de l'Starviewer, per mantenir la " +
-                 "integritat s'esborraran les imatges que se n'havien descarregat fins al moment");
+        foreach (const QString &studyNotFullRetrieved, studiesNotFullRetrieved)
+        {
+            INFO_LOG("L'estudi " + studyNotFullRetrieved + " s'estava descarregant al tancar-se la ultima execucio de l'Starviewer, per mantenir la " +
+                     "integritat s'esborraran les imatges que se n'havien descarregat fins al moment");
 
-        // Es pot donar el cas que s'hagués arribat a inserir l'estudi i just abans d'indicar que la descàrrega de l'estudi havia finalitzat a través del
-        // mètode setStudyRetrieveFinished, s'hagués tancat l'starviewer per tant el mètode el detectaria que l'estudi estés a mig descarregar quan realment
-        // està descarregat, per això comprovem si l'estudi existeix i si és el cas l'esborrem per deixar la base de dades en un estat consistent
-        DicomMask studyMask;
-        studyMask.setStudyInstanceUID(studyNotFullRetrieved);
+            // Es pot donar el cas que s'hagués arribat a inserir l'estudi i just abans d'indicar que la descàrrega de l'estudi havia finalitzat a través del
+            // mètode setStudyRetrieveFinished, s'hagués tancat l'starviewer per tant el mètode el detectaria que l'estudi estés a mig descarregar quan realment
+            // està descarregat, per això comprovem si l'estudi existeix i si és el cas l'esborrem per deixar la base de dades en un estat consistent
+            DicomMask studyMask;
+            studyMask.setStudyInstanceUID(studyNotFullRetrieved);
 
-        if (queryStudy(studyMask).count() > 0)
-        {
-            deleteStudy(studyNotFullRetrieved);
-        }// No s'ha arribat a inserir a la bd
-        else
-        {
-            // Comprovem si el directori existeix de l'estudi, per si no s'hagués arribat a baixar cap imatge, el
-            if (QDir().exists(getStudyPath(studyNotFullRetrieved)))
+            if (queryStudy(studyMask).count() > 0)
+            {
+                deleteStudy(studyNotFullRetrieved);
+            }// No s'ha arribat a inserir a la bd
+            else
             {
-                deleteStudyFromHardDisk(studyNotFullRetrieved);
+                // Comprovem si el directori existeix de l'estudi, per si no s'hagués arribat a baixar cap imatge, el
+                if (QDir().exists(getStudyPath(studyNotFullRetrieved)))
+                {
+                    deleteStudyFromHardDisk(studyNotFullRetrieved);
+                }
             }
         }
 
@@ -635,6 +655,13 @@ bool LocalDatabaseManager::isStudyRetrieving()
     return Settings().contains(InputOutputSettings::RetrievingStudy);
 }
 
+bool LocalDatabaseManager::isStudyRetrieving(const QString &studyInstanceUID)
+{
+    QMutexLocker locker(&RetrievingStudiesMutex);
+
+    return Settings().getValue(InputOutputSettings::RetrievingStudy).toStringList().contains(studyInstanceUID);
+}
+
 int LocalDatabaseManager::saveStudies(DatabaseConnection *dbConnect, QList<Study*> listStudyToSave, const QDate &currentDate, const QTime &currentTime)
 {
     int status = SQLITE_OK;
@@ -670,6 +697,13 @@ int LocalDatabaseManager::saveStudies(DatabaseConnection *dbConnect, QList<Study
         {
             break;
         }
+
+        status = saveStudySizeInBytes(dbConnect, studyToSave->getInstanceUID());
+
+        if (status != SQLITE_OK)
+        {
+            break;
+        }
     }
 
     return status;
@@ -699,6 +733,13 @@ int LocalDatabaseManager::saveSeries(DatabaseConnection *dbConnect, QList<Series
         {
             break;
         }
+
+        status = saveSeriesSizeInBytes(dbConnect, seriesToSave);
+
+        if (status != SQLITE_OK)
+        {
+            break;
+        }
     }
 
     return status;
@@ -707,21 +748,21 @@ int LocalDatabaseManager::saveSeries(DatabaseConnection *dbConnect, QList<Series
 int LocalDatabaseManager::saveImages(DatabaseConnection *dbConnect, QList<Image*> listImageToSave, const QDate &currentDate, const QTime &currentTime)
 {
     int status = SQLITE_OK;
+    // Fem servir el mateix DAL per totes les imatges perquè reaprofiti la caché d'IDs de PACS, i les sentències preparades de la connexió fan que
+    // l'insert només es compili un cop
+    LocalDatabaseImageDAL imageDAL(dbConnect);
 
     foreach (Image *imageToSave, listImageToSave)
     {
         imageToSave->setRetrievedDate(currentDate);
         imageToSave->setRetrievedTime(currentTime);
 
-        status = saveImage(dbConnect, imageToSave);
-
+        status = saveImage(dbConnect, imageDAL, imageToSave);
 
         if (status != SQLITE_OK)
         {
             return status;
         }
-
-        
     }
 
     return status;
@@ -796,10 +837,29 @@ int LocalDatabaseManager::saveSeries(DatabaseConnection *dbConnect, Series *seri
     return seriesDAL.getLastError();
 }
 
-int LocalDatabaseManager::saveImage(DatabaseConnection *dbConnect, Image *imageToSave)
+int LocalDatabaseManager::saveSeriesSizeInBytes(DatabaseConnection *dbConnect, Series *series)
 {
-    LocalDatabaseImageDAL imageDAL(dbConnect);
+    LocalDatabaseSeriesDAL seriesDAL(dbConnect);
+    // Es mesura el directori sencer i no les imatges que s'acaben de guardar, perquè si la sèrie ja hi era i se n'han descarregat més imatges la
+    // mida inclogui també les anteriors
+    QString seriesPath = getStudyPath(series->getParentStudy()->getInstanceUID()) + QDir::separator() + series->getInstanceUID();
+
+    seriesDAL.updateSizeInBytes(series->getInstanceUID(), HardDiskInformation::getDirectorySizeInBytes(seriesPath));
+
+    return seriesDAL.getLastError();
+}
+
+int LocalDatabaseManager::saveStudySizeInBytes(DatabaseConnection *dbConnect, const QString &studyInstanceUID)
+{
+    LocalDatabaseStudyDAL studyDAL(dbConnect);
+
+    studyDAL.updateSizeInBytesFromSeries(studyInstanceUID);
+
+    return studyDAL.getLastError();
+}
 
+int LocalDatabaseManager::saveImage(DatabaseConnection *dbConnect, LocalDatabaseImageDAL &imageDAL, Image *imageToSave)
+{
     imageDAL.insert(imageToSave);
 
     /// Si el pacient ja existia actualitzem la seva informació
@@ -984,36 +1044,71 @@ int LocalDatabaseManager::deleteImageFromDatabase(DatabaseConnection *dbConnect,
     return localDatabaseImageDAL.getLastError();
 }
 
-void LocalDatabaseManager::freeSpaceDeletingStudies(quint64 MbytesToErase)
+void LocalDatabaseManager::freeSpaceDeletingStudies(quint64 minimumFreeMBytes, quint64 targetFreeMBytes)
 {
-    QList<Study*> studyListToDelete = queryStudyOrderByLastAccessDate(DicomMask());
+    QMutexLocker freeingSpaceLocker(&FreeingSpaceMutex);
+
+    m_lastError = Ok;
+
+    // Mentre s'esperava un altre thread pot haver alliberat l'espai
+    quint64 freeMBytes = HardDiskInformation().getNumberOfFreeMBytes(LocalDatabaseManager::getCachePath());
+    if (freeMBytes >= minimumFreeMBytes || freeMBytes >= targetFreeMBytes)
+    {
+        return;
+    }
+
+    QList<QPair<QString, qint64> > studiesSize;
+    {
+        DatabaseConnection dbConnect;
+        LocalDatabaseStudyDAL studyDAL(&dbConnect);
+
+        studiesSize = studyDAL.querySizeInBytesOrderByLastAccessDate();
+        setLastError(studyDAL.getLastError());
+    }
 
-    if (getLastError() == LocalDatabaseManager::Ok)
+    if (getLastError() != LocalDatabaseManager::Ok)
     {
-        quint64 MbytesErased = 0;
-        int index = 0;
+        return;
+    }
 
-        while (index < studyListToDelete.count() && MbytesErased < MbytesToErase)
+    quint64 bytesToErase = (targetFreeMBytes - freeMBytes) * 1024 * 1024;
+    quint64 bytesErased = 0;
+
+    for (int index = 0; index < studiesSize.count() && bytesErased < bytesToErase; index++)
+    {
+        // Es pot demanar aturar el thread, per exemple el del servei d'esborrat en tancar l'Starviewer, sense esperar a alliberar tot l'espai
+        if (QThread::currentThread()->isInterruptionRequested())
         {
-            Study *studyToDelete = studyListToDelete.at(index);
+            INFO_LOG("S'ha interromput l'alliberament d'espai de la cache");
+            break;
+        }
 
-            emit studyWillBeDeleted(studyToDelete->getInstanceUID());
-            MbytesErased += HardDiskInformation::getDirectorySizeInBytes(LocalDatabaseManager::getCachePath() + studyToDelete->getInstanceUID()) / 1024 / 1024;
+        QString studyInstanceUID = studiesSize.at(index).first;
+        qint64 studySizeInBytes = studiesSize.at(index).second;
 
-            deleteStudy(studyToDelete->getInstanceUID());
-            if (getLastError() != LocalDatabaseManager::Ok)
-            {
-                break;
-            }
+        // Mentre es descarrega un estudi que ja era a la base de dades se n'estan escrivint fitxers al seu directori. La llista d'estudis descarregant-se
+        // es bloqueja fins haver-lo esborrat perquè no se'n pugui començar a descarregar un just després de comprovar-la
+        QMutexLocker retrievingStudiesLocker(&RetrievingStudiesMutex);
+        if (Settings().getValue(InputOutputSettings::RetrievingStudy).toStringList().contains(studyInstanceUID))
+        {
+            continue;
+        }
 
-            index++;
+        if (studySizeInBytes < 0)
+        {
+            // Estudi guardat abans que la base de dades tingués la mida dels estudis
+            studySizeInBytes = HardDiskInformation::getDirectorySizeInBytes(getStudyPath(studyInstanceUID));
         }
 
-        // Esborrem els estudis de la memòria
-        foreach (Study *study, studyListToDelete)
+        emit studyWillBeDeleted(studyInstanceUID);
+
+        deleteStudy(studyInstanceUID);
+        if (getLastError() != LocalDatabaseManager::Ok)
         {
-            delete study;
+            break;
         }
+
+        bytesErased += studySizeInBytes;
     }
 }
 
@@ -1030,6 +1125,12 @@ void LocalDatabaseManager::deleteStudyFromHardDisk(const QString &studyInstanceT
     {
         m_lastError = LocalDatabaseManager::Ok;
     }
+
+    // The decoded pixel data is useless without the files it was read from
+    if (!VolumePixelDataCache().removeStudy(studyInstanceToDelete))
+    {
+        WARN_LOG("No s'han pogut esborrar els volums descodificats de l'estudi " + studyInstanceToDelete);
+    }
 }
 
 void LocalDatabaseManager::deleteSeriesFromHardDisk(const QString &studyInstanceUID, const QString &seriesInstanceUID)
@@ -1045,6 +1146,11 @@ void LocalDatabaseManager::deleteSeriesFromHardDisk(const QString &studyInstance
     {
         m_lastError = LocalDatabaseManager::Ok;
     }
+
+    if (!VolumePixelDataCache().removeSeries(studyInstanceUID, seriesInstanceUID))
+    {
+        WARN_LOG("No s'han pogut esborrar els volums descodificats de la sèrie " + seriesInstanceUID);
+    }
 }
 
 void LocalDatabaseManager::createStudyThumbnails(Study *studyToGenerateSeriesThumbnails)
@@ -1057,29 +1163,10 @@ void LocalDatabaseManager::createStudyThumbnails(Study *studyToGenerateSeriesThu
 
 void LocalDatabaseManager::createSeriesThumbnail(Series *seriesToGenerateThumbnail)
 {
-    ThumbnailCreator thumbnailCreator;
-    QString thumbnailFilePath;
-
-    // Només crearem el thumbnail si aquest no s'ha creat encara
-    thumbnailFilePath = getSeriesThumbnailPath(seriesToGenerateThumbnail->getParentStudy()->getInstanceUID(), seriesToGenerateThumbnail);
-    if (!QFileInfo(thumbnailFilePath).exists())
-    {
-        thumbnailCreator.getThumbnail(seriesToGenerateThumbnail).save(thumbnailFilePath, "PNG");
-    }
-}
-
-void LocalDatabaseManager::loadSeriesThumbnail(QString studyInstanceUID, QList<Series*> seriesList)
-{
-    foreach (Series *series, seriesList)
-    {
-        QString thumbnailPath = getSeriesThumbnailPath(studyInstanceUID, series);
-        QFileInfo thumbnailFile(thumbnailPath);
-
-        if (thumbnailFile.exists())
-        {
-            series->setThumbnail(QPixmap(thumbnailPath));
-        }
-    }
+    // Només crearem el thumbnail si aquest no s'ha creat encara. Si cal descodificar una imatge es crea en segon pla, perquè la descàrrega i la
+    // importació no n'hagin d'esperar
+    QString thumbnailFilePath = getSeriesThumbnailPath(seriesToGenerateThumbnail->getParentStudy()->getInstanceUID(), seriesToGenerateThumbnail);
+    ThumbnailService::instance()->requestSeriesThumbnail(seriesToGenerateThumbnail, thumbnailFilePath);
 }
 
 void LocalDatabaseManager::setLastError(int sqliteLastError)
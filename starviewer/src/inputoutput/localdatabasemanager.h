@@ -28,6 +28,7 @@ namespace udg {
 
 class DicomMask;
 class DatabaseConnection;
+class LocalDatabaseImageDAL;
 class DisplayShutter;
 
 /**
@@ -97,20 +98,29 @@ public:
     /// per tal d'alliberar suficient espai per permetre noves descàrregues
     bool thereIsAvailableSpaceOnHardDisk();
 
+    /// Si l'espai lliure de la caché és per sota de minimumFreeMBytes esborra estudis fins tenir-ne targetFreeMBytes, començant pels que fa més temps
+    /// que no es visualitzen. L'espai de cada estudi es treu de la mida guardada a la base de dades, i només es recorre el seu directori si no la té.
+    /// No esborra els estudis que s'estan descarregant. Només allibera espai un thread a la vegada, i l'espai lliure es consulta un cop té el torn.
+    /// Deixa d'esborrar estudis si es demana interrompre el thread actual amb QThread::requestInterruption().
+    void freeSpaceDeletingStudies(quint64 minimumFreeMBytes, quint64 targetFreeMBytes);
+
     /// Donat un study instance UID ens indica a quin ha de ser el directori de l'estudi
     QString getStudyPath(const QString &studyInstanceUID);
 
+    /// Retorna el path + el nom del thumbnail d'una sèrie
+    QString getSeriesThumbnailPath(QString studyInstanceUID, Series *series);
+
     LastError getLastError();
 
     /// Ens permet indicar que tenim un estudi que s'està descarregant, aquest mètode ens permet que en el cas
     /// que l'starviewer tanqui de forma anómala, saber quin estudis s'estava descarregant, per deixar la
     /// base de dades local en un estat consistent.
-    /// Atenció! Aquest mètode només permet establir com a Retrieving un estudi a la vegada
-    /// @return retorna indicant si s'ha pogut realitzar l'operació amb èxit, si indica fals serà perquè ja hi ha un estudi descarregant
+    /// Es poden tenir diversos estudis descarregant-se a la vegada
+    /// @return retorna indicant si s'ha pogut realitzar l'operació amb èxit, si indica fals serà perquè l'estudi ja estava descarregant-se
     bool setStudyRetrieving(const QString &studyInstanceUID);
 
     /// Indiquem que l'estudi que s'havia indicat a través del mètode setStudyRetrieving ja s'ha descarregat
-    void setStudyRetrieveFinished();
+    void setStudyRetrieveFinished(const QString &studyInstanceUID);
 
     /// Aquest mètode està pensat pel cas de que mentre s'està descarregant un estudi, l'starviewer finalitzi de forma anómala.
     /// El mètode comprovarà si teníem estudies en estat de descarregant i si és així esborra les imatges descarregades fins
@@ -120,6 +130,9 @@ public:
     /// Indica si hi algun estudi descarregant
     bool isStudyRetrieving();
 
+    /// Indica si l'estudi passat per paràmetre s'està descarregant
+    bool isStudyRetrieving(const QString &studyInstanceUID);
+
     /// Ens dóna la ruta absoluta al fitxer de bases de dades, fitxer de bases de dades inclós
     static QString getDatabaseFilePath();
 
@@ -144,7 +157,9 @@ private:
     /// Guarda a la base de dades la llista de series passada per paràmetre, si alguna de les series ja existeix actualitza la info
     int saveSeries(DatabaseConnection *dbConnect, QList<Series*> listSeriesToSave, const QDate &currentDate, const QTime &currentTime);
 
-    /// Guarda a la base de dades la llista d'imatges passada per paràmetre, si alguna de les imatges ja existeix actualitza la info
+    /// Guarda a la base de dades la llista d'imatges passada per paràmetre, si alguna de les imatges ja existeix actualitza la info.
+    /// S'ha de cridar dins d'una transacció, de manera que totes les imatges (normalment les d'una sèrie) es guarden de cop amb les mateixes sentències
+    /// preparades.
     int saveImages(DatabaseConnection *dbConnect, QList<Image*> listImageToSave, const QDate &currentDate, const QTime &currentTime);
 
     /// Guarda a la base de dades la llista de display shutters relacionades amb la imatge passada per paràmetre
@@ -159,8 +174,14 @@ private:
     /// Guarda el pacient a la base de dades, si ja existeix li actualitza la informació
     int saveSeries(DatabaseConnection *dbConnect, Series *seriesToSave);
 
-    /// Guarda la imatge a la base de dades, si ja existeix li actualitza la informació
-    int saveImage(DatabaseConnection *dbConnect, Image *imageToSave);
+    /// Guarda a la base de dades la mida que ocupa a disc el directori de la sèrie
+    int saveSeriesSizeInBytes(DatabaseConnection *dbConnect, Series *series);
+
+    /// Guarda a la base de dades la mida de l'estudi com la suma de la de les seves sèries
+    int saveStudySizeInBytes(DatabaseConnection *dbConnect, const QString &studyInstanceUID);
+
+    /// Guarda la imatge a la base de dades amb el DAL donat, si ja existeix li actualitza la informació
+    int saveImage(DatabaseConnection *dbConnect, LocalDatabaseImageDAL &imageDAL, Image *imageToSave);
 
     /// Esborra a base la jerarquia pacient/estudi/series/imatge de l'estudi passat per paràmetre, si es passar un valor buit no esborra res.
     int deleteStudyStructureFromDatabase(DatabaseConnection *dbConnect, const QString &studyInstanceUIDToDelete);
@@ -192,9 +213,6 @@ private:
     /// Aquesta classe s'encarrega d'esborrar les objectes descarregats si es produeix un error mentre s'insereixen els nous objectes a la base de dades
     void deleteRetrievedObjects(Series *failedSeries);
 
-    /// Esborra estudis  fins alliberar l'espai passat per paràmetre, comença esborrant els estudisque fa més que no es visualitzen
-    void freeSpaceDeletingStudies(quint64 MbytesToErase);
-
     /// Esborra l'estudi del disc dur
     void deleteStudyFromHardDisk(const QString &studyInstanceToDelete);
 
@@ -207,12 +225,6 @@ private:
     /// Crea i guarda el thumbnail de les sèries al directori on estan guardades les imatges de la serie
     void createSeriesThumbnail(Series *seriesToGenerateThumbnail);
 
-    /// Ens emplena els thumbnails d'una llistà de sèries
-    void loadSeriesThumbnail(QString studyInstanceUID, QList<Series*> series);
-
-    /// Retorna el path + el nom del thumbnail d'una sèrie
-    QString getSeriesThumbnailPath(QString studyInstanceUID, Series *series);
-
     /// Passant un status de sqlite ens el converteix al nostra status
     void setLastError(int sqliteLastError);
 
@@ -22,6 +22,15 @@
 
 namespace udg {
 
+// L'update fa servir els mateixos paràmetres que l'insert (bindPatient()) més l'ID
+const QString LocalDatabasePatientDAL::SqlInsert("Insert into Patient (DICOMPatientID, Name, Birthdate, Sex) values (?1, ?2, ?3, ?4)");
+
+const QString LocalDatabasePatientDAL::SqlUpdate("Update Patient Set DICOMPatientID = ?1, "
+                                                                    "Name = ?2, "
+                                                                    "Birthdate = ?3, "
+                                                                    "Sex = ?4 "
+                                                 "Where ID = ?5");
+
 LocalDatabasePatientDAL::LocalDatabasePatientDAL(DatabaseConnection *dbConnection)
  : LocalDatabaseBaseDAL(dbConnection)
 {
@@ -29,13 +38,17 @@ LocalDatabasePatientDAL::LocalDatabasePatientDAL(DatabaseConnection *dbConnectio
 
 void LocalDatabasePatientDAL::insert(Patient *newPatient)
 {
-    m_lastSqliteError = sqlite3_exec(m_dbConnection->getConnection(), buildSqlInsert(newPatient).toUtf8().constData(), 0, 0, 0);
+    sqlite3_stmt *statement = prepareStatement(SqlInsert);
 
-    if (getLastError() != SQLITE_OK)
+    if (!statement)
     {
-        logError(buildSqlInsert(newPatient));
+        return;
     }
-    else
+
+    bindPatient(statement, newPatient);
+    executeStatement(statement, SqlInsert);
+
+    if (getLastError() == SQLITE_OK)
     {
         // El mètode retorna un tipus sqlite3_int64 aquest en funció de l'entorn de compilació equival a un determinat tipus
         // http://www.sqlite.org/c3ref/int64.html __int64 per windows i long long int per la resta, qlonglong de qt
@@ -47,11 +60,13 @@ void LocalDatabasePatientDAL::insert(Patient *newPatient)
 
 void LocalDatabasePatientDAL::update(Patient *patientToUpdate)
 {
-    m_lastSqliteError = sqlite3_exec(m_dbConnection->getConnection(), buildSqlUpdate(patientToUpdate).toUtf8().constData(), 0, 0, 0);
+    sqlite3_stmt *statement = prepareStatement(SqlUpdate);
 
-    if (getLastError() != SQLITE_OK)
+    if (statement)
     {
-        logError(buildSqlUpdate(patientToUpdate));
+        bindPatient(statement, patientToUpdate);
+        sqlite3_bind_int64(statement, 5, patientToUpdate->getDatabaseID());
+        executeStatement(statement, SqlUpdate);
     }
 }
 
@@ -121,31 +136,12 @@ QString LocalDatabasePatientDAL::buildSqlSelect(const DicomMask &patientMaskToSe
     return selectSentence + whereSentence;
 }
 
-QString LocalDatabasePatientDAL::buildSqlInsert(Patient *newPatient)
-{
-    QString insertSentence = QString ("Insert into Patient  (DICOMPatientID, Name, Birthdate, Sex) "
-                                                   "values ('%1', '%2', '%3', '%4')")
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newPatient->getID()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newPatient->getFullName()))
-                                    .arg(newPatient->getBirthDate().toString("yyyyMMdd"))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newPatient->getSex()));
-
-    return insertSentence;
-}
-
-QString LocalDatabasePatientDAL::buildSqlUpdate(Patient *patientToUpdate)
+void LocalDatabasePatientDAL::bindPatient(sqlite3_stmt *statement, Patient *patient)
 {
-    QString updateSentence = QString ("Update Patient Set  DICOMPatientID = '%1', "
-                                                           "Name = '%2', "
-                                                           "Birthdate = '%3', "
-                                                           "Sex = '%4' "
-                                                    " Where ID = %5")
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(patientToUpdate->getID()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(patientToUpdate->getFullName()))
-                                    .arg(patientToUpdate->getBirthDate().toString("yyyyMMdd"))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(patientToUpdate->getSex()))
-                                    .arg(patientToUpdate->getDatabaseID());
-    return updateSentence;
+    bindText(statement, 1, patient->getID());
+    bindText(statement, 2, patient->getFullName());
+    bindText(statement, 3, patient->getBirthDate().toString("yyyyMMdd"));
+    bindText(statement, 4, patient->getSex());
 }
 
 QString LocalDatabasePatientDAL::buildSqlDelete(qlonglong patientID)
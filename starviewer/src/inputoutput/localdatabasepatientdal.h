@@ -20,6 +20,8 @@
 #include "localdatabasebasedal.h"
 #include "patient.h"
 
+struct sqlite3_stmt;
+
 namespace udg {
 
 class DicomMask;
@@ -44,11 +46,12 @@ public:
     QList<Patient*> query(const DicomMask &patientMaskToQuery);
 
 private:
-    /// Construeix la sentència sql per inserir el nou pacient
-    QString buildSqlInsert(Patient *newPatient);
+    /// Sentències preparades per inserir i updatar pacients
+    static const QString SqlInsert;
+    static const QString SqlUpdate;
 
-    /// Construeix la sentència updatar el pacient
-    QString buildSqlUpdate(Patient *patientToUpdate);
+    /// Assigna els valors del pacient als paràmetres de la sentència preparada d'insert o d'update, excepte l'ID de l'update
+    void bindPatient(sqlite3_stmt *statement, Patient *patient);
 
     /// Construeix la setència per fer select de pacients a partir de la màscara, només té en compte el PatientID
     QString buildSqlSelect(const DicomMask &patientMaskToSelect);
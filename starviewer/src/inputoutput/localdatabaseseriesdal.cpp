@@ -24,6 +24,33 @@
 
 namespace udg {
 
+// Els paràmetres estan numerats perquè l'insert i l'update facin servir la mateixa assignació de valors (bindSeries())
+const QString LocalDatabaseSeriesDAL::SqlInsert("Insert into Series (InstanceUID, StudyInstanceUID, Number, Modality, Date, Time, "
+                                                                   "InstitutionName, PatientPosition, ProtocolName, Description, "
+                                                                   "FrameOfReferenceUID, PositionReferenceIndicator, BodyPartExaminated, ViewPosition, "
+                                                                   "Manufacturer, Laterality, RetrievedDate, RetrievedTime, State) "
+                                                "values (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12, ?13, ?14, ?15, ?16, ?17, ?18, ?19)");
+
+const QString LocalDatabaseSeriesDAL::SqlUpdate("Update Series Set StudyInstanceUID = ?2, "
+                                                                  "Number = ?3, "
+                                                                  "Modality = ?4, "
+                                                                  "Date = ?5, "
+                                                                  "Time = ?6, "
+                                                                  "InstitutionName = ?7, "
+                                                                  "PatientPosition = ?8, "
+                                                                  "ProtocolName = ?9, "
+                                                                  "Description = ?10, "
+                                                                  "FrameOfReferenceUID = ?11, "
+                                                                  "PositionReferenceIndicator = ?12, "
+                                                                  "BodyPartExaminated = ?13, "
+                                                                  "ViewPosition = ?14, "
+                                                                  "Manufacturer = ?15, "
+                                                                  "Laterality = ?16, "
+                                                                  "RetrievedDate = ?17, "
+                                                                  "RetrievedTime = ?18, "
+                                                                  "State = ?19 "
+                                                "Where InstanceUID = ?1");
+
 LocalDatabaseSeriesDAL::LocalDatabaseSeriesDAL(DatabaseConnection *dbConnection)
  : LocalDatabaseBaseDAL(dbConnection)
 {
@@ -31,21 +58,23 @@ LocalDatabaseSeriesDAL::LocalDatabaseSeriesDAL(DatabaseConnection *dbConnection)
 
 void LocalDatabaseSeriesDAL::insert(Series *newSeries)
 {
-    m_lastSqliteError = sqlite3_exec(m_dbConnection->getConnection(), buildSqlInsert(newSeries).toUtf8().constData(), 0, 0, 0);
+    sqlite3_stmt *statement = prepareStatement(SqlInsert);
 
-    if (getLastError() != SQLITE_OK)
+    if (statement)
     {
-        logError(buildSqlInsert(newSeries));
+        bindSeries(statement, newSeries);
+        executeStatement(statement, SqlInsert);
     }
 }
 
 void LocalDatabaseSeriesDAL::update(Series *seriesToUpdate)
 {
-    m_lastSqliteError = sqlite3_exec(m_dbConnection->getConnection(), buildSqlUpdate(seriesToUpdate).toUtf8().constData(), 0, 0, 0);
+    sqlite3_stmt *statement = prepareStatement(SqlUpdate);
 
-    if (getLastError() != SQLITE_OK)
+    if (statement)
     {
-        logError(buildSqlUpdate(seriesToUpdate));
+        bindSeries(statement, seriesToUpdate);
+        executeStatement(statement, SqlUpdate);
     }
 }
 
@@ -59,7 +88,28 @@ void LocalDatabaseSeriesDAL::del(const DicomMask &seriesMaskToDelete)
     }
 }
 
+void LocalDatabaseSeriesDAL::updateSizeInBytes(const QString &seriesInstanceUID, qint64 sizeInBytes)
+{
+    m_lastSqliteError = sqlite3_exec(m_dbConnection->getConnection(), buildSqlUpdateSizeInBytes(seriesInstanceUID, sizeInBytes).toUtf8().constData(),
+                                     0, 0, 0);
+
+    if (getLastError() != SQLITE_OK)
+    {
+        logError(buildSqlUpdateSizeInBytes(seriesInstanceUID, sizeInBytes));
+    }
+}
+
 QList<Series*> LocalDatabaseSeriesDAL::query(const DicomMask &seriesMask)
+{
+    return querySeries(buildSqlSelect(seriesMask), false);
+}
+
+QList<Series*> LocalDatabaseSeriesDAL::queryWithNumberOfImages(const DicomMask &seriesMask)
+{
+    return querySeries(buildSqlSelectWithNumberOfImages(seriesMask), true);
+}
+
+QList<Series*> LocalDatabaseSeriesDAL::querySeries(const QString &sqlSelect, bool withNumberOfImages)
 {
     int columns;
     int rows;
@@ -67,20 +117,25 @@ QList<Series*> LocalDatabaseSeriesDAL::query(const DicomMask &seriesMask)
     char **error = NULL;
     QList<Series*> seriesList;
 
-    m_lastSqliteError = sqlite3_get_table(m_dbConnection->getConnection(),
-                                          buildSqlSelect(seriesMask).toUtf8().constData(),
-                                          &reply, &rows, &columns, error);
+    m_lastSqliteError = sqlite3_get_table(m_dbConnection->getConnection(), sqlSelect.toUtf8().constData(), &reply, &rows, &columns, error);
 
     if (getLastError() != SQLITE_OK)
     {
-        logError (buildSqlSelect(seriesMask));
+        logError(sqlSelect);
         return seriesList;
     }
 
     // index = 1 ignorem les capçaleres
     for (int index = 1; index <= rows; index++)
     {
-        seriesList.append(fillSeries(reply, index, columns));
+        Series *series = fillSeries(reply, index, columns);
+
+        if (withNumberOfImages)
+        {
+            series->setNumberOfImages(QString(reply[columns - 1 + index * columns]).toInt());
+        }
+
+        seriesList.append(series);
     }
 
     sqlite3_free_table(reply);
@@ -129,81 +184,58 @@ QString LocalDatabaseSeriesDAL::buildSqlSelect(const DicomMask &seriesMaskToSele
     return selectSentence + buildWhereSentence(seriesMaskToSelect);
 }
 
-QString LocalDatabaseSeriesDAL::buildSqlInsert(Series *newSeries)
+QString LocalDatabaseSeriesDAL::buildSqlSelectWithNumberOfImages(const DicomMask &seriesMaskToSelect)
 {
-    QString insertSentence = QString ("Insert into Series   (InstanceUID, StudyInstanceUID, Number, Modality, Date, Time, "
-                                                            "InstitutionName, PatientPosition, ProtocolName, Description, "
-                                                            "FrameOfReferenceUID, PositionReferenceIndicator, BodyPartExaminated, ViewPosition, "
-                                                            "Manufacturer, Laterality, RetrievedDate, RetrievedTime, State) "
-                                                    "values ('%1', '%2', '%3', '%4', '%5', '%6', "
-                                                            "'%7', '%8', '%9', '%10', "
-                                                            "'%11', '%12', '%13', '%14', "
-                                                            "'%15', '%16', '%17', '%18', %19)")
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getInstanceUID()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getParentStudy()->getInstanceUID()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getSeriesNumber()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getModality()))
-                                    .arg(newSeries->getDate().toString("yyyyMMdd"))
-                                    .arg(newSeries->getTime().toString("hhmmss"))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getInstitutionName()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getPatientPosition()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getProtocolName()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getDescription()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getFrameOfReferenceUID()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getPositionReferenceIndicator()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getBodyPartExamined()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getViewPosition()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getManufacturer()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(newSeries->getLaterality()))
-                                    .arg(newSeries->getRetrievedDate().toString("yyyyMMdd"))
-                                    .arg(newSeries->getRetrievedTime().toString("hhmmss"))
-                                    .arg("0");
-
-    return insertSentence;
-}
-
-QString LocalDatabaseSeriesDAL::buildSqlUpdate(Series *seriesToUpdate)
+    // Les imatges es compten agrupant-les per sèrie en una subconsulta filtrada amb els mateixos UID que les sèries, així sqlite només recorre les
+    // imatges de l'estudi. Amb el left join les sèries sense imatges també es retornen, amb 0 imatges
+    QString imageWhereSentence;
+
+    if (!seriesMaskToSelect.getStudyInstanceUID().isEmpty())
+    {
+        imageWhereSentence = QString("Where StudyInstanceUID = '%1' ")
+            .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesMaskToSelect.getStudyInstanceUID()));
+    }
+
+    if (!seriesMaskToSelect.getSeriesInstanceUID().isEmpty())
+    {
+        imageWhereSentence += imageWhereSentence.isEmpty() ? "Where " : "and ";
+        imageWhereSentence += QString("SeriesInstanceUID = '%1' ")
+            .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesMaskToSelect.getSeriesInstanceUID()));
+    }
+
+    QString selectSentence = "Select InstanceUID, StudyInstanceUID, Number, Modality, Date, Time, InstitutionName, "
+                                    "PatientPosition, ProtocolName, Description, FrameOfReferenceUID, PositionReferenceIndicator, "
+                                    "BodyPartExaminated, ViewPosition,  Manufacturer, Laterality, RetrievedDate, "
+                                    "RetrievedTime, State, ifnull(ImageCount.NumberOfImages, 0) "
+                              "From Series left join (Select SeriesInstanceUID, count(*) as NumberOfImages "
+                                                     "From Image " + imageWhereSentence +
+                                                     "Group by SeriesInstanceUID) ImageCount "
+                                          "on ImageCount.SeriesInstanceUID = Series.InstanceUID ";
+
+    return selectSentence + buildWhereSentence(seriesMaskToSelect);
+}
+
+void LocalDatabaseSeriesDAL::bindSeries(sqlite3_stmt *statement, Series *series)
 {
-    QString updateSentence = QString ("Update Series Set StudyInstanceUID = '%1', "
-                                                        "Number = '%2', "
-                                                        "Modality = '%3', "
-                                                        "Date = '%4', "
-                                                        "Time = '%5', "
-                                                        "InstitutionName = '%6', "
-                                                        "PatientPosition = '%7', "
-                                                        "ProtocolName = '%8', "
-                                                        "Description = '%9', "
-                                                        "FrameOfReferenceUID = '%10', "
-                                                        "PositionReferenceIndicator = '%11', "
-                                                        "BodyPartExaminated = '%12', "
-                                                        "ViewPosition = '%13', "
-                                                        "Manufacturer = '%14', "
-                                                        "Laterality = '%15', "
-                                                        "RetrievedDate = '%16', "
-                                                        "RetrievedTime = '%17', "
-                                                        "State = %18 "
-                                                 "Where InstanceUID = '%19'")
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getParentStudy()->getInstanceUID()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getSeriesNumber()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getModality()))
-                                    .arg(seriesToUpdate->getDate().toString("yyyyMMdd"))
-                                    .arg(seriesToUpdate->getTime().toString("hhmmss"))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getInstitutionName()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getPatientPosition()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getProtocolName()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getDescription()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getFrameOfReferenceUID()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getPositionReferenceIndicator()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getBodyPartExamined()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getViewPosition()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getManufacturer()))
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getLaterality()))
-                                    .arg(seriesToUpdate->getRetrievedDate().toString("yyyyMMdd"))
-                                    .arg(seriesToUpdate->getRetrievedTime().toString("hhmmss"))
-                                    .arg("0")
-                                    .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesToUpdate->getInstanceUID()));
-
-    return updateSentence;
+    bindText(statement, 1, series->getInstanceUID());
+    bindText(statement, 2, series->getParentStudy()->getInstanceUID());
+    bindText(statement, 3, series->getSeriesNumber());
+    bindText(statement, 4, series->getModality());
+    bindText(statement, 5, series->getDate().toString("yyyyMMdd"));
+    bindText(statement, 6, series->getTime().toString("hhmmss"));
+    bindText(statement, 7, series->getInstitutionName());
+    bindText(statement, 8, series->getPatientPosition());
+    bindText(statement, 9, series->getProtocolName());
+    bindText(statement, 10, series->getDescription());
+    bindText(statement, 11, series->getFrameOfReferenceUID());
+    bindText(statement, 12, series->getPositionReferenceIndicator());
+    bindText(statement, 13, series->getBodyPartExamined());
+    bindText(statement, 14, series->getViewPosition());
+    bindText(statement, 15, series->getManufacturer());
+    bindText(statement, 16, DatabaseConnection::formatTextToValidSQLSyntax(series->getLaterality()));
+    bindText(statement, 17, series->getRetrievedDate().toString("yyyyMMdd"));
+    bindText(statement, 18, series->getRetrievedTime().toString("hhmmss"));
+    sqlite3_bind_int(statement, 19, 0);
 }
 
 QString LocalDatabaseSeriesDAL::buildSqlDelete(const DicomMask &seriesMaskToDelete)
@@ -211,6 +243,13 @@ QString LocalDatabaseSeriesDAL::buildSqlDelete(const DicomMask &seriesMaskToDele
     return "Delete From Series " + buildWhereSentence(seriesMaskToDelete);
 }
 
+QString LocalDatabaseSeriesDAL::buildSqlUpdateSizeInBytes(const QString &seriesInstanceUID, qint64 sizeInBytes)
+{
+    return QString("Update Series Set SizeInBytes = %1 Where InstanceUID = '%2'")
+            .arg(sizeInBytes)
+            .arg(DatabaseConnection::formatTextToValidSQLSyntax(seriesInstanceUID));
+}
+
 QString LocalDatabaseSeriesDAL::buildWhereSentence(const DicomMask &seriesMask)
 {
     QString whereSentence = "";
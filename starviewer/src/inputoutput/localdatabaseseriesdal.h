@@ -20,6 +20,8 @@
 #include "localdatabasebasedal.h"
 #include "series.h"
 
+struct sqlite3_stmt;
+
 namespace udg {
 
 class DicomMask;
@@ -44,22 +46,41 @@ public:
     /// Cerca les sèries que compleixen amb els criteris de la màscara de cerca, només té en compte l'StudyUID i el SeriesUID
     QList<Series*> query(const DicomMask &seriesMaskToQuery);
 
+    /// Cerca les sèries que compleixen amb els criteris de la màscara de cerca, només té en compte l'StudyUID i el SeriesUID, i n'omple el número
+    /// d'imatges. El recompte es fa agrupant les imatges per sèrie en la mateixa sentència, en comptes de fer una consulta per cada sèrie
+    QList<Series*> queryWithNumberOfImages(const DicomMask &seriesMaskToQuery);
+
+    /// Guarda quants bytes ocupen a disc els fitxers de la sèrie
+    void updateSizeInBytes(const QString &seriesInstanceUID, qint64 sizeInBytes);
+
 private:
-    /// Construeix la sentència sql per inserir la nova sèrie
-    QString buildSqlInsert(Series *newSeries);
+    /// Sentències preparades per inserir i updatar sèries
+    static const QString SqlInsert;
+    static const QString SqlUpdate;
 
-    /// Construeix la sentència updata la sèrie
-    QString buildSqlUpdate(Series *seriesToUpdate);
+    /// Assigna els valors de la sèrie als paràmetres de la sentència preparada d'insert o d'update
+    void bindSeries(sqlite3_stmt *statement, Series *series);
 
     /// Construeix la setència per fer select de sèries a partir de la màscara, només té en compte el StudyUID, i SeriesUID
     QString buildSqlSelect(const DicomMask &seriesMaskToSelect);
 
+    /// Construeix la sentència per fer select de sèries juntament amb el seu número d'imatges a partir de la màscara, només té en compte el StudyUID,
+    /// i SeriesUID
+    QString buildSqlSelectWithNumberOfImages(const DicomMask &seriesMaskToSelect);
+
     /// Construeix la setència per esborrar sèries a partir de la màscara, només té en compte el StudyUID, i SeriesUID
     QString buildSqlDelete(const DicomMask &seriesMaskToDelete);
 
+    /// Construeix la sentència per guardar la mida en bytes de la sèrie
+    QString buildSqlUpdateSizeInBytes(const QString &seriesInstanceUID, qint64 sizeInBytes);
+
     /// Construeix la sentència del where tenint en compte la màscara, només té en compte el StudyUID, i SeriesUID
     QString buildWhereSentence(const DicomMask &seriesMask);
 
+    /// Executa la sentència de select passada i retorna les sèries obtingudes. Si withNumberOfImages és cert, la última columna ha de ser el número
+    /// d'imatges de la sèrie
+    QList<Series*> querySeries(const QString &sqlSelect, bool withNumberOfImages);
+
     /// Emplena un l'objecte series de la fila passada per paràmetre
     Series* fillSeries(char **reply, int row, int columns);
 };
@@ -176,6 +176,45 @@ qlonglong LocalDatabaseStudyDAL::getPatientIDFromStudyInstanceUID(const QString
     return patientID;
 }
 
+void LocalDatabaseStudyDAL::updateSizeInBytesFromSeries(const QString &studyInstanceUID)
+{
+    m_lastSqliteError = sqlite3_exec(m_dbConnection->getConnection(), buildSqlUpdateSizeInBytesFromSeries(studyInstanceUID).toUtf8().constData(), 0, 0, 0);
+
+    if (getLastError() != SQLITE_OK)
+    {
+        logError(buildSqlUpdateSizeInBytesFromSeries(studyInstanceUID));
+    }
+}
+
+QList<QPair<QString, qint64> > LocalDatabaseStudyDAL::querySizeInBytesOrderByLastAccessDate()
+{
+    int columns;
+    int rows;
+    char **reply = NULL;
+    char **error = NULL;
+    QList<QPair<QString, qint64> > studiesSize;
+    QString sqlSelect = "Select InstanceUID, SizeInBytes From Study Order by LastAccessDate";
+
+    m_lastSqliteError = sqlite3_get_table(m_dbConnection->getConnection(), sqlSelect.toUtf8().constData(), &reply, &rows, &columns, error);
+
+    if (getLastError() != SQLITE_OK)
+    {
+        logError(sqlSelect);
+        return studiesSize;
+    }
+
+    // A la row 0 hi ha el header
+    for (int index = 1; index <= rows; index++)
+    {
+        const char *sizeInBytes = reply[index * columns + 1];
+        studiesSize.append(qMakePair(QString(reply[index * columns]), sizeInBytes ? QString(sizeInBytes).toLongLong() : qint64(-1)));
+    }
+
+    sqlite3_free_table(reply);
+
+    return studiesSize;
+}
+
 Study* LocalDatabaseStudyDAL::fillStudy(char **reply, int row, int columns)
 {
     Study *study = new Study();
@@ -319,6 +358,15 @@ QString LocalDatabaseStudyDAL::buildSqlSelectStudyPatient(const DicomMask &study
     return selectSentence + whereSentence + orderBySentence;
 }
 
+QString LocalDatabaseStudyDAL::buildSqlUpdateSizeInBytesFromSeries(const QString &studyInstanceUID)
+{
+    // Count(SizeInBytes) no compta els valors nuls, així si alguna sèrie no té la mida la suma és nul·la en comptes de quedar curta
+    return QString("Update Study Set SizeInBytes = (Select Case When Count(SizeInBytes) = Count(*) Then Sum(SizeInBytes) End "
+                   "From Series Where StudyInstanceUID = '%1') "
+                   "Where InstanceUID = '%1'")
+            .arg(DatabaseConnection::formatTextToValidSQLSyntax(studyInstanceUID));
+}
+
 QString LocalDatabaseStudyDAL::buildSqlGetPatientIDFromStudyInstanceUID(const QString &studyInstanceUID)
 {
     QString selectSentence = QString ("Select PatientID "
@@ -16,6 +16,7 @@
 #define UDGLOCALDATABASESTUDY_H
 
 #include <QList>
+#include <QPair>
 
 #include "localdatabasebasedal.h"
 #include "study.h"
@@ -59,6 +60,13 @@ public:
     /// retorna -1
     qlonglong getPatientIDFromStudyInstanceUID(const QString &studyInstanceUID);
 
+    /// Guarda com a mida en bytes de l'estudi la suma de les mides de les seves sèries. Si alguna sèrie no té la mida guardada, l'estudi tampoc en tindrà
+    void updateSizeInBytesFromSeries(const QString &studyInstanceUID);
+
+    /// Retorna l'UID i la mida en bytes de tots els estudis ordenats per LastAccessDate de manera creixent. Els estudis que no tenen la mida guardada,
+    /// perquè es van descarregar amb una versió anterior de la base de dades, tenen mida -1
+    QList<QPair<QString, qint64> > querySizeInBytesOrderByLastAccessDate();
+
 private:
     /// Construeix la sentència sql per inserir el nou estudi
     QString buildSqlInsert(Study *newStudy, const QDate &lastAcessDate);
@@ -79,6 +87,9 @@ private:
     /// Retorna la sentència per buscar el pacient d'un estudi a partir del Study Instance UID
     QString buildSqlGetPatientIDFromStudyInstanceUID(const QString &studyInstanceUID);
 
+    /// Construeix la sentència per guardar la mida en bytes de l'estudi a partir de la de les seves sèries
+    QString buildSqlUpdateSizeInBytesFromSeries(const QString &studyInstanceUID);
+
     /// Emplena un l'objecte Study de la fila passada per paràmetre
     Study* fillStudy(char **reply, int row, int columns);
 
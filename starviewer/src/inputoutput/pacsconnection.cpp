@@ -254,8 +254,7 @@ bool PACSConnection::connectToPACS(PACSServiceToRequest pacsServiceToRequest)
         ERROR_LOG("S'ha produit un error al intentar connectar amb el PACS. AE Title: " + m_pacs.getAETitle() + ", adreca: " +
             constructPacsServerAddress(pacsServiceToRequest, m_pacs) + ". Descripcio error: " + QString(condition.text()));
 
-        // Si no hem pogut connectar al PACS i és una descàrrega haurem obert el port per rebre connexions entrants DICOM, com no que podrem descarregar
-        // les imatges perquè no hem pogut connectar amb el PACS per sol·licitar-ne la descarrega, tanquem el port local que espera per connexions entrants.
+        // Si no hem pogut connectar al PACS per sol·licitar-ne la descàrrega alliberem la connexió i la xarxa
         if (pacsServiceToRequest == RetrieveDICOMFiles)
         {
             disconnect();
@@ -329,14 +328,15 @@ QString PACSConnection::constructPacsServerAddress(PACSServiceToRequest pacsServ
 
 T_ASC_Network* PACSConnection::initializeAssociationNetwork(PACSServiceToRequest pacsServiceToRequest)
 {
+    Q_UNUSED(pacsServiceToRequest);
+
     Settings settings;
-    // Si no es tracta d'una descarrega indiquem port 0
-    int networkPort = pacsServiceToRequest == RetrieveDICOMFiles ? settings.getValue(InputOutputSettings::IncomingDICOMConnectionsPort).toInt() : 0;
+    // Totes les connexions són de sortida, en les descàrregues el port de connexions entrants l'obre IncomingDICOMConnectionsDispatcher perquè el
+    // puguin compartir diverses descàrregues, per això indiquem port 0
     int timeout = settings.getValue(InputOutputSettings::PACSConnectionTimeout).toInt();
-    T_ASC_NetworkRole networkRole = pacsServiceToRequest == RetrieveDICOMFiles ? NET_ACCEPTORREQUESTOR : NET_REQUESTOR;
     T_ASC_Network *associationNetwork;
 
-    OFCondition condition = ASC_initializeNetwork(networkRole, networkPort, timeout, &associationNetwork);
+    OFCondition condition = ASC_initializeNetwork(NET_REQUESTOR, 0, timeout, &associationNetwork);
     if (!condition.good())
     {
         ERROR_LOG("No s'ha pogut inicialitzar l'objecte network, despripcio error" + QString(condition.text()));
@@ -50,7 +50,8 @@ public:
     /// @return retorna una connexió de PACS
     T_ASC_Association* getConnection();
 
-    /// Retorna una configuració de xarxa. Només és necessària quan l'objectiu de la connexió sigui el de descarregar imatges
+    /// Retorna la configuració de xarxa de la connexió. En les descàrregues, la xarxa que escolta el port de connexions entrants és la
+    /// d'IncomingDICOMConnectionsDispatcher
     /// @return retorna la configuració de la xarxa
     T_ASC_Network* getNetwork();
 
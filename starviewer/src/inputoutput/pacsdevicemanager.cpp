@@ -238,6 +238,7 @@ Settings::SettingsListItemType PacsDeviceManager::pacsDeviceToSettingsListItem(c
     item["QueryRetrieveServiceEnabled"] = pacsDevice.isQueryRetrieveServiceEnabled();
     item["StoreServiceEnabled"] = pacsDevice.isStoreServiceEnabled();
     item["StoreServicePort"] = QString::number(pacsDevice.getStoreServicePort());
+    item["StoreServiceAssociations"] = QString::number(pacsDevice.getNumberOfStoreServiceAssociations());
 
     return item;
 }
@@ -290,6 +291,12 @@ PacsDevice PacsDeviceManager::settingsListItemToPacsDevice(const Settings::Setti
         }
     }
 
+    // Els PACS guardats abans que es poguessin enviar imatges per diverses associacions només en fan servir una
+    if (item.contains("StoreServiceAssociations"))
+    {
+        pacsDevice.setNumberOfStoreServiceAssociations(item.value("StoreServiceAssociations").toInt());
+    }
+
     return pacsDevice;
 }
 };
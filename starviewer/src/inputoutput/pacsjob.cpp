@@ -72,7 +72,8 @@ void PACSJob::defaultBegin(const ThreadWeaver::JobPointer &job, ThreadWeaver::Th
 
 void PACSJob::defaultEnd(const ThreadWeaver::JobPointer &job, ThreadWeaver::Thread *thread)
 {
-    Q_UNUSED(thread)
+    // Allibera els recursos de les polítiques de la cua, perquè es puguin executar els altres jobs que les comparteixen
+    ThreadWeaver::Job::defaultEnd(job, thread);
 
     if (!m_abortIsRequested)
     {
@@ -23,6 +23,9 @@
 #include "querypacsjob.h"
 #include "pacsjob.h"
 #include "inputoutputsettings.h"
+#include "incomingdicomconnectionsdispatcher.h"
+#include "retrievedicomfilesfrompacsjob.h"
+#include "study.h"
 
 namespace udg {
 
@@ -47,8 +50,17 @@ PacsManager::PacsManager()
     m_sendDICOMFilesToPACSQueue->setMaximumNumberOfThreads(settings.getValue(InputOutputSettings::MaximumPACSConnections).toInt());
 
     m_retrieveDICOMFilesFromPACSQueue = new ThreadWeaver::Queue();
-    // Només podem descarregar un estudi a la vegada del PACS, per això com a número màxim de threads especifiquem 1
-    m_retrieveDICOMFilesFromPACSQueue ->setMaximumNumberOfThreads(1);
+    // Per defecte només es descarrega un estudi a la vegada. Les descàrregues simultànies comparteixen el port de connexions entrants a través
+    // d'IncomingDICOMConnectionsDispatcher, que reparteix les subassociacions entre elles
+    int maximumConcurrentRetrieves = settings.getValue(InputOutputSettings::MaximumConcurrentRetrieves).toInt();
+    if (maximumConcurrentRetrieves < 1)
+    {
+        ERROR_LOG("El nombre maxim de descarregues simultanies ha de ser mes gran de 0, en farem una a la vegada");
+        maximumConcurrentRetrieves = 1;
+    }
+    m_retrieveDICOMFilesFromPACSQueue->setMaximumNumberOfThreads(maximumConcurrentRetrieves);
+    // Singleton no és thread-safe, creem el dispatcher abans que el facin servir els threads de descàrrega
+    IncomingDICOMConnectionsDispatcher::instance();
 }
 
 void PacsManager::enqueuePACSJob(PACSJobPointer pacsJob)
@@ -61,6 +73,8 @@ void PacsManager::enqueuePACSJob(PACSJobPointer pacsJob)
             m_sendDICOMFilesToPACSQueue->enqueue(pacsJob);
             break;
         case PACSJob::RetrieveDICOMFilesFromPACSJobType:
+            assignRetrievePerPACSPolicy(pacsJob);
+            assignRetrievePerStudyPolicy(pacsJob);
             m_retrieveDICOMFilesFromPACSQueue->enqueue(pacsJob);
             break;
         case PACSJob::QueryPACS:
@@ -141,6 +155,81 @@ void PacsManager::requestCancelAllPACSJobs()
     m_queryQueue->requestAbort();
 }
 
+void PacsManager::assignRetrievePerPACSPolicy(PACSJobPointer pacsJob)
+{
+    // La cua continua triant els jobs per prioritat, la política només fa que se salti els dels PACS que ja tenen el màxim de descàrregues en curs
+    PacsDevice pacsDevice = pacsJob->getPacsDevice();
+    // Els PACS que no són a la llista de PACS configurats no tenen ID, els identifiquem per l'adreça
+    QString pacsID = pacsDevice.getID().isEmpty() ? pacsDevice.getAETitle() + "@" + pacsDevice.getAddress() : pacsDevice.getID();
+    ThreadWeaver::ResourceRestrictionPolicy *policy = m_retrievePerPACSPolicies.value(pacsID);
+
+    if (!policy)
+    {
+        int maximumConcurrentRetrievesPerPACS = Settings().getValue(InputOutputSettings::MaximumConcurrentRetrievesPerPACS).toInt();
+        if (maximumConcurrentRetrievesPerPACS < 1)
+        {
+            ERROR_LOG("El nombre maxim de descarregues simultanies d'un PACS ha de ser mes gran de 0, en farem una a la vegada");
+            maximumConcurrentRetrievesPerPACS = 1;
+        }
+
+        policy = new ThreadWeaver::ResourceRestrictionPolicy(maximumConcurrentRetrievesPerPACS);
+        m_retrievePerPACSPolicies.insert(pacsID, policy);
+    }
+
+    pacsJob->assignQueuePolicy(policy);
+}
+
+void PacsManager::assignRetrievePerStudyPolicy(PACSJobPointer pacsJob)
+{
+    // Dues descàrregues del mateix estudi escriuen al mateix directori, i si una falla en pot esborrar els fitxers que l'altra està descarregant,
+    // per això les descàrregues d'un mateix estudi es fan una després de l'altra
+    QSharedPointer<RetrieveDICOMFilesFromPACSJob> retrieveJob = pacsJob.objectCast<RetrieveDICOMFilesFromPACSJob>();
+    if (!retrieveJob || !retrieveJob->getStudyToRetrieveDICOMFiles())
+    {
+        return;
+    }
+
+    QString studyInstanceUID = retrieveJob->getStudyToRetrieveDICOMFiles()->getInstanceUID();
+    ThreadWeaver::ResourceRestrictionPolicy *policy = m_retrievePerStudyPolicies.value(studyInstanceUID);
+
+    if (!policy)
+    {
+        policy = new ThreadWeaver::ResourceRestrictionPolicy(1);
+        m_retrievePerStudyPolicies.insert(studyInstanceUID, policy);
+    }
+
+    pacsJob->assignQueuePolicy(policy);
+    m_retrieveJobsStudyInstanceUIDs.insert(pacsJob->getPACSJobID(), studyInstanceUID);
+
+    // Els signals s'emeten des del thread del job o des de la desencuada, la política s'allibera després des del thread de la PacsManager
+    connect(pacsJob.data(), SIGNAL(PACSJobFinished(PACSJobPointer)), SLOT(releaseRetrievePerStudyPolicy(PACSJobPointer)), Qt::QueuedConnection);
+    connect(pacsJob.data(), SIGNAL(PACSJobCancelled(PACSJobPointer)), SLOT(releaseRetrievePerStudyPolicy(PACSJobPointer)), Qt::QueuedConnection);
+}
+
+void PacsManager::releaseRetrievePerStudyPolicy(PACSJobPointer pacsJob)
+{
+    if (!pacsJob || !m_retrieveJobsStudyInstanceUIDs.contains(pacsJob->getPACSJobID()))
+    {
+        return;
+    }
+
+    QString studyInstanceUID = m_retrieveJobsStudyInstanceUIDs.take(pacsJob->getPACSJobID());
+    ThreadWeaver::ResourceRestrictionPolicy *policy = m_retrievePerStudyPolicies.value(studyInstanceUID);
+    if (!policy)
+    {
+        return;
+    }
+
+    // El job avisa la política quan es destrueix, per tant no l'ha de tenir assignada si s'esborra
+    pacsJob->removeQueuePolicy(policy);
+
+    if (!m_retrieveJobsStudyInstanceUIDs.values().contains(studyInstanceUID))
+    {
+        m_retrievePerStudyPolicies.remove(studyInstanceUID);
+        delete policy;
+    }
+}
+
 bool PacsManager::waitForAllPACSJobsFinished(int msec)
 {
     if (!isExecutingPACSJob())
@@ -19,6 +19,7 @@
 #include <QList>
 #include <QHash>
 #include <ThreadWeaver/Queue>
+#include <ThreadWeaver/ResourceRestrictionPolicy>
 
 #include "patient.h"
 #include "pacsdevice.h"
@@ -77,10 +78,29 @@ signals:
     /// Signal que indica que ens han demanat cancel·lar un PACSJob
     void requestedCancelPACSJob(PACSJobPointer pacsJob);
 
+private slots:
+    /// Treu la política per estudi del job de descàrrega que ha acabat o s'ha cancel·lat, i l'esborra si no queda cap altra descàrrega de l'estudi
+    void releaseRetrievePerStudyPolicy(PACSJobPointer pacsJob);
+
+private:
+    /// Assigna al job de descàrrega la política que limita el nombre de descàrregues simultànies del seu PACS
+    void assignRetrievePerPACSPolicy(PACSJobPointer pacsJob);
+    /// Assigna al job de descàrrega la política que fa que les descàrregues d'un mateix estudi no es facin simultàniament
+    void assignRetrievePerStudyPolicy(PACSJobPointer pacsJob);
+
 private:
     ThreadWeaver::Queue *m_queryQueue;
     ThreadWeaver::Queue *m_sendDICOMFilesToPACSQueue;
     ThreadWeaver::Queue *m_retrieveDICOMFilesFromPACSQueue;
+
+    /// Polítiques que limiten les descàrregues simultànies de cada PACS, indexades per l'ID del PACS. Com la PacsManager, no es destrueixen mai perquè
+    /// els jobs encuats hi poden fer referència.
+    QHash<QString, ThreadWeaver::ResourceRestrictionPolicy*> m_retrievePerPACSPolicies;
+    /// Polítiques que eviten les descàrregues simultànies d'un mateix estudi, indexades pel Study Instance UID. Es creen amb la primera descàrrega
+    /// pendent de l'estudi i s'esborren quan acaba o es cancel·la l'última.
+    QHash<QString, ThreadWeaver::ResourceRestrictionPolicy*> m_retrievePerStudyPolicies;
+    /// Study Instance UID de les descàrregues que tenen assignada una política per estudi, indexat per l'ID del job
+    QHash<int, QString> m_retrieveJobsStudyInstanceUIDs;
 };
 
 };  //  end  namespace udg
@@ -0,0 +1,80 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "pipelinestagemetrics.h"
+
+#include <QMutexLocker>
+
+namespace udg {
+
+PipelineStageMetrics::PipelineStageMetrics(const QString &name)
+ : m_name(name), m_numberOfProcessedItems(0), m_processingMilliseconds(0), m_blockedMilliseconds(0), m_maximumQueueSize(0)
+{
+}
+
+PipelineStageMetrics::~PipelineStageMetrics()
+{
+}
+
+void PipelineStageMetrics::addProcessedItem(int processingMilliseconds)
+{
+    QMutexLocker locker(&m_mutex);
+    m_numberOfProcessedItems++;
+    m_processingMilliseconds += processingMilliseconds;
+}
+
+void PipelineStageMetrics::addBlockedTime(int blockedMilliseconds)
+{
+    QMutexLocker locker(&m_mutex);
+    m_blockedMilliseconds += blockedMilliseconds;
+}
+
+void PipelineStageMetrics::updateQueueSize(int queueSize)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maximumQueueSize = qMax(m_maximumQueueSize, queueSize);
+}
+
+int PipelineStageMetrics::getNumberOfProcessedItems() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_numberOfProcessedItems;
+}
+
+qint64 PipelineStageMetrics::getProcessingMilliseconds() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_processingMilliseconds;
+}
+
+qint64 PipelineStageMetrics::getBlockedMilliseconds() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_blockedMilliseconds;
+}
+
+int PipelineStageMetrics::getMaximumQueueSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maximumQueueSize;
+}
+
+QString PipelineStageMetrics::toString() const
+{
+    QMutexLocker locker(&m_mutex);
+    return QString("%1: %2 elements processats en %3 ms, cua maxima %4, etapa anterior bloquejada %5 ms").arg(m_name).arg(m_numberOfProcessedItems)
+        .arg(m_processingMilliseconds).arg(m_maximumQueueSize).arg(m_blockedMilliseconds);
+}
+
+}
@@ -0,0 +1,63 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGPIPELINESTAGEMETRICS_H
+#define UDGPIPELINESTAGEMETRICS_H
+
+#include <QMutex>
+#include <QString>
+
+namespace udg {
+
+/**
+    Mètriques d'una etapa de la cadena de processament dels fitxers descarregats: quants elements ha processat i quant hi ha trigat, quants n'ha
+    arribat a tenir a la cua i quant temps ha estat bloquejada l'etapa anterior esperant que hi hagués lloc a la cua.
+    Es pot actualitzar des de diversos threads.
+  */
+class PipelineStageMetrics {
+public:
+    PipelineStageMetrics(const QString &name);
+    ~PipelineStageMetrics();
+
+    /// Comptabilitza un element processat en processingMilliseconds
+    void addProcessedItem(int processingMilliseconds);
+    /// Comptabilitza el temps que l'etapa anterior ha estat esperant lloc a la cua
+    void addBlockedTime(int blockedMilliseconds);
+    /// Actualitza la mida màxima de la cua amb la mida actual
+    void updateQueueSize(int queueSize);
+
+    /// Retorna el nombre d'elements processats
+    int getNumberOfProcessedItems() const;
+    /// Retorna el temps total de processament en mil·lisegons
+    qint64 getProcessingMilliseconds() const;
+    /// Retorna el temps total que l'etapa anterior ha estat bloquejada en mil·lisegons
+    qint64 getBlockedMilliseconds() const;
+    /// Retorna la mida màxima que ha tingut la cua
+    int getMaximumQueueSize() const;
+
+    /// Retorna les mètriques en una línia de text per al log
+    QString toString() const;
+
+private:
+    QString m_name;
+    int m_numberOfProcessedItems;
+    qint64 m_processingMilliseconds;
+    qint64 m_blockedMilliseconds;
+    int m_maximumQueueSize;
+    mutable QMutex m_mutex;
+};
+
+}
+
+#endif
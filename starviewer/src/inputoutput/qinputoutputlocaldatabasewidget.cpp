@@ -30,6 +30,7 @@
 #include "retrievedicomfilesfrompacsjob.h"
 #include "shortcutmanager.h"
 #include "usermessage.h"
+#include "cacheevictionservice.h"
 
 namespace udg {
 
@@ -64,6 +65,9 @@ QInputOutputLocalDatabaseWidget::QInputOutputLocalDatabaseWidget(QWidget *parent
     //ATENCIÓ!S'ha de fer després del createConnections perquè sinó no haurem connectat amb el signal per control els errors al esborrar estudis
     //TODO: Això s'hauria de moure fora d'aquí no ha de ser responsabilitat d'aquesta classe
     deleteOldStudies();
+
+    // Comprovem ara si cal alliberar espai de la caché, sense esperar que acabi la primera descàrrega
+    CacheEvictionService::instance()->requestCheck();
 }
 
 QInputOutputLocalDatabaseWidget::~QInputOutputLocalDatabaseWidget()
@@ -96,6 +100,8 @@ void QInputOutputLocalDatabaseWidget::createConnections()
 
     // Connecta amb el signal que indica que ha finalitza el thread d'esborrar els estudis vells
     connect(&m_qdeleteOldStudiesThread, SIGNAL(finished()), SLOT(deleteOldStudiesThreadFinished()));
+    // Els estudis que esborra el servei d'alliberar espai de la caché s'han de treure de la llista
+    connect(CacheEvictionService::instance(), SIGNAL(studyWillBeDeleted(QString)), SLOT(removeStudyFromQStudyTreeWidget(QString)));
 
     /// Si movem el QSplitter capturem el signal per guardar la seva posició
     connect(m_StudyTreeSeriesListQSplitter, SIGNAL(splitterMoved (int, int)), SLOT(qSplitterPositionChanged()));
@@ -256,9 +262,11 @@ void QInputOutputLocalDatabaseWidget::setSeriesToSeriesListWidget(Study *current
         return;
     }
 
+    // Els thumbnails es llegeixen en segon pla perquè la llista de sèries es mostri de seguida
     foreach (Series *series, seriesList)
     {
-        m_seriesThumbnailPreviewWidget->insertSeries(currentStudy->getInstanceUID(), series);
+        m_seriesThumbnailPreviewWidget->insertSeries(currentStudy->getInstanceUID(), series,
+                                                     localDatabaseManager.getSeriesThumbnailPath(currentStudy->getInstanceUID(), series));
     }
 
     qDeleteAll(seriesList);
@@ -14,12 +14,34 @@
 
 #include "qseriesthumbnailpreviewwidget.h"
 
+#include <QFileInfo>
+#include <QPixmap>
 #include <QString>
+#include <QtConcurrentRun>
 
 #include "series.h"
+#include "thumbnailservice.h"
 
 namespace udg {
 
+namespace {
+
+// Llegeix el thumbnail del fitxer indicat, retorna una imatge nul·la si no existeix o no es pot llegir. Es fa servir QImage perquè QPixmap només es
+// pot fer servir des del thread de la interfície
+QImage readThumbnailFile(const QString &thumbnailFilePath)
+{
+    QImage thumbnail;
+
+    if (QFileInfo(thumbnailFilePath).exists())
+    {
+        thumbnail.load(thumbnailFilePath);
+    }
+
+    return thumbnail;
+}
+
+}
+
 QSeriesThumbnailPreviewWidget::QSeriesThumbnailPreviewWidget(QWidget *parent)
     : QWidget(parent)
 {
@@ -30,7 +52,7 @@ QSeriesThumbnailPreviewWidget::QSeriesThumbnailPreviewWidget(QWidget *parent)
     createConnections();
 }
 
-void QSeriesThumbnailPreviewWidget::insertSeries(QString studyInstanceUID, Series *series)
+void QSeriesThumbnailPreviewWidget::insertSeries(QString studyInstanceUID, Series *series, const QString &thumbnailFilePath)
 {
     QString seriesThumbnailDescription = getSeriesThumbnailDescription(series);
     m_studyInstanceUIDBySeriesInstanceUID[series->getInstanceUID()] = studyInstanceUID;
@@ -46,10 +68,17 @@ void QSeriesThumbnailPreviewWidget::insertSeries(QString studyInstanceUID, Serie
         m_positionOfLastInsertedThumbnail++;
         m_seriesThumbnailsPreviewWidget->insert(m_positionOfLastInsertedThumbnail, series->getInstanceUID(), series->getThumbnail(), seriesThumbnailDescription);
     }
+
+    if (!thumbnailFilePath.isEmpty())
+    {
+        m_thumbnailFilePathBySeriesInstanceUID[series->getInstanceUID()] = thumbnailFilePath;
+        loadSeriesThumbnail(series->getInstanceUID(), thumbnailFilePath);
+    }
 }
 
 void QSeriesThumbnailPreviewWidget::removeSeries(const QString &seriesInstanceUID)
 {
+    m_thumbnailFilePathBySeriesInstanceUID.remove(seriesInstanceUID);
     m_seriesThumbnailsPreviewWidget->remove(seriesInstanceUID);
 }
 
@@ -60,8 +89,10 @@ void QSeriesThumbnailPreviewWidget::setCurrentSeries(const QString &seriesUID)
 
 void QSeriesThumbnailPreviewWidget::clear()
 {
+    cancelPendingThumbnailLoads();
     m_seriesThumbnailsPreviewWidget->clear();
     m_studyInstanceUIDBySeriesInstanceUID.clear();
+    m_thumbnailFilePathBySeriesInstanceUID.clear();
     // Indiquem que la última imatge insertada està a la posició 0 perquè hem un clear
     m_positionOfLastInsertedThumbnail = -1;
 }
@@ -70,6 +101,54 @@ void QSeriesThumbnailPreviewWidget::createConnections()
 {
     connect(m_seriesThumbnailsPreviewWidget, SIGNAL(thumbnailClicked(QString)), this, SLOT(seriesClicked(QString)));
     connect(m_seriesThumbnailsPreviewWidget, SIGNAL(thumbnailDoubleClicked(QString)), this, SLOT(seriesDoubleClicked(QString)));
+    // Els thumbnails de les sèries acabades de descarregar o importar poden no estar creats encara quan es mostren
+    connect(ThumbnailService::instance(), SIGNAL(thumbnailReady(QString, int)), this, SLOT(thumbnailCreated(QString)));
+}
+
+void QSeriesThumbnailPreviewWidget::loadSeriesThumbnail(const QString &seriesInstanceUID, const QString &thumbnailFilePath)
+{
+    QFutureWatcher<QImage> *thumbnailLoad = new QFutureWatcher<QImage>(this);
+    m_seriesInstanceUIDByThumbnailLoad.insert(thumbnailLoad, seriesInstanceUID);
+    connect(thumbnailLoad, SIGNAL(finished()), SLOT(seriesThumbnailLoaded()));
+    thumbnailLoad->setFuture(QtConcurrent::run(readThumbnailFile, thumbnailFilePath));
+}
+
+void QSeriesThumbnailPreviewWidget::cancelPendingThumbnailLoads()
+{
+    // Les lectures ja començades no es poden aturar, però en esborrar els watchers el seu resultat es descarta
+    foreach (QFutureWatcher<QImage> *thumbnailLoad, m_seriesInstanceUIDByThumbnailLoad.keys())
+    {
+        thumbnailLoad->disconnect(this);
+        thumbnailLoad->deleteLater();
+    }
+    m_seriesInstanceUIDByThumbnailLoad.clear();
+}
+
+void QSeriesThumbnailPreviewWidget::seriesThumbnailLoaded()
+{
+    QFutureWatcher<QImage> *thumbnailLoad = static_cast<QFutureWatcher<QImage>*>(sender());
+
+    if (!m_seriesInstanceUIDByThumbnailLoad.contains(thumbnailLoad))
+    {
+        return;
+    }
+
+    QString seriesInstanceUID = m_seriesInstanceUIDByThumbnailLoad.take(thumbnailLoad);
+    QImage thumbnail = thumbnailLoad->result();
+    thumbnailLoad->deleteLater();
+
+    if (!thumbnail.isNull())
+    {
+        m_seriesThumbnailsPreviewWidget->setThumbnail(seriesInstanceUID, QPixmap::fromImage(thumbnail));
+    }
+}
+
+void QSeriesThumbnailPreviewWidget::thumbnailCreated(const QString &seriesInstanceUID)
+{
+    if (m_thumbnailFilePathBySeriesInstanceUID.contains(seriesInstanceUID))
+    {
+        loadSeriesThumbnail(seriesInstanceUID, m_thumbnailFilePathBySeriesInstanceUID.value(seriesInstanceUID));
+    }
 }
 
 QString QSeriesThumbnailPreviewWidget::getSeriesThumbnailDescription(Series *series)
@@ -17,6 +17,9 @@
 
 #include "ui_qseriesthumbnailpreviewwidgetbase.h"
 
+#include <QFutureWatcher>
+#include <QImage>
+
 namespace udg {
 
 class Series;
@@ -30,8 +33,9 @@ public:
     /// Constructor de la classe
     QSeriesThumbnailPreviewWidget(QWidget *parent = 0);
 
-    /// Insereix l'informació d'una sèrie
-    void insertSeries(QString studyInstanceUID, Series *series);
+    /// Insereix l'informació d'una sèrie. Si s'indica el path d'un fitxer de thumbnail, la sèrie s'insereix amb el thumbnail per defecte i el del
+    /// fitxer es carrega en segon pla, i substitueix el per defecte quan està llegit. Si el fitxer no existeix es manté el thumbnail per defecte
+    void insertSeries(QString studyInstanceUID, Series *series, const QString &thumbnailFilePath = QString());
 
     /// Esborra de la llista la serie amb el UID passat per paràmetre
     void removeSeries(const QString &seriesInstanceUID);
@@ -57,6 +61,12 @@ private:
     /// Retorna la descripció pel thumbnail de la sèrie
     QString getSeriesThumbnailDescription(Series *series);
 
+    /// Comença a llegir en segon pla el thumbnail de la sèrie del fitxer indicat
+    void loadSeriesThumbnail(const QString &seriesInstanceUID, const QString &thumbnailFilePath);
+
+    /// Cancel·la les lectures de thumbnails pendents, els resultats que arribin després s'ignoren
+    void cancelPendingThumbnailLoads();
+
 private slots:
     /// Slot que s'activa quan s'ha fet click sobre un thumbnail
     void seriesClicked(QString IDThumbnail);
@@ -64,6 +74,12 @@ private slots:
     /// Slot que s'activa quan s'ha fet doble click sobre un thumbnail
     void seriesDoubleClicked(QString IDThumbnail);
 
+    /// Slot que s'activa quan s'ha acabat de llegir un thumbnail en segon pla
+    void seriesThumbnailLoaded();
+
+    /// Slot que s'activa quan el ThumbnailService ha creat un thumbnail. Si és d'una de les sèries mostrades es torna a llegir el seu thumbnail
+    void thumbnailCreated(const QString &seriesInstanceUID);
+
 private:
     //Guardem per cada sèrie a quin estudi pertany
     QHash<QString, QString> m_studyInstanceUIDBySeriesInstanceUID;
@@ -72,6 +88,10 @@ private:
     QStringList m_DICOMModalitiesNonImage;
     //Indica a quina ha estat la última fila que hem inseritat una sèrie que era una imatge
     int m_positionOfLastInsertedThumbnail;
+    /// Fitxer del thumbnail de cada sèrie inserida que en té
+    QHash<QString, QString> m_thumbnailFilePathBySeriesInstanceUID;
+    /// Lectures de thumbnails en curs i la sèrie a la qual pertany cadascuna
+    QHash<QFutureWatcher<QImage>*, QString> m_seriesInstanceUIDByThumbnailLoad;
 };
 
 }
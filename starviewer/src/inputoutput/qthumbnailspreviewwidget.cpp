@@ -62,6 +62,16 @@ void QThumbnailsPreviewWidget::remove(QString IDThumbnail)
     }
 }
 
+void QThumbnailsPreviewWidget::setThumbnail(QString IDThumbnail, const QPixmap &thumbnail)
+{
+    QListWidgetItem *item = getQListWidgetItem(IDThumbnail);
+
+    if (item)
+    {
+        item->setIcon(QIcon(thumbnail));
+    }
+}
+
 void QThumbnailsPreviewWidget::setCurrentThumbnail(QString IDThumbnail)
 {
     m_thumbnailsPreviewWidget->setCurrentItem(getQListWidgetItem(IDThumbnail));
@@ -0,0 +1,158 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#include "retrieveddicomfileswriter.h"
+
+// Make sure OS specific configuration is included first
+#include <osconfig.h>
+#include <dcfilefo.h>
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutexLocker>
+
+#include "dicomtagreader.h"
+#include "logging.h"
+
+namespace udg {
+
+RetrievedDICOMFilesWriter::RetrievedDICOMFilesWriter(int maximumQueuedFiles, QObject *parent)
+ : QThread(parent), m_metrics("Escriptura dels fitxers a disc")
+{
+    m_maximumQueuedFiles = qMax(maximumQueuedFiles, 1);
+    m_finishRequested = false;
+    m_numberOfFailedFiles = 0;
+}
+
+RetrievedDICOMFilesWriter::~RetrievedDICOMFilesWriter()
+{
+    // Si no s'ha arribat a engegar el thread, hem d'alliberar els fitxers que hagin quedat a la cua
+    foreach (const QueuedFile &queuedFile, m_queuedFiles)
+    {
+        delete queuedFile.fileRetrieved;
+    }
+}
+
+void RetrievedDICOMFilesWriter::enqueue(DcmFileFormat *fileRetrieved, const QString &dicomFileAbsolutePath)
+{
+    QueuedFile queuedFile;
+    queuedFile.fileRetrieved = fileRetrieved;
+    queuedFile.dicomFileAbsolutePath = dicomFileAbsolutePath;
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_queuedFiles.size() >= m_maximumQueuedFiles)
+    {
+        QElapsedTimer blockedTimer;
+        blockedTimer.start();
+
+        while (m_queuedFiles.size() >= m_maximumQueuedFiles)
+        {
+            m_fileDequeued.wait(&m_mutex);
+        }
+
+        m_metrics.addBlockedTime(blockedTimer.elapsed());
+    }
+
+    m_queuedFiles.enqueue(queuedFile);
+    m_metrics.updateQueueSize(m_queuedFiles.size());
+    m_fileQueued.wakeOne();
+}
+
+void RetrievedDICOMFilesWriter::finish()
+{
+    QMutexLocker locker(&m_mutex);
+    m_finishRequested = true;
+    m_fileQueued.wakeOne();
+}
+
+int RetrievedDICOMFilesWriter::getNumberOfFailedFiles() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_numberOfFailedFiles;
+}
+
+const PipelineStageMetrics& RetrievedDICOMFilesWriter::getMetrics() const
+{
+    return m_metrics;
+}
+
+void RetrievedDICOMFilesWriter::run()
+{
+    forever
+    {
+        QueuedFile queuedFile;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_queuedFiles.isEmpty() && !m_finishRequested)
+            {
+                m_fileQueued.wait(&m_mutex);
+            }
+
+            if (m_queuedFiles.isEmpty())
+            {
+                return;
+            }
+
+            queuedFile = m_queuedFiles.dequeue();
+            m_fileDequeued.wakeOne();
+        }
+
+        QElapsedTimer writeTimer;
+        writeTimer.start();
+
+        OFCondition stateSaveImage = save(queuedFile.fileRetrieved, queuedFile.dicomFileAbsolutePath);
+
+        if (stateSaveImage.bad())
+        {
+            DEBUG_LOG("No s'ha pogut guardar la imatge descarregada [" + queuedFile.dicomFileAbsolutePath + "], error: " + stateSaveImage.text());
+            ERROR_LOG("No s'ha pogut guardar la imatge descarregada [" + queuedFile.dicomFileAbsolutePath + "], error: " + stateSaveImage.text());
+            if (!QFile::remove(queuedFile.dicomFileAbsolutePath))
+            {
+                DEBUG_LOG("Ha fallat el voler esborrar el fitxer " + queuedFile.dicomFileAbsolutePath + " que havia fallat prèviament al voler guardar-se.");
+                ERROR_LOG("Ha fallat el voler esborrar el fitxer " + queuedFile.dicomFileAbsolutePath + " que havia fallat prèviament al voler guardar-se.");
+            }
+
+            QMutexLocker locker(&m_mutex);
+            m_numberOfFailedFiles++;
+        }
+        else
+        {
+            // El DICOMTagReader es queda el dataset, així no s'ha de tornar a llegir el fitxer per processar-lo
+            DICOMTagReader *dicomTagReader = new DICOMTagReader(queuedFile.dicomFileAbsolutePath, queuedFile.fileRetrieved->getAndRemoveDataset());
+            m_metrics.addProcessedItem(writeTimer.elapsed());
+            emit DICOMFileWritten(dicomTagReader);
+        }
+
+        delete queuedFile.fileRetrieved;
+    }
+}
+
+OFCondition RetrievedDICOMFilesWriter::save(DcmFileFormat *fileRetrieved, const QString &dicomFileAbsolutePath)
+{
+    // Indiquem que no fem servir meta-header
+    E_FileWriteMode writeMode = EWM_fileformat;
+    E_EncodingType sequenceType = EET_ExplicitLength;
+    E_GrpLenEncoding groupLength = EGL_recalcGL;
+    E_PaddingEncoding paddingType = EPD_withoutPadding;
+    Uint32 filePadding = 0, itemPadding = 0;
+    E_TransferSyntax transferSyntaxFile = fileRetrieved->getDataset()->getOriginalXfer();
+
+    return fileRetrieved->saveFile(qPrintable(QDir::toNativeSeparators(dicomFileAbsolutePath)), transferSyntaxFile, sequenceType, groupLength, paddingType,
+                                   filePadding, itemPadding, writeMode);
+}
+
+}
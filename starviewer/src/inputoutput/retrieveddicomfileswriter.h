@@ -0,0 +1,94 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#ifndef UDGRETRIEVEDDICOMFILESWRITER_H
+#define UDGRETRIEVEDDICOMFILESWRITER_H
+
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <ofcond.h>
+
+#include "pipelinestagemetrics.h"
+
+class DcmFileFormat;
+
+namespace udg {
+
+class DICOMTagReader;
+
+/**
+    Guarda a disc en un thread a part els fitxers que es reben durant una descàrrega, perquè el thread que respon els C-STORE del PACS no s'hagi d'esperar
+    a l'escriptura de cada fitxer per rebre el següent.
+
+    La cua de fitxers pendents de guardar té una mida màxima. Quan és plena, enqueue() bloqueja el thread que rep els fitxers fins que n'hi ha lloc,
+    de manera que si el disc o el processat dels fitxers no donen l'abast el PACS també s'espera i no s'acumulen fitxers a memòria.
+  */
+class RetrievedDICOMFilesWriter : public QThread {
+Q_OBJECT
+public:
+    /// Crea el writer amb una cua de com a màxim maximumQueuedFiles fitxers
+    RetrievedDICOMFilesWriter(int maximumQueuedFiles, QObject *parent = 0);
+    ~RetrievedDICOMFilesWriter();
+
+    /// Afegeix a la cua el fitxer per guardar-lo a dicomFileAbsolutePath i se'n queda la propietat. Si la cua és plena espera que hi hagi lloc.
+    void enqueue(DcmFileFormat *fileRetrieved, const QString &dicomFileAbsolutePath);
+
+    /// Indica que no s'afegiran més fitxers. El thread acaba quan ha guardat tots els de la cua.
+    void finish();
+
+    /// Retorna el nombre de fitxers que no s'han pogut guardar
+    int getNumberOfFailedFiles() const;
+
+    /// Retorna les mètriques de l'escriptura dels fitxers
+    const PipelineStageMetrics& getMetrics() const;
+
+signals:
+    /// S'emet des del thread del writer cada cop que s'ha guardat un fitxer, amb el DICOMTagReader amb el dataset del fitxer
+    void DICOMFileWritten(DICOMTagReader *dicomTagReader);
+
+protected:
+    void run();
+
+private:
+    struct QueuedFile
+    {
+        DcmFileFormat *fileRetrieved;
+        QString dicomFileAbsolutePath;
+    };
+
+    /// Guarda una composite instance descarregada
+    OFCondition save(DcmFileFormat *fileRetrieved, const QString &dicomFileAbsolutePath);
+
+private:
+    int m_maximumQueuedFiles;
+    QQueue<QueuedFile> m_queuedFiles;
+    bool m_finishRequested;
+    int m_numberOfFailedFiles;
+
+    /// Protegeix la cua, m_finishRequested i m_numberOfFailedFiles
+    mutable QMutex m_mutex;
+    QWaitCondition m_fileQueued;
+    QWaitCondition m_fileDequeued;
+
+    PipelineStageMetrics m_metrics;
+};
+
+}
+
+#endif
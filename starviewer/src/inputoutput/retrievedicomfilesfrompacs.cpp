@@ -24,6 +24,7 @@
 
 #include <QDir>
 #include <QString>
+#include <QThread>
 
 #include "localdatabasemanager.h"
 #include "dicommask.h"
@@ -31,6 +32,8 @@
 #include "dicomtagreader.h"
 #include "pacsconnection.h"
 #include "pacsdevice.h"
+#include "inputoutputsettings.h"
+#include "retrieveddicomfileswriter.h"
 
 namespace udg {
 
@@ -42,81 +45,30 @@ RetrieveDICOMFilesFromPACS::RetrieveDICOMFilesFromPACS(PacsDevice pacs)
 {
     m_pacs = pacs;
     m_abortIsRequested = false;
+    m_pacsConnectionAborted = false;
+    m_retrieveThread = NULL;
+    m_retrievedFilesWriter = NULL;
 
     this->setUpAsCMove();
 }
 
-OFCondition RetrieveDICOMFilesFromPACS::acceptSubAssociation(T_ASC_Network *associationNetwork, T_ASC_Association **association)
-{
-    const char *knownAbstractSyntaxes[] = { UID_VerificationSOPClass };
-    const char *transferSyntaxes[] = { NULL, NULL, NULL, NULL };
-    int numTransferSyntaxes;
-
-    OFCondition condition = ASC_receiveAssociation(associationNetwork, association, ASC_DEFAULTMAXPDU);
-
-    if (condition.good())
-    {
-#ifndef DISABLE_COMPRESSION_EXTENSION
-        // Si disposem de compressió la demanem, i podrem accelerar el temps de descàrrega considerablement
-        // De moment demanem la compressió lossless que tot PACS que suporti compressió ha
-        // de proporcionar: JPEGLossless:Non-Hierarchical-1stOrderPrediction
-        transferSyntaxes[0] = UID_JPEGProcess14SV1TransferSyntax;
-        transferSyntaxes[1] = UID_LittleEndianExplicitTransferSyntax;
-        transferSyntaxes[2] = UID_BigEndianExplicitTransferSyntax;
-        transferSyntaxes[3] = UID_LittleEndianImplicitTransferSyntax;
-        numTransferSyntaxes = 4;
-#else
-        // Defined in dcxfer.h
-        if (gLocalByteOrder == EBO_LittleEndian)
-        {
-        transferSyntaxes[0] = UID_LittleEndianExplicitTransferSyntax;
-        transferSyntaxes[1] = UID_BigEndianExplicitTransferSyntax;
-        }
-        else
-        {
-        transferSyntaxes[0] = UID_BigEndianExplicitTransferSyntax;
-        transferSyntaxes[1] = UID_LittleEndianExplicitTransferSyntax;
-        }
-        transferSyntaxes[2] = UID_LittleEndianImplicitTransferSyntax;
-        numTransferSyntaxes = 3;
-#endif
-
-        // Accept the Verification SOP Class if presented
-        condition = ASC_acceptContextsWithPreferredTransferSyntaxes((*association)->params, knownAbstractSyntaxes, DIM_OF(knownAbstractSyntaxes),
-                                                                    transferSyntaxes, numTransferSyntaxes);
-
-        if (condition.good())
-        {
-            // The array of Storage SOP Class UIDs comes from dcuid.h
-            condition = ASC_acceptContextsWithPreferredTransferSyntaxes((*association)->params, dcmAllStorageSOPClassUIDs, numberOfAllDcmStorageSOPClassUIDs,
-                                                                        transferSyntaxes, numTransferSyntaxes);
-        }
-    }
-
-    if (condition.good())
-    {
-        condition = ASC_acknowledgeAssociation(*association);
-    }
-    else
-    {
-        ASC_dropAssociation(*association);
-        ASC_destroyAssociation(association);
-    }
-    return condition;
-}
-
 void RetrieveDICOMFilesFromPACS::moveCallback(void *callbackData, T_DIMSE_C_MoveRQ *request, int responseCount, T_DIMSE_C_MoveRSP *response)
 {
     Q_UNUSED(responseCount);
     Q_UNUSED(response);
     Q_UNUSED(request);
-    Q_UNUSED(callbackData);
+
+    // Si la subassociació s'ha processat en un thread d'IncomingDICOMConnectionsDispatcher, des d'allà no es pot abortar la connexió amb el PACS
+    // quan es cancel·la la descàrrega, per això es fa aquí en rebre la següent resposta del PACS
+    MoveSCPCallbackData *moveSCPCallbackData = (MoveSCPCallbackData*) callbackData;
+    if (moveSCPCallbackData->retrieveDICOMFilesFromPACS->m_abortIsRequested)
+    {
+        moveSCPCallbackData->retrieveDICOMFilesFromPACS->abortPACSConnection();
+    }
 
     // Aquest en teoria és el codi per cancel·lar una descàrrega però el PACS del l'UDIAT no suporta les requestCancel, per tant la única manera
     // de fer-ho és com es fa en el mètode subOperationSCP que s'aborta la connexió amb el PACS.
 
-    //MoveSCPCallbackData *moveSCPCallbackData = (MoveSCPCallbackData*) callbackData;
-
     //if (moveSCPCallbackData->retrieveDICOMFilesFromPACS->m_abortIsRequested)
     //{
     //    OFCondition condition = DIMSE_sendCancelRequest(moveSCPCallbackData->association, moveSCPCallbackData->presentationContextId, request->MessageID);
@@ -166,65 +118,41 @@ void RetrieveDICOMFilesFromPACS::storeSCPCallback(void *callbackData, T_DIMSE_St
             RetrieveDICOMFilesFromPACS *retrieveDICOMFilesFromPACS = storeSCPCallbackData->retrieveDICOMFilesFromPACS;
             QString dicomFileAbsolutePath = retrieveDICOMFilesFromPACS->getAbsoluteFilePathCompositeInstance(*imageDataSet, storeSCPCallbackData->fileName);
 
-            // Guardem la imatge
-            OFCondition stateSaveImage = retrieveDICOMFilesFromPACS->save(storeSCPCallbackData->dcmFileFormat, dicomFileAbsolutePath);
-
-            if (stateSaveImage.bad())
+            // Should really check the image to make sure it is consistent, that its
+            // sopClass and sopInstance correspond with those in the request.
+            if (storeResponse->DimseStatus == STATUS_Success)
             {
-                storeResponse->DimseStatus = STATUS_STORE_Refused_OutOfResources;
-                DEBUG_LOG("No s'ha pogut guardar la imatge descarregada [" + dicomFileAbsolutePath + "], error: " + stateSaveImage.text());
-                ERROR_LOG("No s'ha pogut guardar la imatge descarregada [" + dicomFileAbsolutePath + "], error: " + stateSaveImage.text());
-                if (!QFile::remove(dicomFileAbsolutePath))
+                // Which SOP class and SOP instance?
+                if (!DU_findSOPClassAndInstanceInDataSet(*imageDataSet, sopClass, sopInstance, correctUIDPadding))
                 {
-                    DEBUG_LOG("Ha fallat el voler esborrar el fitxer " + dicomFileAbsolutePath + " que havia fallat prèviament al voler guardar-se.");
-                    ERROR_LOG("Ha fallat el voler esborrar el fitxer " + dicomFileAbsolutePath + " que havia fallat prèviament al voler guardar-se.");
+                    storeResponse->DimseStatus = STATUS_STORE_Error_CannotUnderstand;
+                    ERROR_LOG(QString("No s'ha trobat la sop class i la sop instance per la imatge %1").arg(storeSCPCallbackData->fileName));
                 }
-            }
-            else
-            {
-                // Should really check the image to make sure it is consistent, that its
-                // sopClass and sopInstance correspond with those in the request.
-                if (storeResponse->DimseStatus == STATUS_Success)
+                else if (strcmp(sopClass, storeRequest->AffectedSOPClassUID) != 0)
                 {
-                    // Which SOP class and SOP instance?
-                    if (!DU_findSOPClassAndInstanceInDataSet(*imageDataSet, sopClass, sopInstance, correctUIDPadding))
-                    {
-                        storeResponse->DimseStatus = STATUS_STORE_Error_CannotUnderstand;
-                        ERROR_LOG(QString("No s'ha trobat la sop class i la sop instance per la imatge %1").arg(storeSCPCallbackData->fileName));
-                    }
-                    else if (strcmp(sopClass, storeRequest->AffectedSOPClassUID) != 0)
-                    {
-                        storeResponse->DimseStatus = STATUS_STORE_Error_DataSetDoesNotMatchSOPClass;
-                        ERROR_LOG(QString("No concorda la sop class rebuda amb la sol.licitada per la imatge %1").arg(storeSCPCallbackData->fileName));
-                    }
-                    else if (strcmp(sopInstance, storeRequest->AffectedSOPInstanceUID) != 0)
-                    {
-                        storeResponse->DimseStatus = STATUS_STORE_Error_DataSetDoesNotMatchSOPClass;
-                        ERROR_LOG(QString("No concorda sop instance rebuda amb la sol.licitada per la imatge %1").arg(storeSCPCallbackData->fileName));
-                    }
+                    storeResponse->DimseStatus = STATUS_STORE_Error_DataSetDoesNotMatchSOPClass;
+                    ERROR_LOG(QString("No concorda la sop class rebuda amb la sol.licitada per la imatge %1").arg(storeSCPCallbackData->fileName));
+                }
+                else if (strcmp(sopInstance, storeRequest->AffectedSOPInstanceUID) != 0)
+                {
+                    storeResponse->DimseStatus = STATUS_STORE_Error_DataSetDoesNotMatchSOPClass;
+                    ERROR_LOG(QString("No concorda sop instance rebuda amb la sol.licitada per la imatge %1").arg(storeSCPCallbackData->fileName));
                 }
-
-                // TODO:Té processar el fitxer si ha fallat alguna de les anteriors comprovacions ?
-                retrieveDICOMFilesFromPACS->m_numberOfImagesRetrieved++;
-                DICOMTagReader *dicomTagReader = new DICOMTagReader(dicomFileAbsolutePath, storeSCPCallbackData->dcmFileFormat->getAndRemoveDataset());
-                emit retrieveDICOMFilesFromPACS->DICOMFileRetrieved(dicomTagReader, retrieveDICOMFilesFromPACS->m_numberOfImagesRetrieved);
             }
+
+            // TODO:Té processar el fitxer si ha fallat alguna de les anteriors comprovacions ?
+            // El fitxer es guarda a disc en el thread del writer, així responem el C-STORE i podem rebre el següent fitxer sense esperar l'escriptura.
+            // Si no es pot guardar el writer ho comptabilitza i la descàrrega acabarà amb l'estat RetrieveSomeDICOMFilesFailed.
+            retrieveDICOMFilesFromPACS->m_retrievedFilesWriter->enqueue(storeSCPCallbackData->dcmFileFormat, dicomFileAbsolutePath);
+            storeSCPCallbackData->dcmFileFormat = NULL;
         }
     }
 }
 
-OFCondition RetrieveDICOMFilesFromPACS::save(DcmFileFormat *fileRetrieved, QString dicomFileAbsolutePath)
+void RetrieveDICOMFilesFromPACS::DICOMFileWritten(DICOMTagReader *dicomTagReader)
 {
-    // Indiquem que no fem servir meta-header
-    E_FileWriteMode writeMode = EWM_fileformat;
-    E_EncodingType sequenceType = EET_ExplicitLength;
-    E_GrpLenEncoding groupLength = EGL_recalcGL;
-    E_PaddingEncoding paddingType = EPD_withoutPadding;
-    Uint32 filePadding = 0, itemPadding = 0;
-    E_TransferSyntax transferSyntaxFile = fileRetrieved->getDataset()->getOriginalXfer();
-
-    return fileRetrieved->saveFile(qPrintable(QDir::toNativeSeparators(dicomFileAbsolutePath)), transferSyntaxFile, sequenceType, groupLength, paddingType,
-                                   filePadding, itemPadding, writeMode);
+    m_numberOfImagesRetrieved++;
+    emit DICOMFileRetrieved(dicomTagReader, m_numberOfImagesRetrieved);
 }
 
 OFCondition RetrieveDICOMFilesFromPACS::storeSCP(T_ASC_Association *association, T_DIMSE_Message *msg, T_ASC_PresentationContextID presentationContextID)
@@ -232,10 +160,11 @@ OFCondition RetrieveDICOMFilesFromPACS::storeSCP(T_ASC_Association *association,
     T_DIMSE_C_StoreRQ *storeRequest = &msg->msg.CStoreRQ;
     OFBool useMetaheader = OFTrue;
     StoreSCPCallbackData storeSCPCallbackData;
-    DcmFileFormat retrievedFile;
-    DcmDataset *retrievedDataset = retrievedFile.getDataset();
+    // Si es rep sencer, el fitxer passa a ser del writer, que l'esborra un cop guardat
+    DcmFileFormat *retrievedFile = new DcmFileFormat();
+    DcmDataset *retrievedDataset = retrievedFile->getDataset();
 
-    storeSCPCallbackData.dcmFileFormat = &retrievedFile;
+    storeSCPCallbackData.dcmFileFormat = retrievedFile;
     storeSCPCallbackData.retrieveDICOMFilesFromPACS = this;
     storeSCPCallbackData.fileName = storeRequest->AffectedSOPInstanceUID;
 
@@ -249,6 +178,8 @@ OFCondition RetrieveDICOMFilesFromPACS::storeSCP(T_ASC_Association *association,
         unlink(qPrintable(storeSCPCallbackData.fileName));
     }
 
+    delete storeSCPCallbackData.dcmFileFormat;
+
     return condition;
 }
 
@@ -265,16 +196,24 @@ OFCondition RetrieveDICOMFilesFromPACS::subOperationSCP(T_ASC_Association **subA
 
     OFCondition condition = DIMSE_receiveCommand(*subAssociation, DIMSE_BLOCKING, 0, &presentationContextID, &dimseMessage, NULL);
 
+    return processSubOperation(subAssociation, condition, &dimseMessage, presentationContextID);
+}
+
+OFCondition RetrieveDICOMFilesFromPACS::processSubOperation(T_ASC_Association **subAssociation, OFCondition receiveCondition, T_DIMSE_Message *dimseMessage,
+                                                            T_ASC_PresentationContextID presentationContextID)
+{
+    OFCondition condition = receiveCondition;
+
     if (condition == EC_Normal)
     {
-        switch (dimseMessage.CommandField)
+        switch (dimseMessage->CommandField)
         {
             case DIMSE_C_STORE_RQ:
-                condition = storeSCP(*subAssociation, &dimseMessage, presentationContextID);
+                condition = storeSCP(*subAssociation, dimseMessage, presentationContextID);
                 break;
 
             case DIMSE_C_ECHO_RQ:
-                condition = echoSCP(*subAssociation, &dimseMessage, presentationContextID);
+                condition = echoSCP(*subAssociation, dimseMessage, presentationContextID);
                 break;
 
             default:
@@ -299,30 +238,23 @@ OFCondition RetrieveDICOMFilesFromPACS::subOperationSCP(T_ASC_Association **subA
     else if (condition != EC_Normal)
     {
         ERROR_LOG("S'ha produit un error reben la peticio d'una suboperacio, descripcio error: " + QString(condition.text()));
-        condition = ASC_abortAssociation(*subAssociation);
+        abortSubAssociation(subAssociation);
+        return condition;
     }
     else if (m_abortIsRequested)
     {
         INFO_LOG("Abortarem les connexions amb el PACS, perque han sol.licitant cancel.lar la descarrega");
-        condition = ASC_abortAssociation(*subAssociation);
-        if (!condition.good())
-        {
-            ERROR_LOG("Error al abortar la connexio pel qual rebem les imatges" + QString(condition.text()));
-        }
+        abortSubAssociation(subAssociation);
 
         // Tanquem la connexió amb el PACS perquè segons indica la documentació DICOM al PS 3.4 (Baseline Behavior of SCP) C.4.2.3.1 si abortem
         // la connexió per la qual rebem les imatges, el comportament del PACS és desconegut, per exemple DCM4CHEE tanca la connexió amb el PACS, però
         // el RAIM_Server no la tanca i la manté fent que no sortim mai d'aquesta classe. Degut a que no es pot saber en aquesta situació com actuaran
-        // els PACS es tanca aquí la connexió amb el PACS.
-        condition = ASC_abortAssociation(m_pacsConnection->getConnection());
-        if (!condition.good())
+        // els PACS es tanca aquí la connexió amb el PACS. Si la subassociació es processa en un altre thread es farà a moveCallback.
+        if (QThread::currentThread() == m_retrieveThread)
         {
-            ERROR_LOG("Error al abortar la connexio pel amb el PACS" + QString(condition.text()));
-        }
-        else
-        {
-            INFO_LOG("Abortada la connexio amb el PACS");
+            abortPACSConnection();
         }
+        return EC_Normal;
     }
 
     if (condition != EC_Normal)
@@ -333,6 +265,59 @@ OFCondition RetrieveDICOMFilesFromPACS::subOperationSCP(T_ASC_Association **subA
     return condition;
 }
 
+void RetrieveDICOMFilesFromPACS::serveSubAssociation(T_ASC_Association *subAssociation, IncomingDICOMConnectionsDispatcher::FirstCommand firstCommand)
+{
+    if (firstCommand.isValid)
+    {
+        processSubOperation(&subAssociation, firstCommand.condition, &firstCommand.message, firstCommand.presentationContextID);
+    }
+
+    // Quan el PACS tanca o aborta la subassociació, processSubOperation la destrueix i la deixa a NULL
+    while (subAssociation != NULL)
+    {
+        if (m_abortIsRequested)
+        {
+            INFO_LOG("Abortem la connexio per on rebem els fitxers, perque han sol.licitant cancel.lar la descarrega");
+            abortSubAssociation(&subAssociation);
+        }
+        else if (ASC_dataWaiting(subAssociation, 1))
+        {
+            subOperationSCP(&subAssociation);
+        }
+    }
+}
+
+void RetrieveDICOMFilesFromPACS::abortSubAssociation(T_ASC_Association **subAssociation)
+{
+    OFCondition condition = ASC_abortAssociation(*subAssociation);
+    if (!condition.good())
+    {
+        ERROR_LOG("Error al abortar la connexio pel qual rebem les imatges" + QString(condition.text()));
+    }
+
+    ASC_dropAssociation(*subAssociation);
+    ASC_destroyAssociation(subAssociation);
+}
+
+void RetrieveDICOMFilesFromPACS::abortPACSConnection()
+{
+    if (m_pacsConnectionAborted)
+    {
+        return;
+    }
+
+    OFCondition condition = ASC_abortAssociation(m_pacsConnection->getConnection());
+    if (!condition.good())
+    {
+        ERROR_LOG("Error al abortar la connexio pel amb el PACS" + QString(condition.text()));
+    }
+    else
+    {
+        INFO_LOG("Abortada la connexio amb el PACS");
+        m_pacsConnectionAborted = true;
+    }
+}
+
 void RetrieveDICOMFilesFromPACS::subOperationCallback(void *subOperationCallbackData, T_ASC_Network *associationNetwork, T_ASC_Association **subAssociation)
 {
     RetrieveDICOMFilesFromPACS *retrieveDICOMFilesFromPACS = (RetrieveDICOMFilesFromPACS*)subOperationCallbackData;
@@ -344,14 +329,19 @@ void RetrieveDICOMFilesFromPACS::subOperationCallback(void *subOperationCallback
 
     if (*subAssociation == NULL)
     {
-        OFCondition condition = retrieveDICOMFilesFromPACS->acceptSubAssociation(associationNetwork, subAssociation);
-        if (!condition.good())
-        {
-            ERROR_LOG("S'ha produit un error negociant l'associacio de la connexio DICOM entrant, descripcio error: " + QString(condition.text()));
-        }
-        else
+        // El port el comparteixen totes les descàrregues en curs, el dispatcher decideix de quina és la subassociació
+        IncomingDICOMConnectionsDispatcher::FirstCommand firstCommand;
+        *subAssociation = IncomingDICOMConnectionsDispatcher::instance()->acceptSubAssociation(retrieveDICOMFilesFromPACS, &firstCommand);
+
+        if (*subAssociation != NULL)
         {
             INFO_LOG("Rebuda solicitud de connexio pel port de connexions DICOM entrants del PACS.");
+
+            if (firstCommand.isValid)
+            {
+                retrieveDICOMFilesFromPACS->processSubOperation(subAssociation, firstCommand.condition, &firstCommand.message,
+                                                                firstCommand.presentationContextID);
+            }
         }
     }
     else
@@ -370,11 +360,24 @@ PACSRequestStatus::RetrieveRequestStatus RetrieveDICOMFilesFromPACS::retrieve(co
     MoveSCPCallbackData moveSCPCallbackData;
     DcmDataset *dcmDatasetToRetrieve = getDcmDatasetOfImagesToRetrieve(studyInstanceUID, seriesInstanceUID, sopInstanceUID);
     m_numberOfImagesRetrieved = 0;
+    m_pacsConnectionAborted = false;
+    m_retrieveThread = QThread::currentThread();
+
+    // El port de connexions entrants el comparteixen totes les descàrregues en curs, el dispatcher l'obre i ens fa arribar les subassociacions del
+    // C-MOVE amb aquest identificador de missatge
+    IncomingDICOMConnectionsDispatcher *incomingDICOMConnectionsDispatcher = IncomingDICOMConnectionsDispatcher::instance();
+    T_DIMSE_C_MoveRQ moveRequest = getConfiguredMoveRequest(incomingDICOMConnectionsDispatcher->getNextMoveMessageID());
+
+    if (!incomingDICOMConnectionsDispatcher->registerRetrieve(this, m_pacs.getAETitle(), moveRequest.MessageID))
+    {
+        return PACSRequestStatus::RetrieveIncomingDICOMConnectionsPortInUse;
+    }
 
     // TODO S'hauria de comprovar que es tracti d'un PACS amb el servei de retrieve configurat
     if (!m_pacsConnection->connectToPACS(PACSConnection::RetrieveDICOMFiles))
     {
         ERROR_LOG("S'ha produit un error al intentar connectar al PACS per fer un retrieve. AE Title: " + m_pacs.getAETitle());
+        incomingDICOMConnectionsDispatcher->unregisterRetrieve(this);
         return PACSRequestStatus::RetrieveCanNotConnectToPACS;
     }
 
@@ -384,20 +387,37 @@ PACSRequestStatus::RetrieveRequestStatus RetrieveDICOMFilesFromPACS::retrieve(co
     if (presentationContextID == 0)
     {
         ERROR_LOG("No s'ha trobat cap presentation context valid");
+        incomingDICOMConnectionsDispatcher->unregisterRetrieve(this);
         return PACSRequestStatus::RetrieveFailureOrRefused;
     }
 
+    // Els fitxers rebuts es guarden a disc en un thread a part. Si el disc o el processat dels fitxers no donen l'abast, la cua del writer s'omple i
+    // deixem de respondre els C-STORE fins que hi ha lloc, de manera que el PACS també s'espera.
+    RetrievedDICOMFilesWriter retrievedFilesWriter(Settings().getValue(InputOutputSettings::MaximumQueuedRetrievedFiles).toInt());
+    // DirectConnection perquè el fitxer es processi des del thread del writer, en l'ordre en què s'ha guardat
+    connect(&retrievedFilesWriter, SIGNAL(DICOMFileWritten(DICOMTagReader*)), this, SLOT(DICOMFileWritten(DICOMTagReader*)), Qt::DirectConnection);
+    m_retrievedFilesWriter = &retrievedFilesWriter;
+    retrievedFilesWriter.start();
+
     moveSCPCallbackData.association = association;
     moveSCPCallbackData.presentationContextId = presentationContextID;
     moveSCPCallbackData.retrieveDICOMFilesFromPACS = this;
 
     // Set the destination of the images to us
-    T_DIMSE_C_MoveRQ moveRequest = getConfiguredMoveRequest(association);
     ASC_getAPTitles(association->params, moveRequest.MoveDestination, NULL, NULL);
 
     OFCondition condition = DIMSE_moveUser(association, presentationContextID, &moveRequest, dcmDatasetToRetrieve, moveCallback, &moveSCPCallbackData,
-                                           DIMSE_BLOCKING, 0, m_pacsConnection->getNetwork(), subOperationCallback, this, &moveResponse, &statusDetail,
-                                           NULL /*responseIdentifiers*/);
+                                           DIMSE_BLOCKING, 0, incomingDICOMConnectionsDispatcher->getNetwork(), subOperationCallback, this, &moveResponse,
+                                           &statusDetail, NULL /*responseIdentifiers*/);
+
+    // Espera que acabin les subassociacions d'aquesta descàrrega que s'estan processant en altres threads
+    incomingDICOMConnectionsDispatcher->unregisterRetrieve(this);
+
+    // Ja no es rebran més fitxers, esperem que el writer guardi els que té a la cua
+    retrievedFilesWriter.finish();
+    retrievedFilesWriter.wait();
+    m_retrievedFilesWriter = NULL;
+    INFO_LOG(retrievedFilesWriter.getMetrics().toString());
 
     if (condition.bad())
     {
@@ -409,6 +429,13 @@ PACSRequestStatus::RetrieveRequestStatus RetrieveDICOMFilesFromPACS::retrieve(co
 
     retrieveRequestStatus = getDIMSEStatusCodeAsRetrieveRequestStatus(moveResponse.DimseStatus);
     processServiceClassProviderResponseStatus(moveResponse.DimseStatus, statusDetail);
+
+    // El PACS ha rebut la resposta dels C-STORE abans que es guardessin els fitxers, per tant no sap si algun no s'ha pogut guardar
+    if (retrieveRequestStatus == PACSRequestStatus::RetrieveOk && retrievedFilesWriter.getNumberOfFailedFiles() > 0)
+    {
+        ERROR_LOG(QString("No s'han pogut guardar %1 dels fitxers descarregats").arg(retrievedFilesWriter.getNumberOfFailedFiles()));
+        retrieveRequestStatus = PACSRequestStatus::RetrieveSomeDICOMFilesFailed;
+    }
     
     // Dump status detail information if there is some
     if (statusDetail != NULL)
@@ -432,12 +459,11 @@ int RetrieveDICOMFilesFromPACS::getNumberOfDICOMFilesRetrieved()
     return m_numberOfImagesRetrieved;
 }
 
-T_DIMSE_C_MoveRQ RetrieveDICOMFilesFromPACS::getConfiguredMoveRequest(T_ASC_Association *association)
+T_DIMSE_C_MoveRQ RetrieveDICOMFilesFromPACS::getConfiguredMoveRequest(DIC_US messageID)
 {
     T_DIMSE_C_MoveRQ moveRequest;
-    DIC_US messageId = association->nextMsgID++;
 
-    moveRequest.MessageID = messageId;
+    moveRequest.MessageID = messageID;
     strcpy(moveRequest.AffectedSOPClassUID, MoveAbstractSyntax);
     moveRequest.Priority = DIMSE_PRIORITY_MEDIUM;
     moveRequest.DataSetType = DIMSE_DATASET_PRESENT;
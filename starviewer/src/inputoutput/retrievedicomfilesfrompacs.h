@@ -22,6 +22,7 @@
 #include "pacsdevice.h"
 #include "pacsrequeststatus.h"
 #include "dimsecservice.h"
+#include "incomingdicomconnectionsdispatcher.h"
 
 struct T_DIMSE_C_MoveRQ;
 struct T_DIMSE_C_MoveRSP;
@@ -32,12 +33,14 @@ struct T_DIMSE_Message;
 
 class DcmDataset;
 class DcmFileFormat;
+class QThread;
 
 namespace udg {
 
 class DicomMask;
 class DICOMTagReader;
 class PACSConnection;
+class RetrievedDICOMFilesWriter;
 
 /**
     Aquesta classe s'encarrega d'interactuars amb els PACS, responent als serveis move i store
@@ -62,9 +65,13 @@ signals:
     /// Signal que indica que s'ha descarregat un fitxer
     void DICOMFileRetrieved(DICOMTagReader *dicomTagReader, int numberOfImagesRetrieved);
 
+private slots:
+    /// Respon al signal DICOMFileWritten de RetrievedDICOMFilesWriter quan s'ha guardat un fitxer descarregat
+    void DICOMFileWritten(DICOMTagReader *dicomTagReader);
+
 private:
-    /// En aquesta funció acceptem la connexió que se'ns sol·licita per transmetre'ns imatges, i indiquem quins transfer syntax suportem
-    OFCondition acceptSubAssociation(T_ASC_Network *associationNetwork, T_ASC_Association **association);
+    /// IncomingDICOMConnectionsDispatcher ens fa processar les subassociacions que han acceptat altres descàrregues
+    friend class IncomingDICOMConnectionsDispatcher;
 
     /// Responem a una petició d'echo
     OFCondition echoSCP(T_ASC_Association *association, T_DIMSE_Message *dimseMessage, T_ASC_PresentationContextID presentationContextID);
@@ -75,8 +82,19 @@ private:
     /// Accepta la connexió que ens fa el PACS, per convertir-nos en un scp
     OFCondition subOperationSCP(T_ASC_Association **subAssociation);
 
-    /// Guarda una composite instance descarregada
-    OFCondition save(DcmFileFormat *fileRetrieved, QString dicomFileAbsolutePath);
+    /// Respon l'ordre que el PACS ens ha enviat per la subassociació, que s'ha rebut amb l'estat receiveCondition
+    OFCondition processSubOperation(T_ASC_Association **subAssociation, OFCondition receiveCondition, T_DIMSE_Message *dimseMessage,
+                                    T_ASC_PresentationContextID presentationContextID);
+
+    /// Processa totes les ordres d'una subassociació que ha acceptat una altra descàrrega, fins que el PACS la tanca o es cancel·la la descàrrega.
+    /// S'executa en un thread d'IncomingDICOMConnectionsDispatcher.
+    void serveSubAssociation(T_ASC_Association *subAssociation, IncomingDICOMConnectionsDispatcher::FirstCommand firstCommand);
+
+    /// Aborta la subassociació i la destrueix
+    void abortSubAssociation(T_ASC_Association **subAssociation);
+
+    /// Aborta la connexió amb el PACS per on hem fet el C-MOVE. Només es pot fer des del thread que fa la descàrrega.
+    void abortPACSConnection();
 
     /// Retorna el nom del fitxer amb que s'ha de guardar l'objecte descarregat, composa el path on s'ha de guardar més el nom del fitxer.
     /// Si el path on s'ha de guardar la imatge no existeix, el crea
@@ -86,7 +104,7 @@ private:
     DcmDataset* getDcmDatasetOfImagesToRetrieve(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &sopInstanceUID);
 
     /// Configura l'objecte MoveRequest per la descàrrega de fitxers DICOM
-    T_DIMSE_C_MoveRQ getConfiguredMoveRequest(T_ASC_Association *association);
+    T_DIMSE_C_MoveRQ getConfiguredMoveRequest(DIC_US messageID);
 
     /// Translates DIMSE status code to PACSRequestStatus::RetrieveRequestStatus
     PACSRequestStatus::RetrieveRequestStatus getDIMSEStatusCodeAsRetrieveRequestStatus(unsigned int dimseStatusCode);
@@ -121,8 +139,14 @@ private:
     PACSConnection *m_pacsConnection;
 
     int m_numberOfImagesRetrieved;
+    /// Guarda els fitxers rebuts en un thread a part. Com només hi ha un thread que els guarda, també serialitza els fitxers que es reben per
+    /// subassociacions processades en threads diferents.
+    RetrievedDICOMFilesWriter *m_retrievedFilesWriter;
 
     bool m_abortIsRequested;
+    bool m_pacsConnectionAborted;
+    /// Thread que fa la descàrrega
+    QThread *m_retrieveThread;
 
 };
 
@@ -15,6 +15,7 @@
 #include "retrievedicomfilesfrompacsjob.h"
 
 #include <QtGlobal>
+#include <QMutexLocker>
 #include <QThread>
 
 #include "logging.h"
@@ -26,12 +27,12 @@
 #include "retrievedicomfilesfrompacs.h"
 #include "dicommask.h"
 #include "localdatabasemanager.h"
+#include "cacheevictionservice.h"
 #include "patientfiller.h"
 #include "directoryutilities.h"
 #include "harddiskinformation.h"
 #include "inputoutputsettings.h"
 #include "dicomtagreader.h"
-#include "portinuse.h"
 #include "dicomsource.h"
 #include "usermessage.h"
 
@@ -39,7 +40,8 @@ namespace udg {
 
 RetrieveDICOMFilesFromPACSJob::RetrieveDICOMFilesFromPACSJob(PacsDevice pacsDevice, RetrievePriorityJob retrievePriorityJob, Study *studyToRetrieveDICOMFiles, 
     const QString &seriesInstanceUIDToRetrieve, const QString &sopInstanceUIDToRetrieve)
- : PACSJob(pacsDevice)
+ : PACSJob(pacsDevice), m_fillStageFreeSlots(qMax(Settings().getValue(InputOutputSettings::MaximumQueuedRetrievedFiles).toInt(), 1)),
+   m_fillStageMetrics("Processat dels fitxers"), m_databaseStageMetrics("Insercio a la base de dades")
 {
     Q_ASSERT(studyToRetrieveDICOMFiles);
     Q_ASSERT(studyToRetrieveDICOMFiles->getParentPatient());
@@ -49,6 +51,8 @@ RetrieveDICOMFilesFromPACSJob::RetrieveDICOMFilesFromPACSJob(PacsDevice pacsDevi
     m_seriesInstanceUIDToRetrieve = seriesInstanceUIDToRetrieve;
     m_SOPInstanceUIDToRetrieve = sopInstanceUIDToRetrieve;
     m_retrievePriorityJob = retrievePriorityJob;
+    m_lastFileFilledTime = 0;
+    m_databaseStageStartTime = 0;
 }
 
 RetrieveDICOMFilesFromPACSJob::~RetrieveDICOMFilesFromPACSJob()
@@ -81,6 +85,7 @@ void RetrieveDICOMFilesFromPACSJob::run(ThreadWeaver::JobPointer self, ThreadWea
         .arg(m_studyToRetrieveDICOMFiles->getInstanceUID(), m_seriesInstanceUIDToRetrieve, m_SOPInstanceUIDToRetrieve));
 
     m_retrievedSeriesInstanceUIDSet.clear();
+    m_pipelineTimer.start();
 
     m_retrieveRequestStatus = thereIsAvailableSpaceOnHardDisk();
 
@@ -89,79 +94,81 @@ void RetrieveDICOMFilesFromPACSJob::run(ThreadWeaver::JobPointer self, ThreadWea
         return;
     }
 
-    int localPort = settings.getValue(InputOutputSettings::IncomingDICOMConnectionsPort).toInt();
+    // El port de connexions entrants el comprova i l'obre IncomingDICOMConnectionsDispatcher, perquè el comparteixen les descàrregues simultànies
+    PatientFiller patientFiller(getDICOMSourceRetrieveFiles());
+    QThread fillersThread;
+    patientFiller.moveToThread(&fillersThread);
+    LocalDatabaseManager localDatabaseManager;
 
-    if (PortInUse().isPortInUse(localPort))
+    // S'ha d'especificar com a DirectConnection, perquè sinó aquest signal l'aten qui ha creat el Job, que és la interfície, per tant
+    // no s'atendria fins que la interfície estigui lliure, provocant comportaments incorrectes
+    connect(m_retrieveDICOMFilesFromPACS, SIGNAL(DICOMFileRetrieved(DICOMTagReader*, int)), this, SLOT(DICOMFileRetrieved(DICOMTagReader*, int)),
+            Qt::DirectConnection);
+    // Connectem amb els signals del patientFiller per processar els fitxers descarregats
+    connect(this, SIGNAL(DICOMTagReaderReadyForProcess(DICOMTagReader*)), &patientFiller, SLOT(processDICOMFile(DICOMTagReader*)));
+    connect(this, SIGNAL(DICOMFilesRetrieveFinished()), &patientFiller, SLOT(finishDICOMFilesProcess()));
+    // Cada fitxer processat allibera una plaça de la cua del PatientFiller
+    connect(&patientFiller, SIGNAL(progress(int)), this, SLOT(patientFillerProgress(int)), Qt::DirectConnection);
+    connect(&patientFiller, SIGNAL(patientProcessed(Patient*)), this, SLOT(patientFillerFinished(Patient*)), Qt::DirectConnection);
+    // Connexió entre el processat dels fitxers DICOM i l'inserció al a BD, és important que aquest signal sigui un Qt:DirectConnection perquè així el
+    // el processa els thread dels fillers, d'aquesta manera el thread de descarrega que està esperant a fillersThread.wait() quan surt
+    // d'aquí perquè els fillers ja han acabat ja s'ha inserit el pacient a la base de dades.
+    connect(&patientFiller, SIGNAL(patientProcessed(Patient*)), &localDatabaseManager, SLOT(save(Patient*)), Qt::DirectConnection);
+    // Connexions per finalitzar els threads
+    connect(&patientFiller, SIGNAL(patientProcessed(Patient*)), &fillersThread, SLOT(quit()), Qt::DirectConnection);
+
+    localDatabaseManager.setStudyRetrieving(m_studyToRetrieveDICOMFiles->getInstanceUID());
+    fillersThread.start();
+
+    m_retrieveRequestStatus = m_retrieveDICOMFilesFromPACS->retrieve(m_studyToRetrieveDICOMFiles->getInstanceUID(), m_seriesInstanceUIDToRetrieve,
+        m_SOPInstanceUIDToRetrieve);
+
+    if ((m_retrieveRequestStatus == PACSRequestStatus::RetrieveOk || m_retrieveRequestStatus == PACSRequestStatus::RetrieveSomeDICOMFilesFailed) &&
+        !this->isAbortRequested())
     {
-        m_retrieveRequestStatus = PACSRequestStatus::RetrieveIncomingDICOMConnectionsPortInUse;
-        ERROR_LOG("El port " + QString::number(localPort) + " per a connexions entrants del PACS, esta en us, no es pot descarregar l'estudi");
-    }
-    else
-    {
-        PatientFiller patientFiller(getDICOMSourceRetrieveFiles());
-        QThread fillersThread;
-        patientFiller.moveToThread(&fillersThread);
-        LocalDatabaseManager localDatabaseManager;
-
-        // S'ha d'especificar com a DirectConnection, perquè sinó aquest signal l'aten qui ha creat el Job, que és la interfície, per tant
-        // no s'atendria fins que la interfície estigui lliure, provocant comportaments incorrectes
-        connect(m_retrieveDICOMFilesFromPACS, SIGNAL(DICOMFileRetrieved(DICOMTagReader*, int)), this, SLOT(DICOMFileRetrieved(DICOMTagReader*, int)),
-                Qt::DirectConnection);
-        // Connectem amb els signals del patientFiller per processar els fitxers descarregats
-        connect(this, SIGNAL(DICOMTagReaderReadyForProcess(DICOMTagReader*)), &patientFiller, SLOT(processDICOMFile(DICOMTagReader*)));
-        connect(this, SIGNAL(DICOMFilesRetrieveFinished()), &patientFiller, SLOT(finishDICOMFilesProcess()));
-        // Connexió entre el processat dels fitxers DICOM i l'inserció al a BD, és important que aquest signal sigui un Qt:DirectConnection perquè així el
-        // el processa els thread dels fillers, d'aquesta manera el thread de descarrega que està esperant a fillersThread.wait() quan surt
-        // d'aquí perquè els fillers ja han acabat ja s'ha inserit el pacient a la base de dades.
-        connect(&patientFiller, SIGNAL(patientProcessed(Patient*)), &localDatabaseManager, SLOT(save(Patient*)), Qt::DirectConnection);
-        // Connexions per finalitzar els threads
-        connect(&patientFiller, SIGNAL(patientProcessed(Patient*)), &fillersThread, SLOT(quit()), Qt::DirectConnection);
-
-        localDatabaseManager.setStudyRetrieving(m_studyToRetrieveDICOMFiles->getInstanceUID());
-        fillersThread.start();
-
-        m_retrieveRequestStatus = m_retrieveDICOMFilesFromPACS->retrieve(m_studyToRetrieveDICOMFiles->getInstanceUID(), m_seriesInstanceUIDToRetrieve,
-            m_SOPInstanceUIDToRetrieve);
-
-        if ((m_retrieveRequestStatus == PACSRequestStatus::RetrieveOk || m_retrieveRequestStatus == PACSRequestStatus::RetrieveSomeDICOMFilesFailed) &&
-            !this->isAbortRequested())
-        {
-            INFO_LOG(QString("Ha finalitzat la descarrega de l'estudi %1 del PACS %2, s'han descarregat %3 fitxers")
-                .arg(m_studyToRetrieveDICOMFiles->getInstanceUID(), getPacsDevice().getAETitle())
-                .arg(m_retrieveDICOMFilesFromPACS->getNumberOfDICOMFilesRetrieved()));
+        INFO_LOG(QString("Ha finalitzat la descarrega de l'estudi %1 del PACS %2, s'han descarregat %3 fitxers")
+            .arg(m_studyToRetrieveDICOMFiles->getInstanceUID(), getPacsDevice().getAETitle())
+            .arg(m_retrieveDICOMFilesFromPACS->getNumberOfDICOMFilesRetrieved()));
 
-            // Indiquem que el procés de descàrrega ha finalitzat
-            emit DICOMFilesRetrieveFinished();
+        // Indiquem que el procés de descàrrega ha finalitzat
+        emit DICOMFilesRetrieveFinished();
 
-            // Esperem que el processat i l'insersió a la base de dades acabin
-            fillersThread.wait();
+        // Esperem que el processat i l'insersió a la base de dades acabin
+        fillersThread.wait();
 
-            if (localDatabaseManager.getLastError() != LocalDatabaseManager::Ok)
+        // El pacient es guarda a la base de dades un sol cop, amb tots els fitxers, quan els fillers han acabat
+        m_databaseStageMetrics.addProcessedItem(m_pipelineTimer.elapsed() - m_databaseStageStartTime);
+        INFO_LOG(m_fillStageMetrics.toString());
+        INFO_LOG(m_databaseStageMetrics.toString());
+
+        if (localDatabaseManager.getLastError() != LocalDatabaseManager::Ok)
+        {
+            if (localDatabaseManager.getLastError() == LocalDatabaseManager::PatientInconsistent)
             {
-                if (localDatabaseManager.getLastError() == LocalDatabaseManager::PatientInconsistent)
-                {
-                    // No s'ha pogut inserir el patient, perquè patientfiller no ha pogut emplenar l'informació de patient correctament
-                    m_retrieveRequestStatus = PACSRequestStatus::RetrievePatientInconsistent;
-                }
-                else
-                {
-                    m_retrieveRequestStatus = PACSRequestStatus::RetrieveDatabaseError;
-                }
+                // No s'ha pogut inserir el patient, perquè patientfiller no ha pogut emplenar l'informació de patient correctament
+                m_retrieveRequestStatus = PACSRequestStatus::RetrievePatientInconsistent;
+            }
+            else
+            {
+                m_retrieveRequestStatus = PACSRequestStatus::RetrieveDatabaseError;
             }
         }
-        else
-        {
-            fillersThread.quit();
-            // Esperem que el thread acabi, ja que pel que s'interpreta de la documentació, sembla que el quit del thread no es fa fins que aquest retorna
-            // al eventLoop, això provoca per exemple en els casos que ens han cancel·lat la descàrrega d'un estudi, si no esperem al thread que estigui mort
-            // poguem esborrar imatges que els fillers estan processant en aquell moment mentre encara s'estan executant i peti l'Starviewer, perquè
-            // no s'ha atés el Slot quit del thread, per això esperem que aquest estigui mort a esborrar les imatges descarregades.
-            fillersThread.wait();
-            deleteRetrievedDICOMFilesIfStudyNotExistInDatabase();
-        }
-
-        localDatabaseManager.setStudyRetrieveFinished();
     }
+    else
+    {
+        fillersThread.quit();
+        // Esperem que el thread acabi, ja que pel que s'interpreta de la documentació, sembla que el quit del thread no es fa fins que aquest retorna
+        // al eventLoop, això provoca per exemple en els casos que ens han cancel·lat la descàrrega d'un estudi, si no esperem al thread que estigui mort
+        // poguem esborrar imatges que els fillers estan processant en aquell moment mentre encara s'estan executant i peti l'Starviewer, perquè
+        // no s'ha atés el Slot quit del thread, per això esperem que aquest estigui mort a esborrar les imatges descarregades.
+        fillersThread.wait();
+        deleteRetrievedDICOMFilesIfStudyNotExistInDatabase();
+    }
+
+    localDatabaseManager.setStudyRetrieveFinished(m_studyToRetrieveDICOMFiles->getInstanceUID());
+
+    // L'espai que ocupa la descàrrega s'allibera en segon pla, perquè la següent no l'hagi d'alliberar abans de començar
+    CacheEvictionService::instance()->requestCheck();
 }
 
 void RetrieveDICOMFilesFromPACSJob::requestCancelJob()
@@ -179,6 +186,21 @@ PACSRequestStatus::RetrieveRequestStatus RetrieveDICOMFilesFromPACSJob::getStatu
 
 void RetrieveDICOMFilesFromPACSJob::DICOMFileRetrieved(DICOMTagReader *dicomTagReader, int numberOfImagesRetrieved)
 {
+    // Si el PatientFiller no dóna l'abast esperem que hi hagi lloc a la seva cua. Mentrestant el writer no guarda més fitxers i la seva cua s'omple,
+    // fins que deixem de respondre el PACS.
+    if (!m_fillStageFreeSlots.tryAcquire())
+    {
+        qint64 blockedStartTime = m_pipelineTimer.elapsed();
+        m_fillStageFreeSlots.acquire();
+        m_fillStageMetrics.addBlockedTime(m_pipelineTimer.elapsed() - blockedStartTime);
+    }
+
+    {
+        QMutexLocker locker(&m_fillStageMutex);
+        m_fillStageQueuedTimes.enqueue(m_pipelineTimer.elapsed());
+        m_fillStageMetrics.updateQueueSize(m_fillStageQueuedTimes.size());
+    }
+
     emit DICOMFileRetrieved(m_selfPointer.toStrongRef(), numberOfImagesRetrieved);
 
     /// Actualitzem el número de sèries processades si ens arriba una nova imatge que pertanyi a una sèrie no descarregada fins al moment
@@ -197,6 +219,32 @@ void RetrieveDICOMFilesFromPACSJob::DICOMFileRetrieved(DICOMTagReader *dicomTagR
     emit DICOMTagReaderReadyForProcess(dicomTagReader);
 }
 
+void RetrieveDICOMFilesFromPACSJob::patientFillerProgress(int numberOfProcessedFiles)
+{
+    Q_UNUSED(numberOfProcessedFiles);
+
+    QMutexLocker locker(&m_fillStageMutex);
+    if (m_fillStageQueuedTimes.isEmpty())
+    {
+        return;
+    }
+
+    // El PatientFiller processa els fitxers en ordre, per tant ha començat aquest quan s'ha posat a la cua o quan ha acabat l'anterior
+    qint64 currentTime = m_pipelineTimer.elapsed();
+    qint64 fillStartTime = qMax(m_fillStageQueuedTimes.dequeue(), m_lastFileFilledTime);
+    m_lastFileFilledTime = currentTime;
+    m_fillStageMetrics.addProcessedItem(currentTime - fillStartTime);
+
+    m_fillStageFreeSlots.release();
+}
+
+void RetrieveDICOMFilesFromPACSJob::patientFillerFinished(Patient *patient)
+{
+    Q_UNUSED(patient);
+
+    m_databaseStageStartTime = m_pipelineTimer.elapsed();
+}
+
 int RetrieveDICOMFilesFromPACSJob::priority() const
 {
     return m_retrievePriorityJob;
@@ -204,6 +252,8 @@ int RetrieveDICOMFilesFromPACSJob::priority() const
 
 PACSRequestStatus::RetrieveRequestStatus RetrieveDICOMFilesFromPACSJob::thereIsAvailableSpaceOnHardDisk()
 {
+    // Normalment CacheEvictionService manté prou espai lliure i aquí només es consulta l'espai del disc. Si no ha donat l'abast s'allibera l'espai
+    // abans de començar la descàrrega, fent servir la mida dels estudis guardada a la base de dades
     LocalDatabaseManager localDatabaseManager;
     // TODO: Aquest signal no s'hauria de fer des d'aquesta classe sinó des d'una CacheManager, però com de moment encara no està implementada
     //       temporalment emetem el signal des d'aquí*/
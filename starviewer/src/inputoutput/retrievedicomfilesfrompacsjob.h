@@ -15,12 +15,17 @@
 #ifndef RETRIEVEDICOMFILESFROMPACSJOB_H
 #define RETRIEVEDICOMFILESFROMPACSJOB_H
 
+#include <QElapsedTimer>
+#include <QMutex>
 #include <QObject>
+#include <QQueue>
+#include <QSemaphore>
 #include <QSet>
 
 #include "pacsjob.h"
 #include "pacsrequeststatus.h"
 #include "dicommask.h"
+#include "pipelinestagemetrics.h"
 
 namespace udg {
 
@@ -87,6 +92,12 @@ private slots:
     /// Slot que s'activa quan s'ha descarregat una imatge, respn al signal DICOMFileRetrieved de RetrieveDICOMFilesFromPACS
     void DICOMFileRetrieved(DICOMTagReader *dicomTagReader, int numberOfImagesRetrieved);
 
+    /// Respon al signal progress de PatientFiller, des del thread dels fillers, quan s'ha acabat de processar un fitxer
+    void patientFillerProgress(int numberOfProcessedFiles);
+
+    /// Respon al signal patientProcessed de PatientFiller, des del thread dels fillers, just abans de guardar el pacient a la base de dades
+    void patientFillerFinished(Patient *patient);
+
 private:
     /// Indica la prioritat del job
     // Sobreescribim el mtode priority de la classe ThreadWeaver::Job
@@ -120,6 +131,19 @@ private:
     
     /// Conjunt que conté els diferents UIDs de sèrie de les imatges descarregades
     QSet<QString> m_retrievedSeriesInstanceUIDSet;
+
+    /// Places lliures a la cua de fitxers pendents de processar pel PatientFiller. Quan no n'hi ha, el thread que guarda els fitxers s'espera.
+    QSemaphore m_fillStageFreeSlots;
+    /// Moment en què s'ha posat a la cua cada fitxer pendent de processar, per calcular quant ha trigat el PatientFiller
+    QQueue<qint64> m_fillStageQueuedTimes;
+    qint64 m_lastFileFilledTime;
+    qint64 m_databaseStageStartTime;
+    QMutex m_fillStageMutex;
+
+    /// Temps des de l'inici de la descàrrega, que fan servir les mètriques de les etapes
+    QElapsedTimer m_pipelineTimer;
+    PipelineStageMetrics m_fillStageMetrics;
+    PipelineStageMetrics m_databaseStageMetrics;
 };
 
 }
@@ -21,7 +21,10 @@
 #include <dcdeftag.h>
 
 #include <QDir>
+#include <QMutexLocker>
+#include <QRunnable>
 #include <QSet>
+#include <QThreadPool>
 
 #include "logging.h"
 #include "image.h"
@@ -31,11 +34,39 @@
 
 namespace udg {
 
+/// Obre una associació més amb el PACS i hi envia fitxers pendents, en un thread del QThreadPool de send()
+class SendDICOMFilesToPACS::AssociationSender : public QRunnable {
+public:
+    AssociationSender(SendDICOMFilesToPACS *sendDICOMFilesToPACS)
+     : m_sendDICOMFilesToPACS(sendDICOMFilesToPACS)
+    {
+    }
+
+    void run()
+    {
+        QScopedPointer<PACSConnection> pacsConnection(m_sendDICOMFilesToPACS->createPACSConnection(m_sendDICOMFilesToPACS->m_pacs));
+        if (!pacsConnection->connectToPACS(PACSConnection::SendDICOMFiles))
+        {
+            // La resta d'associacions continuen enviant els fitxers
+            WARN_LOG("No s'ha pogut obrir una de les associacions en paral.lel per enviar fitxers al PACS " + m_sendDICOMFilesToPACS->m_pacs.getAETitle());
+            return;
+        }
+
+        m_sendDICOMFilesToPACS->sendPendingFiles(pacsConnection->getConnection());
+        pacsConnection->disconnect();
+    }
+
+private:
+    SendDICOMFilesToPACS *m_sendDICOMFilesToPACS;
+};
+
 SendDICOMFilesToPACS::SendDICOMFilesToPACS(PacsDevice pacsDevice)
  : DIMSECService()
 {
     m_pacs = pacsDevice;
     m_abortIsRequested = false;
+    m_pacsConnectionBroken = false;
+    m_nextImageToSend = 0;
 
     this->setUpAsCStore();
 }
@@ -57,29 +88,66 @@ PACSRequestStatus::SendRequestStatus SendDICOMFilesToPACS::send(QList<Image*> im
 
     removeDuplicateFiles(imageListToSend);
     initialitzeDICOMFilesCounters(imageListToSend.count());
+    m_imagesToSend = imageListToSend;
+    m_nextImageToSend = 0;
+    m_pacsConnectionBroken = false;
+
+    // No té sentit obrir més associacions que fitxers a enviar. La primera és la que acabem d'obrir i l'aprofitem en aquest thread.
+    int numberOfAssociations = qMin(qMax(m_pacs.getNumberOfStoreServiceAssociations(), 1), qMax(imageListToSend.count(), 1));
+    QThreadPool associationSendersPool;
+    associationSendersPool.setMaxThreadCount(qMax(numberOfAssociations - 1, 1));
 
-    foreach (Image *imageToStore, imageListToSend)
+    for (int i = 1; i < numberOfAssociations; i++)
     {
-        if (m_abortIsRequested)
-        {
-            break;
-        }
+        associationSendersPool.start(new AssociationSender(this));
+    }
+
+    sendPendingFiles(pacsConnection->getConnection());
+    associationSendersPool.waitForDone();
+
+    pacsConnection->disconnect();
+
+    return getStatusStoreSCU();
+}
+
+void SendDICOMFilesToPACS::sendPendingFiles(T_ASC_Association *association)
+{
+    Image *imageToStore;
+
+    while ((imageToStore = takeNextImageToSend()) != NULL)
+    {
+        OFCondition condition;
 
         INFO_LOG(QString("S'enviara al PACS %1 el fitxer %2").arg(m_pacs.getAETitle(), imageToStore->getPath()));
-        if (storeSCU(pacsConnection->getConnection(), qPrintable(imageToStore->getPath())))
+        if (storeSCU(association, qPrintable(imageToStore->getPath()), condition))
         {
-            emit DICOMFileSent(imageToStore, getNumberOfDICOMFilesSentSuccesfully() + this->getNumberOfDICOMFilesSentWarning());
+            // Copiem els comptadors i emetem sense el mutex bloquejat, perquè els slots connectats no bloquegin les altres associacions
+            int numberOfDICOMFilesSent;
+            {
+                QMutexLocker locker(&m_countersMutex);
+                numberOfDICOMFilesSent = m_numberOfDICOMFilesSentSuccessfully + m_numberOfDICOMFilesSentWithWarning;
+            }
+            emit DICOMFileSent(imageToStore, numberOfDICOMFilesSent);
         }
-        else if (m_lastOFCondition == DIMSE_SENDFAILED)
+        else if (condition == DIMSE_SENDFAILED)
         {
             // Si se'ns retorna un OFCondition == DIMSE_SENDFAILED, indica que s'ha perdut la connexió amb el PACS
-            break;
+            QMutexLocker locker(&m_imagesToSendMutex);
+            m_pacsConnectionBroken = true;
         }
     }
+}
 
-    pacsConnection->disconnect();
+Image* SendDICOMFilesToPACS::takeNextImageToSend()
+{
+    QMutexLocker locker(&m_imagesToSendMutex);
 
-    return getStatusStoreSCU();
+    if (m_abortIsRequested || m_pacsConnectionBroken || m_nextImageToSend >= m_imagesToSend.count())
+    {
+        return NULL;
+    }
+
+    return m_imagesToSend.at(m_nextImageToSend++);
 }
 
 void SendDICOMFilesToPACS::requestCancel()
@@ -129,9 +197,9 @@ void SendDICOMFilesToPACS::initialitzeDICOMFilesCounters(int numberOfDICOMFilesT
 // Parameters:
 //   association - [in] The associationiation (network connection to another DICOM application).
 //   filepathToStore - [in] Name of the file which shall be processed.
-bool SendDICOMFilesToPACS::storeSCU(T_ASC_Association *association, QString filepathToStore)
+//   condition - [out] Result of the operation.
+bool SendDICOMFilesToPACS::storeSCU(T_ASC_Association *association, QString filepathToStore, OFCondition &condition)
 {
-    DIC_US msgId = association->nextMsgID++;
     T_ASC_PresentationContextID presentationContextID;
     T_DIMSE_C_StoreRQ request;
     T_DIMSE_C_StoreRSP response;
@@ -139,33 +207,44 @@ bool SendDICOMFilesToPACS::storeSCU(T_ASC_Association *association, QString file
     DIC_UI sopInstance;
     DcmDataset *statusDetail = NULL;
     DcmFileFormat dcmff;
+    // Si és NULL el fitxer s'envia directament des de disc
+    DcmDataset *datasetToStore = NULL;
+    QByteArray nativeFilePathToStore = QDir::toNativeSeparators(filepathToStore).toLocal8Bit();
 
-    m_lastOFCondition = dcmff.loadFile(qPrintable(QDir::toNativeSeparators(filepathToStore)));
+    presentationContextID = findPresentationContextToSendFileFromDisk(association, filepathToStore, sopClass, sopInstance);
 
-    // Figure out if an error occured while the file was read
-    if (m_lastOFCondition.bad())
-    {
-        ERROR_LOG("No s'ha pogut obrir el fitxer " + filepathToStore);
-        return false;
-    }
-    // Figure out which SOP class and SOP instance is encapsulated in the file
-    if (!DU_findSOPClassAndInstanceInDataSet(dcmff.getDataset(), sopClass, sopInstance, OFFalse))
+    if (presentationContextID == 0)
     {
-        ERROR_LOG("No s'ha pogut obtenir el SOPClass i SOPInstance del fitxer " + filepathToStore);
-        return false;
-    }
+        // El PACS no accepta la transfer syntax del fitxer, l'hem de carregar perquè DCMTK el converteixi a la del presentation context
+        condition = dcmff.loadFile(nativeFilePathToStore.constData());
 
-    // Figure out which of the accepted presentation contexts should be used
-    DcmXfer filexfer(dcmff.getDataset()->getOriginalXfer());
+        // Figure out if an error occured while the file was read
+        if (condition.bad())
+        {
+            ERROR_LOG("No s'ha pogut obrir el fitxer " + filepathToStore);
+            return false;
+        }
+        // Figure out which SOP class and SOP instance is encapsulated in the file
+        if (!DU_findSOPClassAndInstanceInDataSet(dcmff.getDataset(), sopClass, sopInstance, OFFalse))
+        {
+            ERROR_LOG("No s'ha pogut obtenir el SOPClass i SOPInstance del fitxer " + filepathToStore);
+            return false;
+        }
 
-    // Busquem dels presentationContextID que hem establert al connectar quin és el que hem d'utilitzar per transferir aquesta imatge
-    if (filexfer.getXfer() != EXS_Unknown)
-    {
-        presentationContextID = ASC_findAcceptedPresentationContextID(association, sopClass, filexfer.getXferID());
-    }
-    else
-    {
-        presentationContextID = ASC_findAcceptedPresentationContextID(association, sopClass);
+        // Figure out which of the accepted presentation contexts should be used
+        DcmXfer filexfer(dcmff.getDataset()->getOriginalXfer());
+
+        // Busquem dels presentationContextID que hem establert al connectar quin és el que hem d'utilitzar per transferir aquesta imatge
+        if (filexfer.getXfer() != EXS_Unknown)
+        {
+            presentationContextID = ASC_findAcceptedPresentationContextID(association, sopClass, filexfer.getXferID());
+        }
+        else
+        {
+            presentationContextID = ASC_findAcceptedPresentationContextID(association, sopClass);
+        }
+
+        datasetToStore = dcmff.getDataset();
     }
 
     if (presentationContextID == 0)
@@ -192,34 +271,75 @@ bool SendDICOMFilesToPACS::storeSCU(T_ASC_Association *association, QString file
     {
         // Prepare the transmission of data
         bzero((char*)&request, sizeof(request));
-        request.MessageID = msgId;
+        request.MessageID = association->nextMsgID++;
         strcpy(request.AffectedSOPClassUID, sopClass);
         strcpy(request.AffectedSOPInstanceUID, sopInstance);
         request.DataSetType = DIMSE_DATASET_PRESENT;
         request.Priority = DIMSE_PRIORITY_LOW;
 
-        m_lastOFCondition = DIMSE_storeUser(association, presentationContextID, &request, NULL /*imageFileName*/, dcmff.getDataset(),
-                                            NULL /*progressCallback*/, NULL /*callbackData */, DIMSE_NONBLOCKING,
-                                            Settings().getValue(InputOutputSettings::PACSConnectionTimeout).toInt(), &response, &statusDetail,
-                                            NULL /*check for cancel parameters*/, OFStandard::getFileSize(qPrintable(filepathToStore)));
+        condition = DIMSE_storeUser(association, presentationContextID, &request, datasetToStore ? NULL : nativeFilePathToStore.constData(), datasetToStore,
+                                    NULL /*progressCallback*/, NULL /*callbackData */, DIMSE_NONBLOCKING,
+                                    Settings().getValue(InputOutputSettings::PACSConnectionTimeout).toInt(), &response, &statusDetail,
+                                    NULL /*check for cancel parameters*/, OFStandard::getFileSize(nativeFilePathToStore.constData()));
 
-        if (m_lastOFCondition.bad())
+        if (condition.bad())
         {
-            ERROR_LOG("S'ha produit un error al fer el store de la imatge " + filepathToStore + ", descripció de l'error" + QString(m_lastOFCondition.text()));
+            ERROR_LOG("S'ha produit un error al fer el store de la imatge " + filepathToStore + ", descripció de l'error" + QString(condition.text()));
         }
 
-        processResponseFromStoreSCP(response.DimseStatus, filepathToStore);
-        processServiceClassProviderResponseStatus(response.DimseStatus, statusDetail);
+        {
+            QMutexLocker locker(&m_countersMutex);
+            processResponseFromStoreSCP(response.DimseStatus, filepathToStore);
+            processServiceClassProviderResponseStatus(response.DimseStatus, statusDetail);
+        }
 
         if (statusDetail != NULL)
         {
             delete statusDetail;
         }
 
-        return m_lastOFCondition.good() && response.DimseStatus == STATUS_Success;
+        return condition.good() && response.DimseStatus == STATUS_Success;
     }
 }
 
+T_ASC_PresentationContextID SendDICOMFilesToPACS::findPresentationContextToSendFileFromDisk(T_ASC_Association *association,
+                                                                                            const QString &filePathToStore, DIC_UI sopClass,
+                                                                                            DIC_UI sopInstance)
+{
+    DcmMetaInfo metaInfo;
+    OFString metaInfoSOPClass, metaInfoSOPInstance, metaInfoTransferSyntax;
+
+    // Sense meta-header no sabem la transfer syntax del fitxer sense llegir-lo sencer
+    if (metaInfo.loadFile(qPrintable(QDir::toNativeSeparators(filePathToStore))).bad() ||
+        metaInfo.findAndGetOFString(DCM_MediaStorageSOPClassUID, metaInfoSOPClass).bad() ||
+        metaInfo.findAndGetOFString(DCM_MediaStorageSOPInstanceUID, metaInfoSOPInstance).bad() ||
+        metaInfo.findAndGetOFString(DCM_TransferSyntaxUID, metaInfoTransferSyntax).bad())
+    {
+        return 0;
+    }
+
+    T_ASC_PresentationContextID presentationContextID = ASC_findAcceptedPresentationContextID(association, metaInfoSOPClass.c_str(),
+                                                                                              metaInfoTransferSyntax.c_str());
+    if (presentationContextID == 0)
+    {
+        return 0;
+    }
+
+    // Si no troba cap presentation context amb la transfer syntax demanada, ASC_findAcceptedPresentationContextID en retorna un altre de la mateixa
+    // SOP class. Per enviar el fitxer tal com està a disc ha de ser exactament la del fitxer.
+    T_ASC_PresentationContext presentationContext;
+    if (ASC_findAcceptedPresentationContext(association->params, presentationContextID, &presentationContext).bad() ||
+        metaInfoTransferSyntax != presentationContext.acceptedTransferSyntax)
+    {
+        return 0;
+    }
+
+    OFStandard::strlcpy(sopClass, metaInfoSOPClass.c_str(), sizeof(DIC_UI));
+    OFStandard::strlcpy(sopInstance, metaInfoSOPInstance.c_str(), sizeof(DIC_UI));
+
+    return presentationContextID;
+}
+
 void SendDICOMFilesToPACS::processResponseFromStoreSCP(unsigned int dimseStatusCode, QString filePathDicomObjectStoredFailed)
 {
     QString messageErrorLog = "No s'ha pogut enviar el fitxer " + filePathDicomObjectStoredFailed + ", descripció error rebuda";
@@ -282,7 +402,7 @@ PACSRequestStatus::SendRequestStatus SendDICOMFilesToPACS::getStatusStoreSCU()
         INFO_LOG("S'ha abortat l'enviament d'imatges al PACS");
         return PACSRequestStatus::SendCancelled;
     }
-    else if (m_lastOFCondition == DIMSE_SENDFAILED)
+    else if (m_pacsConnectionBroken)
     {
         ERROR_LOG("S'ha perdut la connexio amb el PACS mentre s'enviaven els fitxers");
         return PACSRequestStatus::SendPACSConnectionBroken;
@@ -16,8 +16,10 @@
 #define UDGSENDDICOMFILESTOPACS_H
 
 #include <QList>
+#include <QMutex>
 #include <QObject>
 #include <ofcond.h>
+#include <assoc.h>
 
 #include "pacsdevice.h"
 #include "pacsrequeststatus.h"
@@ -26,7 +28,6 @@
 class DcmDataset;
 
 struct T_DIMSE_C_StoreRSP;
-struct T_ASC_Association;
 
 namespace udg {
 
@@ -41,7 +42,8 @@ public:
     /// Retorna el PACS que s'ha passat al constructor i amb el qual es fa el send de fitxers DICOM
     PacsDevice getPacs();
 
-    /// Guarda les imatges que s'especifiquen a la llista en el pacs establert per la connexió
+    /// Guarda les imatges que s'especifiquen a la llista en el pacs establert per la connexió. S'obren tantes associacions en paral·lel com indica
+    /// PacsDevice::getNumberOfStoreServiceAssociations() i cadascuna va enviant el següent fitxer pendent.
     /// @param ImageListStore de les imatges a enviar al PACS
     /// @return indica estat del mètode
     PACSRequestStatus::SendRequestStatus send(QList<Image*> imageListToSend);
@@ -68,8 +70,11 @@ protected:
 
     /// Number of files that have been sent successfully.
     int m_numberOfDICOMFilesSentSuccessfully;
+    /// Protects the counters, which are updated from all the associations that send files in parallel.
+    QMutex m_countersMutex;
 
 private:
+    class AssociationSender;
 
     /// Creates and returns a PACS connection to the given PACS device.
     virtual PACSConnection* createPACSConnection(const PacsDevice &pacsDevice) const;
@@ -83,8 +88,20 @@ private:
     /// Processa un resposta del Store SCP que no ha tingut l'Status Successfull
     void processResponseFromStoreSCP(unsigned int dimseStatusCode, QString filePathDicomObjectStoredFailed);
 
-    /// Envia una image al PACS amb l'associació passada per paràmetre, retorna si la imatge s'ha enviat correctament
-    virtual bool storeSCU(T_ASC_Association *association, QString filePathToStore);
+    /// Envia per l'associació passada per paràmetre els fitxers pendents fins que no en queden, es cancel·la l'enviament o es perd la connexió
+    void sendPendingFiles(T_ASC_Association *association);
+
+    /// Retorna el següent fitxer pendent d'enviar, o NULL si no en queden o s'ha d'aturar l'enviament
+    Image* takeNextImageToSend();
+
+    /// Envia una image al PACS amb l'associació passada per paràmetre, retorna si la imatge s'ha enviat correctament. A condition hi deixa el
+    /// resultat de l'operació, que indica si s'ha perdut la connexió.
+    virtual bool storeSCU(T_ASC_Association *association, QString filePathToStore, OFCondition &condition);
+
+    /// Si el PACS accepta la transfer syntax del fitxer, retorna el presentation context per enviar-lo directament des de disc sense carregar-lo a
+    /// memòria i deixa a sopClass i sopInstance els del fitxer. Només es llegeix el meta-header del fitxer. Si no es pot, retorna 0.
+    T_ASC_PresentationContextID findPresentationContextToSendFileFromDisk(T_ASC_Association *association, const QString &filePathToStore,
+                                                                           DIC_UI sopClass, DIC_UI sopInstance);
 
     /// Retorna un Status indicant com ha finalitzat l'operació C-Store
     PACSRequestStatus::SendRequestStatus getStatusStoreSCU();
@@ -97,7 +114,13 @@ private:
     int m_numberOfDICOMFilesToSend;
     PacsDevice m_pacs;
     bool m_abortIsRequested;
-    OFCondition m_lastOFCondition;
+    /// Indica si s'ha perdut la connexió amb el PACS en alguna de les associacions
+    bool m_pacsConnectionBroken;
+
+    /// Fitxers a enviar i índex del següent que s'ha d'enviar, protegits per m_imagesToSendMutex
+    QList<Image*> m_imagesToSend;
+    int m_nextImageToSend;
+    QMutex m_imagesToSendMutex;
 
 };
 
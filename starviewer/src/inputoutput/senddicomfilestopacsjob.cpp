@@ -53,8 +53,7 @@ void SendDICOMFilesToPACSJob::run(ThreadWeaver::JobPointer self, ThreadWeaver::T
     Q_UNUSED(self)
     Q_UNUSED(thread)
 
-    m_lastDICOMFileSeriesInstanceUID = "";
-    m_numberOfSeriesSent = 0;
+    m_seriesInstanceUIDsSent.clear();
 
     if (m_imagesToSend.count() > 0)
     {
@@ -66,14 +65,6 @@ void SendDICOMFilesToPACSJob::run(ThreadWeaver::JobPointer self, ThreadWeaver::T
         connect(m_sendDICOMFilesToPACS, SIGNAL(DICOMFileSent(Image *, int)), SLOT(DICOMFileSent(Image *, int)), Qt::DirectConnection);
 
         m_sendRequestStatus = m_sendDICOMFilesToPACS->send(getFilesToSend());
-
-        if (m_sendRequestStatus == PACSRequestStatus::SendOk || m_sendRequestStatus == PACSRequestStatus::SendSomeDICOMFilesFailed ||
-            m_sendRequestStatus == PACSRequestStatus::SendWarningForSomeImages)
-        {
-            /// Si s'han envait imatges indiquem que s'ha enviat la última sèrie
-            m_numberOfSeriesSent++;
-            emit DICOMSeriesSent(m_selfPointer.toStrongRef(), m_numberOfSeriesSent);
-        }
     }
 }
 
@@ -167,17 +158,25 @@ Study* SendDICOMFilesToPACSJob::getStudyOfDICOMFilesToSend()
 
 void SendDICOMFilesToPACSJob::DICOMFileSent(Image *imageSent, int numberOfDICOMFilesSent)
 {
-    // Pressuposem que les imatges venen agrupades per sèries, sino és així s'ha de modificar aquest codi, perquè sinó es comptabilitzaran més series enviades
-    // de les que realment s'han enviat
     emit DICOMFileSent(m_selfPointer.toStrongRef(), numberOfDICOMFilesSent);
 
-    if (imageSent->getParentSeries()->getInstanceUID() != m_lastDICOMFileSeriesInstanceUID && !m_lastDICOMFileSeriesInstanceUID.isEmpty())
+    // Es crida des del thread de cada associació, els signals s'emeten sense tenir el mutex bloquejat
+    int numberOfSeriesSent = 0;
     {
-        m_numberOfSeriesSent++;
-        emit DICOMSeriesSent(m_selfPointer.toStrongRef(), m_numberOfSeriesSent);
+        QMutexLocker locker(&m_seriesInstanceUIDsSentMutex);
+        QString seriesInstanceUID = imageSent->getParentSeries()->getInstanceUID();
+
+        if (!m_seriesInstanceUIDsSent.contains(seriesInstanceUID))
+        {
+            m_seriesInstanceUIDsSent.insert(seriesInstanceUID);
+            numberOfSeriesSent = m_seriesInstanceUIDsSent.count();
+        }
     }
 
-    m_lastDICOMFileSeriesInstanceUID = imageSent->getParentSeries()->getInstanceUID();
+    if (numberOfSeriesSent > 0)
+    {
+        emit DICOMSeriesSent(m_selfPointer.toStrongRef(), numberOfSeriesSent);
+    }
 }
 
 };
@@ -16,6 +16,8 @@
 #define UDGSENDDICOMFILESTOPACSJOB_H
 
 #include <QObject>
+#include <QMutex>
+#include <QSet>
 
 #include "pacsjob.h"
 #include "pacsdevice.h"
@@ -60,7 +62,7 @@ signals:
     /// Signal que s'emet quan s'enviat una imatge al PACS
     void DICOMFileSent(PACSJobPointer pacsJob, int numberOfDICOMFilesSent);
 
-    /// Signal que s'emet quan s'ha enviat un serie completa al PACS
+    /// Signal que s'emet quan s'ha enviat al PACS la primera imatge d'una sèrie, amb el número de sèries diferents de les quals s'han enviat imatges
     void DICOMSeriesSent(PACSJobPointer pacsJob, int numberOfSeriesSent);
 
 private:
@@ -75,8 +77,11 @@ private:
     QList<Image*> m_imagesToSend;
     PACSRequestStatus::SendRequestStatus m_sendRequestStatus;
     SendDICOMFilesToPACS *m_sendDICOMFilesToPACS;
-    int m_numberOfSeriesSent;
-    QString m_lastDICOMFileSeriesInstanceUID;
+    /// Sèries de les quals s'ha enviat alguna imatge. Les imatges s'envien per diverses associacions en paral·lel i no acaben en ordre, per això
+    /// no es pot suposar que una sèrie s'ha acabat d'enviar quan arriba una imatge d'una altra.
+    QSet<QString> m_seriesInstanceUIDsSent;
+    /// Protegeix m_seriesInstanceUIDsSent, que s'actualitza des del thread de cada associació
+    QMutex m_seriesInstanceUIDsSentMutex;
 };
 
 };
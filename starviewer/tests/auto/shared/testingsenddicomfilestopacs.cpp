@@ -2,6 +2,8 @@
 
 #include "testingpacsconnection.h"
 
+#include <QMutexLocker>
+
 namespace testing {
 
 TestingSendDICOMFilesToPACS::TestingSendDICOMFilesToPACS(const PacsDevice &pacsDevice) :
@@ -15,10 +17,12 @@ PACSConnection* TestingSendDICOMFilesToPACS::createPACSConnection(const PacsDevi
     return new TestingPACSConnection();
 }
 
-bool TestingSendDICOMFilesToPACS::storeSCU(T_ASC_Association *association, QString filePathToStore)
+bool TestingSendDICOMFilesToPACS::storeSCU(T_ASC_Association *association, QString filePathToStore, OFCondition &condition)
 {
     Q_UNUSED(association)
     Q_UNUSED(filePathToStore)
+    condition = EC_Normal;
+    QMutexLocker locker(&m_countersMutex);
     m_numberOfDICOMFilesSentSuccessfully++;
     return true;
 }
@@ -16,7 +16,7 @@ public:
 private:
 
     virtual PACSConnection* createPACSConnection(const PacsDevice &pacsDevice) const;
-    virtual bool storeSCU(T_ASC_Association *association, QString filePathToStore);
+    virtual bool storeSCU(T_ASC_Association *association, QString filePathToStore, OFCondition &condition);
 
 };
 
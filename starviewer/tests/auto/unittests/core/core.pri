@@ -59,6 +59,7 @@ SOURCES += $$PWD/test_image.cpp \
            $$PWD/test_areameasurecomputer.cpp \
            $$PWD/test_colortransferfunction.cpp \
            $$PWD/test_volumepixeldataiterator.cpp \
+           $$PWD/test_volumepixeldatacache.cpp \
            $$PWD/test_patientcomparer.cpp \
            $$PWD/test_syncactionsconfiguration.cpp \
            $$PWD/test_dicomserviceresponsestatus.cpp \
@@ -68,10 +69,12 @@ SOURCES += $$PWD/test_image.cpp \
            $$PWD/test_filteroutput.cpp \
            $$PWD/test_orthogonalplane.cpp \
            $$PWD/test_slicehandler.cpp \
+           $$PWD/test_slicelocator.cpp \
            $$PWD/test_voxel.cpp \
            $$PWD/test_roidata.cpp \
            $$PWD/test_mammographyimagehelper.cpp \
            $$PWD/test_transferfunction.cpp \
+           $$PWD/test_minmaxbrickgrid.cpp \
            $$PWD/test_leanbodymassformula.cpp \
            $$PWD/test_bodysurfaceareaformula.cpp \
            $$PWD/test_decaycorrectionfactorformula.cpp \
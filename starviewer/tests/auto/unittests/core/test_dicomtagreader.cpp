@@ -5,7 +5,12 @@
 
 #include <dcdatset.h>
 #include <dcdeftag.h>
+#include <dcfilefo.h>
 #include <dcsequen.h>
+#include <dcuid.h>
+
+#include <QTemporaryDir>
+#include <QVector>
 
 using namespace udg;
 
@@ -17,6 +22,8 @@ private slots:
     
     void getValueAttribute_ReturnsExpectedValues_data();
     void getValueAttribute_ReturnsExpectedValues();
+
+    void setFile_WithReadHeaderOnly_ReadsHeaderAndLeavesPixelDataOnDisk();
 };
 
 Q_DECLARE_METATYPE(DcmDataset*)
@@ -110,6 +117,46 @@ void test_DICOMTagReader::getValueAttribute_ReturnsExpectedValues()
     QCOMPARE(expectedValue->getValueAsByteArray(), returnValue->getValueAsByteArray());
 }
 
+void test_DICOMTagReader::setFile_WithReadHeaderOnly_ReadsHeaderAndLeavesPixelDataOnDisk()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QString filename = directory.path() + "/image.dcm";
+
+    const int numberOfPixels = 256 * 256;
+    QVector<Uint16> pixels(numberOfPixels);
+    for (int i = 0; i < numberOfPixels; i++)
+    {
+        pixels[i] = i % 4096;
+    }
+
+    DcmFileFormat fileFormat;
+    DcmDataset *dataset = fileFormat.getDataset();
+    dataset->putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage);
+    dataset->putAndInsertString(DCM_SOPInstanceUID, "1.2.3.4");
+    dataset->putAndInsertString(DCM_PatientName, "JOHN^DOE");
+    dataset->putAndInsertUint16(DCM_Rows, 256);
+    dataset->putAndInsertUint16(DCM_Columns, 256);
+    dataset->putAndInsertUint16Array(DCM_PixelData, pixels.constData(), numberOfPixels);
+    QVERIFY(fileFormat.saveFile(qPrintable(filename), EXS_LittleEndianExplicit).good());
+
+    DICOMTagReader tagReader(filename, DICOMTagReader::ReadHeaderOnly);
+
+    QVERIFY(tagReader.canReadFile());
+    QCOMPARE(tagReader.getValueAttributeAsQString(DICOMPatientName), QString("JOHN^DOE"));
+    QCOMPARE(tagReader.getValueAttributeAsQString(DICOMRows), QString("256"));
+    QVERIFY(tagReader.tagExists(DICOMPixelData));
+
+    DcmElement *pixelData = 0;
+    QVERIFY(tagReader.getDcmDataset()->findAndGetElement(DCM_PixelData, pixelData).good());
+    QVERIFY(!pixelData->valueLoaded());
+
+    // The pixel data is read from the file when it is requested
+    const Uint16 *readPixels = 0;
+    QVERIFY(tagReader.getDcmDataset()->findAndGetUint16Array(DCM_PixelData, readPixels).good());
+    QCOMPARE(memcmp(readPixels, pixels.constData(), numberOfPixels * sizeof(Uint16)), 0);
+}
+
 DECLARE_TEST(test_DICOMTagReader)
 
 #include "test_dicomtagreader.moc"
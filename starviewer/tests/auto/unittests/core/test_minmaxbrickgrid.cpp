@@ -0,0 +1,144 @@
+#include "autotest.h"
+#include "minmaxbrickgrid.h"
+
+#include "transferfunction.h"
+
+#include <QVector>
+
+using namespace udg;
+
+class test_MinMaxBrickGrid : public QObject {
+
+    Q_OBJECT
+
+private slots:
+
+    void setData_ShouldComputeMinimumAndMaximumOfEachBrickWithMargin();
+
+    void setTransferFunction_ShouldMarkTransparentBricks();
+
+    void getNumberOfTransparentSteps_ShouldReturnExpectedValue_data();
+    void getNumberOfTransparentSteps_ShouldReturnExpectedValue();
+
+    void getNumberOfTransparentSteps_ShouldReturnZeroWithoutData();
+
+private:
+    /// Returns a 32x1x1 volume with value 0 in the voxels with x < 20 and value 100 in the rest.
+    static QVector<unsigned short> createStepVolume();
+    /// Returns a transfer function that is transparent up to 50 and opaque from there on.
+    static TransferFunction createStepTransferFunction();
+
+};
+
+Q_DECLARE_METATYPE(Vector3)
+
+QVector<unsigned short> test_MinMaxBrickGrid::createStepVolume()
+{
+    QVector<unsigned short> data(32);
+    for (int x = 0; x < data.size(); x++)
+    {
+        data[x] = x < 20 ? 0 : 100;
+    }
+    return data;
+}
+
+TransferFunction test_MinMaxBrickGrid::createStepTransferFunction()
+{
+    TransferFunction transferFunction;
+    transferFunction.setOpacity(0.0, 0.0);
+    transferFunction.setOpacity(50.0, 0.0);
+    transferFunction.setOpacity(100.0, 1.0);
+    return transferFunction;
+}
+
+void test_MinMaxBrickGrid::setData_ShouldComputeMinimumAndMaximumOfEachBrickWithMargin()
+{
+    QVector<unsigned short> data(20);
+    for (int x = 0; x < data.size(); x++)
+    {
+        data[x] = x;
+    }
+    int dimensions[3] = { 20, 1, 1 };
+
+    MinMaxBrickGrid grid;
+    grid.setData(data.constData(), dimensions);
+
+    QVERIFY(grid.hasData());
+    QCOMPARE(grid.getNumberOfBricks()[0], 3);
+    QCOMPARE(grid.getNumberOfBricks()[1], 1);
+    QCOMPARE(grid.getNumberOfBricks()[2], 1);
+    QCOMPARE(grid.getMinimum(0, 0, 0), static_cast<unsigned short>(0));
+    QCOMPARE(grid.getMaximum(0, 0, 0), static_cast<unsigned short>(9));
+    QCOMPARE(grid.getMinimum(1, 0, 0), static_cast<unsigned short>(7));
+    QCOMPARE(grid.getMaximum(1, 0, 0), static_cast<unsigned short>(17));
+    QCOMPARE(grid.getMinimum(2, 0, 0), static_cast<unsigned short>(15));
+    QCOMPARE(grid.getMaximum(2, 0, 0), static_cast<unsigned short>(19));
+}
+
+void test_MinMaxBrickGrid::setTransferFunction_ShouldMarkTransparentBricks()
+{
+    QVector<unsigned short> data = createStepVolume();
+    int dimensions[3] = { 32, 1, 1 };
+
+    MinMaxBrickGrid grid;
+    grid.setData(data.constData(), dimensions);
+    grid.setTransferFunction(createStepTransferFunction());
+
+    QCOMPARE(grid.getNumberOfBricks()[0], 4);
+    QCOMPARE(grid.isTransparent(0, 0, 0), true);
+    QCOMPARE(grid.isTransparent(1, 0, 0), true);
+    QCOMPARE(grid.isTransparent(2, 0, 0), false);
+    QCOMPARE(grid.isTransparent(3, 0, 0), false);
+
+    TransferFunction opaqueTransferFunction;
+    opaqueTransferFunction.setOpacity(0.0, 0.5);
+    grid.setTransferFunction(opaqueTransferFunction);
+
+    QCOMPARE(grid.isTransparent(0, 0, 0), false);
+    QCOMPARE(grid.isTransparent(1, 0, 0), false);
+}
+
+void test_MinMaxBrickGrid::getNumberOfTransparentSteps_ShouldReturnExpectedValue_data()
+{
+    QTest::addColumn<Vector3>("position");
+    QTest::addColumn<Vector3>("increment");
+    QTest::addColumn<int>("maximumSteps");
+    QTest::addColumn<int>("expectedSteps");
+
+    QTest::newRow("forward through two transparent bricks") << Vector3(0.5, 0.0, 0.0) << Vector3(1.0, 0.0, 0.0) << 100 << 16;
+    QTest::newRow("forward with half steps") << Vector3(0.25, 0.0, 0.0) << Vector3(0.5, 0.0, 0.0) << 100 << 32;
+    QTest::newRow("forward limited by maximum steps") << Vector3(0.5, 0.0, 0.0) << Vector3(1.0, 0.0, 0.0) << 5 << 5;
+    QTest::newRow("backward until leaving the volume") << Vector3(15.5, 0.0, 0.0) << Vector3(-1.0, 0.0, 0.0) << 100 << 16;
+    QTest::newRow("start in opaque brick") << Vector3(20.5, 0.0, 0.0) << Vector3(-1.0, 0.0, 0.0) << 100 << 0;
+    QTest::newRow("start outside the volume") << Vector3(-0.5, 0.0, 0.0) << Vector3(1.0, 0.0, 0.0) << 100 << 0;
+    QTest::newRow("along a transparent brick") << Vector3(3.5, 0.0, 0.0) << Vector3(0.0, 0.0, 0.0) << 100 << 100;
+}
+
+void test_MinMaxBrickGrid::getNumberOfTransparentSteps_ShouldReturnExpectedValue()
+{
+    QFETCH(Vector3, position);
+    QFETCH(Vector3, increment);
+    QFETCH(int, maximumSteps);
+    QFETCH(int, expectedSteps);
+
+    QVector<unsigned short> data = createStepVolume();
+    int dimensions[3] = { 32, 1, 1 };
+
+    MinMaxBrickGrid grid;
+    grid.setData(data.constData(), dimensions);
+    grid.setTransferFunction(createStepTransferFunction());
+
+    QCOMPARE(grid.getNumberOfTransparentSteps(position, increment, maximumSteps), expectedSteps);
+}
+
+void test_MinMaxBrickGrid::getNumberOfTransparentSteps_ShouldReturnZeroWithoutData()
+{
+    MinMaxBrickGrid grid;
+
+    QVERIFY(!grid.hasData());
+    QCOMPARE(grid.getNumberOfTransparentSteps(Vector3(0.5, 0.0, 0.0), Vector3(1.0, 0.0, 0.0), 100), 0);
+}
+
+DECLARE_TEST(test_MinMaxBrickGrid)
+
+#include "test_minmaxbrickgrid.moc"
@@ -4,10 +4,34 @@
 #include "fuzzycomparetesthelper.h"
 
 #include <QString>
+#include <QVector>
+#include <QtCore/qmath.h>
 
 using namespace udg;
 using namespace testing;
 
+namespace {
+
+/// Reader of the values of a vector for ROIData::addValues()
+class VectorValueReader {
+public:
+    VectorValueReader(const QVector<double> &values) : m_values(values) {}
+
+    template <class Consumer>
+    void readValues(Consumer &consumer) const
+    {
+        foreach (double value, m_values)
+        {
+            consumer(value);
+        }
+    }
+
+private:
+    const QVector<double> &m_values;
+};
+
+}
+
 class test_ROIData : public QObject {
 Q_OBJECT
 
@@ -27,8 +51,21 @@ private slots:
     void getMaximum_ReturnsExpectedData_data();
     void getMaximum_ReturnsExpectedData();
 
+    void getMinimum_ReturnsExpectedData_data();
+    void getMinimum_ReturnsExpectedData();
+
+    void getNumberOfVoxels_ReturnsExpectedData();
+
+    void addValues_GivesSameStatisticsAsTwoPassComputation();
+
+    void addValue_AfterAddValuesGivesOnePassStandardDeviation();
+
+    void getHistogram_ReturnsExpectedData_data();
+    void getHistogram_ReturnsExpectedData();
+
 private:
-    ROIData generateROIData();
+    /// Returns a ROIData with the values from 1 to 10. If numberOfHistogramBins is greater than 0, it has the given histogram enabled
+    ROIData generateROIData(double histogramMinimum = 0.0, double histogramMaximum = 0.0, int numberOfHistogramBins = 0);
 };
 
 Q_DECLARE_METATYPE(ROIData)
@@ -120,9 +157,109 @@ void test_ROIData::getMaximum_ReturnsExpectedData()
     QCOMPARE(roiData.getMaximum(), expectedMaximum);
 }
 
-ROIData test_ROIData::generateROIData()
+void test_ROIData::getMinimum_ReturnsExpectedData_data()
+{
+    QTest::addColumn<ROIData>("roiData");
+    QTest::addColumn<double>("expectedMinimum");
+
+    QTest::newRow("Random single valued voxels (min)") << generateROIData() << 1.0;
+}
+
+void test_ROIData::getMinimum_ReturnsExpectedData()
+{
+    QFETCH(ROIData, roiData);
+    QFETCH(double, expectedMinimum);
+
+    QCOMPARE(roiData.getMinimum(), expectedMinimum);
+}
+
+void test_ROIData::getNumberOfVoxels_ReturnsExpectedData()
+{
+    ROIData roiData = generateROIData();
+
+    QCOMPARE(roiData.getNumberOfVoxels(), 10);
+
+    roiData.addVoxel(Voxel());
+
+    QCOMPARE(roiData.getNumberOfVoxels(), 10);
+}
+
+void test_ROIData::addValues_GivesSameStatisticsAsTwoPassComputation()
 {
     ROIData roiData;
+    QVector<double> values;
+
+    // Values with a large offset, where the standard deviation is more sensitive to rounding errors
+    for (int i = 0; i < 100000; ++i)
+    {
+        values << 3000.0 + (i * 7919 % 1009) * 0.25;
+    }
+
+    roiData.addValues(VectorValueReader(values));
+
+    double mean = 0.0;
+    foreach (double value, values)
+    {
+        mean += value;
+    }
+    mean /= values.size();
+
+    double standardDeviation = 0.0;
+    foreach (double value, values)
+    {
+        standardDeviation += (value - mean) * (value - mean);
+    }
+    standardDeviation = qSqrt(standardDeviation / values.size());
+
+    QCOMPARE(roiData.getMean(), mean);
+    QCOMPARE(roiData.getStandardDeviation(), standardDeviation);
+}
+
+void test_ROIData::addValue_AfterAddValuesGivesOnePassStandardDeviation()
+{
+    ROIData roiData;
+    QVector<double> values;
+    values << 1.0 << 2.0 << 3.0 << 4.0 << 5.0;
+
+    roiData.addValues(VectorValueReader(values));
+    roiData.addValue(6.0);
+
+    QCOMPARE(roiData.getNumberOfVoxels(), 6);
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(roiData.getStandardDeviation(), 1.708, 1.0e-3));
+}
+
+void test_ROIData::getHistogram_ReturnsExpectedData_data()
+{
+    QTest::addColumn<ROIData>("roiData");
+    QTest::addColumn<QVector<int> >("expectedHistogram");
+
+    QTest::newRow("Histogram not enabled") << generateROIData() << QVector<int>();
+
+    QVector<int> histogram;
+    histogram << 2 << 2 << 2 << 2 << 2;
+    QTest::newRow("All the values inside the range") << generateROIData(1.0, 11.0, 5) << histogram;
+
+    histogram.clear();
+    histogram << 3 << 1 << 1 << 1 << 4;
+    QTest::newRow("Values out of the range") << generateROIData(3.0, 8.0, 5) << histogram;
+}
+
+void test_ROIData::getHistogram_ReturnsExpectedData()
+{
+    QFETCH(ROIData, roiData);
+    QFETCH(QVector<int>, expectedHistogram);
+
+    QCOMPARE(roiData.getHistogram(), expectedHistogram);
+}
+
+ROIData test_ROIData::generateROIData(double histogramMinimum, double histogramMaximum, int numberOfHistogramBins)
+{
+    ROIData roiData;
+
+    if (numberOfHistogramBins > 0)
+    {
+        roiData.enableHistogram(histogramMinimum, histogramMaximum, numberOfHistogramBins);
+    }
 
     double value = 1.0;
     for (int i = 0; i < 10; ++i)
@@ -0,0 +1,124 @@
+#include "autotest.h"
+#include "slicelocator.h"
+
+#include "image.h"
+#include "volume.h"
+#include "volumetesthelper.h"
+
+using namespace udg;
+using namespace testing;
+
+class test_SliceLocator : public QObject {
+Q_OBJECT
+
+private slots:
+    void getNearestSlice_ReturnsExpectedSlice_data();
+    void getNearestSlice_ReturnsExpectedSlice();
+
+    void getNearestSlice_ReturnsMinusOneWithoutVolume();
+
+    void getNearestSlice_UpdatesIndexWhenVolumeChanges();
+
+private:
+    /// Creates a volume with a slice at each of the given positions along the z axis. If tiltLastSlice is true, the last slice is not parallel to the others.
+    Volume* createVolume(const QList<double> &slicePositions, double zSpacing, bool tiltLastSlice = false);
+};
+
+Q_DECLARE_METATYPE(Volume*)
+
+Volume* test_SliceLocator::createVolume(const QList<double> &slicePositions, double zSpacing, bool tiltLastSlice)
+{
+    double origin[3] = { 0.0, 0.0, slicePositions.first() };
+    double spacing[3] = { 1.0, 1.0, zSpacing };
+    int extent[6] = { 0, 9, 0, 9, 0, slicePositions.size() - 1 };
+    Volume *volume = VolumeTestHelper::createVolumeWithParameters(slicePositions.size(), 1, slicePositions.size(), origin, spacing, extent);
+    volume->setParent(this);
+
+    ImageOrientation orientation;
+    orientation.setRowAndColumnVectors(QVector3D(1.0, 0.0, 0.0), QVector3D(0.0, 1.0, 0.0));
+    for (int i = 0; i < slicePositions.size(); i++)
+    {
+        double position[3] = { 0.0, 0.0, slicePositions.at(i) };
+        volume->getImage(i)->setImagePositionPatient(position);
+        volume->getImage(i)->setImageOrientationPatient(orientation);
+    }
+
+    if (tiltLastSlice)
+    {
+        ImageOrientation tiltedOrientation;
+        tiltedOrientation.setRowAndColumnVectors(QVector3D(1.0, 0.0, 0.0), QVector3D(0.0, 0.8, 0.6));
+        volume->getImage(slicePositions.size() - 1)->setImageOrientationPatient(tiltedOrientation);
+    }
+
+    return volume;
+}
+
+void test_SliceLocator::getNearestSlice_ReturnsExpectedSlice_data()
+{
+    QTest::addColumn<Volume*>("volume");
+    QTest::addColumn<double>("pointZ");
+    QTest::addColumn<int>("expectedSlice");
+
+    QList<double> ascendingPositions;
+    ascendingPositions << 0.0 << 2.0 << 4.0 << 6.0 << 8.0;
+    QList<double> descendingPositions;
+    descendingPositions << 8.0 << 6.0 << 4.0 << 2.0 << 0.0;
+    QList<double> repeatedPositions;
+    repeatedPositions << 0.0 << 2.0 << 2.0 << 4.0;
+
+    QTest::newRow("ascending, on a slice") << createVolume(ascendingPositions, 2.0) << 4.0 << 2;
+    QTest::newRow("ascending, near a slice") << createVolume(ascendingPositions, 2.0) << 6.7 << 3;
+    QTest::newRow("ascending, halfway between slices") << createVolume(ascendingPositions, 2.0) << 5.0 << 2;
+    QTest::newRow("ascending, before first slice") << createVolume(ascendingPositions, 2.0) << -2.5 << 0;
+    QTest::newRow("ascending, after last slice") << createVolume(ascendingPositions, 2.0) << 10.5 << 4;
+    QTest::newRow("ascending, too far") << createVolume(ascendingPositions, 2.0) << -3.5 << -1;
+    QTest::newRow("descending, near a slice") << createVolume(descendingPositions, 2.0) << 1.9 << 3;
+    QTest::newRow("descending, halfway between slices") << createVolume(descendingPositions, 2.0) << 5.0 << 1;
+    QTest::newRow("repeated positions") << createVolume(repeatedPositions, 2.0) << 2.2 << 1;
+    QTest::newRow("not parallel") << createVolume(ascendingPositions, 2.0, true) << 2.3 << 1;
+}
+
+void test_SliceLocator::getNearestSlice_ReturnsExpectedSlice()
+{
+    QFETCH(Volume*, volume);
+    QFETCH(double, pointZ);
+    QFETCH(int, expectedSlice);
+
+    SliceLocator sliceLocator;
+    sliceLocator.setVolume(volume);
+    sliceLocator.setPlane(OrthogonalPlane::XYPlane);
+
+    double point[3] = { 4.0, 4.0, pointZ };
+    QCOMPARE(sliceLocator.getNearestSlice(point), expectedSlice);
+    // The second lookup uses the already built index
+    QCOMPARE(sliceLocator.getNearestSlice(point), expectedSlice);
+}
+
+void test_SliceLocator::getNearestSlice_ReturnsMinusOneWithoutVolume()
+{
+    SliceLocator sliceLocator;
+
+    double point[3] = { 0.0, 0.0, 0.0 };
+    QCOMPARE(sliceLocator.getNearestSlice(point), -1);
+}
+
+void test_SliceLocator::getNearestSlice_UpdatesIndexWhenVolumeChanges()
+{
+    QList<double> positions;
+    positions << 0.0 << 2.0 << 4.0;
+    QList<double> otherPositions;
+    otherPositions << 10.0 << 12.0 << 14.0;
+
+    SliceLocator sliceLocator;
+    sliceLocator.setVolume(createVolume(positions, 2.0));
+
+    double point[3] = { 0.0, 0.0, 12.0 };
+    QCOMPARE(sliceLocator.getNearestSlice(point), -1);
+
+    sliceLocator.setVolume(createVolume(otherPositions, 2.0));
+    QCOMPARE(sliceLocator.getNearestSlice(point), 1);
+}
+
+DECLARE_TEST(test_SliceLocator)
+
+#include "test_slicelocator.moc"
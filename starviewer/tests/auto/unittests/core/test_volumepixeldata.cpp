@@ -8,6 +8,8 @@
 #include "fuzzycomparetesthelper.h"
 
 #include "vtkImageData.h"
+#include "vtkPointData.h"
+#include "vtkShortArray.h"
 
 using namespace udg;
 using namespace testing;
@@ -37,6 +39,8 @@ private slots:
 
     void getVoxelValue_IndexVariant_ShouldReturnExpectedSingleComponentValue_data();
     void getVoxelValue_IndexVariant_ShouldReturnExpectedSingleComponentValue();
+
+    void applyPendingScalars_ShouldReplaceScalarsAndMarkAllSlicesReady();
 };
 
 Q_DECLARE_METATYPE(unsigned char*)
@@ -405,6 +409,33 @@ void test_VolumePixelData::getVoxelValue_IndexVariant_ShouldReturnExpectedSingle
     }
 }
 
+void test_VolumePixelData::applyPendingScalars_ShouldReplaceScalarsAndMarkAllSlicesReady()
+{
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetExtent(0, 1, 0, 1, 0, 2);
+    imageData->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+
+    VolumePixelData volumePixelData;
+    volumePixelData.setData(imageData);
+    volumePixelData.setAllSlicesPending(3);
+    volumePixelData.setSliceReady(1);
+
+    vtkSmartPointer<vtkShortArray> newScalars = vtkSmartPointer<vtkShortArray>::New();
+    newScalars->SetNumberOfTuples(12);
+    volumePixelData.setPendingScalars(newScalars);
+
+    QVERIFY(volumePixelData.hasPendingScalars());
+    QVERIFY(!volumePixelData.areAllSlicesReady());
+    QCOMPARE(volumePixelData.getScalarType(), static_cast<int>(VTK_UNSIGNED_SHORT));
+
+    volumePixelData.applyPendingScalars();
+
+    QVERIFY(!volumePixelData.hasPendingScalars());
+    QVERIFY(volumePixelData.areAllSlicesReady());
+    QCOMPARE(volumePixelData.getVtkData()->GetPointData()->GetScalars(), static_cast<vtkDataArray*>(newScalars.GetPointer()));
+    QCOMPARE(volumePixelData.getScalarType(), static_cast<int>(VTK_SHORT));
+}
+
 DECLARE_TEST(test_VolumePixelData)
 
 #include "test_volumepixeldata.moc"
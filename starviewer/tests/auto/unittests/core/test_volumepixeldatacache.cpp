@@ -0,0 +1,174 @@
+#include "autotest.h"
+#include "volumepixeldatacache.h"
+
+#include "volumepixeldata.h"
+#include "volumepixeldatatesthelper.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+using namespace testing;
+
+class test_VolumePixelDataCache : public QObject {
+Q_OBJECT
+private slots:
+    void save_ShouldWriteDataThatCanBeLoadedBack();
+
+    void load_ShouldReturnNullIfFileDoesNotExist();
+
+    void load_ShouldReturnNullIfFileIsNotValid();
+
+    void removeSeries_ShouldRemoveSavedFiles();
+
+    void load_ScalarsShouldRemainValidAfterPixelDataIsDestroyed();
+
+    void enforceMaximumSize_ShouldRemoveEntriesUntilSizeFits();
+};
+
+void test_VolumePixelDataCache::save_ShouldWriteDataThatCanBeLoadedBack()
+{
+    QTemporaryDir cacheDirectory;
+    QVERIFY(cacheDirectory.isValid());
+    VolumePixelDataCache cache(cacheDirectory.path());
+
+    int dimensions[3] = { 12, 7, 5 };
+    int extent[6] = { 0, 11, 0, 6, 0, 4 };
+    double spacing[3] = { 0.5, 0.75, 2.5 };
+    double origin[3] = { -10.0, 3.0, 25.0 };
+    VolumePixelData *savedPixelData = VolumePixelDataTestHelper::createVolumePixelData(dimensions, extent, spacing, origin);
+    QString cacheFilePath = cacheDirectory.path() + "/study/series/entry.raw";
+
+    QVERIFY(cache.save(cacheFilePath, savedPixelData, 5));
+    QVERIFY(QFile::exists(cacheFilePath));
+    QVERIFY(!QFile::exists(cacheFilePath + ".part"));
+
+    VolumePixelData *loadedPixelData = cache.load(cacheFilePath);
+    QVERIFY(loadedPixelData != 0);
+
+    vtkImageData *savedImage = savedPixelData->getVtkData();
+    vtkImageData *loadedImage = loadedPixelData->getVtkData();
+    int loadedExtent[6];
+    loadedImage->GetExtent(loadedExtent);
+    for (int i = 0; i < 6; i++)
+    {
+        QCOMPARE(loadedExtent[i], extent[i]);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        QCOMPARE(loadedImage->GetSpacing()[i], spacing[i]);
+        QCOMPARE(loadedImage->GetOrigin()[i], origin[i]);
+    }
+    QCOMPARE(loadedImage->GetScalarType(), savedImage->GetScalarType());
+    QCOMPARE(loadedImage->GetNumberOfScalarComponents(), savedImage->GetNumberOfScalarComponents());
+    QCOMPARE(memcmp(loadedImage->GetScalarPointer(), savedImage->GetScalarPointer(), savedImage->GetNumberOfPoints() * sizeof(short)), 0);
+
+    delete loadedPixelData;
+    delete savedPixelData;
+}
+
+void test_VolumePixelDataCache::load_ShouldReturnNullIfFileDoesNotExist()
+{
+    QTemporaryDir cacheDirectory;
+    QVERIFY(cacheDirectory.isValid());
+    VolumePixelDataCache cache(cacheDirectory.path());
+
+    QVERIFY(cache.load(cacheDirectory.path() + "/missing.raw") == 0);
+}
+
+void test_VolumePixelDataCache::load_ShouldReturnNullIfFileIsNotValid()
+{
+    QTemporaryDir cacheDirectory;
+    QVERIFY(cacheDirectory.isValid());
+    VolumePixelDataCache cache(cacheDirectory.path());
+
+    QString cacheFilePath = cacheDirectory.path() + "/invalid.raw";
+    QFile file(cacheFilePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(1024, 'x'));
+    file.close();
+
+    QVERIFY(cache.load(cacheFilePath) == 0);
+}
+
+void test_VolumePixelDataCache::removeSeries_ShouldRemoveSavedFiles()
+{
+    QTemporaryDir cacheDirectory;
+    QVERIFY(cacheDirectory.isValid());
+    VolumePixelDataCache cache(cacheDirectory.path());
+
+    int dimensions[3] = { 4, 4, 2 };
+    int extent[6] = { 0, 3, 0, 3, 0, 1 };
+    double spacing[3] = { 1.0, 1.0, 1.0 };
+    double origin[3] = { 0.0, 0.0, 0.0 };
+    VolumePixelData *pixelData = VolumePixelDataTestHelper::createVolumePixelData(dimensions, extent, spacing, origin);
+    QString cacheFilePath = cacheDirectory.path() + "/study/series/entry.raw";
+    QVERIFY(cache.save(cacheFilePath, pixelData, 1));
+
+    QVERIFY(cache.removeSeries("study", "series"));
+    QVERIFY(!QFile::exists(cacheFilePath));
+
+    delete pixelData;
+}
+
+void test_VolumePixelDataCache::load_ScalarsShouldRemainValidAfterPixelDataIsDestroyed()
+{
+    QTemporaryDir cacheDirectory;
+    QVERIFY(cacheDirectory.isValid());
+    VolumePixelDataCache cache(cacheDirectory.path());
+
+    int dimensions[3] = { 8, 8, 3 };
+    int extent[6] = { 0, 7, 0, 7, 0, 2 };
+    double spacing[3] = { 1.0, 1.0, 1.0 };
+    double origin[3] = { 0.0, 0.0, 0.0 };
+    VolumePixelData *savedPixelData = VolumePixelDataTestHelper::createVolumePixelData(dimensions, extent, spacing, origin);
+    QString cacheFilePath = cacheDirectory.path() + "/study/series/entry.raw";
+    QVERIFY(cache.save(cacheFilePath, savedPixelData, 1));
+
+    VolumePixelData *loadedPixelData = cache.load(cacheFilePath);
+    QVERIFY(loadedPixelData != 0);
+    vtkSmartPointer<vtkDataArray> loadedScalars = loadedPixelData->getVtkData()->GetPointData()->GetScalars();
+    delete loadedPixelData;
+
+    vtkImageData *savedImage = savedPixelData->getVtkData();
+    QCOMPARE(memcmp(loadedScalars->GetVoidPointer(0), savedImage->GetScalarPointer(), savedImage->GetNumberOfPoints() * sizeof(short)), 0);
+
+    delete savedPixelData;
+}
+
+void test_VolumePixelDataCache::enforceMaximumSize_ShouldRemoveEntriesUntilSizeFits()
+{
+    QTemporaryDir cacheDirectory;
+    QVERIFY(cacheDirectory.isValid());
+    VolumePixelDataCache cache(cacheDirectory.path());
+
+    int dimensions[3] = { 4, 4, 2 };
+    int extent[6] = { 0, 3, 0, 3, 0, 1 };
+    double spacing[3] = { 1.0, 1.0, 1.0 };
+    double origin[3] = { 0.0, 0.0, 0.0 };
+    VolumePixelData *pixelData = VolumePixelDataTestHelper::createVolumePixelData(dimensions, extent, spacing, origin);
+    QString cacheFilePath1 = cacheDirectory.path() + "/study1/series/entry.raw";
+    QString cacheFilePath2 = cacheDirectory.path() + "/study2/series/entry.raw";
+    QVERIFY(cache.save(cacheFilePath1, pixelData, 1));
+    QVERIFY(cache.save(cacheFilePath2, pixelData, 1));
+    qint64 entrySize = QFileInfo(cacheFilePath1).size();
+
+    cache.enforceMaximumSize(2 * entrySize);
+    QVERIFY(QFile::exists(cacheFilePath1));
+    QVERIFY(QFile::exists(cacheFilePath2));
+
+    cache.enforceMaximumSize(entrySize);
+    QVERIFY(QFile::exists(cacheFilePath1) != QFile::exists(cacheFilePath2));
+
+    delete pixelData;
+}
+
+DECLARE_TEST(test_VolumePixelDataCache)
+
+#include "test_volumepixeldatacache.moc"
@@ -23,13 +23,14 @@ Q_DECLARE_METATYPE(PACSRequestStatus::SendRequestStatus)
 void test_SendDICOMFilesToPACS::send_ShouldSendExpectedNumberOfFiles_data()
 {
     QTest::addColumn< QList<Image*> >("images");
+    QTest::addColumn<int>("numberOfAssociations");
     QTest::addColumn<PACSRequestStatus::SendRequestStatus>("expectedReturnValue");
     QTest::addColumn<int>("expectedNumberOfFilesSentSuccessfully");
     QTest::addColumn<int>("expectedNumberOfFilesSentFailed");
     QTest::addColumn<int>("expectedNumberOfFilesSentWarning");
 
-    QTest::newRow("empty list") << QList<Image*>() << PACSRequestStatus::SendAllDICOMFilesFailed << 0 << 0 << 0;
-    QTest::newRow("one image") << (QList<Image*>() << new Image(this)) << PACSRequestStatus::SendOk << 1 << 0 << 0;
+    QTest::newRow("empty list") << QList<Image*>() << 1 << PACSRequestStatus::SendAllDICOMFilesFailed << 0 << 0 << 0;
+    QTest::newRow("one image") << (QList<Image*>() << new Image(this)) << 1 << PACSRequestStatus::SendOk << 1 << 0 << 0;
 
     {
         QList<Image*> images;
@@ -41,7 +42,7 @@ void test_SendDICOMFilesToPACS::send_ShouldSendExpectedNumberOfFiles_data()
             images.append(image);
         }
 
-        QTest::newRow("multiple images with different paths") << images << PACSRequestStatus::SendOk << 10 << 0 << 0;
+        QTest::newRow("multiple images with different paths") << images << 1 << PACSRequestStatus::SendOk << 10 << 0 << 0;
     }
 
     {
@@ -54,7 +55,7 @@ void test_SendDICOMFilesToPACS::send_ShouldSendExpectedNumberOfFiles_data()
             images.append(image);
         }
 
-        QTest::newRow("multiple images with the same path") << images << PACSRequestStatus::SendOk << 1 << 0 << 0;
+        QTest::newRow("multiple images with the same path") << images << 1 << PACSRequestStatus::SendOk << 1 << 0 << 0;
     }
 
     {
@@ -88,19 +89,38 @@ void test_SendDICOMFilesToPACS::send_ShouldSendExpectedNumberOfFiles_data()
             images.append(image);
         }
 
-        QTest::newRow("multiple images with mixed paths") << images << PACSRequestStatus::SendOk << 4 << 0 << 0;
+        QTest::newRow("multiple images with mixed paths") << images << 1 << PACSRequestStatus::SendOk << 4 << 0 << 0;
+        QTest::newRow("multiple images with mixed paths and several associations") << images << 3 << PACSRequestStatus::SendOk << 4 << 0 << 0;
     }
+
+    {
+        QList<Image*> images;
+
+        for (int i = 0; i < 100; i++)
+        {
+            Image *image = new Image(this);
+            image->setPath(QString::number(i));
+            images.append(image);
+        }
+
+        QTest::newRow("multiple images with different paths and several associations") << images << 4 << PACSRequestStatus::SendOk << 100 << 0 << 0;
+    }
+
+    QTest::newRow("one image and several associations") << (QList<Image*>() << new Image(this)) << 4 << PACSRequestStatus::SendOk << 1 << 0 << 0;
 }
 
 void test_SendDICOMFilesToPACS::send_ShouldSendExpectedNumberOfFiles()
 {
     QFETCH(QList<Image*>, images);
+    QFETCH(int, numberOfAssociations);
     QFETCH(PACSRequestStatus::SendRequestStatus, expectedReturnValue);
     QFETCH(int, expectedNumberOfFilesSentSuccessfully);
     QFETCH(int, expectedNumberOfFilesSentFailed);
     QFETCH(int, expectedNumberOfFilesSentWarning);
 
-    TestingSendDICOMFilesToPACS sender((PacsDevice())); // double parentheses are necessary to avoid compiler confusion
+    PacsDevice pacsDevice;
+    pacsDevice.setNumberOfStoreServiceAssociations(numberOfAssociations);
+    TestingSendDICOMFilesToPACS sender(pacsDevice);
 
     QCOMPARE(sender.send(images), expectedReturnValue);
     QCOMPARE(sender.getNumberOfDICOMFilesSentSuccesfully(), expectedNumberOfFilesSentSuccessfully);